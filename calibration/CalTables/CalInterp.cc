@@ -69,6 +69,7 @@ CalInterp::CalInterp(CalSet<Complex>& cs,
   tPC_(cs.nSpw(),NULL),
   tCC_(cs.nSpw(),NULL),
   tOk_(cs.nSpw(),NULL),
+  tCoeffCache_(cs.nSpw()),
 
   ch0_(cs.nSpw(),NULL),
   ef_(cs.nSpw(),NULL),
@@ -203,13 +204,13 @@ Bool CalInterp::interpTime(const Double& time) {
       if (verbose_) cout << "   "
 			 << "FOUND EXACT TIME!" << endl;
       // Just reference CalSet parameter
-      IPosition blc(4,0,0,0,currSlot());
-      IPosition trc(4,nPar()-1,nChan()-1,nElem()-1,currSlot());
-
       Cube<Complex> t;
-      t.reference(csPar()(blc,trc).reform(IPosition(3,nPar(),nChan(),nElem())));
+      t.reference(csPar(currSlot()));
       r_.reference(t);
-      tOk().reference(csParOK()(blc,trc).reform(IPosition(3,nPar(),nChan(),nElem())));
+      tOk().reference(csParOK(currSlot()));
+
+      // tOk() no longer refers to the time coefficients
+      lastlo()=-1;
 
     } else {
 
@@ -340,72 +341,92 @@ void CalInterp::updTimeCoeff() {
   if ( currSlot() != lastlo() ) {
     lastlo()=currSlot();
 
-    // Resize Coefficient arrays 
-    IPosition ip4s(4,2,nPar(),nChan(),nElem());
-    IPosition ip3s(3,nPar(),nChan(),nElem());
-
-    tAC().resize(ip4s);
-    tOk().resize(ip3s);
+    Bool linear(linearT()), aipslin(aipslinT());
 
-    if ( timeType()=="linear") 
-      tPC().resize(ip4s);
-    else if (timeType()=="aipslin") 
-      tCC().resize(ip4s);
-    
     // Time ref/step for this interval
     t0()=csTimes()(currSlot());
     tS()=csTimes()(currSlot()+1)-t0();
-    
-    // For indexing parameter cache
-    IPosition lo(4,0,0,0,currSlot()), hi(4,0,0,0,currSlot()+1);
-    IPosition ref(4,0,0,0,0), slope(4,1,0,0,0);
-
-    for (Int ielem=0;ielem<nElem();ielem++) {
-      lo(2)=hi(2)=ref(3)=slope(3)=ielem;
-      for (Int ichan=0;ichan<nChan();ichan++) {
-	lo(1)=hi(1)=ref(2)=slope(2)=ichan;
-	for (Int ipar=0;ipar<nPar();ipar++) {
-	  lo(0)=hi(0)=ref(1)=slope(1)=ipar;
 
-	  tOk()(ipar,ichan,ielem) = (csParOK()(lo) && csParOK()(hi));
+    // Use the coefficients of this slot if calculated before
+    std::map<Int,TimeCoeff>& cache(tCoeffCache_[currSpw()]);
+    std::map<Int,TimeCoeff>::iterator iter=cache.find(currSlot());
+    if (iter==cache.end()) {
+
+      // (previous results stay alive while referenced)
+      if (cache.size()>=maxCachedSlots_)
+	cache.clear();
+      TimeCoeff& tc(cache[currSlot()]);
+
+      IPosition ip4s(4,2,nPar(),nChan(),nElem());
+      IPosition ip3s(3,nPar(),nChan(),nElem());
+      tc.ac.resize(ip4s);
+      tc.ok.resize(ip3s);
+      if (linear)
+	tc.pc.resize(ip4s);
+      else if (aipslin) 
+	tc.cc.resize(ip4s);
+
+      // Each slot is contiguous, so all (par,chan,elem) of the slot pair
+      //  are done in a single loop
+      Int n=nPar()*nChan()*nElem();
+      const Complex* lo=csPar(currSlot()).data();
+      const Complex* hi=csPar(currSlot()+1).data();
+      const Bool* lok=csParOK(currSlot()).data();
+      const Bool* hok=csParOK(currSlot()+1).data();
+      Float* ac=tc.ac.data();
+      Float* pc=(linear ? tc.pc.data() : 0);
+      Complex* cc=(aipslin ? tc.cc.data() : 0);
+      Bool* ok=tc.ok.data();
+
+      for (Int i=0;i<n;i++) {
+	Int ref(2*i), slope(2*i+1);
+	ok[i] = (lok[i] && hok[i]);
 	  
-	  if (tOk()(ipar,ichan,ielem)) {
-	    // Intercept
-	    tAC()(ref) = abs(csPar()(lo));
-	    tAC()(slope) = abs(csPar()(hi)) - tAC()(ref);
+	if (ok[i]) {
+	  // Intercept
+	  ac[ref] = abs(lo[i]);
+	  ac[slope] = abs(hi[i]) - ac[ref];
 	    
-	    if (timeType()=="linear") {
-	      tPC()(ref) = arg(csPar()(lo));
+	  if (linear) {
+	    pc[ref] = arg(lo[i]);
 	      
-	      // Slope
-	      Float pslope = arg(csPar()(hi)) - tPC()(ref);
-	      // Catch simple phase wraps
-	      if (pslope > C::pi)
-		pslope-=(2*C::pi);
-	      else if (pslope < -C::pi)
-		pslope+=(2*C::pi);
-	      tPC()(slope) = pslope;
-	      
-	    } else if (timeType()=="aipslin") {
-	      tCC()(ref) = csPar()(lo);
-	      tCC()(slope) = csPar()(hi)-tCC()(ref);
+	    // Slope
+	    Float pslope = arg(hi[i]) - pc[ref];
+	    // Catch simple phase wraps
+	    if (pslope > C::pi)
+	      pslope-=(2*C::pi);
+	    else if (pslope < -C::pi)
+	      pslope+=(2*C::pi);
+	    pc[slope] = pslope;
 	      
-	    }
+	  } else if (aipslin) {
+	    cc[ref] = lo[i];
+	    cc[slope] = hi[i]-cc[ref];
+	  }
 	    
-	  } else {
-	    tAC()(ref)=1.0;
-	    tAC()(slope)=0.0;
-	    if (timeType()=="linear") {
-	      tPC()(ref)=0.0;
-	      tPC()(slope)=0.0;
-	    } else if (timeType()=="aipslin") {
-	      tCC()(ref)=Complex(1.0,0.0);
-	      tCC()(slope)=Complex(0.0,0.0);
-	    }
+	} else {
+	  ac[ref]=1.0;
+	  ac[slope]=0.0;
+	  if (linear) {
+	    pc[ref]=0.0;
+	    pc[slope]=0.0;
+	  } else if (aipslin) {
+	    cc[ref]=Complex(1.0,0.0);
+	    cc[slope]=Complex(0.0,0.0);
 	  }
 	}
       }
+      iter=cache.find(currSlot());
     }
+
+    // Refer to the coefficients of this slot
+    const TimeCoeff& tc(iter->second);
+    tAC().reference(tc.ac);
+    tOk().reference(tc.ok);
+    if (linear) 
+      tPC().reference(tc.pc);
+    else if (aipslin) 
+      tCC().reference(tc.cc);
   }
 
 }
@@ -415,72 +436,69 @@ void CalInterp::interpTimeCalc(const Double& time) {
 
   if (verbose_) cout << "CalInterp::interpTimeCalc()" << endl;
 
-
-  // TODO:
-  //  a. Use matrix math instead of loops?  (tOk() usage?)
+  Bool linear(linearT()), aipslin(aipslinT());
 
   // Fractional time interval for this timestamp
   Float dt( Float( (time-t0())/tS() ) );
 
   // Ensure intermediate results cache is properly sized and ref'd
-  if (tA_.nelements()==0) {
-    tA_.resize(nPar(),nChan(),nElem());
+  //  (nChan may differ per spw)
+  IPosition ip3s(3,nPar(),nChan(),nElem());
+  if (!tA_.shape().isEqual(ip3s)) {
+    tA_.resize(ip3s);
     a.reference(tA_);
-    ok.reference(tOk());
-    if (timeType()=="linear") {
-      tP_.resize(nPar(),nChan(),nElem());
+    if (linear) {
+      tP_.resize(ip3s);
       p.reference(tP_);
       c.resize(); 
     }
-    else if (timeType()=="aipslin") {
-      tC_.resize(nPar(),nChan(),nElem());
+    else if (aipslin) {
+      tC_.resize(ip3s);
       c.reference(tC_);
       p.resize();
     }
   }
-  
-  IPosition ref(4,0,0,0,0),slope(4,1,0,0,0);
-  for (Int ielem=ref(3)=slope(3)=0; 
-       ielem<nElem();
-       ielem++,ref(3)++,slope(3)++) {
-    for (Int ichan=ref(2)=slope(2)=0;
-	 ichan<nChan();
-	 ichan++,ref(2)++,slope(2)++) {
-      for (Int ipar=ref(1)=slope(1)=0;
-	   ipar<nPar();
-	   ipar++,ref(1)++,slope(1)++) {
-	
-	if (tOk()(ipar,ichan,ielem)) {
-
-	  tA_(ipar,ichan,ielem) = tAC()(ref) + tAC()(slope)*dt;
-	  if (timeType()=="linear") {
-	    tP_(ipar,ichan,ielem) = tPC()(ref) + tPC()(slope)*dt;
-	  } else if (timeType()=="aipslin") {
-	    Complex tCtmp(tCC()(ref) + tCC()(slope)*dt);
-	    Float Amp(abs(tCtmp));
-	    if (Amp>0.0)
-	      tC_(ipar,ichan,ielem) = tCtmp/abs(tCtmp);
-	    else
-	      tC_(ipar,ichan,ielem) = Complex(1.0);
-	  }
-	} 
-	else {
-	  tA_(ipar,ichan,ielem) = 1.0;
-	  if (timeType()=="linear") {
-	    tP_(ipar,ichan,ielem) = 0.0;
-	  } else if (timeType()=="aipslin") {
-	    tC_(ipar,ichan,ielem) = Complex(1.0,0.0);
-	  }
-	}	// tOk()
-      } // ipar
-    } // ichan
-  } // ielem
+  ok.reference(tOk());
+
+  // Evaluate for all (par,chan,elem) at once
+  Int n=tA_.nelements();
+  const Float* ac=tAC().data();
+  const Float* pc=(linear ? tPC().data() : 0);
+  const Complex* cc=(aipslin ? tCC().data() : 0);
+  const Bool* tok=tOk().data();
+  Float* ta=tA_.data();
+  Float* tp=(linear ? tP_.data() : 0);
+  Complex* tc=(aipslin ? tC_.data() : 0);
+  for (Int i=0;i<n;i++) {
+    Int ref(2*i), slope(2*i+1);
+    if (tok[i]) {
+      ta[i] = ac[ref] + ac[slope]*dt;
+      if (linear) {
+	tp[i] = pc[ref] + pc[slope]*dt;
+      } else if (aipslin) {
+	Complex tCtmp(cc[ref] + cc[slope]*dt);
+	Float Amp(abs(tCtmp));
+	if (Amp>0.0)
+	  tc[i] = tCtmp/Amp;
+	else
+	  tc[i] = Complex(1.0);
+      }
+    } 
+    else {
+      ta[i] = 1.0;
+      if (linear) {
+	tp[i] = 0.0;
+      } else if (aipslin) {
+	tc[i] = Complex(1.0,0.0);
+      }
+    }	// tOk()
+  }
   
   if (verbose_) {
     cout << "tA_ = " << tA_.nonDegenerate() << endl;
-    if (timeType()=="linear") 
+    if (linear) 
       cout << "tP_ = " << tP_.nonDegenerate() << endl;
-    else if (timeType()=="aipslin")
+    else if (aipslin)
       cout << "tC_ = " << tC_.nonDegenerate() << endl;
   }
 
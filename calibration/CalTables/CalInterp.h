@@ -33,6 +33,8 @@
 #include <casa/OS/File.h>
 #include <casa/Logging/LogMessage.h>
 #include <casa/Logging/LogSink.h>
+#include <map>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -54,7 +56,12 @@ public:
 
 
   // Set non-trivial spw mapping
-  void setSpwMap(const Vector<Int>& spwmap) {spwMap_ = spwmap; setSpwOK();};
+  void setSpwMap(const Vector<Int>& spwmap) {
+    spwMap_ = spwmap; setSpwOK();
+    // the cached coefficients refer to the old mapping
+    for (uInt i=0;i<tCoeffCache_.size();i++) tCoeffCache_[i].clear();
+    lastlo_=-1;
+  };
 
   // Interpolate, given timestamp, spw, freq list; returns T if new result
   Bool interpolate(const Double& time,
@@ -138,8 +145,9 @@ protected:
   inline Int& nChan()              { return cs_->nChan(currSpwMap()); }
   inline Vector<Double>& csTimes() { return cs_->time(currSpwMap()); };
   inline Vector<Double>& csFreq()  { return cs_->frequencies(currSpwMap()); };
-  inline Array<Complex>& csPar()   { return cs_->par(currSpwMap()); };
-  inline Array<Bool>&    csParOK() { return cs_->parOK(currSpwMap()); };
+  // (one slot at a time; the CalSet keeps at least two)
+  inline Array<Complex>& csPar(const Int& slot)   { return cs_->slotPar(currSpwMap(),slot); };
+  inline Array<Bool>&    csParOK(const Int& slot) { return cs_->slotParOK(currSpwMap(),slot); };
 
   // Access to IPositions
   inline IPosition&  ip4d() { return (*ip4d_[currSpw_]); };
@@ -229,6 +237,16 @@ private:
   PtrBlock<Array<Complex>*> tCC_;        // [nSpw](2,nPar,nChan,nElem)
   PtrBlock<Cube<Bool>*>     tOk_;        // [nSpw](nPar,nChan,nElem)
 
+  // Time Interpolation coefficients of recently used slots (per spw),
+  //  so revisiting a slot (e.g., interleaved fields) needs no recalculation
+  struct TimeCoeff {
+    Array<Float>   ac, pc;   // (2,nPar,nChan,nElem)
+    Array<Complex> cc;       // (2,nPar,nChan,nElem)
+    Cube<Bool>     ok;       // (nPar,nChan,nElem)
+  };
+  std::vector<std::map<Int,TimeCoeff> > tCoeffCache_;  // [nSpw]
+  static const uInt maxCachedSlots_ = 16;
+
   // Time Interpolation results (currSpw)
   Cube<Float>    tA_, tP_;    // (nPar,nChan,nElem)
   Cube<Complex>  tC_;         // (nPar,nChan,nElem)
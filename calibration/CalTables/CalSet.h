@@ -38,6 +38,9 @@
 #include <calibration/CalTables/CalTable2.h>
 #include <calibration/CalTables/SolvableCalSetMCol.h>
 #include <calibration/CalTables/VisCalEnum.h>
+#include <list>
+#include <map>
+#include <utility>
 //#include <calibration/CalTables/BaseCalSet.h>
 
 // #include <synthesis/MeasurementComponents/VisJones.h>
@@ -122,15 +125,29 @@ public:
   Vector<Int>&    fieldId(const Int& spw)      { return *fieldId_[spw]; };
   Vector<String>& fieldName(const Int& spw)    { return *fieldName_[spw]; };
   Vector<String>& sourceName(const Int& spw)   { return *sourceName_[spw]; };
-  Array<T>&       par(const Int& spw)          { return *par_[spw]; };
-  Array<Bool>&    parOK(const Int& spw)        { return *parOK_[spw]; };
-  Array<Float>&   parErr(const Int& spw)       { return *parErr_[spw]; };
-  Array<Float>&   parSNR(const Int& spw)       { return *parSNR_[spw]; };
+  //  (in the apply context, the parameters of a spw are read from the
+  //   table when first accessed)
+  Array<T>&       par(const Int& spw)          { loadPars(spw); return *par_[spw]; };
+  Array<Bool>&    parOK(const Int& spw)        { loadPars(spw); return *parOK_[spw]; };
+  Array<Float>&   parErr(const Int& spw)       { loadPars(spw); return *parErr_[spw]; };
+  Array<Float>&   parSNR(const Int& spw)       { loadPars(spw); return *parSNR_[spw]; };
+
+  // Slot-wise access for interpolation, (nPar_,nSolnChan_,nElem_) per
+  //  slot.  In the apply context, a slot is read from the table when first
+  //  accessed and kept in a cache of at most maxSlots() slots (of all
+  //  spws), from which the least recently used slot is dropped.  So the
+  //  returned arrays stay valid until maxSlots() other slots have been
+  //  accessed.  Once the whole spw is in memory (solve context, or after
+  //  par(spw)), they reference the whole-spw caches.
+  Array<T>&       slotPar(const Int& spw, const Int& slot)   { return cachedSlot(spw,slot).par; };
+  Array<Bool>&    slotParOK(const Int& spw, const Int& slot) { return cachedSlot(spw,slot).parOK; };
+  Int maxSlots() const { return maxSlots_; };
+  void setMaxSlots(const Int& maxSlots);
 
   // Statistics
   //  Matrix<Bool>&   iSolutionOK(const Int& spw)  { return *iSolutionOK_[spw]; };
-  Matrix<Float>&  iFit(const Int& spw)         { return *iFit_[spw]; };
-  Matrix<Float>&  iFitwt(const Int& spw)       { return *iFitwt_[spw]; };
+  Matrix<Float>&  iFit(const Int& spw)         { loadPars(spw); return *iFit_[spw]; };
+  Matrix<Float>&  iFitwt(const Int& spw)       { loadPars(spw); return *iFitwt_[spw]; };
   Vector<Bool>&   solutionOK(const Int& spw)   { return *solutionOK_[spw]; };
   Vector<Float>&  fit(const Int& spw)          { return *fit_[spw]; };
   Vector<Float>&  fitwt(const Int& spw)        { return *fitwt_[spw]; };
@@ -151,9 +168,38 @@ protected:
 private:
 
   // new/delete of cache
-  void inflate();
+  //  (the parameter caches are only made if pars=True)
+  void inflate(const Bool& pars=True);
   void deflate();
 
+  // Make and fill the parameter caches of a spw if not done yet
+  inline void loadPars(const Int& spw) { if (parPending_(spw)) fillPars(spw); };
+  void fillPars(const Int& spw);
+  void fillAllPars();
+
+  // Read the parameters of slots first..last of a spw from the table
+  //  into par and parOK (nPar_,nSolnChan_,nElem_,last-first+1), and
+  //  optionally the SNR (same shape) and the fit statistics
+  //  (nElem_,last-first+1)
+  void readSlots(const Int& spw, const Int& first, const Int& last,
+		 Array<T>& par, Array<Bool>& parOK,
+		 Array<Float>* parSNR=NULL,
+		 Matrix<Float>* iFit=NULL, Matrix<Float>* iFitwt=NULL);
+
+  // The parameters of a slot, cached for slotPar/slotParOK
+  struct SlotPars {
+    Int spw, slot;
+    Array<T> par;      // (nPar_,nSolnChan_,nElem_)
+    Array<Bool> parOK; // (nPar_,nSolnChan_,nElem_)
+  };
+  SlotPars& cachedSlot(const Int& spw, const Int& slot);
+
+  // Drop the cached slots of a spw (of all spws if spw<0)
+  void clearSlots(const Int& spw=-1);
+
+  // Select the (time-sorted) rows of a cal desc in the table
+  void selectCalDesc(CalTable2& tab, const String& select, const Int& calDescId);
+
 
   // Table name
   String calTableName_;
@@ -203,6 +249,22 @@ private:
   PtrBlock<Vector<Float>*> fit_;         // [nSpw_](numberSlots_)
   PtrBlock<Vector<Float>*> fitwt_;       // [nSpw_](numberSlots_)
 
+  // Table selection, and per spw the cal desc to fill the parameter caches
+  // from and whether that still has to be done (for some slots)
+  String calTableSelect_;
+  Vector<Int> calDescId_;                // (nSpw_)
+  Vector<Bool> parPending_;              // (nSpw_)
+
+  // Per spw, the selected cal desc the parameters are read from while
+  //  parPending_.  Its rows are sorted in time, nElem_ rows per slot, so
+  //  the rows of a slot are found directly.
+  PtrBlock<CalTable2*> parTab_;          // [nSpw_]
+
+  // The cached slots, most recently used first, and their index
+  Int maxSlots_;
+  std::list<SlotPars> slotLru_;
+  std::map<std::pair<Int,Int>,typename std::list<SlotPars>::iterator> slotIndex_;
+
   LogSink logSink_p;
   LogSink& logSink() {return logSink_p;};
 
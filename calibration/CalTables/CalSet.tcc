@@ -88,7 +88,12 @@ template<class T> CalSet<T>::CalSet(const Int& nSpw) :
   iFitwt_(nSpw_,NULL),
   solutionOK_(nSpw_,NULL),
   fit_(nSpw_,NULL),
-  fitwt_(nSpw_,NULL)
+  fitwt_(nSpw_,NULL),
+  calTableSelect_(""),
+  calDescId_(nSpw_,-1),
+  parPending_(nSpw_,False),
+  parTab_(nSpw_,NULL),
+  maxSlots_(max(2,2*nSpw_))
 {
   calTabDesc_=NULL;
   calTab_=NULL;
@@ -125,7 +130,12 @@ template<class T> CalSet<T>::CalSet(const Int& nSpw,
   iFitwt_(nSpw_,NULL),
   solutionOK_(nSpw_,NULL),
   fit_(nSpw_,NULL),
-  fitwt_(nSpw_,NULL)
+  fitwt_(nSpw_,NULL),
+  calTableSelect_(""),
+  calDescId_(nSpw_,-1),
+  parPending_(nSpw_,False),
+  parTab_(nSpw_,NULL),
+  maxSlots_(max(2,2*nSpw_))
 {
   calTabDesc_=NULL;
   calTab_=NULL;
@@ -165,7 +175,12 @@ template<class T> CalSet<T>::CalSet(const String& calTableName,
   iFitwt_(nSpw_,NULL),
   solutionOK_(nSpw_,NULL),
   fit_(nSpw_,NULL),
-  fitwt_(nSpw_,NULL)
+  fitwt_(nSpw_,NULL),
+  calTableSelect_(""),
+  calDescId_(nSpw_,-1),
+  parPending_(nSpw_,False),
+  parTab_(nSpw_,NULL),
+  maxSlots_(max(2,2*nSpw_))
 {
   calTabDesc_=NULL;
   calTab_=NULL;
@@ -199,7 +214,7 @@ template<class T> void CalSet<T>::resize(const Int& nPar,
 
 
 // Inflate cache to proper size
-template<class T> void CalSet<T>::inflate() {
+template<class T> void CalSet<T>::inflate(const Bool& pars) {
   
   // Construct shaped pointed-to objects in cache
 
@@ -208,6 +223,7 @@ template<class T> void CalSet<T>::inflate() {
 
   // Delete exiting cache
   deflate();
+  parPending_=False;
 
   for (Int ispw=0; ispw<nSpw_; ispw++) {
     uInt ntime=nTime_(ispw);
@@ -222,15 +238,19 @@ template<class T> void CalSet<T>::inflate() {
       sourceName_[ispw]   = new Vector<String>(ntime,"");
       fieldId_[ispw]      = new Vector<Int>(ntime,-1);
 
-      IPosition parshape(4,nPar_,nChan_(ispw),nElem_,ntime);
-      par_[ispw]     = new Array<T>(parshape,1.0);
-      parOK_[ispw]   = new Array<Bool>(parshape,False);
-      parErr_[ispw]  = new Array<Float>(parshape,0.0);
-      parSNR_[ispw]  = new Array<Float>(parshape,0.0);
+      if (pars) {
+	IPosition parshape(4,nPar_,nChan_(ispw),nElem_,ntime);
+	par_[ispw]     = new Array<T>(parshape,1.0);
+	parOK_[ispw]   = new Array<Bool>(parshape,False);
+	parErr_[ispw]  = new Array<Float>(parshape,0.0);
+	parSNR_[ispw]  = new Array<Float>(parshape,0.0);
 
-      //      iSolutionOK_[ispw]  = new Matrix<Bool>(nElem_,ntime,False);
-      iFit_[ispw]         = new Matrix<Float>(nElem_,ntime,0.0);
-      iFitwt_[ispw]       = new Matrix<Float>(nElem_,ntime,0.0);
+	//      iSolutionOK_[ispw]  = new Matrix<Bool>(nElem_,ntime,False);
+	iFit_[ispw]         = new Matrix<Float>(nElem_,ntime,0.0);
+	iFitwt_[ispw]       = new Matrix<Float>(nElem_,ntime,0.0);
+      }
+      else
+	parPending_(ispw)=True;
       solutionOK_[ispw]   = new Vector<Bool>(ntime,False);
       fit_[ispw]          = new Vector<Float>(ntime,0.0);
       fitwt_[ispw]        = new Vector<Float>(ntime,0.0);
@@ -263,6 +283,7 @@ template<class T> void CalSet<T>::deflate() {
     if (solutionOK_[ispw])   delete solutionOK_[ispw];
     if (fit_[ispw])          delete fit_[ispw];
     if (fitwt_[ispw])        delete fitwt_[ispw];
+    if (parTab_[ispw])       delete parTab_[ispw];
     MJDStart_[ispw]=NULL;
     MJDStop_[ispw]=NULL;
     MJDTimeStamp_[ispw]=NULL;
@@ -279,7 +300,9 @@ template<class T> void CalSet<T>::deflate() {
     solutionOK_[ispw]=NULL;
     fit_[ispw]=NULL;
     fitwt_[ispw]=NULL;
+    parTab_[ispw]=NULL;
   }
+  clearSlots();
 }
 
 
@@ -373,8 +396,12 @@ template<class T> void CalSet<T>::load (const String& file,
   timer.mark();
 
   // At this point, we know how big our slot-dep caches must be
-  //  (in private data), so initialize them
-  inflate();
+  //  (in private data), so initialize them.  The (large) parameter
+  //  caches are made per spw when first used (see fillPars), or read
+  //  per slot for interpolation (see cachedSlot).
+  calTableName_=file;
+  calTableSelect_=select;
+  inflate(False);
 
   // Remember if we found and filled any solutions
   Bool solfillok(False);
@@ -382,7 +409,7 @@ template<class T> void CalSet<T>::load (const String& file,
   //  cout << "CalSet inflated: " << timer.all_usec()/1.0e6 << endl;
 
 
-  // Fill per caldesc
+  // Fill the per-slot meta info per caldesc
   Double ttime(0.0);
   for (Int idesc=0;idesc<nDesc;idesc++) {
 
@@ -391,116 +418,46 @@ template<class T> void CalSet<T>::load (const String& file,
     timer.mark();
 
     Int thisSpw=spwmap(idesc);
+    calDescId_(thisSpw)=idesc;
       
-    // Reopen and globally select caltable
-    //SolvableVisJonesTable svjtabspw(file);
+    // Reopen and select this caldesc of the caltable
     CalTable2 svjtabspw(file);
-    svjtabspw.select2(select);
-
-    //    cout << " Sel: " << timer.all_usec()/1.0e6 << flush;
-
-    // isolate this caldesc:
-    ostringstream selectstr;
-    selectstr << "CAL_DESC_ID == " << idesc;
-    String caldescsel; caldescsel = selectstr.str();
-    svjtabspw.select2(caldescsel);
-
-    //    cout << " CDIsel: " << timer.all_usec()/1.0e6 << flush;
-
-    //    cout << "Sorting..." << endl;
-    Block<String> scol(1);
-    scol[0]="TIME";
-    svjtabspw.sort2(scol);
-
-    //    cout << " Sort: " << timer.all_usec()/1.0e6 << flush;
+    selectCalDesc(svjtabspw,select,idesc);
 
     Int nrow = svjtabspw.nRowMain();
-    IPosition out(3,0,0,0);   // par, chan, row
-    IPosition in(4,0,0,0,0);  // par, chan, ant, slot
     if (nrow>0) {
 
       // Found some solutions to fill
       solfillok=True;
 
-      // Ensure sorted on time
-      Block <String> sortCol(1,"TIME");
-      svjtabspw.sort2(sortCol);
-      
-      // Extract the gain table columns
-      //ROSolvableVisJonesMCol svjmcol(svjtabspw);
-      ROSolvableCalSetMCol<T> *svjmcol;
-      svjmcol= new ROSolvableCalSetMCol<T>(svjtabspw);
-
-      Vector<Int>    calDescId;  (*svjmcol).calDescId().getColumn(calDescId);
-      Vector<Double> time;       (*svjmcol).time().getColumn(time);
-      Vector<Double> interval;   (*svjmcol).interval().getColumn(interval);
-      Vector<Int>    antenna1;   (*svjmcol).antenna1().getColumn(antenna1);
-      //      cout << "antennas = " << antenna1 << endl;
-      Vector<Int>    fieldId;    (*svjmcol).fieldId().getColumn(fieldId);
-      //      cout << "fieldId = " << fieldId << endl;
-      Vector<String> fieldName;  (*svjmcol).fieldName().getColumn(fieldName);
-      Vector<String> sourceName; (*svjmcol).sourceName().getColumn(sourceName);
-      Vector<Bool>   totalSolOk; (*svjmcol).totalSolnOk().getColumn(totalSolOk);
-      Vector<Float>  totalFit;   (*svjmcol).totalFit().getColumn(totalFit);
-      Vector<Float>  totalFitWt; (*svjmcol).totalFitWgt().getColumn(totalFitWt);
-      Array<T> gain;       (*svjmcol).gain().getColumn(gain);
-      Cube<Bool>     solOk;      (*svjmcol).solnOk().getColumn(solOk);
-      Cube<Float>    fit;        (*svjmcol).fit().getColumn(fit);
-      Cube<Float>    fitWt;      (*svjmcol).fitWgt().getColumn(fitWt);
-      Cube<Bool>     flag;       (*svjmcol).flag().getColumn(flag);
-      Cube<Float>    snr;        (*svjmcol).snr().getColumn(snr);
-
-      // Read the calibration information
-      Double lastTime(-1.0), thisTime(0.0), thisInterval(0.0);
-      Int islot(-1);
-      Int iant;
-
-      for (Int irow=0; irow<nrow; irow++) {
-	out(2)=irow;
-
+      // Extract the meta info columns (only)
+      ROSolvableCalSetMCol<T> svjmcol(svjtabspw);
+
+      Vector<Double> time;       svjmcol.time().getColumn(time);
+      Vector<Double> interval;   svjmcol.interval().getColumn(interval);
+      Vector<Int>    fieldId;    svjmcol.fieldId().getColumn(fieldId);
+      Vector<String> fieldName;  svjmcol.fieldName().getColumn(fieldName);
+      Vector<String> sourceName; svjmcol.sourceName().getColumn(sourceName);
+      Vector<Bool>   totalSolOk; svjmcol.totalSolnOk().getColumn(totalSolOk);
+      Vector<Float>  totalFit;   svjmcol.totalFit().getColumn(totalFit);
+      Vector<Float>  totalFitWt; svjmcol.totalFitWgt().getColumn(totalFitWt);
+
+      // Read the calibration information of each new solution
+      Double thisTime(0.0), thisInterval(0.0);
+      for (Int irow=0, islot=0; irow<nrow && islot<nTime_(thisSpw);
+	   irow+=numberAnt, islot++) {
 	thisTime=time(irow);
-	
-	// If this is a new solution
-	if (irow%numberAnt==0) {
-
-	  islot++;
-	  in(3)=islot;
+	thisInterval=interval(irow);
+	(*MJDTimeStamp_[thisSpw])(islot) = thisTime;
+	(*MJDStart_[thisSpw])(islot) = thisTime - thisInterval / 2.0;
+	(*MJDStop_[thisSpw])(islot) = thisTime + thisInterval / 2.0;
+	(*fieldId_[thisSpw])(islot) = fieldId(irow);
+	(*fieldName_[thisSpw])(islot) = fieldName(irow);
+	(*sourceName_[thisSpw])(islot) = sourceName(irow);
 	  
-	  thisInterval=interval(irow);
-	  (*MJDTimeStamp_[thisSpw])(islot) = thisTime;
-	  (*MJDStart_[thisSpw])(islot) = thisTime - thisInterval / 2.0;
-	  (*MJDStop_[thisSpw])(islot) = thisTime + thisInterval / 2.0;
-	  (*fieldId_[thisSpw])(islot) = fieldId(irow);
-	  (*fieldName_[thisSpw])(islot) = fieldName(irow);
-	  (*sourceName_[thisSpw])(islot) = sourceName(irow);
-	  
-	  (*solutionOK_[thisSpw])(islot) = totalSolOk(irow);
-	  (*fit_[thisSpw])(islot) = totalFit(irow);
-	  (*fitwt_[thisSpw])(islot) = totalFitWt(irow);
-	  
-	  lastTime = thisTime;
-	};
-	
-	iant=antenna1(irow);
-	in(2)=iant;
-
-	//	(*iSolutionOK_[thisSpw])(iant,islot) = solOk(0,0,irow);
-	(*iFit_[thisSpw])(iant,islot) = fit(0,0,irow);
-	(*iFitwt_[thisSpw])(iant,islot) = fitWt(0,0,irow);
-	
-	for (Int ichan=0; ichan<nChan_(thisSpw); ichan++) {
-
-
-	  out(1)=in(1)=ichan;
-
-	  for (Int ipar=0; ipar<nPar_; ipar++) {
-	    in(0)=out(0)=ipar;
-	    (*par_[thisSpw])(in)=gain(out);
-	    (*parOK_[thisSpw])(in) = (solOk(out) && !flag(out));
-	    (*parSNR_[thisSpw])(in) = snr(out);
-	  }
-	}
-	
+	(*solutionOK_[thisSpw])(islot) = totalSolOk(irow);
+	(*fit_[thisSpw])(islot) = totalFit(irow);
+	(*fitwt_[thisSpw])(islot) = totalFitWt(irow);
       } // irow
     } // nrow>0
 
@@ -521,6 +478,175 @@ template<class T> void CalSet<T>::load (const String& file,
 
 };
 
+template<class T> void CalSet<T>::selectCalDesc(CalTable2& tab,
+						const String& select,
+						const Int& calDescId)
+{
+  // Globally select the caltable
+  tab.select2(select);
+
+  // isolate this caldesc:
+  ostringstream selectstr;
+  selectstr << "CAL_DESC_ID == " << calDescId;
+  String caldescsel; caldescsel = selectstr.str();
+  tab.select2(caldescsel);
+
+  // Ensure sorted on time
+  Block<String> scol(1);
+  scol[0]="TIME";
+  tab.sort2(scol);
+}
+
+template<class T> void CalSet<T>::fillPars(const Int& spw)
+{
+  // Make and fill the whole-spw caches
+  uInt ntime=nTime_(spw);
+  IPosition parshape(4,nPar_,nChan_(spw),nElem_,ntime);
+  par_[spw]     = new Array<T>(parshape,1.0);
+  parOK_[spw]   = new Array<Bool>(parshape,False);
+  parErr_[spw]  = new Array<Float>(parshape,0.0);
+  parSNR_[spw]  = new Array<Float>(parshape,0.0);
+  iFit_[spw]    = new Matrix<Float>(nElem_,ntime,0.0);
+  iFitwt_[spw]  = new Matrix<Float>(nElem_,ntime,0.0);
+  readSlots(spw,0,ntime-1,*par_[spw],*parOK_[spw],
+	    parSNR_[spw],iFit_[spw],iFitwt_[spw]);
+
+  // The table is not needed anymore, and the cached slots of this spw
+  //  are replaced by references into the whole-spw caches (which the
+  //  caller may change)
+  parPending_(spw)=False;
+  delete parTab_[spw];
+  parTab_[spw]=NULL;
+  clearSlots(spw);
+}
+
+template<class T> void CalSet<T>::setMaxSlots(const Int& maxSlots)
+{
+  // Interpolation needs two slots at a time
+  maxSlots_=max(2,maxSlots);
+  while (Int(slotLru_.size())>maxSlots_) {
+    slotIndex_.erase(std::make_pair(slotLru_.back().spw,slotLru_.back().slot));
+    slotLru_.pop_back();
+  }
+}
+
+template<class T> typename CalSet<T>::SlotPars& CalSet<T>::cachedSlot(const Int& spw,
+								       const Int& slot)
+{
+  std::pair<Int,Int> key(spw,slot);
+  typename std::map<std::pair<Int,Int>,typename std::list<SlotPars>::iterator>::iterator
+    it=slotIndex_.find(key);
+  if (it!=slotIndex_.end()) {
+    // Move it to the front
+    slotLru_.splice(slotLru_.begin(),slotLru_,it->second);
+    return slotLru_.front();
+  }
+
+  SlotPars sp;
+  sp.spw=spw;
+  sp.slot=slot;
+  IPosition slotshape(3,nPar_,nChan_(spw),nElem_);
+  if (parPending_(spw)) {
+    // Read only this slot from the table
+    IPosition parshape(4,nPar_,nChan_(spw),nElem_,1);
+    Array<T> par(parshape,1.0);
+    Array<Bool> parOK(parshape,False);
+    readSlots(spw,slot,slot,par,parOK);
+    sp.par.reference(par.reform(slotshape));
+    sp.parOK.reference(parOK.reform(slotshape));
+  }
+  else {
+    IPosition blc(4,0,0,0,slot);
+    IPosition trc(4,nPar_-1,nChan_(spw)-1,nElem_-1,slot);
+    sp.par.reference((*par_[spw])(blc,trc).reform(slotshape));
+    sp.parOK.reference((*parOK_[spw])(blc,trc).reform(slotshape));
+  }
+
+  // Drop the least recently used slots to make room
+  while (Int(slotLru_.size())>=maxSlots_) {
+    slotIndex_.erase(std::make_pair(slotLru_.back().spw,slotLru_.back().slot));
+    slotLru_.pop_back();
+  }
+  slotLru_.push_front(sp);
+  slotIndex_[key]=slotLru_.begin();
+  return slotLru_.front();
+}
+
+template<class T> void CalSet<T>::clearSlots(const Int& spw)
+{
+  typename std::list<SlotPars>::iterator it=slotLru_.begin();
+  while (it!=slotLru_.end()) {
+    if (spw<0 || it->spw==spw) {
+      slotIndex_.erase(std::make_pair(it->spw,it->slot));
+      it=slotLru_.erase(it);
+    }
+    else
+      it++;
+  }
+}
+
+template<class T> void CalSet<T>::readSlots(const Int& spw,
+					    const Int& first,
+					    const Int& last,
+					    Array<T>& par,
+					    Array<Bool>& parOK,
+					    Array<Float>* parSNR,
+					    Matrix<Float>* iFit,
+					    Matrix<Float>* iFitwt)
+{
+  // Select this spw's cal desc once
+  if (!parTab_[spw]) {
+    parTab_[spw]=new CalTable2(calTableName_);
+    selectCalDesc(*parTab_[spw],calTableSelect_,calDescId_(spw));
+  }
+
+  Int row0=first*nElem_;
+  Int nrow=min((last+1)*nElem_,Int(parTab_[spw]->nRowMain()))-row0;
+  if (nrow<=0)
+    return;
+
+  // Read only the rows of these slots
+  Slicer rows(IPosition(1,row0),IPosition(1,nrow));
+  ROSolvableCalSetMCol<T> svjmcol(*parTab_[spw]);
+
+  Vector<Int>    antenna1;   svjmcol.antenna1().getColumnRange(rows,antenna1);
+  Array<T>       gain;       svjmcol.gain().getColumnRange(rows,gain);
+  Cube<Bool>     solOk;      svjmcol.solnOk().getColumnRange(rows,solOk);
+  Cube<Bool>     flag;       svjmcol.flag().getColumnRange(rows,flag);
+  Cube<Float>    snr;        if (parSNR) svjmcol.snr().getColumnRange(rows,snr);
+  Cube<Float>    fit;        if (iFit) svjmcol.fit().getColumnRange(rows,fit);
+  Cube<Float>    fitWt;      if (iFitwt) svjmcol.fitWgt().getColumnRange(rows,fitWt);
+
+  IPosition out(3,0,0,0);   // par, chan, row
+  IPosition in(4,0,0,0,0);  // par, chan, ant, slot-first
+  for (Int irow=0; irow<nrow; irow++) {
+    Int islot=(row0+irow)/nElem_-first;
+    out(2)=irow;
+    in(3)=islot;
+    Int iant=antenna1(irow);
+    in(2)=iant;
+
+    if (iFit) (*iFit)(iant,islot) = fit(0,0,irow);
+    if (iFitwt) (*iFitwt)(iant,islot) = fitWt(0,0,irow);
+	
+    for (Int ichan=0; ichan<nChan_(spw); ichan++) {
+      out(1)=in(1)=ichan;
+      for (Int ipar=0; ipar<nPar_; ipar++) {
+	in(0)=out(0)=ipar;
+	par(in)=gain(out);
+	parOK(in) = (solOk(out) && !flag(out));
+	if (parSNR) (*parSNR)(in) = snr(out);
+      }
+    }
+  } // irow
+}
+
+template<class T> void CalSet<T>::fillAllPars()
+{
+  for (Int ispw=0; ispw<nSpw_; ispw++)
+    loadPars(ispw);
+}
+
 template<class T> void CalSet<T>::initCalTableDesc(const String& type, const Int& parType)
 {
   if (calTabDesc_) {delete calTabDesc_;calTabDesc_=NULL;}
@@ -543,6 +669,9 @@ template<class T> void CalSet<T>::store (const String& file,
   //    append         Bool          Append if true, else overwrite
   //
 
+  // Make sure all solutions are in memory
+  fillAllPars();
+
   // total rows to be written per Spw
   Vector<Int> nRow(nSpw_,0);
   for (Int iSpw=0;iSpw<nSpw_;iSpw++) 
@@ -851,6 +980,9 @@ template<class T> void CalSet<T>::store (const String& file,
   //    append         Bool          Append if true, else overwrite
   //
 
+  // Make sure all solutions are in memory
+  fillAllPars();
+
   // total rows to be written per Spw
   Vector<Int> nRow(nSpw_,0);
   for (Int iSpw=0;iSpw<nSpw_;iSpw++) 
@@ -33,6 +33,7 @@
 #include <measures/Measures/Stokes.h>
 #include <casa/Utilities/Regex.h>
 #include <casa/OS/HostInfo.h>
+#include <casa/OS/Memory.h>
 #include <flagging/Flagging/Flagger.h>
 #include <flagging/Flagging/RFAFlagExaminer.h>
 #include <flagging/Flagging/RFAMedianClip.h>
@@ -71,6 +72,9 @@
 #include <flagging/Flagging/RFANewMedianClip.h>
 
 #include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <sstream>
 
@@ -94,6 +98,8 @@ namespace casa {
     agents_p = NULL;
     agentCount_p=0;
     opts_p = NULL;
+    nthreads_p=0;
+    maxmem_p=0;
 
     logSink_p = LogSink(LogMessage::NORMAL, False);
     
@@ -121,6 +127,7 @@ namespace casa {
     agents_p = NULL;
     agentCount_p=0;
     opts_p = NULL;
+    nthreads_p=0;
     
     logSink_p = LogSink(LogMessage::NORMAL, False);
     
@@ -183,10 +190,12 @@ namespace casa {
 	rec.defineRecord(RF_GLOBAL, Record());
 	rec.define(RF_TRIAL, False);
 	rec.define(RF_RESET, False);
+	rec.define(RF_NTHREADS, 0);
 	
 	rec.setComment(RF_GLOBAL, "Record of global parameters applied to all methods");
 	rec.setComment(RF_TRIAL, "T for trial run (no flags written out)");
 	rec.setComment(RF_RESET, "T to reset existing flags before running");
+	rec.setComment(RF_NTHREADS, "Number of threads for agents iterating over rows in parallel, 0 for all cores");
       }
     return rec;
   }
@@ -1427,6 +1436,9 @@ namespace casa {
     *opts_p = defaultOptions();
     opts_p->define(RF_RESET,reset);
     opts_p->define(RF_TRIAL,trial);
+    opts_p->define(RF_NTHREADS,nthreads_p);
+    if (maxmem_p > 0)
+      opts_p->define("maxmem",maxmem_p);
     Record opt = *opts_p;
     
     if (!setdata_p) {
@@ -1452,6 +1464,12 @@ namespace casa {
     // reset existing flags?
     Bool reset_flags = isFieldSet(opt, RF_RESET);
 
+    // number of threads for agents iterating over rows in parallel
+#ifdef _OPENMP
+    if ( opt.isDefined(RF_NTHREADS) && opt.asInt(RF_NTHREADS) > 0 )
+      omp_set_num_threads(opt.asInt(RF_NTHREADS));
+#endif
+
     /* Don't use the progmeter if less than this
        number of timestamps (for performance reasons;
        just creating a ProgressMeter is relatively
@@ -1563,6 +1581,11 @@ namespace casa {
 
       Int64 inRowFlags=0, outRowFlags=0, totalRows=0, inDataFlags=0, outDataFlags=0, totalData=0;
 
+      // peak memory used by each agent and by the flag cube, in bytes
+      Vector<Double> agentPeakMem(acc.size(), 0.0);
+      Double flagPeakMem = 0;
+      Bool flagSpilled = False;
+
       for (vi.originChunks();
 	   vi.moreChunks(); 
 	   ) { //vi.nextChunk(), nchunk++) {
@@ -1583,15 +1606,32 @@ namespace casa {
 	  if ( debug_level>0 )
 	    dprintf(os,"%d MB memory available\n",availmem);
 
+	  // The flag cube may use up to half of the memory; if it needs more,
+	  // it is spilled to a scratch file.
+	  {
+	    Int flagmem = RFFlagCube::estimateMemoryUse(chunk, chunk.num(CORR)+acc.size());
+	    RFFlagCube::setMaxMem(availmem/2);
+	    availmem -= min(flagmem, availmem/2);
+	  }
+
 	  // call newChunk() for all accumulators; determine which ones are active
 	  Vector<Int> iter_mode(acc.size(),RFA::DATA);
 	  Vector<Bool> active(acc.size());
 	  
+	  Vector<Double> chunkMem(acc.size(), 0.0);
 	  for (uInt i = 0; i < acc.size(); i++)
 	    {
 	      Int maxmem;
 	      maxmem = availmem;
-	      if ( ! (active(i) = acc[i]->newChunk(maxmem))  ) // refused this chunk?
+	      // measure the memory allocated by the agent, not counting the
+	      // flag cube which is created by the first agent
+	      Double mem0 = Memory::allocatedMemoryInBytes();
+	      Double flag0 = RFFlagCube::spilled() ? 0 : RFFlagCube::peakMemoryUse();
+	      active(i) = acc[i]->newChunk(maxmem);
+	      Double flag1 = RFFlagCube::spilled() ? 0 : RFFlagCube::peakMemoryUse();
+	      chunkMem(i) = Memory::allocatedMemoryInBytes() - mem0 - (flag1 - flag0);
+	      agentPeakMem(i) = max(agentPeakMem(i), chunkMem(i));
+	      if ( ! active(i) ) // refused this chunk?
 		{
 		  iter_mode(i) = RFA::STOP;  // skip over it
 		}
@@ -1663,10 +1703,15 @@ namespace casa {
                   //cout << "-----------subtitle=" << subtitle << endl;
 		  for( uInt ival = 0; ival<acc.size(); ival++ ) 
 		    if ( active(ival) )
-		      if ( iter_mode(ival) == RFA::DATA )
-			acc[ival]->startData(new_field_spw);
-		      else if ( iter_mode(ival) == RFA::DRY )
-			acc[ival]->startDry(new_field_spw);
+		      {
+			Double mem0 = Memory::allocatedMemoryInBytes();
+			if ( iter_mode(ival) == RFA::DATA )
+			  acc[ival]->startData(new_field_spw);
+			else if ( iter_mode(ival) == RFA::DRY )
+			  acc[ival]->startDry(new_field_spw);
+			agentPeakMem(ival) = max(agentPeakMem(ival), chunkMem(ival) +
+						 Memory::allocatedMemoryInBytes() - mem0);
+		      }
 		  // iterate over visbuffers
 		  for( vi.origin(); vi.more() && nactive; vi++,itime++ ) {
 
@@ -1716,10 +1761,46 @@ namespace casa {
 			  }
 		      }
 
-		    // also iterate over rows for data passes
-		    for( Int ir=0; ir<vb.nRow() && ndata; ir++ ) {
-		      for( uInt ival = 0; ival<acc.size(); ival++ ) 
-			if ( iter_mode(ival) == RFA::DATA )
+		    // also iterate over rows for data passes. Within a time slot
+		    // each ifr occurs only once, and an agent only looks at the
+		    // flags of the ifr of the current row, so the agents can be
+		    // iterated over one after the other. Agents allowing it get
+		    // their rows in parallel, in blocks of RF_IFR_BLOCK ifrs.
+		    Bool anyParallel = False;
+		    for( uInt ival = 0; ival<acc.size(); ival++ )
+		      if ( iter_mode(ival) == RFA::DATA && acc[ival]->parallelRows() )
+			anyParallel = True;
+		    Int nblock = 0;
+		    Vector<Int> blockStart, blockRows;
+		    if ( anyParallel )
+		      {
+			// sort the rows by ifr block (counting sort)
+			nblock = (chunk.num(IFR) + RF_IFR_BLOCK - 1) / RF_IFR_BLOCK;
+			blockStart.resize(nblock+1);
+			blockStart = 0;
+			blockRows.resize(vb.nRow());
+			for( Int ir=0; ir<vb.nRow(); ir++ )
+			  blockStart(chunk.ifrNum(ir)/RF_IFR_BLOCK + 1)++;
+			for( Int ib=0; ib<nblock; ib++ )
+			  blockStart(ib+1) += blockStart(ib);
+			Vector<Int> fill(blockStart(Slice(0,nblock)).copy());
+			for( Int ir=0; ir<vb.nRow(); ir++ )
+			  blockRows(fill(chunk.ifrNum(ir)/RF_IFR_BLOCK)++) = ir;
+		      }
+		    for( uInt ival = 0; ival<acc.size() && ndata; ival++ ) 
+		      {
+			if ( iter_mode(ival) != RFA::DATA )
+			  continue;
+			if ( acc[ival]->parallelRows() )
+			  {
+			    RFABase *agent = acc[ival].get();
+#pragma omp parallel for schedule(dynamic)
+			    for( Int ib=0; ib<nblock; ib++ )
+			      for( Int i=blockStart(ib); i<blockStart(ib+1); i++ )
+				agent->iterRow(blockRows(i));
+			    continue;
+			  }
+			for( Int ir=0; ir<vb.nRow(); ir++ )
 			  {
 			    RFA::IterMode res = acc[ival]->iterRow(ir);
 			    if ( ! ( res == RFA::CONT || res == RFA::DATA ) )
@@ -1727,11 +1808,10 @@ namespace casa {
 				ndata--; nactive--;
 				iter_mode(ival) = res;
 				active(ival) = False;
-				if ( ndata <= 0 )
-				  break;
+				break;
 			      }
 			  }
-		    }
+		      }
                     
                     for( uInt ival = 0; ival<acc.size(); ival++ ) {
                         if ( active(ival) ) {
@@ -1866,6 +1946,9 @@ namespace casa {
 
       end_of_loop:
 
+	  flagPeakMem = max(flagPeakMem, Double(RFFlagCube::peakMemoryUse()));
+	  flagSpilled = flagSpilled || RFFlagCube::spilled();
+
 	  // call endChunk on all agents
 	  for( uInt i = 0; i<acc.size(); i++ ) 
 	    acc[i]->endChunk();
@@ -1916,6 +1999,17 @@ namespace casa {
 
       } // end loop over chunks
       
+      // report the memory used
+      for (uInt i = 0; i < acc.size(); i++) {
+        os << LogIO::NORMAL << acc[i]->name() << ": peak memory "
+           << agentPeakMem(i)/(1024*1024) << " MB" << LogIO::POST;
+      }
+      if (flagPeakMem > 0) {
+        os << LogIO::NORMAL << "Flag cube: peak memory "
+           << flagPeakMem/(1024*1024) << " MB"
+           << (flagSpilled ? " (spilled to scratch file)" : "") << LogIO::POST;
+      }
+
       // get results for all agents
       // (gets just last agent; doesn't work for multiple agents, 
       // but only used in mode summary)
@@ -207,6 +207,15 @@ public:
   
   Record run(Bool trial, Bool reset);    
 
+  // Sets the number of threads used by agents that can iterate over
+  // the rows of a time slot in parallel (0 means all available cores).
+  void setnthreads(Int nthreads) { nthreads_p = nthreads; }
+
+  // Sets the memory limit (in MB) for the flag cube and the agents, 0 to
+  // use all of the memory of the host. A flag cube not fitting in half of
+  // the limit is spilled to a scratch file.
+  void setmaxmem(Int maxmem) { maxmem_p = maxmem; }
+
   void summary ( const RecordInterface &agents ); 
 
     // flag version support.
@@ -288,6 +297,12 @@ private:
   // List of extra options
   Record *opts_p;
 
+  // Number of threads for parallel row iteration
+  Int nthreads_p;
+
+  // Memory limit in MB, 0 if not set
+  Int maxmem_p;
+
   // Debug Message flag
   static const bool dbg;
 
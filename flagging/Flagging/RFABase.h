@@ -134,6 +134,14 @@ virtual void endRows(uInt /* itime */) {};
 // at least for data iterations.
   virtual IterMode iterRow  ( uInt /* irow */ ) { return CONT; };
 
+// Returns True if iterRow() may be called concurrently for rows belonging
+// to different ifrs. Flagger::run() then spreads the rows of a time slot
+// over multiple threads (in blocks of RF_IFR_BLOCK ifrs, so that no two
+// threads touch the same word of the flag cube). An agent doing so must
+// keep all per-row scratch state per ifr, and must not change its
+// iteration mode from iterRow().
+  virtual Bool parallelRows () { return False; };
+
 // Iteration method for a dry pass. Called once per each time slot.
 // Return value: STOP to finish iterating, CONT/DRY to continue, or DATA
 // to cancel the dry pass and request another data pass.
@@ -132,7 +132,8 @@ Bool RFADiffBase::newChunk (Int &maxmem)
   diff.init(num(CHAN),num(IFR),num(TIME),num(CORR), nAgent, mmdiff,2);
 // init the row-clipper object
   rowclipper.init(num(IFR),num(TIME));
-  diffrow.resize(num(CHAN));
+  diffrow.resize(num(CHAN),num(IFR));
+  idiffrow.resize(num(IFR));
   
 // if rows are too short, there's no point in flagging them in toto 
 // based on their noise level
@@ -153,6 +154,7 @@ void RFADiffBase::endChunk ()
   diff.cleanup();
   rowclipper.cleanup();
   diffrow.resize();
+  idiffrow.resize();
 }
 
 // -----------------------------------------------------------------------
@@ -209,7 +211,8 @@ RFA::IterMode RFADiffBase::iterDry ( uInt it )
       continue;
     }
     Float thr = clip_level*rowclipper.sigma0(ifr,it);
-    idiffrow=0;
+    Int &nd = idiffrow(ifr);
+    nd=0;
     Bool updated=False;
     for( uInt ich=0; ich<num(CHAN); ich++ ) // loop over channels
     {
@@ -224,12 +227,12 @@ RFA::IterMode RFADiffBase::iterDry ( uInt it )
       }
       else
       {
-        diffrow(idiffrow++) = d;
+        diffrow(nd++,ifr) = d;
       }
     } // for(ich)
     // update the noise level, if any changes in flags
     if( updated ) 
-      rowclipper.setSigma(ifr,it,idiffrow ? median( diffrow(Slice(0,idiffrow)) ) : -1 );
+      rowclipper.setSigma(ifr,it,nd ? median( diffrow.column(ifr)(Slice(0,nd)) ) : -1 );
   } // for(ifr)
   return CONT;
 }
@@ -267,16 +270,19 @@ RFA::IterMode RFADiffBase::endDry ()
   return RFA::DRY;
 }
 
-void RFADiffBase::startDataRow (uInt)
+// The row scratch state is kept per ifr, so that rows of different
+// ifrs can be processed concurrently (see RFABase::parallelRows()).
+void RFADiffBase::startDataRow (uInt ifr)
 {
-  idiffrow=0;
+  idiffrow(ifr)=0;
 }
 
 void RFADiffBase::endDataRow (uInt ifr)
 {
 //  if( !idiffrow )
 //    dprintf(os,"No data points at ifr %d\n",ifr);
-  Float sigma = idiffrow ? median( diffrow( Slice(0,idiffrow) ) ) : -1;
+  Int nd = idiffrow(ifr);
+  Float sigma = nd ? median( diffrow.column(ifr)( Slice(0,nd) ) ) : -1;
   uInt it = diff.position();
   rowclipper.setSigma(ifr,it,sigma);
 }
@@ -312,7 +318,7 @@ Float RFADiffBase::setDiff ( uInt ich,uInt ifr,Float d,Bool &flagged )
     }
   }
   if( !flagged )
-    diffrow(idiffrow++) = d;
+    diffrow(idiffrow(ifr)++,ifr) = d;
   
   return thr;
 }
@@ -121,8 +121,8 @@ protected:
   FlagCubeIterator *     pflagiter; // flag iterator used by setDiff()
   RFRowClipper          rowclipper;
   
-  Vector<Float> diffrow;   // one row of deviations, for noise computations
-  int idiffrow;
+  Matrix<Float> diffrow;   // one row of deviations per ifr, for noise computations
+  Vector<Int> idiffrow;    // number of deviations in diffrow, per ifr
 
   Matrix<Float> sig;       // current noise estimate for (it,ifr)
   Matrix<Float> sig0;      // reference estimate (boxcar average from previous pass)
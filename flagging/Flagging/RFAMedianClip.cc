@@ -58,7 +58,7 @@ RFATimeMedian::RFATimeMedian( RFChunkStats &ch,const RecordInterface &parm ) :
 
 RFATimeMedian::~RFATimeMedian ()
 {
-  if( msl ) delete [] msl;
+  RFSlidingMedians::release(msl);
 }
 
 const RecordInterface & RFATimeMedian::getDefaults ()
@@ -87,11 +87,16 @@ Bool RFATimeMedian::newChunk (Int &maxmem)
     return active=False;
   }
   maxmem -= 2; 
-// reserve memory for our bunch of median sliders
-  maxmem -= (num(CHAN)*num(IFR)*MedianSlider::objsize(halfwin))/(1024*1024)+1;
+// reserve memory for the time window, as far as other agents sharing it
+// did not already
+  String key = RFSlidingMedians::makeKey(chunk,RFDataMapper::description(),
+                 RFDataMapper::corrMask(chunk.visIter()),
+                 isFieldSet(params,RF_FIGNORE),isFieldSet(params,RF_RESET));
+  maxmem -= RFSlidingMedians::extraMemoryUse(key,num(CHAN),num(IFR),2*halfwin+1)/(1024*1024)+1;
 // call parent's newChunk  
   if( !RFADiffMapBase::newChunk(maxmem) )
     return active=False;
+  msl = RFSlidingMedians::acquire(key,num(CHAN),num(IFR),2*halfwin+1);
 // create local flag iterator
   flag_iter = flag.newCustomIter();
   pflagiter = &flag_iter;
@@ -103,23 +108,17 @@ void RFATimeMedian::endChunk ()
   RFADiffMapBase::endChunk();
 // create local flag iterator
   flag_iter = FlagCubeIterator();
-  if( msl ) delete [] msl;
+  RFSlidingMedians::release(msl);
   msl = NULL;
 }
 
 // startData
-// create new median sliders at start of data pass
+// clear the time window at start of data pass
 void RFATimeMedian::startData (bool verbose)
 {
   RFADiffMapBase::startData(verbose);
   flag_iter.reset();
-  if( msl ) delete [] msl;
-// this is a workaround for a compiler bug that we occasionally see
-  uInt tmpnum2 = num(CHAN)*num(IFR);
-// create nchan x nifr median sliders
-  msl = new MedianSlider[tmpnum2];
-  for(uInt i=0; i<num(CHAN)*num(IFR); i++)
-     msl[i] = MedianSlider(halfwin);
+  msl->startPass(chunk.npass());
 }
 
 // iterTime
@@ -150,17 +149,16 @@ RFA::IterMode RFATimeMedian::iterRow ( uInt irow )
   uInt iifr = chunk.ifrNum(irow);
   uInt it = chunk.iTime();
   Bool fill = ( chunk.iTime() >= (Int)halfwin );
+  // the row may already have been stored by an agent sharing the window
+  Bool update = msl->needStep(iifr,it);
   Bool rowfl = chunk.npass() ? flag.rowFlagged(iifr,it) 
                             : flag.rowPreFlagged(iifr,it);
-  if( rowfl ) 
-  {
-    // the whole row is flagged, so just advance all median sliders
-    for( uInt i=0; i<num(CHAN); i++ ) 
-      slider(i,iifr).next();
-  } 
-  else 
+  // the whole row is flagged: it is stored as flagged by needStep
+  if( !rowfl ) 
   {
     startDataRow(iifr);
+    std::vector<Float> work;
+    work.reserve(2*halfwin+1);
     // loop over channels for this spw, ifr
     for( uInt ich=0; ich<num(CHAN); ich++ )
     {
@@ -168,19 +166,18 @@ RFA::IterMode RFATimeMedian::iterRow ( uInt irow )
       Float val = 0;
 // during first pass, look at pre-flags only. During subsequent passes,
 // look at all flags
-      Bool fl = chunk.npass() ? flag.anyFlagged(ich,iifr) : flag.preFlagged(ich,iifr);
-      if( fl )
-      {
-      }
-      else
+      Bool fl = False;
+      if( update )
       {
-        val = mapValue(ich,irow);
+        fl = chunk.npass() ? flag.anyFlagged(ich,iifr) : flag.preFlagged(ich,iifr);
+        if( !fl )
+          val = mapValue(ich,irow);
+        msl->set( ich,iifr,val,fl ); 
       }
-      slider(ich,iifr).add( val,fl ); 
       // are we filling in the diff-median lattice already?
       if( fill )
       {
-        Float d = slider(ich,iifr).diff(fl);
+        Float d = msl->diff(ich,iifr,it-halfwin,halfwin,fl,work);
         if( !fl )  // ignore if flagged
           setDiff( ich,iifr,d );
       }
@@ -196,17 +193,19 @@ RFA::IterMode RFATimeMedian::iterRow ( uInt irow )
 // -----------------------------------------------------------------------
 RFA::IterMode RFATimeMedian::endData ()
 {
+  std::vector<Float> work;
+  work.reserve(2*halfwin+1);
   for( uInt it=num(TIME)-halfwin; it<num(TIME); it++ )
   {
     diff.advance(it);
     for( uInt i = 0; i<num(IFR); i++ )
     {
+      // the window is cut off at the last time slot
       startDataRow(i);
       for( uInt j = 0; j<num(CHAN); j++ )
       {
-        slider(j,i).next();
         Bool fl;
-        Float diff = slider(j,i).diff(fl);
+        Float diff = msl->diff(j,i,it,halfwin,fl,work);
         if( !fl )
           setDiff(j,i,diff);
         
@@ -214,12 +213,6 @@ RFA::IterMode RFATimeMedian::endData ()
       endDataRow(i);
     }
   }
-// destroy sliders
-  if( msl ) 
-  {
-    delete [] msl;
-    msl = NULL;
-  }
   return RFADiffMapBase::endData();
 }
 
@@ -28,6 +28,7 @@
 #define FLAGGING_RFAMEDIANCLIP_H
 
 #include <flagging/Flagging/RFADiffBase.h> 
+#include <flagging/Flagging/RFSlidingMedians.h> 
 #include <scimath/Mathematics/MedianSlider.h> 
 
 namespace casa { //# NAMESPACE CASA - BEGIN
@@ -42,14 +43,16 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 // </reviewed>
 
 // <prerequisite>
-//   <li> MedianSlider
+//   <li> RFSlidingMedians
 //   <li> RFADiffMapBase
 // </prerequisite>
 //
 // <synopsis>
 // RFATimeMedian computes a sliding median of some quantity (as established
 // in RFADiffMapbase) over time, per each channel. Deviation w/respect to
-// the median is passed to RFADiffBase for the actual flagging.
+// the median is passed to RFADiffBase for the actual flagging. The values
+// are kept in an RFSlidingMedians, shared with the other median agents
+// flagging the same quantity.
 // </synopsis>
 //
 // <todo asof="2001/04/16">
@@ -69,26 +72,22 @@ public:
   virtual void startData (bool verbose);
   virtual IterMode iterTime (uInt itime);
   virtual IterMode iterRow  (uInt irow);
+  virtual Bool parallelRows () { return True; }
   virtual IterMode endData  ();
   virtual String getDesc ();
   static const RecordInterface & getDefaults ();
 
 protected:
   uInt itime;  
-  MedianSlider & slider (uInt ich,uInt ifr);
 
   FlagCubeIterator flag_iter;
   
   uInt halfwin;
-  MedianSlider *msl;
+  // time window of the values, possibly shared with other agents
+  RFSlidingMedians *msl;
   
 };
 
-inline MedianSlider & RFATimeMedian::slider (uInt ich,uInt ifr)
-{
-  return msl[ ifr*num(CHAN) + ich ];
-}
-
 
 // <summary>
 // RFAFreqMedian: RedFlagger Agent for clipping relative to median over frequency
@@ -124,6 +123,7 @@ public:
 
   virtual Bool newChunk (Int &maxmem);
   virtual RFA::IterMode iterRow (uInt irow);
+  virtual Bool parallelRows () { return True; }
   virtual String getDesc ();
   static const RecordInterface & getDefaults ();
 
@@ -48,7 +48,7 @@ RFANewMedianClip::RFANewMedianClip( RFChunkStats &ch,const RecordInterface &parm
 
 RFANewMedianClip::~RFANewMedianClip ()
 {
-  if( msl ) delete [] msl;
+  RFSlidingMedians::release(msl);
 }
 
 uInt RFANewMedianClip::estimateMemoryUse () 
@@ -91,9 +91,11 @@ Bool RFANewMedianClip::newChunk (Int &maxmem)
   }
 
   maxmem -= 2; 
-  uInt halfwin = num(TIME)/2;
-  // reserve memory for our bunch of median sliders
-  maxmem -= (num(CHAN)*num(IFR)*MedianSlider::objsize(halfwin))/(1024*1024)+1;
+  // reserve memory for a time window of the whole chunk, as far as other
+  // agents sharing it did not already
+  String key = RFSlidingMedians::makeKey(chunk,RFDataMapper::description(),corrmask,
+                 isFieldSet(params,RF_FIGNORE),isFieldSet(params,RF_RESET));
+  maxmem -= RFSlidingMedians::extraMemoryUse(key,num(CHAN),num(IFR),num(TIME))/(1024*1024)+1;
 
   Int mmdiff = (Int)(1.05*evalue.estimateMemoryUse(num(CHAN),num(IFR),num(TIME))); // sufficient memory? reserve it
   if( maxmem>mmdiff ) 
@@ -114,6 +116,11 @@ Bool RFANewMedianClip::newChunk (Int &maxmem)
   stdev.resize(num(CHAN), num(IFR));
   stdev.set(0);
   stdeved = False;
+  medians.resize(num(CHAN), num(IFR));
+  medians.set(0);
+  nvals.resize(num(CHAN), num(IFR));
+  nvals.set(0);
+  msl = RFSlidingMedians::acquire(key,num(CHAN),num(IFR),num(TIME));
   // create local flag iterator
   flag_iter = flag.newCustomIter();
   pflagiter = &flag_iter;
@@ -127,12 +134,12 @@ void RFANewMedianClip::endChunk ()
   RFAFlagCubeBase::endChunk();
 // create local flag iterator
   flag_iter = FlagCubeIterator();
-  if( msl ) delete [] msl;
+  RFSlidingMedians::release(msl);
   msl = NULL;
 }
 
 // startData
-// create new median sliders at start of data pass
+// clear the time window at start of data pass
 void RFANewMedianClip::startData (bool verbose)
 {
   //new added
@@ -142,16 +149,9 @@ void RFANewMedianClip::startData (bool verbose)
   flag_iter.reset();
 
   pflagiter = &flag.iterator();
-  if( msl ) delete [] msl;
   globalsigma = 0;
-  // this is a workaround for a compiler bug that we occasionally see
-  uInt tmpnum2 = num(CHAN)*num(IFR);
-  uInt halfwin = num(TIME)/2;
-  // create nchan x nifr median sliders
-  msl = new MedianSlider[tmpnum2];
-  for(uInt i=0; i<num(CHAN)*num(IFR); i++)
-    msl[i] = MedianSlider(halfwin);
-  globalmed = MedianSlider(tmpnum2);
+  msl->startPass(chunk.npass());
+  globalmed = MedianSlider(num(CHAN)*num(IFR));
 }
 
 // iterTime
@@ -177,22 +177,25 @@ RFA::IterMode RFANewMedianClip::iterRow ( uInt irow )
   uInt it = chunk.iTime();
   Float val = 0;
 
+  // the row may already have been stored by an agent sharing the window
+  Bool update = msl->needStep(iifr,it);
   Bool rowfl = chunk.npass() ? flag.rowFlagged(iifr,it) 
                             : flag.rowPreFlagged(iifr,it);
-  if( rowfl ) {
-    // the whole row is flagged, so just advance all median sliders
-    for( uInt i=0; i<num(CHAN); i++ ) 
-      slider(i,iifr).next();
-  } 
-  else {
+  // the whole row is flagged: it is stored as flagged by needStep
+  if( !rowfl ) {
     // loop over channels for this spw, ifr
     for( uInt ich=0; ich<num(CHAN); ich++ )
       {
-	// during first pass, look at pre-flags only. During subsequent passes,
-	// look at all flags
-	Bool fl = chunk.npass() ? flag.anyFlagged(ich,iifr) : flag.preFlagged(ich,iifr);
-	val = mapValue(ich,irow);
-	slider(ich,iifr).add( val,fl ); 
+	Bool fl;
+	if( update ) {
+	  // during first pass, look at pre-flags only. During subsequent passes,
+	  // look at all flags
+	  fl = chunk.npass() ? flag.anyFlagged(ich,iifr) : flag.preFlagged(ich,iifr);
+	  val = fl ? 0 : mapValue(ich,irow);
+	  msl->set( ich,iifr,val,fl ); 
+	} else {
+	  val = msl->value( ich,iifr,it,fl );
+	}
 	if( !fl ) {	
 	  evalue(ich,iifr) = val;
 	}
@@ -209,6 +212,13 @@ RFA::IterMode RFANewMedianClip::iterRow ( uInt irow )
 RFA::IterMode RFANewMedianClip::endData ()
 {
   RFAFlagCubeBase::endData();
+  // take the medians over the chunk, before another agent clears the
+  // window for its next data pass
+  std::vector<Float> work;
+  work.reserve(num(TIME));
+  for( uInt ifr=0; ifr<num(IFR); ifr++ )
+    for( uInt ich=0; ich<num(CHAN); ich++ )
+      medians(ich,ifr) = msl->median(ich,ifr,0,num(TIME)-1,nvals(ich,ifr),work);
   return RFA::DRY;
 }
 
@@ -297,7 +307,7 @@ RFA::IterMode RFANewMedianClip::iterDry ( uInt it )
 	  {
 	    Bool fl = flag.anyFlagged(ich, ifr);
 	    if(!fl) {
-	      Float diff = evalue(ich,ifr) - slider(ich,ifr).median();
+	      Float diff = evalue(ich,ifr) - medians(ich,ifr);
 	      stdev(ich, ifr) += diff * diff;
 	    }
 	  }
@@ -318,11 +328,11 @@ RFA::IterMode RFANewMedianClip::endDry ()
     {
       for( uInt ich=0; ich<num(CHAN); ich++ ) // loop over channels
 	{
-	  if(slider(ich, ifr).nval()){
-	    stdev(ich, ifr) /= slider(ich, ifr).nval();
+	  if(nvals(ich, ifr)){
+	    stdev(ich, ifr) /= nvals(ich, ifr);
 	    //	  cout << "variance " << stdev(ich, ifr) << endl;
 	    stdev(ich, ifr) = sqrt(stdev(ich, ifr));
-	    globalmed.add(slider(ich, ifr).median(), dummy);
+	    globalmed.add(medians(ich, ifr), dummy);
 	  } else {
 	    stdev(ich, ifr) = 0;
 	  }
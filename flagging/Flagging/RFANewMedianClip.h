@@ -32,6 +32,7 @@
 #include <flagging/Flagging/RFFlagCube.h> 
 #include <flagging/Flagging/RFFloatLattice.h> 
 #include <flagging/Flagging/RFRowClipper.h> 
+#include <flagging/Flagging/RFSlidingMedians.h> 
 #include <scimath/Mathematics/MedianSlider.h> 
 
 namespace casa { //# NAMESPACE CASA - BEGIN
@@ -46,14 +47,16 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 // </reviewed>
 
 // <prerequisite>
-//   <li> MedianSlider
+//   <li> RFSlidingMedians
 //   <li> RFAFlagCubeBase
 // </prerequisite>
 //
 // <synopsis>
 // RFANewMedianClip computes a median of some quantity over time slots, 
 // per each channel. Deviation w/respect to the median is computed for 
-// the actual flagging.
+// the actual flagging. The values are kept in an RFSlidingMedians holding
+// the whole chunk, shared with the other median agents flagging the same
+// quantity. The medians are taken from it at the end of the data pass.
 // </synopsis>
 //
 // <todo asof="2004/04/21">
@@ -83,14 +86,17 @@ public:
   static const RecordInterface & getDefaults ();
 
 protected:
-  MedianSlider & slider (uInt ich,uInt ifr);
   MedianSlider globalmed;
 
   FlagCubeIterator * pflagiter; 
   FlagCubeIterator flag_iter;
   Double  threshold;  
 
-  MedianSlider * msl;
+  // time window of the values, possibly shared with other agents
+  RFSlidingMedians * msl;
+  // median over the chunk and number of unflagged values [NCH,NIFR]
+  Matrix<Float> medians;
+  Matrix<uInt> nvals;
 
   // lattice of evaluated values [NCH,NIFR,NTIME]
   RFFloatLattice evalue;
@@ -101,12 +107,6 @@ protected:
 };
 
 
-inline MedianSlider & RFANewMedianClip::slider (uInt ich,uInt ifr)
-{
-  return msl[ ifr*num(CHAN) + ich ];
-}
-
-
 } //# NAMESPACE CASA - END
 
 #endif
@@ -53,6 +53,7 @@ const char
     RF_TRIAL[]   = "trial",
 
     RF_RESET[]   = "reset",
+    RF_NTHREADS[] = "nthreads",
     RF_FIGNORE[] = "fignore",
     RF_UNFLAG[]  = "unflag",
     RF_SHADOW[]  = "shadow",
@@ -112,6 +113,11 @@ const char
     RF_MODE[] = "mode",
     RF_MSSELECT[] = "msselect";
 
+// Number of ifrs handled by one thread when an agent iterates over rows in
+// parallel. The flag cube stores n_bit*n_chan bits per ifr in consecutive
+// 64-bit words, so a block of 64 ifrs always starts on a word boundary.
+const uInt RF_IFR_BLOCK = 64;
+
 // <summary>
 // FlaggerEnums: collection of enums for various flagger classes
 // </summary>
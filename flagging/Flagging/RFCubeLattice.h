@@ -30,8 +30,7 @@
 #include <casa/Arrays/Matrix.h> 
 #include <lattices/Lattices/TempLattice.h> 
 #include <lattices/Lattices/LatticeIterator.h> 
-#include <boost/dynamic_bitset.hpp>
-#include <vector>
+#include <flagging/Flagging/RFMappedBuffer.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -46,7 +45,7 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 // </reviewed>
 
 // <prerequisite>
-//   <li> std::vector, Matrix
+//   <li> RFMappedBuffer, Matrix
 // </prerequisite>
 //
 // <synopsis>
@@ -69,20 +68,34 @@ class RFCubeLattice;
 template<class T> class RFCubeLatticeIterator
 {
   private:
-    std::vector<boost::dynamic_bitset<> > *lattice;
+    RFMappedBuffer *lattice;
 
     unsigned int iter_pos;   // current time
 
     unsigned n_chan, n_ifr, n_time, n_bit, n_corr;
 
     void update_curs();
+
+    typedef RFMappedBuffer::Word Word;
+    static const uInt WordBits = RFMappedBuffer::WordBits;
+
+    // bit access in the current time slot
+    const Word * cursor () const
+      { return lattice->slot(iter_pos); }
+    Word * cursor ()
+      { return lattice->slot(iter_pos); }
+    static bool getBit ( const Word *w,unsigned indx )
+      { return (w[indx/WordBits] >> (indx%WordBits)) & 1; }
+    static void setBit ( Word *w,unsigned indx,bool val )
+      { if( val ) w[indx/WordBits] |= Word(1) << (indx%WordBits);
+        else      w[indx/WordBits] &= ~(Word(1) << (indx%WordBits)); }
   
   public:
     // default constructor creates empty iterator
     RFCubeLatticeIterator();
     
     // creates and attaches to lattice
-    RFCubeLatticeIterator(std::vector<boost::dynamic_bitset<> > *lat, 
+    RFCubeLatticeIterator(RFMappedBuffer *lat, 
 			  unsigned nchan, unsigned nifr, 
 			  unsigned ntime, unsigned nbit, unsigned ncorr);
     
@@ -125,22 +138,19 @@ template<class T> class RFCubeLatticeIterator
 // <synopsis>
 // RFCubeLattice is a [NX,NY,NZ] vector of Matrices which 
 // is iterated over the Z axis. 
-// While a vector of Matrices may not be localized in memory, it has the
-// advantage that the total amount of memory allocated can exceed
-// the available RAM, which is probably not possible if allocated as a
-// single giant block.
 // Each element of the matrices is a few bits, therefore (in order to
 // save memory), the full matrix is represented as a bitsequence, which
 // is converted to Matrix<T> on the fly.
 //
 // The buffer is no longer implemented using a TempLattice because the
-// template parameter to TempLattice is restricted to certain types, and
-// cannot be boost::dynamic_bitset<>. Besides, TempLattice is currently(?)
-// *not* well implemented: it creates TempLattice disk files although most
-// of the RAM is free.
+// template parameter to TempLattice is restricted to certain types.
+// Besides, TempLattice is currently(?) *not* well implemented: it creates
+// TempLattice disk files although most of the RAM is free.
 //
-// If more memory than avilable RAM is requested, swapping will occur.
-// The underlying OS probably knows better when to swap!
+// The bit sequences of all time slots are kept in an RFMappedBuffer. If
+// a memory limit is given and the cube does not fit in it, the buffer is
+// a mapping of a scratch file, and only the time slots most recently
+// visited by an iterator are kept in memory.
 //
 // </synopsis>
 //
@@ -164,7 +174,7 @@ template<class T> class RFCubeLattice
 {
 protected:
   IPosition                              lat_shape;
-  std::vector<boost::dynamic_bitset<> >  lat;
+  RFMappedBuffer                         lat;
   RFCubeLatticeIterator<T>               iter;
   unsigned n_chan, n_ifr, n_time, n_bit, n_corr;
 
@@ -179,16 +189,25 @@ public:
   ~RFCubeLattice();
 
 // creates NX x NY x NZ cube
-// tile_mb is the tile size, in MB (when using paging)
-  void init ( uInt nx,uInt ny,uInt nz, uInt ncorr, uInt nAgent );
-// creates NX x NY x NZ cube and fills with initial value
-// tile_mb is the tile size, in MB (when using paging)
-  void init ( uInt nx,uInt ny,uInt nz, uInt ncorr, uInt nAgent, const T &init_val );
+  void init ( uInt nx,uInt ny,uInt nz, uInt ncorr, uInt nAgent, Int maxmem_mb = 0 );
+// creates NX x NY x NZ cube and fills with initial value.
+// If the cube is larger than maxmem_mb (if >0), it is spilled to a
+// scratch file and only part of it is kept in memory.
+  void init ( uInt nx,uInt ny,uInt nz, uInt ncorr, uInt nAgent, const T &init_val,
+              Int maxmem_mb = 0 );
 // destroys cube
   void cleanup ();
-// returns size of cube
+// returns size of cube, in MB
   static uInt estimateMemoryUse ( uInt nx,uInt ny,uInt nz )
         { return nx*ny*nz*sizeof(T)/(1024*1024) + 1; }
+// returns size of cube with nbit bits per element, in MB
+  static uInt estimateMemoryUse ( uInt nx,uInt ny,uInt nz,uInt nbit )
+        { return uInt( (Double(nx)*ny*nbit/8 + sizeof(RFMappedBuffer::Word))*nz/(1024*1024) ) + 1; }
+
+// tells if the cube is spilled to a scratch file
+  Bool spilled () const     { return lat.spilled(); }
+// returns the largest amount of memory (in bytes) used by the cube
+  size_t peakMemoryUse () const { return lat.peakResident(); }
 
 // resets the lattice iterator to beginning. 
   //Matrix<T> * reset( Bool will_read=True,
@@ -218,7 +237,7 @@ public:
   void set_column( uInt ifr, const T &val );
 
 // provides access to lattice itself  
-//  std::vector<boost::dynamic_bitset<> > & lattice()    { return lat; }
+//  RFMappedBuffer & lattice()    { return lat; }
 
 // provides access to iterator  
   RFCubeLatticeIterator<T> & iterator()    { return iter; }
@@ -26,6 +26,7 @@
 //# $Id$
 #include <lattices/Lattices/LatticeStepper.h>
 #include <flagging/Flagging/RFCubeLattice.h>
+#include <string.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -37,7 +38,7 @@ template<class T> RFCubeLatticeIterator<T>::RFCubeLatticeIterator ()
   lattice = NULL;
 }
 
- template<class T> RFCubeLatticeIterator<T>::RFCubeLatticeIterator(std::vector<boost::dynamic_bitset<> > *lat,
+ template<class T> RFCubeLatticeIterator<T>::RFCubeLatticeIterator(RFMappedBuffer *lat,
 								   unsigned nchan, unsigned nifr, 
 								   unsigned ntime, unsigned nbit,
 								   unsigned ncorr)
@@ -75,6 +76,8 @@ template<class T> void RFCubeLatticeIterator<T>::reset()
 template<class T> void RFCubeLatticeIterator<T>::advance(uInt t1)
 {
   iter_pos = t1;
+  if (lattice != NULL)
+    lattice->touch(iter_pos);
   return;
 }
 
@@ -83,23 +86,23 @@ RFCubeLatticeIterator<T>::operator()(uInt chan, uInt ifr) const
 { 
     T val = 0;
     
-    boost::dynamic_bitset<> &l = (*lattice)[iter_pos];
+    const Word *l = cursor();
 
     if (n_bit == 2) {
         unsigned indx = n_bit*(chan + n_chan*ifr);
-        val = l[indx] + 4*l[indx+1];
+        val = getBit(l, indx) + 4*getBit(l, indx+1);
     }
     else if (n_corr <= 1) {
       /* write corr0 */
       unsigned indx = 0 + n_bit*(chan + n_chan*ifr);
-      if (l[indx]) {
+      if (getBit(l, indx)) {
         val |= 1;
       }
       
       /* write agents starting from b[2] */
       for (unsigned b = 1; b < n_bit; b++) {
         indx++;
-        if (l[indx]) {
+        if (getBit(l, indx)) {
           val |= 1 << (b+1);
         }
       }
@@ -107,7 +110,7 @@ RFCubeLatticeIterator<T>::operator()(uInt chan, uInt ifr) const
     else {
       unsigned indx = n_bit*(chan + n_chan*ifr);
       for (unsigned b = 0; b < n_bit; b++) {
-        if (l[indx++]) {
+        if (getBit(l, indx++)) {
           val |= 1 << b;
         }
       }
@@ -119,26 +122,26 @@ RFCubeLatticeIterator<T>::operator()(uInt chan, uInt ifr) const
 template<class T> void 
 RFCubeLatticeIterator<T>::set( uInt chan, uInt ifr, const T &val )
 {
-    boost::dynamic_bitset<> &l = (*lattice)[iter_pos];
+    Word *l = cursor();
 
     if (n_bit == 2) {
       unsigned indx = n_bit*(chan + n_chan*ifr);
-      l[indx] = val & 1;
-      l[indx+1] = val & 4;
+      setBit(l, indx, val & 1);
+      setBit(l, indx+1, val & 4);
     }
     else if (n_corr <= 1) {
       unsigned indx = 0 + n_bit*(chan + n_chan*ifr);
-      l[indx] = val & 1;
+      setBit(l, indx, val & 1);
       
       for (unsigned b = 1; b < n_bit; b++) {
 	indx++;
-	l[indx] = val & (1<<(b+1));
+	setBit(l, indx, val & (1<<(b+1)));
       }
     }
     else {
       unsigned indx = n_bit*(chan + n_chan*ifr);
       for (unsigned b = 0; b < n_bit; b++) {
-	l[indx++] = val & (1<<b);
+	setBit(l, indx++, val & (1<<b));
       }
     }
     
@@ -152,11 +155,9 @@ RFCubeLatticeIterator<T>::set( uInt ichan,
                                uInt icorr, 
                                bool val)
 {
-  boost::dynamic_bitset<> &l = (*lattice)[iter_pos];
-
   unsigned indx = icorr + n_bit*(ichan + n_chan*ifr);
     
-  l[indx] = val;
+  setBit(cursor(), indx, val);
   
   return;
 }
@@ -195,7 +196,8 @@ RFCubeLattice<T>::init(uInt nchan,
                        uInt nifr,
                        uInt ntime,
 		       uInt ncorr,
-		       uInt nAgent)
+		       uInt nAgent,
+		       Int maxmem_mb)
 {
   n_bit = ncorr + nAgent;
 
@@ -210,10 +212,9 @@ RFCubeLattice<T>::init(uInt nchan,
 
   lat_shape = IPosition(3, nchan, nifr, ntime);
 
-  lat = std::vector<boost::dynamic_bitset<> >(ntime);
-  for (unsigned i = 0; i < ntime; i++) {
-    lat[i] = boost::dynamic_bitset<>(nchan * nifr * (ncorr+nAgent));
-  }
+  size_t nbits = size_t(nchan) * nifr * (ncorr+nAgent);
+  size_t nwords = (nbits + RFMappedBuffer::WordBits - 1) / RFMappedBuffer::WordBits;
+  lat.init(ntime, nwords, maxmem_mb > 0 ? size_t(maxmem_mb)*1024*1024 : 0);
 
   iter = RFCubeLatticeIterator<T>(&lat, nchan, nifr, ntime, ncorr+nAgent, ncorr);
 }
@@ -228,52 +229,36 @@ template<class T> void RFCubeLattice<T>::init(uInt nchan,
                                               uInt ntime,
 					      uInt ncorr,
 					      uInt nAgent,
-                                              const T &init_val)
+                                              const T &init_val,
+                                              Int maxmem_mb)
 {
   n_chan = nchan;
   n_ifr = nifr;
   n_time = ntime;
   n_bit = ncorr + nAgent;
   n_corr = ncorr;
-  init(nchan, nifr, ntime, ncorr, nAgent);
-
-  uInt nbits = ncorr + nAgent;
+  init(nchan, nifr, ntime, ncorr, nAgent, maxmem_mb);
+  if (ntime == 0) {
+    return;
+  }
 
-  /* Write init_val to every matrix element.
+  /* Write init_val to every matrix element of the first time slot,
+     and copy that to the other time slots.
      See above for description of format */
-  boost::dynamic_bitset<> val((int)(nbits+1), (unsigned) init_val);
-  for (unsigned i = 0; i < ntime; i++) {
-    if (n_bit == 2) {
-        unsigned indx = 0;
-        bool v0 = val[0];
-        bool v2 = val[2];
-        while (indx < 2*n_chan*n_ifr) {
-          lat[i][indx++] = v0;
-          lat[i][indx++] = v2;
-        } 
-    } 
-    else {
-      for (unsigned ifr = 0; ifr < nifr; ifr++) {
-        for (unsigned chan = 0; chan < nchan; chan++) {
-         if (n_corr <= 1) {
-	  unsigned indx = 0 + n_bit*(chan + n_chan*ifr);
-	  lat[i][indx] = val[0];
-
-	  for (unsigned b = 1; b < n_bit; b++) {
-	    indx++;
-	    lat[i][indx] = val[b+1];
-	  }
-	}
-	else {
-	  unsigned indx = n_bit*(chan + n_chan*ifr);
-	  for (unsigned b = 0; b < n_bit; b++) {
-	    lat[i][indx++] = val[b];
-	  }
-	}
-      }
+  iter.advance(0);
+  for (unsigned ifr = 0; ifr < nifr; ifr++) {
+    for (unsigned chan = 0; chan < nchan; chan++) {
+      iter.set(chan, ifr, init_val);
     }
   }
-}
+  size_t nbits = size_t(nchan) * nifr * n_bit;
+  size_t nbytes = (nbits + RFMappedBuffer::WordBits - 1) / RFMappedBuffer::WordBits
+                  * sizeof(RFMappedBuffer::Word);
+  for (unsigned i = 1; i < ntime; i++) {
+    lat.touch(i);
+    memcpy(lat.slot(i), lat.slot(0), nbytes);
+  }
+  iter.reset();
 }
 
 template<class T> void
@@ -288,7 +273,7 @@ RFCubeLattice<T>::set_column( uInt ifr, const T &val )
 template<class T> void RFCubeLattice<T>::cleanup ()
 {
   iter = RFCubeLatticeIterator<T>();
-  lat.resize(0);
+  lat.cleanup();
   lat_shape.resize(0);
 }
 
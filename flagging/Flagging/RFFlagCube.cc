@@ -63,6 +63,7 @@ Vector<RFlagWord> RFFlagCube::corr_flagmask;
 // which agents deal with any of the given correlations
 
 Bool RFFlagCube::reset_preflags;
+Int RFFlagCube::maxmem_mb=0;
   LogIO RFFlagCube::default_sink(LogOrigin("Flagger","FlagCube"));
 
 RFFlagCube::RFFlagCube ( RFChunkStats &ch,Bool ignore,Bool reset,LogIO &sink )
@@ -100,12 +101,20 @@ RFFlagCube::~RFFlagCube ()
     }
 }
 
-uInt RFFlagCube::estimateMemoryUse ( const RFChunkStats &ch )
+uInt RFFlagCube::estimateMemoryUse ( const RFChunkStats &ch,uInt nbit )
 {
-    return
-        ch.num(CHAN) * ch.num(IFR) * ch.num(TIME) * 
-        sizeof(RFlagWord) / (1024*1024) + 1;
-    
+    return RFCubeLattice<RFlagWord>::estimateMemoryUse(ch.num(CHAN),ch.num(IFR),
+                                                       ch.num(TIME),nbit);
+}
+
+void RFFlagCube::setMaxMem ( Int maxmem )
+{
+    maxmem_mb = maxmem>0 ? maxmem : 0;
+}
+
+int RFFlagCube::getMaxMem ()
+{
+    return maxmem_mb;
 }
 
 // creates flag cube for a given visibility chunk
@@ -150,7 +159,13 @@ void RFFlagCube::init( RFlagWord corrmsk, uInt nAgent, bool only_selector, const
         if (!kiss) {
             // init empty flag lattice
             // initial state is all pre-flags set; we'll clear them as we go along
-            flag.init(num(CHAN),num(IFR),num(TIME),num(CORR), nAgent, full_corrmask);
+            flag.init(num(CHAN),num(IFR),num(TIME),num(CORR), nAgent, full_corrmask, maxmem_mb);
+            if (flag.spilled()) {
+                os << LogIO::NORMAL << "Flag cube of "
+                   << estimateMemoryUse(chunk, num(CORR)+nAgent)
+                   << " MB does not fit in " << maxmem_mb
+                   << " MB; using a scratch file" << LogIO::POST;
+            }
 
         }
         else {
@@ -277,7 +292,9 @@ Bool RFFlagCube::setFlag ( uInt ich,uInt ifr, FlagCubeIterator &iter )
             }
         }
         if (raised) {
+#pragma omp atomic
             tot_fl_raised++;
+#pragma omp atomic
             fl_raised++;
         }
         return raised;
@@ -288,7 +305,10 @@ Bool RFFlagCube::setFlag ( uInt ich,uInt ifr, FlagCubeIterator &iter )
     RFlagWord oldfl = iter(ich,ifr);
     if (dbg) cerr << " : " << oldfl << "," << flagmask;
     if ( !(oldfl&flagmask) ) {
+	// agents iterating over rows in parallel share these counters
+#pragma omp atomic
 	tot_fl_raised++;
+#pragma omp atomic
 	fl_raised++;
 	if (dbg) cerr << " setting " << oldfl << " | " << flagmask << endl;
 	iter.set(ich, ifr, oldfl | flagmask);
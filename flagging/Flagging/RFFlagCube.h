@@ -102,8 +102,9 @@ public:
   // returns reference to logsink
   LogIO & logSink ();
 
-  // returns estimated size of flag cube for a given chunk.
-  static uInt estimateMemoryUse ( const RFChunkStats &ch );
+  // returns estimated size of flag cube (in MB) for a given chunk, with
+  // nbit bits (correlations plus agents) per element.
+  static uInt estimateMemoryUse ( const RFChunkStats &ch,uInt nbit = sizeof(RFlagWord)*8 );
 
   // creates flag cube for current chunk. name is name of agent.
   // nAgent is total number of agents
@@ -194,10 +195,17 @@ public:
   // returns the number of instances of the flag cube
   static Int numInstances ();
 
-  // sets the maximum memory usage for the flag cube  
+  // sets the maximum memory usage (in MB) for the flag cube, 0 for no
+  // limit. Applies to flag cubes created afterwards; a larger cube is
+  // spilled to a scratch file.
   static void setMaxMem ( Int maxmem );
   // returns the current maximum memory usage
   static int  getMaxMem ();
+
+  // tells if the current flag cube is spilled to a scratch file
+  static Bool spilled ()             { return flag.spilled(); }
+  // returns the peak memory (in bytes) used by the current flag cube
+  static size_t peakMemoryUse ()     { return flag.peakMemoryUse(); }
       
  private:
   RFChunkStats &chunk;                  // chunk
@@ -219,6 +227,7 @@ public:
   static Int pos_get_flag,pos_set_flag; 
 
   static Bool reset_preflags; // flag: RESET policy specified for at least one instance
+  static Int maxmem_mb;       // memory limit for the flag cube, 0 for none
   
   static uInt npol,nchan;
   
@@ -0,0 +1,149 @@
+//# RFMappedBuffer.cc: this defines RFMappedBuffer
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+#include <flagging/Flagging/RFMappedBuffer.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/OS/EnvVar.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+    
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+RFMappedBuffer::RFMappedBuffer () :
+  base(NULL),nslots(0),stride(0),spill(False),
+  maxresident(0),peakslots(0),last(0)
+{}
+
+RFMappedBuffer::~RFMappedBuffer ()
+{
+  cleanup();
+}
+
+void RFMappedBuffer::init ( uInt nslot,size_t nword,size_t maxmem,const String &dir )
+{
+  cleanup();
+  nslots = nslot;
+  stride = nword;
+  size_t bytes = nslots*stride*sizeof(Word);
+  spill = ( maxmem>0 && bytes>maxmem );
+  if( !spill )
+  {
+    if( bytes )
+    {
+      base = new Word[nslots*stride];
+      memset(base,0,bytes);
+    }
+    return;
+  }
+// page-align the slots, so they can be released one by one
+  size_t page = sysconf(_SC_PAGESIZE)/sizeof(Word);
+  stride = (nword+page-1)/page*page;
+  bytes = nslots*stride*sizeof(Word);
+  maxresident = maxmem/(stride*sizeof(Word));
+  if( maxresident<1 )
+    maxresident = 1;
+// create an unlinked scratch file of the right size; it is zero-filled
+  String tmpdir = dir;
+  if( tmpdir.empty() )
+    tmpdir = EnvironmentVariable::isDefined("TMPDIR") ?
+      EnvironmentVariable::get("TMPDIR") : String(".");
+  String name = tmpdir + "/RFFlagCube_XXXXXX";
+  std::vector<char> fname(name.chars(),name.chars()+name.length()+1);
+  int fd = mkstemp(&fname[0]);
+  if( fd<0 )
+    throw AipsError("RFMappedBuffer: cannot create scratch file " + name +
+                    ": " + strerror(errno));
+  unlink(&fname[0]);
+  if( ftruncate(fd,bytes)!=0 )
+  {
+    close(fd);
+    throw AipsError("RFMappedBuffer: cannot size scratch file in " + tmpdir +
+                    ": " + strerror(errno));
+  }
+  void *p = mmap(NULL,bytes,PROT_READ|PROT_WRITE,MAP_SHARED,fd,0);
+  close(fd);
+  if( p==MAP_FAILED )
+    throw AipsError(String("RFMappedBuffer: cannot map scratch file: ") +
+                    strerror(errno));
+  base = static_cast<Word*>(p);
+  hotpos.resize(nslots);
+  ishot.assign(nslots,false);
+  last = nslots;
+}
+
+void RFMappedBuffer::cleanup ()
+{
+  if( base )
+  {
+    if( spill )
+      munmap(base,nslots*stride*sizeof(Word));
+    else
+      delete [] base;
+  }
+  base = NULL;
+  nslots = 0;
+  stride = 0;
+  spill = False;
+  peakslots = 0;
+  hot.clear();
+  hotpos.clear();
+  ishot.clear();
+}
+
+size_t RFMappedBuffer::peakResident () const
+{
+  return spill ? peakslots*stride*sizeof(Word) : size();
+}
+
+void RFMappedBuffer::touchSlot ( uInt islot )
+{
+  last = islot;
+  if( ishot[islot] )
+  {
+    hot.splice(hot.begin(),hot,hotpos[islot]);
+    return;
+  }
+  hot.push_front(islot);
+  hotpos[islot] = hot.begin();
+  ishot[islot] = true;
+// hand the least recently used slots back to the OS
+  while( hot.size()>maxresident )
+  {
+    uInt cold = hot.back();
+    hot.pop_back();
+    ishot[cold] = false;
+    Word *p = slot(cold);
+    msync(p,stride*sizeof(Word),MS_ASYNC);
+    madvise(p,stride*sizeof(Word),MADV_DONTNEED);
+  }
+  if( hot.size()>peakslots )
+    peakslots = hot.size();
+}
+
+} //# NAMESPACE CASA - END
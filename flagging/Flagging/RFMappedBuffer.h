@@ -0,0 +1,121 @@
+//# RFMappedBuffer.h: this defines RFMappedBuffer
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+#ifndef FLAGGING_RFMAPPEDBUFFER_H
+#define FLAGGING_RFMAPPEDBUFFER_H
+
+#include <casa/aips.h>
+#include <casa/BasicSL/String.h>
+#include <list>
+#include <vector>
+#include <cstddef>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+// <summary>
+// RFMappedBuffer: slotted word buffer that can spill to a scratch file
+// </summary>
+
+// <use visibility=local>
+
+// <reviewed reviewer="" date="" tests="" demos="">
+// </reviewed>
+
+// <synopsis>
+// RFMappedBuffer holds NSLOT equally sized slots of machine words (one
+// slot per time slot of a flag cube). If the total size fits in the
+// memory limit given to init(), the buffer is simply allocated in memory.
+// Otherwise it is a shared memory mapping of an (unlinked) scratch file,
+// and the buffer keeps track of the slots recently used through touch().
+// When more than the memory limit is in use, the least recently touched
+// slots are handed back to the OS, which writes them to the scratch file
+// and reads them back when they are accessed again.
+//
+// Slots are page-aligned in the spilled case, so that every slot can be
+// released individually.
+// </synopsis>
+//
+// <motivation>
+// The flag cube of a long chunk with many channels and baselines may not
+// fit in memory. Since the flagging agents iterate over time, only a
+// window of time slots is needed at any moment.
+// </motivation>
+
+class RFMappedBuffer
+{
+public:
+  typedef unsigned long Word;
+  static const uInt WordBits = sizeof(Word)*8;
+
+  RFMappedBuffer ();
+  ~RFMappedBuffer ();
+
+  // Allocates NSLOT slots of NWORD words each, cleared to 0. MAXMEM is
+  // the memory limit in bytes (0 for no limit); the scratch file, if
+  // needed, is created in directory DIR (empty for the default).
+  void init ( uInt nslot,size_t nword,size_t maxmem=0,const String &dir="" );
+  // releases the buffer
+  void cleanup ();
+
+  // returns pointer to the first word of a slot
+  Word * slot ( uInt islot )
+    { return base + islot*stride; }
+  const Word * slot ( uInt islot ) const
+    { return base + islot*stride; }
+
+  // marks a slot as being used. In the spilled case this may release
+  // the least recently used slots.
+  void touch ( uInt islot )
+    { if( spill && islot != last ) touchSlot(islot); }
+
+  // tells if the buffer is backed by a scratch file
+  Bool spilled () const { return spill; }
+  // returns the total size in bytes
+  size_t size () const { return nslots*stride*sizeof(Word); }
+  // returns the maximum number of bytes that were resident
+  size_t peakResident () const;
+
+private:
+  RFMappedBuffer ( const RFMappedBuffer & );
+  RFMappedBuffer & operator= ( const RFMappedBuffer & );
+
+  void touchSlot ( uInt islot );
+
+  Word *base;
+  uInt nslots;
+  size_t stride;        // slot size in words
+  Bool spill;
+  size_t maxresident;   // max number of resident slots when spilled
+  size_t peakslots;
+  uInt last;            // last slot touched
+  std::list<uInt> hot;  // resident slots, most recently used first
+  std::vector<std::list<uInt>::iterator> hotpos;
+  std::vector<bool> ishot;
+};
+
+} //# NAMESPACE CASA - END
+
+#endif
@@ -0,0 +1,187 @@
+//# RFSlidingMedians.cc: this defines RFSlidingMedians
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+#include <flagging/Flagging/RFSlidingMedians.h>
+#include <flagging/Flagging/RFChunkStats.h>
+#include <msvis/MSVis/AsynchronousTools.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/stdio.h>
+#include <algorithm>
+    
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+std::map<String,RFSlidingMedians*> RFSlidingMedians::registry;
+
+// guards the registry and the user counts of its instances
+static async::Mutex registryMutex;
+
+RFSlidingMedians::RFSlidingMedians ( uInt nch,uInt ni,uInt nw ) :
+  nchan(nch),nifr(ni),nwin(nw),
+  laststep(ni,-1),pass(-1),nusers(0)
+{}
+
+RFSlidingMedians::~RFSlidingMedians ()
+{}
+
+RFSlidingMedians * RFSlidingMedians::acquire ( const String &key,uInt nchan,uInt nifr,uInt nwin )
+{
+  async::MutexLocker locker(registryMutex);
+  std::map<String,RFSlidingMedians*>::iterator iter = registry.find(key);
+  RFSlidingMedians *sm;
+  if( iter == registry.end() )
+  {
+    sm = new RFSlidingMedians(nchan,nifr,max(nwin,1u));
+    sm->key = key;
+    registry[key] = sm;
+  }
+  else
+  {
+    sm = iter->second;
+    AlwaysAssert( sm->nchan==nchan && sm->nifr==nifr,AipsError );
+    // a larger window is allocated at the start of the next pass
+    if( nwin > sm->nwin )
+    {
+      sm->nwin = nwin;
+      sm->pass = -1;
+    }
+  }
+  sm->nusers++;
+  return sm;
+}
+
+void RFSlidingMedians::release ( RFSlidingMedians *sm )
+{
+  if( !sm )
+    return;
+  async::MutexLocker locker(registryMutex);
+  if( --sm->nusers == 0 )
+  {
+    registry.erase(sm->key);
+    delete sm;
+  }
+}
+
+String RFSlidingMedians::makeKey ( const RFChunkStats &chunk,const String &mapperDesc,
+                                   RFlagWord corrmask,Bool fignore,Bool reset )
+{
+  // The chunk statistics object belongs to one Flagger run, so agents of
+  // different runs (or of different MSs) never share a buffer.
+  char s[256];
+  snprintf(s,sizeof(s),"|chunkstats=%p|chunk=%u|corr=%u|fignore=%d|reset=%d",
+           (const void*)&chunk,chunk.nchunk(),corrmask,
+           (Int)fignore,(Int)reset);
+  return chunk.msName()+"|"+mapperDesc+s;
+}
+
+uInt RFSlidingMedians::estimateMemoryUse ( uInt nchan,uInt nifr,uInt nwin )
+{
+  return nchan*nifr*nwin*(sizeof(Float)+sizeof(Bool)) + nifr*sizeof(Int);
+}
+
+uInt RFSlidingMedians::extraMemoryUse ( const String &key,uInt nchan,uInt nifr,uInt nwin )
+{
+  async::MutexLocker locker(registryMutex);
+  std::map<String,RFSlidingMedians*>::const_iterator iter = registry.find(key);
+  if( iter == registry.end() )
+    return estimateMemoryUse(nchan,nifr,nwin);
+  uInt nw = iter->second->nwin;
+  return nwin > nw ? estimateMemoryUse(nchan,nifr,nwin) - estimateMemoryUse(nchan,nifr,nw) : 0;
+}
+
+void RFSlidingMedians::startPass ( uInt npass )
+{
+  if( pass == (Int)npass )
+    return;
+  pass = npass;
+  uInt n = nchan*nwin*nifr;
+  if( values.nelements() != n )
+  {
+    values.resize(n,True,False);
+    flags.resize(n,True,False);
+  }
+  flags.set(True);
+  laststep = -1;
+}
+
+Bool RFSlidingMedians::needStep ( uInt ifr,Int step )
+{
+  Int last = laststep(ifr);
+  if( last >= step )
+    return False;
+  // flag the skipped steps and the new one, at most a full buffer
+  for( Int st = max(last+1,step-(Int)nwin+1); st<=step; st++ )
+  {
+    Bool *fl = flags.storage() + index(0,ifr,st);
+    for( uInt ich=0; ich<nchan; ich++ )
+      fl[ich] = True;
+  }
+  laststep(ifr) = step;
+  return True;
+}
+
+Float RFSlidingMedians::value ( uInt ich,uInt ifr,Int step,Bool &fl ) const
+{
+  if( !held(ifr,step) )
+  {
+    fl = True;
+    return 0;
+  }
+  uInt i = index(ich,ifr,step);
+  fl = flags[i];
+  return values[i];
+}
+
+Float RFSlidingMedians::median ( uInt ich,uInt ifr,Int first,Int last,uInt &nval,
+                                 std::vector<Float> &work ) const
+{
+  first = max(first,max(0,laststep(ifr)-(Int)nwin+1));
+  last = min(last,laststep(ifr));
+  work.clear();
+  for( Int st=first; st<=last; st++ )
+  {
+    uInt i = index(ich,ifr,st);
+    if( !flags[i] )
+      work.push_back(values[i]);
+  }
+  nval = work.size();
+  if( !nval )
+    return 0;
+  std::vector<Float>::iterator mid = work.begin() + nval/2;
+  std::nth_element(work.begin(),mid,work.end());
+  return *mid;
+}
+
+Float RFSlidingMedians::diff ( uInt ich,uInt ifr,Int centre,uInt halfwin,Bool &fl,
+                               std::vector<Float> &work ) const
+{
+  Float val = value(ich,ifr,centre,fl);
+  uInt nval;
+  return val - median(ich,ifr,centre-(Int)halfwin,centre+(Int)halfwin,nval,work);
+}
+
+} //# NAMESPACE CASA - END
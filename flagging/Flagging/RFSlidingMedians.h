@@ -0,0 +1,181 @@
+//# RFSlidingMedians.h: this defines RFSlidingMedians
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+#ifndef FLAGGING_RFSLIDINGMEDIANS_H
+#define FLAGGING_RFSLIDINGMEDIANS_H
+
+#include <flagging/Flagging/RFCommon.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Containers/Block.h>
+#include <casa/BasicSL/String.h>
+#include <map>
+#include <vector>
+    
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+class RFChunkStats;
+
+// <summary>
+// RFSlidingMedians: time window of values per baseline, shared between agents
+// </summary>
+
+// <use visibility=local>
+
+// <reviewed reviewer="" date="" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> RFChunkStats
+//   <li> RFDataMapper
+// </prerequisite>
+//
+// <synopsis>
+// RFSlidingMedians holds, per ifr, the mapped values and flags of the last
+// time slots of a chunk. The values of a time slot are stored contiguously
+// over channels, in a ring buffer of time slots. Agents read order
+// statistics from it: the median of a channel over any range of time slots
+// still held, and the deviation from the median of a window centred on a
+// time slot. Each agent asks for the number of time slots it needs to see
+// (2*halfwin+1 for RFATimeMedian, the whole chunk for RFANewMedianClip);
+// the buffer holds the largest of these.
+//
+// Instances are kept in a static registry keyed on the MS and chunk being
+// flagged (as given by the RFChunkStats of the Flagger run) and on
+// everything that determines the values stored (data mapper expression
+// and column, correlations and pre-flag policy). The window sizes of the
+// agents are not part of the key, so all median-based agents on the same
+// data share one instance, whatever their window. The values of an ifr
+// are then mapped once per time slot, and the memory is that of the
+// largest window instead of growing with the number of agents. Access to
+// the registry is serialized by a mutex.
+//
+// Since all agents in a data pass iterate over the same VisBuffer, the
+// first agent to process a row stores it. Other agents call needStep() to
+// find out that the row has already been stored, and only read. Note that
+// the flags of the row are therefore taken as seen by that first agent.
+// Time slots for which an ifr has no row are stored as flagged.
+//
+// The median of n unflagged values is the element n/2 (counting from 0) of
+// the sorted values, as in MedianSlider. It is found with a partial sort
+// of the values in the window.
+// </synopsis>
+//
+// <motivation>
+// Flagging runs often combine several median agents on the same data.
+// Each agent used to keep its own NCHAN*NIFR MedianSliders and map the
+// data itself, which is costly in both memory and time.
+// </motivation>
+//
+// <todo asof="2011/10/01">
+//   <li> RFAFreqMedian slides over channels within one row and keeps no
+//        state between rows, so it does not use this
+//   <li> RFATimeFreqCrop fits polynomials to its bandpass and time series
+//        and computes no medians, so it does not use this
+// </todo>
+
+class RFSlidingMedians
+{
+public:
+  // returns the instance for the given key, creating it if needed. The
+  // instance will hold at least nwin time slots. Each call must be matched
+  // by a call to release(). All agents must be registered before the
+  // first pass starts.
+  static RFSlidingMedians * acquire ( const String &key,uInt nchan,uInt nifr,uInt nwin );
+  // releases an instance obtained by acquire(); deletes it when it is
+  // no longer used
+  static void release ( RFSlidingMedians *sm );
+  // builds a registry key from the chunk and the parameters of an agent
+  static String makeKey ( const RFChunkStats &chunk,const String &mapperDesc,
+                          RFlagWord corrmask,Bool fignore,Bool reset );
+
+  // number of bytes needed for nwin time slots
+  static uInt estimateMemoryUse ( uInt nchan,uInt nifr,uInt nwin );
+  // number of bytes that acquiring an instance with this key for nwin
+  // time slots adds to the memory already reserved by other agents
+  static uInt extraMemoryUse ( const String &key,uInt nchan,uInt nifr,uInt nwin );
+
+  // clears the buffer at the start of a data pass. Calls from other
+  // agents for the same pass are ignored.
+  void startPass ( uInt npass );
+
+  // Returns True if the caller has to store the values of the given ifr
+  // for the given step (the time slot), and marks the step as stored with
+  // all channels flagged. Returns False if another agent did so already.
+  // Skipped steps are marked as flagged. Calls for different ifrs may be
+  // done concurrently.
+  Bool needStep ( uInt ifr,Int step );
+
+  // stores the value of channel ich for the last step of ifr
+  void set ( uInt ich,uInt ifr,Float val,Bool fl )
+    { uInt i = index(ich,ifr,laststep(ifr)); values[i] = val; flags[i] = fl; }
+
+  // returns the value and flag of channel ich at the given step. Steps not
+  // (or no longer) held are flagged.
+  Float value ( uInt ich,uInt ifr,Int step,Bool &fl ) const;
+
+  // returns the median of the unflagged values of channel ich in steps
+  // [first,last], and their number in nval. Steps not (or no longer) held
+  // are skipped. The median is 0 if there are no values. The work vector
+  // is used as scratch space, so concurrent calls need their own.
+  Float median ( uInt ich,uInt ifr,Int first,Int last,uInt &nval,
+                 std::vector<Float> &work ) const;
+
+  // returns the value at step centre minus the median over the window of
+  // steps [centre-halfwin,centre+halfwin], and the flag of the value.
+  Float diff ( uInt ich,uInt ifr,Int centre,uInt halfwin,Bool &fl,
+               std::vector<Float> &work ) const;
+
+  // returns the last step stored for ifr (-1 if none)
+  Int lastStep ( uInt ifr ) const { return laststep(ifr); }
+
+private:
+  RFSlidingMedians ( uInt nchan,uInt nifr,uInt nwin );
+  ~RFSlidingMedians ();
+
+  // Forbid copy and assignment
+  RFSlidingMedians ( const RFSlidingMedians & );
+  RFSlidingMedians & operator= ( const RFSlidingMedians & );
+
+  // is the step held in the buffer of ifr?
+  Bool held ( uInt ifr,Int step ) const
+    { return step >= 0 && step <= laststep(ifr) && step > laststep(ifr) - (Int)nwin; }
+  uInt index ( uInt ich,uInt ifr,Int step ) const
+    { return ( ifr*nwin + step%nwin )*nchan + ich; }
+
+  uInt nchan,nifr,nwin;
+  Block<Float> values;    // [NCHAN,NWIN,NIFR]
+  Block<Bool> flags;      // [NCHAN,NWIN,NIFR]
+  Vector<Int> laststep;   // last step stored per ifr
+  Int pass;               // pass for which the buffer was last cleared
+  uInt nusers;
+  String key;
+
+  static std::map<String,RFSlidingMedians*> registry;
+};
+
+} //# NAMESPACE CASA - END
+
+#endif
@@ -91,10 +91,40 @@ void test()
     return;
 }
 
+// A cube larger than its memory limit is spilled to a scratch file;
+// values must survive the time slots being released.
+void testSpill()
+{
+    unsigned nc = 1024, ni = 1000, nt = 7;
+    unsigned val = 3;
+    RFCubeLattice<RFlagWord> r;
+    r.init(nc, ni, nt, ncorr, nagent, val, 1);
+
+    assert( r.spilled() );
+
+    for (unsigned t = 0; t < nt; t++) {
+        r.advance(t);
+        assert( r(0, 0) == val );
+        assert( r(nc-1, ni-1) == val );
+        r.set(t, t, t);
+    }
+    for (unsigned t = 0; t < nt; t++) {
+        r.advance(t);
+        assert( r(t, t) == t );
+        assert( r(t+1, t) == val );
+    }
+
+    assert( r.peakMemoryUse() <= 1024*1024 );
+
+    return;
+}
+
 int main()
 {
     test();
 
+    testSpill();
+
     
 
     return 0;
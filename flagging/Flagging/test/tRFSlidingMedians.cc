@@ -0,0 +1,165 @@
+//# tRFSlidingMedians.cc: Test the shared time window of the median agents
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <flagging/Flagging/RFSlidingMedians.h>
+#include <scimath/Mathematics/MedianSlider.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/iostream.h>
+#include <vector>
+#include <casa/namespace.h>
+
+// Two agents with half-windows 2 and 4 share the window. Ifr 1 has no
+// rows in time slots 7 and 8.
+const uInt nChan = 3;
+const uInt nIfr = 2;
+const Int nTime = 20;
+const uInt halfwin[2] = {2, 4};
+
+Float dataValue (uInt ich, uInt ifr, Int t)
+{
+  return Float((t*7 + ich*13 + ifr*5) % 17) - 8;
+}
+
+Bool dataFlag (uInt ich, uInt ifr, Int t)
+{
+  return (t + ich + ifr) % 7 == 0;
+}
+
+Bool hasRow (uInt ifr, Int t)
+{
+  return !(ifr == 1  &&  (t == 7  ||  t == 8));
+}
+
+// Compare the deviations from the median with those of a MedianSlider per
+// channel and ifr, advanced once per time slot.
+void testDiff (RFSlidingMedians& sm, uInt hw)
+{
+  std::vector<MedianSlider> sliders (nChan*nIfr, MedianSlider(hw));
+  std::vector<Float> work;
+  sm.startPass (0);
+  for (Int t=0; t<nTime; ++t) {
+    for (uInt ifr=0; ifr<nIfr; ++ifr) {
+      if (hasRow (ifr, t)) {
+        if (sm.needStep (ifr, t)) {
+          for (uInt ich=0; ich<nChan; ++ich) {
+            sm.set (ich, ifr, dataValue(ich,ifr,t), dataFlag(ich,ifr,t));
+          }
+        }
+        // A second agent finds the row stored.
+        AlwaysAssertExit (!sm.needStep (ifr, t));
+      }
+      for (uInt ich=0; ich<nChan; ++ich) {
+        MedianSlider& msl = sliders[ifr*nChan + ich];
+        if (hasRow (ifr, t)) {
+          msl.add (dataValue(ich,ifr,t), dataFlag(ich,ifr,t));
+        } else {
+          msl.next();
+        }
+        if (t >= Int(hw)  &&  hasRow (ifr, t)) {
+          Bool fl1, fl2;
+          Float d1 = msl.diff (fl1);
+          Float d2 = sm.diff (ich, ifr, t-hw, hw, fl2, work);
+          AlwaysAssertExit (fl1 == fl2);
+          if (!fl1) {
+            AlwaysAssertExit (d1 == d2);
+          }
+        }
+      }
+    }
+  }
+  // The window is cut off at the last time slot.
+  for (Int t=nTime; t<nTime+Int(hw); ++t) {
+    for (uInt ifr=0; ifr<nIfr; ++ifr) {
+      for (uInt ich=0; ich<nChan; ++ich) {
+        MedianSlider& msl = sliders[ifr*nChan + ich];
+        msl.next();
+        Bool fl1, fl2;
+        Float d1 = msl.diff (fl1);
+        Float d2 = sm.diff (ich, ifr, t-hw, hw, fl2, work);
+        AlwaysAssertExit (fl1 == fl2);
+        if (!fl1) {
+          AlwaysAssertExit (d1 == d2);
+        }
+        uInt nval;
+        Float med = sm.median (ich, ifr, t-2*hw, t, nval, work);
+        AlwaysAssertExit (med == msl.median());
+        AlwaysAssertExit (nval == msl.nval());
+      }
+    }
+  }
+}
+
+int main()
+{
+  try {
+    RFSlidingMedians* sm1 = RFSlidingMedians::acquire ("key", nChan, nIfr,
+                                                       2*halfwin[0]+1);
+    AlwaysAssertExit (RFSlidingMedians::extraMemoryUse ("key", nChan, nIfr, 5) == 0);
+    AlwaysAssertExit (RFSlidingMedians::extraMemoryUse ("key", nChan, nIfr, 9) ==
+                      nChan*nIfr*4*(sizeof(Float)+sizeof(Bool)));
+    // The second agent has a larger window, but shares the instance.
+    RFSlidingMedians* sm2 = RFSlidingMedians::acquire ("key", nChan, nIfr,
+                                                       2*halfwin[1]+1);
+    AlwaysAssertExit (sm1 == sm2);
+    RFSlidingMedians* sm3 = RFSlidingMedians::acquire ("other", nChan, nIfr, 3);
+    AlwaysAssertExit (sm3 != sm1);
+    RFSlidingMedians::release (sm3);
+    for (uInt i=0; i<2; ++i) {
+      testDiff (*sm1, halfwin[i]);
+      // A new pass clears the window; the same pass does not.
+      sm1->startPass (0);
+      AlwaysAssertExit (sm1->lastStep(0) == nTime-1);
+      sm1->startPass (1);
+      AlwaysAssertExit (sm1->lastStep(0) == -1);
+      Bool fl;
+      sm1->value (0, 0, 0, fl);
+      AlwaysAssertExit (fl);
+    }
+    // Steps no longer held are flagged.
+    sm1->startPass (2);
+    for (Int t=0; t<nTime; ++t) {
+      AlwaysAssertExit (sm1->needStep (0, t));
+      sm1->set (0, 0, t, False);
+    }
+    Bool fl;
+    AlwaysAssertExit (sm1->value (0, 0, nTime-9, fl) == nTime-9  &&  !fl);
+    sm1->value (0, 0, nTime-10, fl);
+    AlwaysAssertExit (fl);
+    uInt nval;
+    std::vector<Float> work;
+    AlwaysAssertExit (sm1->median (0, 0, 0, nTime-1, nval, work) == nTime-5);
+    AlwaysAssertExit (nval == 9);
+    RFSlidingMedians::release (sm1);
+    RFSlidingMedians::release (sm2);
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
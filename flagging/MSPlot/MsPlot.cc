@@ -137,7 +137,7 @@ String MsPlot::clname = "MsPlot";
 //#////////////////////////////////////////////////////////////////////////////
 //# default constructor. In case for some reason, one need to pass a Table 
 //# object, not a MeasurementSet to TABS_P, he can use this constructor.
-MsPlot::MsPlot() : msa(0), itsResetCallBack(0)
+MsPlot::MsPlot() : msa(0), itsBinner(0), itsResetCallBack(0)
 {
     String fnname = "MsPlot";
     log = SLog::slog();
@@ -160,7 +160,7 @@ MsPlot::MsPlot() : msa(0), itsResetCallBack(0)
 
 //#////////////////////////////////////////////////////////////////////////////
 //# Another constructor with a ms object, ???
-MsPlot::MsPlot( const String& MSPath ) : msa(0), itsResetCallBack(0)
+MsPlot::MsPlot( const String& MSPath ) : msa(0), itsBinner(0), itsResetCallBack(0)
 {
     String fnname = "MsPlot";
     log = SLog::slog();
@@ -196,6 +196,7 @@ MsPlot::~MsPlot()
     }
     if ( itsTable != NULL ) { delete itsTable; itsTable = NULL; }
 
+    if ( itsBinner != NULL ) { delete itsBinner; itsBinner = NULL; }
     if ( itsMS != NULL ) { delete itsMS; itsMS = NULL; }     
 }
 
@@ -6157,6 +6158,116 @@ MsPlot::flagData( Int direction )
   return rstat;
 }
 
+//#///////////////////////////////////////////////////////////////////////////
+//# Bin the selected data server-side, so that large data sets can be
+//# plotted without sending every point to TablePlot.
+Bool
+MsPlot::binData( const String& x, const String& y, Int nx, Int ny,
+                 const Vector<Double>& range, Record& result )
+{
+    String FnCall = String( "( " ) + x + String( ", " ) + y
+       + String( ", " ) + String::toString( nx ) + String( ", " )
+       + String::toString( ny ) + String( ", range, result )" );
+    String fnname = "binData";
+    log->FnEnter( fnname + FnCall, clname );
+
+    Bool rstat( True );
+    if ( ! checkInit() || ! checkOpenMS() )  {
+       log->FnExit( fnname, clname);
+       return rstat=False;
+    }
+    if ( nx <= 0 || ny <= 0
+         || ( range.nelements() != 0 && range.nelements() != 4 ) )
+    {
+       String msg = String( "Please give a positive number of bins and " )
+          + String( "an empty range or [xmin,xmax,ymin,ymax]" );
+       log->out( msg, fnname, clname, LogMessage::WARN, True );
+       log->FnExit( fnname, clname);
+       return rstat=False;
+    }
+
+    //# The data column as given to average().
+    String column = upcase( itsDataColumn );
+    if ( column.contains( "CORRECTED" ) )
+       column = "CORRECTED_DATA";
+    else if ( column.contains( "MODEL" ) )
+       column = "MODEL_DATA";
+    else
+       column = "DATA";
+
+    try {
+       if ( itsBinner != NULL ) { delete itsBinner; itsBinner = NULL; }
+       itsBinner = new MsPlotBinner( itsSelectedMS, x, y, column );
+       itsBinner->setBins( nx, ny );
+       if ( range.nelements() == 4 )
+          itsBinner->setRange( range[0], range[1], range[2], range[3] );
+       itsBinner->bin();
+       itsBinner->toRecord( result );
+    } catch ( AipsError ae ) {
+       log->out( ae.getMesg(), fnname, clname, LogMessage::SEVERE );
+       rstat = False;
+    }
+
+    log->FnExit( fnname, clname);
+    return rstat;
+}
+
+//#///////////////////////////////////////////////////////////////////////////
+Bool
+MsPlot::flagBinnedRegion( const Vector<Double>& regionvec, Int direction,
+                          Vector<uInt>& rows )
+{
+    String FnCall = String( "( regionvec, " ) + String::toString( direction )
+       + String( ", rows )" );
+    String fnname = "flagBinnedRegion";
+    log->FnEnter( fnname + FnCall, clname );
+
+    Bool rstat( True );
+    if ( ! checkInit() || ! checkOpenMS() )  {
+       log->FnExit( fnname, clname);
+       return rstat=False;
+    }
+    if ( itsBinner == NULL || regionvec.nelements() != 4 )
+    {
+       String msg = String( "Please bin the data first and enter a valid " )
+          + String( "region [xmin,xmax,ymin,ymax]" );
+       log->out( msg, fnname, clname, LogMessage::WARN, True );
+       log->FnExit( fnname, clname);
+       return rstat=False;
+    }
+
+    //# TablePlot::flagData cannot be used here: it flags the points inside
+    //# the regions marked on the plotted panels, and a binned plot has no
+    //# points. So the binner writes FLAG/FLAG_ROW itself. To keep this
+    //# undoable like the other flag edits, the flags are first saved as
+    //# a flag version, which restoreFlagVersion can bring back.
+    if ( ! itsTablePlot->saveFlagVersion( String( "before_flagBinnedRegion" ),
+            String( "Flags before the last flagBinnedRegion" ),
+            String( "replace" ) ) )
+    {
+       log->out( String( "Unable to save the flags before flagging; " )
+          + String( "nothing is flagged" ), fnname, clname,
+          LogMessage::WARN );
+       log->FnExit( fnname, clname);
+       return rstat=False;
+    }
+
+    try {
+       //# Map the rows of the selection back to the rows of the MS.
+       Vector<uInt> selRows = itsBinner->flagRegion( regionvec, direction );
+       Vector<uInt> msRows = itsBinner->measurementSet().rowNumbers();
+       rows.resize( selRows.nelements() );
+       for ( uInt i = 0; i < selRows.nelements(); i++ )
+          rows[i] = msRows[selRows[i]];
+    } catch ( AipsError ae ) {
+       log->out( ae.getMesg(), fnname, clname, LogMessage::SEVERE );
+       rstat = False;
+    }
+
+    log->FnExit( fnname, clname);
+    return rstat;
+}
+
 //#///////////////////////////////////////////////////////////////////////////
 Bool 
 MsPlot::locateData( )
@@ -54,6 +54,7 @@
 #include <tableplot/TablePlot/SLog.h>
 
 #include <msvis/MSVis/MsAverager.h>
+#include <flagging/MSPlot/MsPlotBinner.h>
 
 
 namespace casa { //#! NAMESPACE CASA - BEGIN
@@ -450,6 +451,23 @@ class MsPlot
     Bool flagData( Int direction );
     Bool locateData();
 
+    // Bin the selected data on a grid of nx by ny bins instead of
+    // extracting every point. The result record holds the 2D density
+    // histogram and the count, min, max and mean of y per x-bin
+    // (see <linkto class="MsPlotBinner">MsPlotBinner</linkto>). An empty
+    // range [xmin,xmax,ymin,ymax] is determined from the data.
+    Bool binData( const String& x, const String& y, Int nx, Int ny,
+                  const Vector<Double>& range, Record& result );
+
+    // Flag (direction=1) or unflag (direction=0) the samples in the region
+    // [xmin,xmax,ymin,ymax] of the last binned plot. The affected rows of
+    // the MS are returned in <src>rows</src>. The flags are written
+    // directly, not by flagData (a binned plot has no plotted points).
+    // Beforehand they are saved as flag version "before_flagBinnedRegion",
+    // so the last call can be undone with restoreFlagVersion.
+    Bool flagBinnedRegion( const Vector<Double>& regionvec, Int direction,
+                           Vector<uInt>& rows );
+
     // Functions for flag version control.
     Bool saveFlagVersion(String versionname, 
                          String comment, 
@@ -526,6 +544,9 @@ private:
     Int itsTimeStep;
 
     MsAverager *msa;
+
+    // The binner of the last binned plot.
+    MsPlotBinner *itsBinner;
     String itsDataColumn;
     String itsAveMode;
     Vector<String> itsAveCorr;
@@ -0,0 +1,454 @@
+//# MsPlotBinner.cc: Implementation of MsPlotBinner.h
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <flagging/MSPlot/MsPlotBinner.h>
+#include <ms/MeasurementSets/MSDataDescColumns.h>
+#include <ms/MeasurementSets/MSSpWindowColumns.h>
+#include <tables/Tables/ArrayColumn.h>
+#include <tables/Tables/ScalarColumn.h>
+#include <casa/Arrays/ArrayMath.h>
+#include <casa/Arrays/Slicer.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/BasicSL/Complex.h>
+#include <casa/BasicSL/Constants.h>
+#include <casa/Exceptions/Error.h>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+MsPlotBinner::MsPlotBinner (MeasurementSet& ms, const String& xAxis,
+                            const String& yAxis, const String& dataColumn,
+                            Bool useFlags)
+  : ms_p         (ms),
+    xAxis_p      (axisType (xAxis)),
+    yAxis_p      (axisType (yAxis)),
+    dataColumn_p (upcase (dataColumn)),
+    useFlags_p   (useFlags),
+    nx_p         (512),
+    ny_p         (512),
+    range_p      (4, 0.)
+{
+  needData_p = (xAxis_p >= AMPLITUDE  ||  yAxis_p >= AMPLITUDE);
+  if (needData_p  &&  !ms_p.tableDesc().isColumn (dataColumn_p)) {
+    throw AipsError ("MsPlotBinner: MS has no column " + dataColumn_p);
+  }
+  uInt nDD = ms_p.dataDescription().nrow();
+  freqs_p.resize (nDD);
+  haveFreqs_p.resize (nDD);
+  haveFreqs_p.set (False);
+}
+
+MsPlotBinner::~MsPlotBinner()
+{}
+
+MsPlotBinner::Axis MsPlotBinner::axisType (const String& name)
+{
+  String axis = upcase (name);
+  if (axis == "TIME") return TIME;
+  if (axis == "UVDIST") return UVDIST;
+  if (axis == "UVDIST_L") return UVDIST_L;
+  if (axis == "U") return U;
+  if (axis == "V") return V;
+  if (axis == "W") return W;
+  if (axis == "CHANNEL") return CHANNEL;
+  if (axis == "FREQUENCY") return FREQUENCY;
+  if (axis == "AMPLITUDE"  ||  axis == "AMP") return AMPLITUDE;
+  if (axis == "PHASE") return PHASE;
+  if (axis == "REAL") return REAL;
+  if (axis == "IMAGINARY"  ||  axis == "IMAG") return IMAGINARY;
+  throw AipsError ("MsPlotBinner: unknown plot axis " + name);
+}
+
+void MsPlotBinner::setBins (uInt nx, uInt ny)
+{
+  if (nx == 0  ||  ny == 0) {
+    throw AipsError ("MsPlotBinner: number of bins must be positive");
+  }
+  nx_p = nx;
+  ny_p = ny;
+}
+
+void MsPlotBinner::setRange (Double xmin, Double xmax,
+                             Double ymin, Double ymax)
+{
+  range_p(0) = xmin;
+  range_p(1) = xmax;
+  range_p(2) = ymin;
+  range_p(3) = ymax;
+}
+
+const Vector<Double>& MsPlotBinner::frequencies (Int ddId)
+{
+  if (! haveFreqs_p[ddId]) {
+    ROMSDataDescColumns ddCols (ms_p.dataDescription());
+    ROMSSpWindowColumns spwCols (ms_p.spectralWindow());
+    freqs_p[ddId] = spwCols.chanFreq()(ddCols.spectralWindowId()(ddId));
+    haveFreqs_p[ddId] = True;
+  }
+  return freqs_p[ddId];
+}
+
+uInt MsPlotBinner::blockRows() const
+{
+  // Read about 32 MB of data and flags at a time.
+  if (ms_p.nrow() == 0) {
+    return 1;
+  }
+  ROArrayColumn<Bool> flagCol (ms_p, "FLAG");
+  uInt rowSize = flagCol.shape(0).product() *
+                 (sizeof(Bool) + (needData_p ? sizeof(Complex) : 0));
+  return max (1u, uInt(32*1024*1024 / max(1u, rowSize)));
+}
+
+uInt MsPlotBinner::readBlock (uInt row, uInt maxRows)
+{
+  ROArrayColumn<Bool> flagCol (ms_p, "FLAG");
+  // The data shape can vary with the spectral window.
+  IPosition shape = flagCol.shape (row);
+  uInt nrow = ms_p.nrow();
+  uInt n = 1;
+  while (n < maxRows  &&  row+n < nrow  &&  flagCol.shape(row+n) == shape) {
+    ++n;
+  }
+  Slicer rows (IPosition(1, row), IPosition(1, n));
+  flag_p.reference (flagCol.getColumnRange (rows));
+  flagRow_p.reference (ROScalarColumn<Bool>(ms_p, "FLAG_ROW").getColumnRange (rows));
+  time_p.reference (ROScalarColumn<Double>(ms_p, "TIME").getColumnRange (rows));
+  uvw_p.reference (ROArrayColumn<Double>(ms_p, "UVW").getColumnRange (rows));
+  ddId_p.reference (ROScalarColumn<Int>(ms_p, "DATA_DESC_ID").getColumnRange (rows));
+  if (needData_p) {
+    data_p.reference (ROArrayColumn<Complex>(ms_p, dataColumn_p).getColumnRange (rows));
+  }
+  // Fill the frequencies here, so they can be used in parallel.
+  for (uInt i=0; i<n; ++i) {
+    frequencies (ddId_p[i]);
+  }
+  return n;
+}
+
+Double MsPlotBinner::value (Axis axis, uInt corr, uInt chan, uInt row) const
+{
+  switch (axis) {
+  case TIME:
+    return time_p[row];
+  case UVDIST:
+    return sqrt(uvw_p(0,row)*uvw_p(0,row) + uvw_p(1,row)*uvw_p(1,row));
+  case UVDIST_L:
+    return sqrt(uvw_p(0,row)*uvw_p(0,row) + uvw_p(1,row)*uvw_p(1,row)) *
+           freqs_p[ddId_p[row]](chan) / C::c;
+  case U:
+    return uvw_p(0,row);
+  case V:
+    return uvw_p(1,row);
+  case W:
+    return uvw_p(2,row);
+  case CHANNEL:
+    return chan;
+  case FREQUENCY:
+    return freqs_p[ddId_p[row]](chan);
+  case AMPLITUDE:
+    return abs(data_p(corr,chan,row));
+  case PHASE:
+    return arg(data_p(corr,chan,row)) * 180. / C::pi;
+  case REAL:
+    return real(data_p(corr,chan,row));
+  case IMAGINARY:
+    return imag(data_p(corr,chan,row));
+  }
+  return 0;
+}
+
+Bool MsPlotBinner::inRegion (const Vector<Double>& region,
+                             uInt corr, uInt chan, uInt row) const
+{
+  // NaN compares False, so it is never inside the region.
+  Double x = value (xAxis_p, corr, chan, row);
+  Double y = value (yAxis_p, corr, chan, row);
+  return (x >= region(0)  &&  x <= region(1)  &&
+          y >= region(2)  &&  y <= region(3));
+}
+
+void MsPlotBinner::findRange()
+{
+  Bool needX = range_p(1) <= range_p(0);
+  Bool needY = range_p(3) <= range_p(2);
+  if (!needX  &&  !needY) {
+    return;
+  }
+  Int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
+  // Per thread xmin,xmax,ymin,ymax.
+  Matrix<Double> ext (4, nThreads);
+  for (Int t=0; t<nThreads; ++t) {
+    ext(0,t) = ext(2,t) = C::dbl_max;
+    ext(1,t) = ext(3,t) = -C::dbl_max;
+  }
+  uInt nrow = ms_p.nrow();
+  uInt maxRows = blockRows();
+  for (uInt r0=0; r0<nrow; ) {
+    Int nr = readBlock (r0, maxRows);
+    uInt nCorr = flag_p.shape()[0];
+    uInt nChan = flag_p.shape()[1];
+#pragma omp parallel for schedule(dynamic,64) num_threads(nThreads) if (nThreads > 1)
+    for (Int row=0; row<nr; ++row) {
+      Int t = 0;
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+#endif
+      if (useFlags_p  &&  flagRow_p[row]) {
+        continue;
+      }
+      for (uInt chan=0; chan<nChan; ++chan) {
+        for (uInt corr=0; corr<nCorr; ++corr) {
+          if (useFlags_p  &&  flag_p(corr,chan,row)) {
+            continue;
+          }
+          Double x = value (xAxis_p, corr, chan, row);
+          Double y = value (yAxis_p, corr, chan, row);
+          if (!isFinite(x)  ||  !isFinite(y)) {
+            continue;
+          }
+          if (x < ext(0,t)) ext(0,t) = x;
+          if (x > ext(1,t)) ext(1,t) = x;
+          if (y < ext(2,t)) ext(2,t) = y;
+          if (y > ext(3,t)) ext(3,t) = y;
+        }
+      }
+    }
+    r0 += nr;
+  }
+  for (uInt i=0; i<4; i+=2) {
+    if ((i == 0 && needX)  ||  (i == 2 && needY)) {
+      Double vmin = min (ext.row(i));
+      Double vmax = max (ext.row(i+1));
+      if (vmin > vmax) {
+        // No unflagged data.
+        vmin = 0;
+        vmax = 1;
+      } else if (vmin == vmax) {
+        vmin -= 0.5;
+        vmax += 0.5;
+      }
+      range_p(i)   = vmin;
+      range_p(i+1) = vmax;
+    }
+  }
+}
+
+void MsPlotBinner::bin()
+{
+  findRange();
+  Double x0 = range_p(0);
+  Double y0 = range_p(2);
+  Double sx = nx_p / (range_p(1) - range_p(0));
+  Double sy = ny_p / (range_p(3) - range_p(2));
+  Int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
+  // Each thread accumulates in its own bins.
+  Block<Matrix<uInt> > dens (nThreads);
+  Block<Vector<uInt> > cnt (nThreads);
+  Block<Vector<Double> > ymin (nThreads), ymax (nThreads), ysum (nThreads);
+  for (Int t=0; t<nThreads; ++t) {
+    dens[t].resize (nx_p, ny_p);
+    dens[t] = 0;
+    cnt[t].resize (nx_p);
+    cnt[t] = 0;
+    ymin[t].resize (nx_p);
+    ymin[t] = C::dbl_max;
+    ymax[t].resize (nx_p);
+    ymax[t] = -C::dbl_max;
+    ysum[t].resize (nx_p);
+    ysum[t] = 0.;
+  }
+  uInt nrow = ms_p.nrow();
+  uInt maxRows = blockRows();
+  for (uInt r0=0; r0<nrow; ) {
+    Int nr = readBlock (r0, maxRows);
+    uInt nCorr = flag_p.shape()[0];
+    uInt nChan = flag_p.shape()[1];
+#pragma omp parallel for schedule(dynamic,64) num_threads(nThreads) if (nThreads > 1)
+    for (Int row=0; row<nr; ++row) {
+      Int t = 0;
+#ifdef _OPENMP
+      t = omp_get_thread_num();
+#endif
+      if (useFlags_p  &&  flagRow_p[row]) {
+        continue;
+      }
+      for (uInt chan=0; chan<nChan; ++chan) {
+        for (uInt corr=0; corr<nCorr; ++corr) {
+          if (useFlags_p  &&  flag_p(corr,chan,row)) {
+            continue;
+          }
+          Double x = value (xAxis_p, corr, chan, row);
+          Double y = value (yAxis_p, corr, chan, row);
+          if (!isFinite(x)  ||  !isFinite(y)) {
+            continue;
+          }
+          // Check the bin in Double, because values far outside the
+          // range do not fit in an Int.
+          // The upper edge of the range falls in the last bin.
+          Double bx = floor((x - x0) * sx);
+          Double by = floor((y - y0) * sy);
+          if (bx == nx_p  &&  x == range_p(1)) bx = nx_p-1;
+          if (by == ny_p  &&  y == range_p(3)) by = ny_p-1;
+          if (bx < 0  ||  bx >= nx_p  ||  by < 0  ||  by >= ny_p) {
+            continue;
+          }
+          Int ix = Int(bx);
+          Int iy = Int(by);
+          dens[t](ix,iy)++;
+          cnt[t][ix]++;
+          ysum[t][ix] += y;
+          if (y < ymin[t][ix]) ymin[t][ix] = y;
+          if (y > ymax[t][ix]) ymax[t][ix] = y;
+        }
+      }
+    }
+    r0 += nr;
+  }
+  // Combine the results of the threads.
+  density_p.reference (dens[0]);
+  count_p.reference (cnt[0]);
+  yMin_p.reference (ymin[0]);
+  yMax_p.reference (ymax[0]);
+  yMean_p.reference (ysum[0]);
+  for (Int t=1; t<nThreads; ++t) {
+    density_p += dens[t];
+    count_p += cnt[t];
+    yMean_p += ysum[t];
+    for (uInt ix=0; ix<nx_p; ++ix) {
+      yMin_p[ix] = min (yMin_p[ix], ymin[t][ix]);
+      yMax_p[ix] = max (yMax_p[ix], ymax[t][ix]);
+    }
+  }
+  for (uInt ix=0; ix<nx_p; ++ix) {
+    if (count_p[ix] > 0) {
+      yMean_p[ix] /= count_p[ix];
+    } else {
+      yMin_p[ix] = yMax_p[ix] = yMean_p[ix] = 0;
+    }
+  }
+}
+
+void MsPlotBinner::toRecord (RecordInterface& rec) const
+{
+  rec.define ("density", density_p);
+  rec.define ("count", count_p);
+  rec.define ("ymin", yMin_p);
+  rec.define ("ymax", yMax_p);
+  rec.define ("ymean", yMean_p);
+  rec.define ("range", range_p);
+}
+
+Vector<uInt> MsPlotBinner::flagRegion (const Vector<Double>& region,
+                                       Int direction)
+{
+  if (region.nelements() != 4) {
+    throw AipsError ("MsPlotBinner: region must be [xmin,xmax,ymin,ymax]");
+  }
+  Int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = omp_get_max_threads();
+#endif
+  std::vector<uInt> rowsFound;
+  uInt nrow = ms_p.nrow();
+  uInt maxRows = blockRows();
+  for (uInt r0=0; r0<nrow; ) {
+    Int nr = readBlock (r0, maxRows);
+    uInt nCorr = flag_p.shape()[0];
+    uInt nChan = flag_p.shape()[1];
+    // Only the thread handling a row writes its flags.
+    Vector<Bool> hit (nr, False);
+#pragma omp parallel for schedule(dynamic,64) num_threads(nThreads) if (nThreads > 1)
+    for (Int row=0; row<nr; ++row) {
+      for (uInt chan=0; chan<nChan; ++chan) {
+        for (uInt corr=0; corr<nCorr; ++corr) {
+          Bool flagged = flagRow_p[row]  ||  flag_p(corr,chan,row);
+          // Samples already having the requested flag are skipped, as
+          // are flagged samples if only locating plotted data.
+          if ((direction == 1  &&  flagged)  ||
+              (direction == 0  &&  !flagged)  ||
+              (direction < 0  &&  useFlags_p  &&  flagged)) {
+            continue;
+          }
+          if (inRegion (region, corr, chan, row)) {
+            hit[row] = True;
+            if (direction >= 0) {
+              flag_p(corr,chan,row) = (direction == 1);
+            }
+          }
+        }
+      }
+      if (direction == 0  &&  hit[row]) {
+        // Clearing FLAG_ROW would also unflag the samples outside the
+        // region, so first move the row flag to their FLAG.
+        if (flagRow_p[row]) {
+          for (uInt chan=0; chan<nChan; ++chan) {
+            for (uInt corr=0; corr<nCorr; ++corr) {
+              if (! inRegion (region, corr, chan, row)) {
+                flag_p(corr,chan,row) = True;
+              }
+            }
+          }
+        }
+        flagRow_p[row] = False;
+      }
+    }
+    Bool anyHit = False;
+    for (Int row=0; row<nr; ++row) {
+      if (hit[row]) {
+        rowsFound.push_back (r0 + row);
+        anyHit = True;
+      }
+    }
+    if (anyHit  &&  direction >= 0) {
+      Slicer rows (IPosition(1, r0), IPosition(1, nr));
+      ArrayColumn<Bool> (ms_p, "FLAG").putColumnRange (rows, flag_p);
+      if (direction == 0) {
+        ScalarColumn<Bool> (ms_p, "FLAG_ROW").putColumnRange (rows, flagRow_p);
+      }
+    }
+    r0 += nr;
+  }
+  Vector<uInt> result (rowsFound.size());
+  for (uInt i=0; i<rowsFound.size(); ++i) {
+    result[i] = rowsFound[i];
+  }
+  return result;
+}
+
+
+} //# NAMESPACE CASA - END
@@ -0,0 +1,219 @@
+//# MsPlotBinner.h: Server-side binning of MS data for MsPlot
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef FLAGGING_MSPLOTBINNER_H
+#define FLAGGING_MSPLOTBINNER_H
+
+#include <casa/aips.h>
+#include <casa/BasicSL/String.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Arrays/Matrix.h>
+#include <casa/Arrays/Cube.h>
+#include <casa/Containers/Block.h>
+#include <casa/Containers/Record.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+// <summary>
+// Bin the visibilities of an MS on a plot grid without extracting all points
+// </summary>
+//
+// <use visibility=export>
+//
+// <reviewed reviewer="" date="yyyy/mm/dd" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> <linkto class="MeasurementSet">MeasurementSet</linkto>
+//   <li> <linkto class="MsPlot">MsPlot</linkto>
+// </prerequisite>
+//
+// <etymology>
+// Bins the data of an MsPlot plot.
+// </etymology>
+//
+// <synopsis>
+// MsPlot hands all selected points to TablePlot, which becomes very slow
+// and memory hungry for large data sets (e.g. amplitude against uv-distance
+// of a full observation). MsPlotBinner reduces the data to the resolution
+// of the plot instead. It streams the MS in blocks of rows and accumulates
+// for each (correlation,channel,row) sample the point (x,y) in
+// <ul>
+//   <li> a 2D density histogram of <src>nx</src> by <src>ny</src> bins, and
+//   <li> the number, minimum, maximum and mean of y per x-bin.
+// </ul>
+// Memory use only depends on the number of bins and the block size, not on
+// the size of the MS. The samples of a block are binned in parallel if
+// OpenMP is used; each thread has its own histograms, which are summed at
+// the end.
+//
+// The x and y axes can be one of TIME (s), UVDIST (m), UVDIST_L
+// (wavelengths), U, V, W (m), CHANNEL, FREQUENCY (Hz), AMPLITUDE, PHASE
+// (deg), REAL or IMAGINARY. The latter four are taken from the given data
+// column. If no range is given, it is determined in an extra pass over the
+// data.
+//
+// Because no points are kept, flagging a region of the plot is done by
+// streaming the data again: <src>flagRegion</src> sets or clears the FLAG
+// of the samples inside a region of the plot and returns the rows (of the
+// MS given at construction) that were changed. Use
+// <src>MeasurementSet::rowNumbers</src> to map them to the rows of the
+// original MS if the MS is a selection.
+// </synopsis>
+//
+// <example>
+// <srcblock>
+//   MsPlotBinner binner(ms, "UVDIST", "AMPLITUDE", "CORRECTED_DATA");
+//   binner.setBins(800, 600);
+//   binner.bin();
+//   const Matrix<uInt>& density = binner.density();
+// </srcblock>
+// </example>
+//
+// <motivation>
+// Interactive plots of large data sets should be bounded in memory and time.
+// </motivation>
+
+class MsPlotBinner
+{
+public:
+  // The supported plot axes.
+  enum Axis {TIME, UVDIST, UVDIST_L, U, V, W, CHANNEL, FREQUENCY,
+             AMPLITUDE, PHASE, REAL, IMAGINARY};
+
+  // Construct for the given axes and data column (DATA, CORRECTED_DATA or
+  // MODEL_DATA). If <src>useFlags</src> is True, flagged samples are not
+  // binned. An exception is thrown for an unknown axis or column.
+  MsPlotBinner (MeasurementSet& ms, const String& xAxis,
+                const String& yAxis, const String& dataColumn="DATA",
+                Bool useFlags=True);
+
+  ~MsPlotBinner();
+
+  // Convert an axis name to its type. An exception is thrown for an
+  // unknown name.
+  static Axis axisType (const String& name);
+
+  // Set the number of bins (default 512 by 512).
+  void setBins (uInt nx, uInt ny);
+
+  // Set the plot range. If the range of an axis is empty (max<=min), it
+  // is determined from the data.
+  void setRange (Double xmin, Double xmax, Double ymin, Double ymax);
+
+  // Stream the MS and bin the samples.
+  void bin();
+
+  // Get the results of <src>bin</src>.
+  // <group>
+  const Matrix<uInt>& density() const
+    { return density_p; }
+  const Vector<uInt>& count() const
+    { return count_p; }
+  const Vector<Double>& yMin() const
+    { return yMin_p; }
+  const Vector<Double>& yMax() const
+    { return yMax_p; }
+  const Vector<Double>& yMean() const
+    { return yMean_p; }
+  const Vector<Double>& range() const
+    { return range_p; }
+  // </group>
+
+  // Get the MS being binned.
+  const MeasurementSet& measurementSet() const
+    { return ms_p; }
+
+  // Put the results in a record with fields density, count, ymin, ymax,
+  // ymean and range ([xmin,xmax,ymin,ymax]).
+  void toRecord (RecordInterface& rec) const;
+
+  // Set (<src>direction=1</src>) or clear (<src>direction=0</src>) the
+  // flags of the samples in the region [xmin,xmax,ymin,ymax].
+  // A negative direction only locates the samples.
+  // If a sample of a row with FLAG_ROW set is unflagged, FLAG_ROW is
+  // cleared and the other samples of the row are flagged in FLAG.
+  // The rows containing such samples are returned.
+  Vector<uInt> flagRegion (const Vector<Double>& region, Int direction);
+
+private:
+  // Prohibit copy constructor and assignment.
+  MsPlotBinner (const MsPlotBinner&);
+  MsPlotBinner& operator= (const MsPlotBinner&);
+
+  // Read the block of rows starting at <src>row</src> in which all rows
+  // have the same data shape. The number of rows read is returned.
+  uInt readBlock (uInt row, uInt maxRows);
+
+  // Get the channel frequencies of the given data description id.
+  const Vector<Double>& frequencies (Int ddId);
+
+  // Get the value of a sample of the current block for the given axis.
+  Double value (Axis axis, uInt corr, uInt chan, uInt row) const;
+
+  // Is a sample of the current block inside the region [xmin,xmax,ymin,ymax]?
+  Bool inRegion (const Vector<Double>& region,
+                 uInt corr, uInt chan, uInt row) const;
+
+  // Determine the ranges not given by the user.
+  void findRange();
+
+  // Number of rows per block.
+  uInt blockRows() const;
+
+  MeasurementSet ms_p;
+  Axis   xAxis_p;
+  Axis   yAxis_p;
+  String dataColumn_p;
+  Bool   useFlags_p;
+  Bool   needData_p;
+  uInt   nx_p;
+  uInt   ny_p;
+  Vector<Double> range_p;
+  // Channel frequencies per data description id.
+  Block<Vector<Double> > freqs_p;
+  Block<Bool> haveFreqs_p;
+  // The current block of data.
+  Cube<Complex> data_p;
+  Cube<Bool>    flag_p;
+  Vector<Bool>  flagRow_p;
+  Vector<Double> time_p;
+  Matrix<Double> uvw_p;
+  Vector<Int>   ddId_p;
+  // The results.
+  Matrix<uInt>   density_p;
+  Vector<uInt>   count_p;
+  Vector<Double> yMin_p;
+  Vector<Double> yMax_p;
+  Vector<Double> yMean_p;
+};
+
+
+} //# NAMESPACE CASA - END
+
+#endif
@@ -0,0 +1,191 @@
+//# tMsPlotBinner.cc: Test the binning and region flagging of MsPlotBinner
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <casa/aips.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/Arrays/ArrayMath.h>
+#include <casa/Arrays/ArrayLogical.h>
+#include <casa/iostream.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <msvis/MSVis/test/MSTestFixture.h>
+#include <flagging/MSPlot/MsPlotBinner.h>
+#include <casa/namespace.h>
+
+// The MS has 3 rows of 2 correlations and 4 channels. The amplitude of
+// channel c in row r is 10*r+c+1. Row 0 has FLAG_ROW set (but no FLAG)
+// and row 1 has one flagged sample. Row 2 has two unflagged bad samples:
+// a huge value and a NaN.
+const Int nRow = 3;
+const Int nChan = 4;
+
+MeasurementSet createMS (const String& name)
+{
+  MeasurementSet ms = newTestMS (name);
+  Vector<Double> freqs(nChan);
+  for (Int i=0; i<nChan; ++i) {
+    freqs[i] = 1.4e9 + i*1e6;
+  }
+  addTestSpw (ms, freqs, 1e6);
+
+  MSColumns cols (ms);
+  for (Int row=0; row<nRow; ++row) {
+    Matrix<Complex> data(2, nChan);
+    for (Int chan=0; chan<nChan; ++chan) {
+      data.column(chan) = Complex(10*row + chan + 1, 0);
+    }
+    Matrix<Bool> flag(2, nChan, False);
+    if (row == 1) {
+      flag(0,1) = True;
+    } else if (row == 2) {
+      data(1,2) = Complex(1e30, 0);
+      Float nan;
+      setNaN (nan);
+      data(1,3) = Complex(nan, 0);
+    }
+    ms.addRow();
+    cols.time().put (row, 4.5e9);
+    cols.antenna1().put (row, 0);
+    cols.antenna2().put (row, row+1);
+    cols.dataDescId().put (row, 0);
+    cols.uvw().put (row, Vector<Double>(3, 100.*(row+1)));
+    cols.data().put (row, data);
+    cols.flag().put (row, flag);
+    cols.flagRow().put (row, row == 0);
+  }
+  return ms;
+}
+
+void testRange (MeasurementSet& ms)
+{
+  // The bad samples are not part of the range.
+  MsPlotBinner binner (ms, "CHANNEL", "AMPLITUDE");
+  binner.bin();
+  AlwaysAssertExit (binner.range()(0) == 0);
+  AlwaysAssertExit (binner.range()(1) == nChan-1);
+  AlwaysAssertExit (binner.range()(2) == 11);
+  AlwaysAssertExit (near (binner.range()(3), 1e30, 1e-6));
+  // Without flags row 0 is also used.
+  MsPlotBinner binner2 (ms, "CHANNEL", "AMPLITUDE", "DATA", False);
+  binner2.bin();
+  AlwaysAssertExit (binner2.range()(2) == 1);
+  // A given range is kept.
+  MsPlotBinner binner3 (ms, "CHANNEL", "AMPLITUDE");
+  binner3.setRange (-1, 5, 2, 3);
+  binner3.bin();
+  AlwaysAssertExit (binner3.range()(0) == -1  &&  binner3.range()(1) == 5);
+  AlwaysAssertExit (binner3.range()(2) == 2  &&  binner3.range()(3) == 3);
+}
+
+void testBin (MeasurementSet& ms)
+{
+  // One bin per channel and per unit of amplitude. The huge value falls
+  // outside the range and the NaN is ignored.
+  MsPlotBinner binner (ms, "CHANNEL", "AMPLITUDE", "DATA", False);
+  binner.setBins (nChan, 32);
+  binner.setRange (0, nChan, 0, 32);
+  binner.bin();
+  const Vector<uInt>& count = binner.count();
+  AlwaysAssertExit (count(0) == 6  &&  count(1) == 6);
+  AlwaysAssertExit (count(2) == 5  &&  count(3) == 5);
+  AlwaysAssertExit (sum(binner.density()) == 22);
+  AlwaysAssertExit (binner.density()(0,1) == 2);
+  AlwaysAssertExit (binner.density()(3,24) == 1);
+  AlwaysAssertExit (binner.yMin()(3) == 4);
+  AlwaysAssertExit (binner.yMax()(2) == 23);
+  AlwaysAssertExit (near (binner.yMean()(3), 12.));
+  // With flags row 0 and a sample of row 1 are left out.
+  MsPlotBinner binner2 (ms, "CHANNEL", "AMPLITUDE");
+  binner2.setBins (nChan, 32);
+  binner2.setRange (0, nChan, 0, 32);
+  binner2.bin();
+  AlwaysAssertExit (binner2.count()(0) == 4  &&  binner2.count()(1) == 3);
+  AlwaysAssertExit (binner2.count()(2) == 3  &&  binner2.count()(3) == 3);
+  // Values far outside a narrow range do not overflow the bin index.
+  MsPlotBinner binner3 (ms, "CHANNEL", "AMPLITUDE", "DATA", False);
+  binner3.setBins (nChan, 10);
+  binner3.setRange (0, nChan, 0, 1e-20);
+  binner3.bin();
+  AlwaysAssertExit (sum(binner3.count()) == 0);
+}
+
+void testFlagRegion (MeasurementSet& ms)
+{
+  MsPlotBinner binner (ms, "CHANNEL", "AMPLITUDE");
+  ROMSColumns cols (ms);
+  // Locate channel 2 of the unflagged rows.
+  Vector<Double> region(4);
+  region(0) = 1.5; region(1) = 2.5; region(2) = 0; region(3) = 100;
+  Vector<uInt> rows = binner.flagRegion (region, -1);
+  AlwaysAssertExit (rows.nelements() == 2  &&  rows(0) == 1  &&  rows(1) == 2);
+  // Unflag channel 0 of row 0. The row flag has to be moved to the other
+  // samples of the row.
+  region(0) = 0; region(1) = 0.5; region(2) = 0; region(3) = 5;
+  rows = binner.flagRegion (region, 0);
+  AlwaysAssertExit (rows.nelements() == 1  &&  rows(0) == 0);
+  AlwaysAssertExit (! cols.flagRow()(0));
+  Matrix<Bool> flag = cols.flag()(0);
+  AlwaysAssertExit (! flag(0,0)  &&  ! flag(1,0));
+  for (Int chan=1; chan<nChan; ++chan) {
+    AlwaysAssertExit (flag(0,chan)  &&  flag(1,chan));
+  }
+  // Row 1 has no flagged sample in the region, so it is untouched.
+  flag = cols.flag()(1);
+  AlwaysAssertExit (flag(0,1)  &&  ntrue(flag) == 1);
+  // Flag the large amplitudes; the NaN is not in the region.
+  region(0) = 0; region(1) = nChan; region(2) = 23.5; region(3) = 1e31;
+  rows = binner.flagRegion (region, 1);
+  AlwaysAssertExit (rows.nelements() == 1  &&  rows(0) == 2);
+  flag = cols.flag()(2);
+  AlwaysAssertExit (flag(0,3)  &&  flag(1,2)  &&  ! flag(1,3));
+  AlwaysAssertExit (ntrue(flag) == 2);
+  // Unflag the flagged sample of row 1, which has no row flag.
+  region(0) = 0.5; region(1) = 1.5; region(2) = 0; region(3) = 100;
+  rows = binner.flagRegion (region, 0);
+  AlwaysAssertExit (rows.nelements() == 2  &&  rows(0) == 0  &&  rows(1) == 1);
+  AlwaysAssertExit (! cols.flagRow()(1));
+  AlwaysAssertExit (ntrue(cols.flag()(1)) == 0);
+  flag = cols.flag()(0);
+  AlwaysAssertExit (! flag(0,1)  &&  ! flag(1,1)  &&  flag(0,2));
+}
+
+int main()
+{
+  try {
+    MeasurementSet ms = createMS ("tMsPlotBinner_tmp.ms");
+    testRange (ms);
+    testBin (ms);
+    testFlagRegion (ms);
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
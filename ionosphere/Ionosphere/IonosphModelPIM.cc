@@ -229,6 +229,9 @@ const char
 
     
 const Float defaultSlantSep = .1;    
+
+// maximum number of ED profiles kept in the cache
+const uInt maxCacheSize = 100000;
     
 
 // -----------------------------------------------------------------------
@@ -301,6 +304,7 @@ IonosphModelPIM::~IonosphModelPIM ()
 // -----------------------------------------------------------------------
 void IonosphModelPIM::setAlt( const Float *alt,uInt nalt )
 {
+  clearCache();
   IonosphModel::setAlt(alt,nalt);
   preFortran("PIM:setalt");
   fpimsetalt_(alt,(int*)&nalt); 
@@ -623,6 +627,21 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
     os<<"IMF Bz>0 implies Ap = "<<sap(0)<<" (Kp = "<<kp<<")"<<LogIO::POST;
   }
   
+// Profiles computed by earlier runs can only be reused if the same
+// model parameters are in effect. F10.7 and Ap taken from the tables
+// only depend on the date, so they are the same for each run.
+  Vector<Double> parms(4);
+  parms(0) = by;
+  parms(1) = bz;
+  parms(2) = fix_f107 ? sf107(0) : -1;
+  parms(3) = ( bz_south && !fix_ap ) ? -1 : sap(0);
+  if( parms.nelements()!=cache_parms.nelements() || !allEQ(parms,cache_parms) )
+  {
+    clearCache();
+    cache_parms.resize(parms.nelements());
+    cache_parms = parms;
+  }
+
 // clear one-time options (i.e. those that must be specified anew
 // each run)
   
@@ -658,6 +677,9 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
   uInt ncomputed=0;
   const Double sep_rad = sep_deg*C::degree,
               sep_mjd = sep_rad/2*C::pi;
+// Slants are sorted by time, so only slants from sl_near on can be
+// close enough in time to the current slant.
+  uInt sl_near=0;
   for( uInt ut=0; ut<nut; ut++ ) 
   {
     uInt sl_first=suniq(ut), // figure out first and last slant for this time slot
@@ -665,8 +687,11 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
     for( uInt sl=sl_first; sl<=sl_last; sl++ )
     {
       uInt idx=sidx(sl),sl1;
+      while( sl_near<sl && 
+             slants[idx].mjd()-slants[sidx(sl_near)].mjd() >= sep_mjd )
+        sl_near++;
       // is there a near-enough truly computed slot?
-      for( sl1=0; sl1<sl; sl1++ )
+      for( sl1=sl_near; sl1<sl; sl1++ )
       {
         uInt idx1=sidx(sl1);
         if( copy_from(idx1)<0 &&
@@ -686,7 +711,7 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
     }
   }
 // initialize a progress meter (if >1 slant requested)
-  uInt icomputed=0;
+  uInt icomputed=0,ncached=0;
   ProgressMeter prog_meter(1,max(ncomputed,2U),
       "Computing PIM profiles","PIM","1",String::toString(ncomputed));
   os<<"Minimal significant slant separation is "<<sep_deg<<" degrees.\n";
@@ -716,6 +741,17 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
               sl,edp[idx].slant().string().chars(),idx1);
         continue;
       }
+// Else it may have been computed by an earlier run.
+      SlantKey key( slants[idx] );
+      std::map<SlantKey,EDProfile>::const_iterator cached = cache.find(key);
+      if( cached != cache.end() )
+      {
+        edp[idx].copyData( cached->second );
+        ncached++;
+        if( ncomputed>1 )
+            prog_meter.update(++icomputed);
+        continue;
+      }
 // Else it needs to be computed. Load PIM for this time slot then.
 // load PIM for this time slot 
       if( !pim_loaded )
@@ -773,15 +809,33 @@ Block <EDProfile> IonosphModelPIM::getED( LogicalVector &isUniq,
         cerr<<"profile: "<<edp[idx].tec()<<" / "<<edp[idx].ed()<<endl;
       postFortran();
 
+// keep a copy in the cache
+      if( cache.size() >= maxCacheSize )
+        clearCache();
+      EDProfile &entry = cache[key];
+      entry.set_slant( slants[idx] );
+      entry.copyData( edp[idx] );
+
 // update the progress meter      
       if( ncomputed>1 )
           prog_meter.update(++icomputed);
     }
   }
+  if( ncached )
+    os<<ncached<<" of "<<ncomputed<<" profiles were taken from the cache."<<LogIO::POST;
   
   return edp;
 }
 
+// -----------------------------------------------------------------------
+// clearCache
+// Clears the cache of computed ED profiles
+// -----------------------------------------------------------------------
+void IonosphModelPIM::clearCache ()
+{
+  cache.clear();
+}
+
 
 } //# NAMESPACE CASA - END
 
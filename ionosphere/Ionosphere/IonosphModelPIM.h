@@ -91,6 +91,9 @@ class IonosphModelPIM : public IonosphModel
 // and returns the corresponding ED profile estimates.
 // isUniq is a vector of flags; if false, then the corresponding slant
 // was not actually computed, but rather copied from the nearest neighbour. 
+// Computed profiles are kept in a cache, keyed by the quantized slant 
+// (see SlantKey), and reused by later calls as long as the model
+// parameters (IMF, F10.7, Ap, altitude grid) are unchanged.
     virtual Block<EDProfile> getED ( LogicalVector &isUniq,
                                     const SlantSet &sl_set,
                                     const Vector<uInt> &sidx,
@@ -104,9 +107,18 @@ class IonosphModelPIM : public IonosphModel
 // Note that when IMF Bz is >0 (north), Ap no longer matters.
     void fixParameter       ( PIM_Parameter type,Float val);
 
+// Clears the cache of computed ED profiles
+    void clearCache ();
+// Returns the number of profiles in the cache
+    uInt cacheSize () const { return cache.size(); }
+
 // log sink
     static LogIO os;    
 
+  private:
+    std::map<SlantKey,EDProfile> cache;   // computed profiles
+    Vector<Double> cache_parms;           // model parameters used for them
+
 //  private:
 // clears all fixed parameters
 //    void clearFixes ();
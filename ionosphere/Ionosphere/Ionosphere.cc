@@ -8,6 +8,7 @@
 #include <measures/Measures/MeasFrame.h>
 #include <measures/Measures/EarthMagneticMachine.h>
 #include <casa/Arrays/Slice.h>
+#include <casa/Arrays/ArrayLogical.h>
 
 #include <casa/stdio.h>
     
@@ -15,6 +16,9 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 
 // define to 1 to use PIM IGRF calls instead of Measures
 #define USE_PIM_IGRF 0
+
+// maximum number of line-of-sight fields kept by Ionosphere::getTecRot()
+const uInt maxLOSCacheSize = 100000;
         
 uInt Ionosphere::debug_level=0;
 
@@ -81,6 +85,32 @@ uInt sortSlants( Vector<uInt> &sidx,Vector<uInt> &suniq,const SlantSet &sl_set)
   return sort.unique(suniq,sidx);
 }
 
+// -----------------------------------------------------------------------
+// SlantKey
+// Quantizes the slant's time, direction and position
+// -----------------------------------------------------------------------
+SlantKey::SlantKey ( const Slant &sl )
+{
+  t_ = (Int64)floor(sl.mjd()*86400.+.5);
+  Vector<Double> azel( sl.azEl() );
+  az_ = (Int)floor(azel(0)*1e6+.5);
+  el_ = (Int)floor(azel(1)*1e6+.5);
+  const Vector<Double> &xyz = sl.pos().getValue();
+  x_ = (Int)floor(xyz(0)+.5);
+  y_ = (Int)floor(xyz(1)+.5);
+  z_ = (Int)floor(xyz(2)+.5);
+}
+
+Bool SlantKey::operator < ( const SlantKey &other ) const
+{
+  if( t_ != other.t_ )   return t_ < other.t_;
+  if( az_ != other.az_ ) return az_ < other.az_;
+  if( el_ != other.el_ ) return el_ < other.el_;
+  if( x_ != other.x_ )   return x_ < other.x_;
+  if( y_ != other.y_ )   return y_ < other.y_;
+  return z_ < other.z_;
+}
+
 
 // -----------------------------------------------------------------------
 // FORTRAN declarations 
@@ -256,7 +286,29 @@ void Ionosphere::getTecRot ( Vector<Double> &tec,Vector<Double> &rot,const Block
   tec.resize(n);
 
   for( uInt i=0; i<n; i++ ) // loop over target slants 
+  {
+#if( !USE_PIM_IGRF )
+// reuse the line-of-sight field if this slant was seen before
+    const Vector<Float> &alt = ed[i].alt();
+    if( alt.nelements()!=los_alt.nelements() || !allEQ(alt,los_alt) )
+    {
+      clearCache();
+      los_alt.resize(alt.nelements());
+      los_alt = alt;
+    }
+    SlantKey key( ed[i].slant() );
+    std::map<SlantKey,Vector<Float> >::const_iterator iter = los_cache.find(key);
+    if( iter != los_cache.end() )
+      ed[i].setLOSField(iter->second);
+    else
+    {
+      if( los_cache.size() >= maxLOSCacheSize )
+        los_cache.clear();
+      los_cache[key] = ed[i].getLOSField();
+    }
+#endif
     rot(i)=ed[i].getTecRot(tec(i));
+  }
 }
 
 
@@ -300,6 +352,19 @@ const Vector<Float> & EDProfile::getLOSField () const
   return bpar_;
 }
 
+// -----------------------------------------------------------------------
+// EDProfile::setLOSField
+// Sets the magnetic field along the line of sight, as computed earlier
+// by getLOSField() for the same slant.
+// -----------------------------------------------------------------------
+void EDProfile::setLOSField ( const Vector<Float> &bpar ) const
+{
+  // Same const violation as in getLOSField(): the field is derived data.
+  Vector<Float> *bp = (Vector<Float>*) &bpar_;
+  bp->resize(bpar.nelements());
+  *bp = bpar;
+}
+
 #if( !USE_PIM_IGRF )
 // -----------------------------------------------------------------------
 // EDProfile::getTecRot
@@ -15,6 +15,7 @@
 #include <measures/Measures/MPosition.h>    
 #include <casa/BasicSL/Constants.h>    
 #include <casa/Logging/LogIO.h>    
+#include <map>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -88,6 +89,27 @@ typedef Block<Slant> SlantSet;
 // Helper function to sort slants into unique time slots
 uInt sortSlants( Vector<uInt> &sidx,Vector<uInt> &suniq,const SlantSet &sl);
 
+// -----------------------------------------------------------------------
+// SlantKey
+// <summary>
+// Quantized slant, for use as a cache key
+// </summary>
+// Slants with the same key are the same line-of-sight for all practical
+// purposes: the time is quantized to 1 second, the (Az,El) direction to 
+// 1 microradian and the (ITRF) position to 1 metre.
+// -----------------------------------------------------------------------
+class SlantKey
+{
+  private:
+      Int64 t_;
+      Int   az_,el_,x_,y_,z_;
+
+  public:
+      SlantKey ( const Slant &sl );
+
+      Bool operator < ( const SlantKey &other ) const;
+};
+
 // -----------------------------------------------------------------------
 // EDProfile
 // <summary>
@@ -147,6 +169,10 @@ class EDProfile
 // of sight. Returns the line-of-sight intensity (in Gauss) at each defined 
 // altitude point.
     const Vector<Float> & getLOSField() const; 
+
+// sets the line-of-sight field (e.g. from a cache), so that getLOSField()
+// does not need to compute it.
+    void setLOSField ( const Vector<Float> &bpar ) const;
     
 // copies data members directly from other EDProfile
     void copyData( const EDProfile &other );
@@ -178,6 +204,11 @@ class Ionosphere
     PtrBlock <IonosphData*> rtd;
     IonosphModel *model;
     Block <EDProfile> edp;
+// line-of-sight fields computed by getTecRot(), and the altitude grid
+// they were computed for. The field does not depend on the model, so it
+// can be reused for repeated slants.
+    std::map<SlantKey,Vector<Float> > los_cache;
+    Vector<Float> los_alt;
       
   public:
     static uInt   debug_level;
@@ -228,6 +259,9 @@ class Ionosphere
 // computes the TEC (int TECU) and rotation measure (in RMI), given a set 
 // of ED profiles
     void getTecRot ( Vector<Double> &tec,Vector<Double> &rmi,const Block<EDProfile> &ed );
+
+// clears the cache of line-of-sight fields used by getTecRot()
+    void clearCache () { los_cache.clear(); los_alt.resize(0); }
 };
 
 // -----------------------------------------------------------------------
@@ -100,6 +100,13 @@ template<class T> class MomentsBase;
 // However, MSMoments only allows to generate moments along spectral axis so far.
 // Implementation of generating moments along other axis is future work.
 //
+// The spectra are read from the MeasurementSet in blocks of rows and the
+// moments are written to the output MeasurementSets block by block, so
+// the data never have to be held in memory as a whole. If OpenMP is used,
+// the spectra of a block are processed in parallel by the clip method
+// (each thread using its own moment calculator); the window and fit
+// methods are done serially.
+//
 // Smoothing the data and making plots are not implemented so far.
 // </synopsis>
 //
@@ -227,6 +234,16 @@ private:
    Bool whatIsTheNoise (T& noise,
                         MeasurementSet &ms);
 
+   // Compute the moments of the spectra in FLOAT_DATA of <src>inMS</src>
+   // (masked by the flags of the input data) and put them in the 
+   // FLOAT_DATA column of the output MSs. The data are processed in 
+   // blocks of rows, in parallel if <src>parallel</src> is True.
+   // The number of failed fits is returned.
+   uInt computeMoments (PtrBlock<MeasurementSet*>& outPt,
+                        const MeasurementSet& inMS,
+                        Bool clipMethod, Bool windowMethod,
+                        Bool fitMethod, Bool parallel);
+
    // Data
    MeasurementSet *ms_p; 
 
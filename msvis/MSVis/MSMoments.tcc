@@ -44,6 +44,12 @@
 #include <lattices/Lattices/LatticeApply.h>
 #include <lattices/Lattices/MaskedLattice.h>
 #include <lattices/Lattices/SubLattice.h>
+#include <casa/Arrays/Cube.h>
+#include <casa/Utilities/CountedPtr.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -554,121 +560,25 @@ Bool MSMoments<T>::createMoments(PtrBlock< MeasurementSet* >& outPt,
     stdDeviation_p = noise ;
   }
 
-  // Create Lattice from input or smoothed MS
-  if ( pSmoothedData ) {
-    floatDataCol.attach( *pSmoothedData, "FLOAT_DATA" ) ;
-  }
-  else {
-    floatDataCol.attach( *ms_p, "FLOAT_DATA" ) ;
-  }
-  ArrayLattice<T> arrLatIn( floatDataCol.getColumn().nonDegenerate( IPosition( 2, 0, 1 ) ) ) ;
-  ROArrayColumn<Bool> flagCol( *ms_p, "FLAG" ) ;
-  Array<Bool> flagArr = flagCol.getColumn() ;
-  ROScalarColumn<Bool> flagRowCol( *ms_p, "FLAG_ROW" ) ;
-  for ( uInt irow = 0 ; irow < flagRowCol.nrow() ; irow++ ) {
-    if ( flagRowCol( irow ) ) {
-      flagArr[irow].set( False ) ;
-    }
-    else {
-      flagArr[irow].assign( !flagArr[irow] ) ;
-    }
-  }
-  const ArrayLattice<Bool> mskLatIn( flagArr.nonDegenerate( IPosition( 2, 0, 1 ) ) ) ;
-  MaskedLattice<T> *mskArrIn = new SubLattice<T>( arrLatIn, False) ;
-  ((SubLattice<T> *)mskArrIn)->setPixelMask( mskLatIn, False ) ; 
-  PtrBlock< MaskedLattice<T>* > arrLatOutPts( moments_p.nelements() ) ;
-  IPosition outDataShape ;
-  CoordinateSystem cSysOut = this->makeOutputCoordinates( outDataShape, 
-                                                          cSys, 
-                                                          mskArrIn->shape(), 
-                                                          momentAxis_p, 
-                                                          False ) ;
-  for ( uInt i = 0 ; i < moments_p.nelements() ; i++ ) {
-    ArrayLattice<T> tmpLattice( outDataShape ) ;
-    tmpLattice.set( (T)0 ) ;
-    arrLatOutPts[i] = new SubLattice<T>( tmpLattice, True ) ; 
-  }
-  
-  // Create appropriate MomentCalculator object
-  //os_p << LogIO::NORMAL << "Begin computation of moments" << LogIO::POST ;
-  PtrHolder< MomentCalcBase<T> > pMomentCalculatorHolder ;
+  // Compute the moments while streaming the (smoothed) input MS in 
+  // blocks of rows, and write them to the output MSs block by block.
+  // The interactive methods are done serially.
+  uInt nFailed = 0 ;
   try {
-    if ( clipMethod || smoothClipMethod ) {
-      //os_p << "create MomentClip" << LogIO::POST ;
-      pMomentCalculatorHolder.set( new MomentClip<T>( mskArrIn, *this, os_p, moments_p.nelements() ),
-                                   False, False ) ;
-    }
-    else if ( windowMethod ) {
-      //os_p << "create MomentWindow" << LogIO::POST ;
-      pMomentCalculatorHolder.set( new MomentWindow<T>( mskArrIn, *this, os_p, moments_p.nelements() ),
-                                   False, False ) ;
-    }
-    else if ( fitMethod ) {
-      //os_p << "create MomentFit" << LogIO::POST ;
-      pMomentCalculatorHolder.set( new MomentFit<T>( *this, os_p, moments_p.nelements() ),
-                                   False, False ) ;
-    }
-  }
-  catch ( AipsError x ) {
-    delete mskArrIn ;
-    mskArrIn = 0 ;
-    for ( uInt i = 0 ; i < arrLatOutPts.nelements() ; i++ ) {
-      delete arrLatOutPts[i] ;
-      arrLatOutPts[i] = 0 ;
-    }
-    if ( msSel_p != 0 ) {
-      String name = msSel_p->tableName() ;
-      delete msSel_p ;
-      msSel_p = 0 ;
-      Table::deleteTable( name, True ) ;
-    }
-    RETHROW( x ) ;
-  }
-
-  // Iterate optimally through the data, compute the moments, fill the output MSs
-  MomentCalcBase<T> *pMomentCalculator = pMomentCalculatorHolder.ptr() ;
-  try {
-    LatticeApply<T>::lineMultiApply( arrLatOutPts, *mskArrIn, *pMomentCalculator, momentAxis_p, NULL ) ;
-  }
-  catch ( AipsError x ) {
-    delete mskArrIn ;
-    mskArrIn = 0 ;
-    for ( uInt i = 0 ; i < arrLatOutPts.nelements() ; i++ ) {
-      delete arrLatOutPts[i] ;
-      arrLatOutPts[i] = 0 ;
-    }
-    if ( msSel_p != 0 ) {
-      String name = msSel_p->tableName() ;
-      delete msSel_p ;
-      msSel_p = 0 ;
-      Table::deleteTable( name, True ) ;
-    }
-    RETHROW( x ) ;
-  }
-
-  // Put moment results in output MS
-  try {
-    ostringstream oss ;
-    for ( uInt i = 0 ; i < arrLatOutPts.nelements() ; i++ ) {
+    for ( uInt i = 0 ; i < outFiles.nelements() ; i++ ) {
       outPt[i] = new MeasurementSet( outFiles[i], Table::Update ) ;
-      Array<T> tmpData = arrLatOutPts[i]->get() ;
-      ArrayColumn<T> outDataCol( *outPt[i], "FLOAT_DATA" ) ;
-      if ( ms_p->nrow() == 1 )
-        outDataCol.put( 0, tmpData ) ;
-      else 
-        outDataCol.putColumn( tmpData ) ;
+    }
+    nFailed = computeMoments( outPt, 
+                              pSmoothedData ? *pSmoothedData : *ms_p,
+                              clipMethod || smoothClipMethod, 
+                              windowMethod, 
+                              fitMethod, 
+                              ( clipMethod || smoothClipMethod ) && !doPlot ) ;
+    for ( uInt i = 0 ; i < outPt.nelements() ; i++ ) {
       outPt[i]->flush() ;
-      delete arrLatOutPts[i] ;
-      arrLatOutPts[i] = 0 ;
     }
   }
   catch ( AipsError x ) {
-    delete mskArrIn ;
-    mskArrIn = 0 ;
-    for ( uInt i = 0 ; i < arrLatOutPts.nelements() ; i++ ) {
-      delete arrLatOutPts[i] ;
-      arrLatOutPts[i] = 0 ;
-    }
     for ( uInt i = 0 ; i < outPt.nelements() ; i++ ) {
       if ( outPt[i] ) {
         String tmpname = outPt[i]->tableName() ;
@@ -687,11 +597,9 @@ Bool MSMoments<T>::createMoments(PtrBlock< MeasurementSet* >& outPt,
   }
 
   // Clean up
-  delete mskArrIn ;
-  mskArrIn = 0 ;
   if ( windowMethod || fitMethod ) {
-    if ( pMomentCalculator->nFailedFits() != 0 ) {
-      os_p << LogIO::NORMAL << "There were " << pMomentCalculator->nFailedFits() << " failed fits" << LogIO::POST ;
+    if ( nFailed != 0 ) {
+      os_p << LogIO::NORMAL << "There were " << nFailed << " failed fits" << LogIO::POST ;
     }
   }
 
@@ -706,6 +614,130 @@ Bool MSMoments<T>::createMoments(PtrBlock< MeasurementSet* >& outPt,
   return True;
 }
 
+template<class T>
+uInt MSMoments<T>::computeMoments( PtrBlock< MeasurementSet* >& outPt,
+                                   const MeasurementSet& inMS,
+                                   Bool clipMethod,
+                                   Bool windowMethod,
+                                   Bool fitMethod,
+                                   Bool parallel )
+{
+  ROArrayColumn<T> dataCol( inMS, "FLOAT_DATA" ) ;
+  ROArrayColumn<Bool> flagCol( *ms_p, "FLAG" ) ;
+  ROScalarColumn<Bool> flagRowCol( *ms_p, "FLAG_ROW" ) ;
+  uInt nMom = outPt.nelements() ;
+  Block< ArrayColumn<T> > outDataCols( nMom ) ;
+  for ( uInt i = 0 ; i < nMom ; i++ ) {
+    outDataCols[i].attach( *outPt[i], "FLOAT_DATA" ) ;
+  }
+
+  // The pixel axes are those of coordinates(): polarization, channel
+  // and (if more than one row) row.
+  uInt nrow = inMS.nrow() ;
+  IPosition cellShape = dataCol.shape( 0 ) ;
+  uInt nPol = cellShape( 0 ) ;
+  uInt nChan = cellShape( 1 ) ;
+  uInt nDim = ( nrow == 1 ) ? 2 : 3 ;
+  if ( momentAxis_p != 1 ) {
+    throw AipsError( "MSMoments: moments can only be computed along the spectral axis" ) ;
+  }
+
+  // Read about 64 MB of spectra at a time.
+  uInt rowSize = max( 1u, uInt( nPol * nChan * ( sizeof(T) + sizeof(Bool) ) ) ) ;
+  uInt nRowBlock = max( 1u, uInt( 64*1024*1024 / rowSize ) ) ;
+
+  // Each thread has its own moment calculator, as they hold internal state.
+  Int nThreads = 1 ;
+#ifdef _OPENMP
+  if ( parallel ) {
+    nThreads = omp_get_max_threads() ;
+  }
+#endif
+  Block< LogIO > logs( nThreads, os_p ) ;
+  Block< CountedPtr< MomentCalcBase<T> > > calcs( nThreads ) ;
+  for ( Int t = 0 ; t < nThreads ; t++ ) {
+    // The input profile itself is used for clipping and windowing; the 
+    // ancilliary lattice is only needed for smoothed data.
+    if ( clipMethod ) {
+      calcs[t] = new MomentClip<T>( 0, *this, logs[t], nMom ) ;
+    }
+    else if ( windowMethod ) {
+      calcs[t] = new MomentWindow<T>( 0, *this, logs[t], nMom ) ;
+    }
+    else if ( fitMethod ) {
+      calcs[t] = new MomentFit<T>( *this, logs[t], nMom ) ;
+    }
+    calcs[t]->init( nMom ) ;
+  }
+  Block< Vector<T> > profiles( nThreads ), results( nThreads ) ;
+  Block< Vector<Bool> > profileMasks( nThreads ), resultMasks( nThreads ) ;
+  for ( Int t = 0 ; t < nThreads ; t++ ) {
+    profiles[t].resize( nChan ) ;
+    profileMasks[t].resize( nChan ) ;
+    results[t].resize( nMom ) ;
+    resultMasks[t].resize( nMom ) ;
+  }
+
+  Block< Cube<T> > outData( nMom ) ;
+  for ( uInt r0 = 0 ; r0 < nrow ; r0 += nRowBlock ) {
+    uInt nr = min( nRowBlock, nrow - r0 ) ;
+    Slicer rowRange( IPosition( 1, r0 ), IPosition( 1, nr ) ) ;
+    Cube<T> data( dataCol.getColumnRange( rowRange ) ) ;
+    Cube<Bool> flag( flagCol.getColumnRange( rowRange ) ) ;
+    Vector<Bool> flagRow( flagRowCol.getColumnRange( rowRange ) ) ;
+    for ( uInt i = 0 ; i < nMom ; i++ ) {
+      outData[i].resize( nPol, 1, nr ) ;
+    }
+
+    // All moments of a spectrum are computed in one call.
+    String errMsg ;
+    Int nSpec = nPol * nr ;
+#pragma omp parallel for schedule(dynamic,16) num_threads(nThreads) if (nThreads > 1)
+    for ( Int ispec = 0 ; ispec < nSpec ; ispec++ ) {
+      Int t = 0 ;
+#ifdef _OPENMP
+      t = omp_get_thread_num() ;
+#endif
+      uInt ipol = ispec % nPol ;
+      uInt irow = ispec / nPol ;
+      Vector<T> &profile = profiles[t] ;
+      Vector<Bool> &profileMask = profileMasks[t] ;
+      for ( uInt ichan = 0 ; ichan < nChan ; ichan++ ) {
+        profile( ichan ) = data( ipol, ichan, irow ) ;
+        profileMask( ichan ) = !flagRow( irow ) && !flag( ipol, ichan, irow ) ;
+      }
+      IPosition pos( nDim, 0 ) ;
+      pos( 0 ) = ipol ;
+      if ( nDim == 3 ) {
+        pos( 2 ) = r0 + irow ;
+      }
+      try {
+        calcs[t]->multiProcess( results[t], resultMasks[t], profile, profileMask, pos ) ;
+        for ( uInt i = 0 ; i < nMom ; i++ ) {
+          outData[i]( ipol, 0, irow ) = results[t]( i ) ;
+        }
+      }
+      catch ( AipsError x ) {
+#pragma omp critical(MSMoments_computeMoments)
+        errMsg = x.getMesg() ;
+      }
+    }
+    if ( !errMsg.empty() ) {
+      throw AipsError( errMsg ) ;
+    }
+
+    for ( uInt i = 0 ; i < nMom ; i++ ) {
+      outDataCols[i].putColumnRange( rowRange, outData[i] ) ;
+    }
+  }
+
+  uInt nFailed = 0 ;
+  for ( Int t = 0 ; t < nThreads ; t++ ) {
+    nFailed += calcs[t]->nFailedFits() ;
+  }
+  return nFailed ;
+}
+
 template<class T>
 CoordinateSystem MSMoments<T>::coordinates()
 {
@@ -65,6 +65,7 @@
 #include <msvis/MSVis/VisBuffer.h>
 #include <msvis/MSVis/VisChunkAverager.h>
 #include <msvis/MSVis/VisIterator.h>
+#include <msvis/MSVis/AsynchronousTools.h>
 //#include <msvis/MSVis/VisibilityIterator.h>
 #include <tables/Tables/IncrementalStMan.h>
 #include <tables/Tables/ScalarColumn.h>
@@ -87,15 +88,637 @@
 #include <scimath/Mathematics/FFTServer.h>
 #include <casa/sstream.h>
 #include <casa/iomanip.h>
+#include <algorithm>
 #include <functional>
 #include <map>
+#include <memory>
 #include <set>
+#include <vector>
 #include <measures/Measures/MeasTable.h>
 #include <scimath/Mathematics/Smooth.h>
 #include <casa/Quanta/MVTime.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace casa {
 
+namespace {
+
+// The output MS is only written by the calling thread: the casacore table
+// system (and the Measures used by the iterators) is not thread-safe.
+// Each block holds all columns of a block of rows, so they are written
+// with one put per column.
+
+// The data, flags and weights of a VisIter iteration, written to the
+// output VisIter, which is then advanced to its next iteration.
+class CopyBlock
+{
+public:
+  CopyBlock (VisIter& viOut, uInt ncol)
+    : viOut_p  (viOut),
+      doWtSp_p (False),
+      data_p   (ncol),
+      outCol_p (ncol)
+  {}
+
+  void write()
+  {
+    viOut_p.setFlag (flag_p);
+    viOut_p.setWeightMat (weight_p);
+    viOut_p.setSigmaMat (sigma_p);
+    if (doWtSp_p) {
+      viOut_p.setWeightSpectrum (wtsp_p);
+    }
+    for (uInt i=0; i<data_p.nelements(); ++i) {
+      viOut_p.setVis (data_p[i], outCol_p[i]);
+    }
+    viOut_p++;
+    if (! viOut_p.more()) {
+      viOut_p.nextChunk();
+      if (viOut_p.moreChunks()) {
+        viOut_p.origin();
+      }
+    }
+  }
+
+  VisIter&       viOut_p;
+  Cube<Bool>     flag_p;
+  Matrix<Float>  weight_p;
+  Matrix<Float>  sigma_p;
+  Bool           doWtSp_p;
+  Cube<Float>    wtsp_p;
+  Block<Cube<Complex> > data_p;
+  Block<VisibilityIterator::DataColumn> outCol_p;
+};
+
+// A time averaged chunk, appended to the output MS.
+class AverBlock
+{
+public:
+  AverBlock (MeasurementSet& ms, MSColumns& msc, uInt startRow, uInt nrow,
+             uInt ndata)
+    : ms_p       (ms),
+      msc_p      (msc),
+      startRow_p (startRow),
+      nrow_p     (nrow),
+      doFloat_p  (False),
+      doWtSp_p   (False),
+      data_p     (ndata),
+      dataCols_p (ndata)
+  {}
+
+  void write()
+  {
+    RefRows rowstoadd(startRow_p, startRow_p + nrow_p - 1);
+
+    // ms_p.addRow(nrow_p, True);
+    ms_p.addRow(nrow_p);            // Try it without initialization.
+
+    msc_p.antenna1().putColumnCells(rowstoadd, ant1_p);
+    msc_p.antenna2().putColumnCells(rowstoadd, ant2_p);
+    msc_p.arrayId().putColumnCells(rowstoadd, arrayId_p);
+    for(uInt i = 0; i < data_p.nelements(); ++i)
+      dataCols_p[i]->putColumnCells(rowstoadd, data_p[i]);
+    if(doFloat_p)
+      msc_p.floatData().putColumnCells(rowstoadd, floatData_p);
+    msc_p.dataDescId().putColumnCells(rowstoadd, ddId_p);
+    msc_p.exposure().putColumnCells(rowstoadd, exposure_p);
+    msc_p.feed1().putColumnCells(rowstoadd, feed1_p);
+    msc_p.feed2().putColumnCells(rowstoadd, feed2_p);
+    msc_p.fieldId().putColumnCells(rowstoadd, fieldId_p);
+    msc_p.flagRow().putColumnCells(rowstoadd, flagRow_p);
+    msc_p.flag().putColumnCells(rowstoadd, flag_p);
+    msc_p.interval().putColumnCells(rowstoadd, interval_p);
+    msc_p.observationId().putColumnCells(rowstoadd, obsId_p);
+    msc_p.processorId().putColumnCells(rowstoadd, procId_p);
+    msc_p.scanNumber().putColumnCells(rowstoadd, scan_p);
+    msc_p.sigma().putColumnCells(rowstoadd, sigma_p);
+    msc_p.stateId().putColumnCells(rowstoadd, stateId_p);
+    msc_p.time().putColumnCells(rowstoadd, time_p);
+    msc_p.timeCentroid().putColumnCells(rowstoadd, timeCentroid_p);
+    msc_p.uvw().putColumnCells(rowstoadd, uvw_p);
+    msc_p.weight().putColumnCells(rowstoadd, weight_p);
+    if(doWtSp_p)
+      msc_p.weightSpectrum().putColumnCells(rowstoadd, wtsp_p);
+  }
+
+  MeasurementSet& ms_p;
+  MSColumns&      msc_p;
+  uInt            startRow_p;
+  uInt            nrow_p;
+  Vector<Int>     ant1_p, ant2_p, arrayId_p, ddId_p, feed1_p, feed2_p;
+  Vector<Int>     fieldId_p, obsId_p, procId_p, scan_p, stateId_p;
+  Vector<Double>  exposure_p, interval_p, time_p, timeCentroid_p;
+  Vector<Bool>    flagRow_p;
+  Cube<Bool>      flag_p;
+  Matrix<Float>   sigma_p, weight_p;
+  Matrix<Double>  uvw_p;
+  Bool            doFloat_p;
+  Cube<Float>     floatData_p;
+  Bool            doWtSp_p;
+  Cube<Float>     wtsp_p;
+  Block<Cube<Complex> >        data_p;
+  Block<ArrayColumn<Complex>*> dataCols_p;
+};
+
+// Time averages a chunk read by VisChunkAverager::readChunk() in its own
+// thread, which is started by the constructor.  averageChunk() does not
+// touch the MS, so the calling thread can meanwhile read and write.
+// An exception in the thread is rethrown by wait().
+class ChunkAverager : public async::Thread
+{
+public:
+  explicit ChunkAverager (VisChunkAverager& vca)
+    : vca_p    (vca),
+      result_p (0),
+      joined_p (False)
+  {
+    startThread();
+  }
+
+  ~ChunkAverager()
+  {
+    if (! joined_p) {
+      join();
+    }
+  }
+
+  // Wait for the averaging to finish and return the averaged chunk.
+  VisBuffer& wait()
+  {
+    if (! joined_p) {
+      join();
+      joined_p = True;
+    }
+    if (! error_p.empty()) {
+      throw AipsError ("Error averaging a chunk: " + error_p);
+    }
+    return *result_p;
+  }
+
+protected:
+  void* run()
+  {
+    try {
+      result_p = &vca_p.averageChunk();
+    } catch (AipsError& x) {
+      error_p = x.getMesg();
+    } catch (std::exception& x) {
+      error_p = x.what();
+    }
+    return 0;
+  }
+
+private:
+  VisChunkAverager& vca_p;
+  VisBuffer*        result_p;
+  Bool              joined_p;
+  String            error_p;
+};
+
+// The sparse weights of a nearest neighbour or linear interpolation of the
+// input channels onto the output channels of a spectral window.  Output
+// channel j is weight[j]*y(lower[j]) + (1-weight[j])*y(upper[j]); a
+// negative lower[j] means that it lies outside the input channels.
+// The tables only change with the input frequencies, so they are made once
+// per (field, spw) and time stamp and only read by the regridding threads.
+struct RegridWeights
+{
+  Int method;
+  uInt nIn;
+  std::vector<Int> lower;
+  std::vector<Int> upper;
+  std::vector<Float> weight;
+};
+
+// Make the weights for the given method (nearestNeighbour or linear).
+// The input frequencies can be in ascending or descending order.
+void makeRegridWeights(RegridWeights& w, const Vector<Double>& xout,
+                       const Vector<Double>& xin, Int method)
+{
+  uInt nIn = xin.size();
+  uInt nOut = xout.size();
+  w.method = method;
+  w.nIn = nIn;
+  w.lower.assign(nOut, -1);
+  w.upper.assign(nOut, -1);
+  w.weight.assign(nOut, 0.f);
+  if(nIn == 0){
+    return;
+  }
+  Bool desc = xin[0] > xin[nIn-1];
+  Double xmin = desc ? xin[nIn-1] : xin[0];
+  Double xmax = desc ? xin[0] : xin[nIn-1];
+  for(uInt j = 0; j < nOut; ++j){
+    Double x = xout[j];
+    if(x < xmin || x > xmax){
+      continue;                         // no extrapolation
+    }
+    // Find the input channels i0,i1 around x by bisection on the
+    // ascending order of the channels.
+    uInt lo = 0;
+    uInt hi = nIn - 1;
+    while(hi - lo > 1){
+      uInt mid = (lo + hi) / 2;
+      if(xin[desc ? nIn-1-mid : mid] <= x){
+        lo = mid;
+      }
+      else{
+        hi = mid;
+      }
+    }
+    Int i0 = desc ? nIn-1-lo : lo;
+    Int i1 = desc ? nIn-1-hi : hi;
+    Double f = 1.;
+    if(xin[i1] != xin[i0]){
+      f = (xin[i1] - x) / (xin[i1] - xin[i0]);
+    }
+    if(method == Int(InterpolateArray1D<Double,Complex>::nearestNeighbour)){
+      if(f < 0.5){
+        i0 = i1;
+      }
+      i1 = i0;
+      f = 1.;
+    }
+    w.lower[j] = i0;
+    w.upper[j] = i1;
+    w.weight[j] = f;
+  }
+}
+
+// Regrid the channel axis (axis 1) of yin with the sparse weights.
+// A sample outside the input channels is zero and flagged.  If one of the
+// two input samples is flagged, the other one is used; if both are, the
+// result is flagged.
+template<class T>
+void regridSparse(Array<T>& yout, Array<Bool>& youtFlags,
+                  const Array<T>& yin, const Array<Bool>& yinFlags,
+                  const RegridWeights& w)
+{
+  IPosition shape = yin.shape();
+  uInt nCorr = shape(0);
+  uInt nIn = shape(1);
+  if(nIn != w.nIn || !yinFlags.shape().isEqual(shape)){
+    throw(AipsError("regridSparse: shape of the data does not match the regrid weights"));
+  }
+  uInt nOut = w.lower.size();
+  uInt nOther = (nCorr*nIn == 0 ? 0 : shape.product() / (nCorr*nIn));
+  shape(1) = nOut;
+  yout.resize(shape);
+  youtFlags.resize(shape);
+  Bool delIn, delFlagsIn, delOut, delFlagsOut;
+  const T* pin = yin.getStorage(delIn);
+  const Bool* fin = yinFlags.getStorage(delFlagsIn);
+  T* pout = yout.getStorage(delOut);
+  Bool* fout = youtFlags.getStorage(delFlagsOut);
+  for(uInt k = 0; k < nOther; ++k){
+    for(uInt j = 0; j < nOut; ++j){
+      T* po = pout + (k*nOut + j)*nCorr;
+      Bool* fo = fout + (k*nOut + j)*nCorr;
+      if(w.lower[j] < 0){
+        for(uInt c = 0; c < nCorr; ++c){
+          po[c] = T(0);
+          fo[c] = True;
+        }
+        continue;
+      }
+      uInt off0 = (k*nIn + w.lower[j])*nCorr;
+      uInt off1 = (k*nIn + w.upper[j])*nCorr;
+      const T* p0 = pin + off0;
+      const T* p1 = pin + off1;
+      const Bool* f0 = fin + off0;
+      const Bool* f1 = fin + off1;
+      Float w0 = w.weight[j];
+      Float w1 = 1 - w0;
+      for(uInt c = 0; c < nCorr; ++c){
+        if(f0[c] == f1[c]){
+          po[c] = w0*p0[c] + w1*p1[c];
+          fo[c] = f0[c];
+        }
+        else if(f0[c]){
+          po[c] = p1[c];
+          fo[c] = False;
+        }
+        else{
+          po[c] = p0[c];
+          fo[c] = False;
+        }
+      }
+    }
+  }
+  yin.freeStorage(pin, delIn);
+  yinFlags.freeStorage(fin, delFlagsIn);
+  yout.putStorage(pout, delOut);
+  youtFlags.putStorage(fout, delFlagsOut);
+}
+
+// Regrid only the flags (e.g. of FLAG_CATEGORY) in the same way.
+void regridSparseFlags(Array<Bool>& youtFlags, const Array<Bool>& yinFlags,
+                       const RegridWeights& w)
+{
+  IPosition shape = yinFlags.shape();
+  uInt nCorr = shape(0);
+  uInt nIn = shape(1);
+  if(nIn != w.nIn){
+    throw(AipsError("regridSparseFlags: shape of the flags does not match the regrid weights"));
+  }
+  uInt nOut = w.lower.size();
+  uInt nOther = (nCorr*nIn == 0 ? 0 : shape.product() / (nCorr*nIn));
+  shape(1) = nOut;
+  youtFlags.resize(shape);
+  Bool delIn, delOut;
+  const Bool* fin = yinFlags.getStorage(delIn);
+  Bool* fout = youtFlags.getStorage(delOut);
+  for(uInt k = 0; k < nOther; ++k){
+    for(uInt j = 0; j < nOut; ++j){
+      Bool* fo = fout + (k*nOut + j)*nCorr;
+      if(w.lower[j] < 0){
+        for(uInt c = 0; c < nCorr; ++c){
+          fo[c] = True;
+        }
+        continue;
+      }
+      const Bool* f0 = fin + (k*nIn + w.lower[j])*nCorr;
+      const Bool* f1 = fin + (k*nIn + w.upper[j])*nCorr;
+      for(uInt c = 0; c < nCorr; ++c){
+        fo[c] = f0[c] && f1[c];
+      }
+    }
+  }
+  yinFlags.freeStorage(fin, delIn);
+  youtFlags.putStorage(fout, delOut);
+}
+
+// The cells of a MAIN table row to be regridded by regridSpw, and the
+// regridded result.
+struct RegridRow
+{
+  RegridRow()
+    : row(0), iDone(0), weights(-1), relShift(0.), flagsWritten(False),
+      hasFloat(False), hasSigmaSp(False), hasWeightSp(False),
+      hasFlagCat(False)
+  {
+    for(uInt i = 0; i < 4; ++i)
+      hasCmplx[i] = False;
+  }
+
+  uInt row;
+  Int iDone;
+  // The input and output channel frequencies.  They are copies, because
+  // the reference counts of Arrays must not be shared between threads.
+  Vector<Double> xindd;
+  Vector<Double> xout;
+  // The index of the regrid weights of the row in its block (or -1 if the
+  // interpolation is not nearest neighbour or linear).
+  Int weights;
+  Double relShift;
+  // CORRECTED_DATA, DATA, LAG_DATA, MODEL_DATA (in that order).
+  Bool hasCmplx[4];
+  Array<Complex> cmplx[4];
+  Array<Bool> flags;
+  Array<Bool> flagsOut;
+  Bool flagsWritten;
+  Bool hasFloat, hasSigmaSp, hasWeightSp, hasFlagCat;
+  Array<Float> floatData, sigmaSp, weightSp;
+  Array<Bool> flagCat;
+};
+
+// Hanning smooth (if requested) and regrid a spectrum of a complex column.
+void regridCmplx(Array<Complex>& yout, Array<Bool>& youtFlags,
+                 Array<Complex>& yin, Array<Bool>& yinFlags,
+                 const Array<Bool>& yinFlagsUnsmoothed, Bool doHanningSmooth,
+                 const Vector<Double>& xout, const Vector<Double>& xindd,
+                 Int method, Double relShift,
+                 InterpolateArray1D<Double,Complex>::InterpolationMethod methodC,
+                 const RegridWeights* weights,
+                 FFTServer<Float, Complex>& fFFTServer)
+{
+  Bool doExtrapolate = False;
+  Array<Complex> yinIntermediate;
+  Array<Bool> yinFlagsIntermediate;
+
+  // hanning smooth if requested
+  if(doHanningSmooth){
+    // copy yin to yinUnsmoothed 
+    Array<Complex> yinUnsmoothed;
+    yinUnsmoothed.assign(yin);
+
+    Smooth<Complex>::hanning(yin, // the output
+                             yinFlags, // the output flags
+                             yinUnsmoothed, // the input
+                             yinFlagsUnsmoothed, // the input flags
+                             False);  // for flagging: good is not true
+  }
+
+  if(method==(Int)SubMS::useLinIntThenFFTShift){
+    // first interpolate to equidistant grid at initial timestamp
+    if(weights){
+      regridSparse(yinIntermediate, yinFlagsIntermediate, yin, yinFlags, *weights);
+    }
+    else{
+      InterpolateArray1D<Double,Complex>::interpolate(yinIntermediate, // the new visibilities
+                                                      yinFlagsIntermediate, // the new flags
+                                                      xout, // the new channel centers (for the output SPW timestamp)
+                                                      xindd, // the old channel centers
+                                                      yin, // the old visibilities
+                                                      yinFlags,// the old flags
+                                                      methodC, // the interpol method
+                                                      False, // for flagging: good is not true
+                                                      doExtrapolate // do not extrapolate
+                                                      );
+    }
+    // shift from this timestamp to the output SPW timestamp
+    fFFTServer.fftshift(yout, youtFlags, yinIntermediate, yinFlagsIntermediate, 
+                        1, // axis 1 of the array is the polarisation axis 
+                        relShift, 
+                        False, // for flagging: good is not true 
+                        False);
+  }
+  else if(method==(Int)SubMS::useFFTShift){
+    // shift from this timestamp to the output SPW timestamp
+    fFFTServer.fftshift(yout, youtFlags, yin, yinFlags, 
+                        1, // axis 1 of the array is the polarisation axis 
+                        relShift, 
+                        False, // for flagging: good is not true 
+                        False);
+  }
+  else if(weights){
+    regridSparse(yout, youtFlags, yin, yinFlags, *weights);
+  }
+  else{
+    InterpolateArray1D<Double,Complex>::interpolate(yout, // the new visibilities
+                                                    youtFlags, // the new flags
+                                                    xout, // the new channel centers
+                                                    xindd, // the old channel centers
+                                                    yin, // the old visibilities 
+                                                    yinFlags,// the old flags
+                                                    methodC, // the interpol method
+                                                    False, // for flagging: good is not true
+                                                    doExtrapolate // do not extrapolate
+                                                    );
+  }
+}
+
+// Regrid the cells of a row.  This does not access the MS, so rows can be
+// done in parallel, each thread using its own FFTServer.  The regrid
+// weights are used (if given) instead of InterpolateArray1D.
+void regridRowCells(RegridRow& r, Bool doHanningSmooth, Int method,
+                    const RegridWeights* weights,
+                    FFTServer<Float, Complex>& fFFTServer)
+{
+  Bool doExtrapolate = False;
+  const Vector<Double>& xindd = r.xindd;
+  const Vector<Double>& xout = r.xout;
+  Double relShift = r.relShift;
+
+  InterpolateArray1D<Double,Complex>::InterpolationMethod  methodC = InterpolateArray1D<Double,Complex>::linear; // the default
+  InterpolateArray1D<Double,Float>::InterpolationMethod  methodF = InterpolateArray1D<Double,Float>::linear;
+  if(!(fabs(relShift)>0. && 
+       (method==(Int)SubMS::useFFTShift || method==(Int)SubMS::useLinIntThenFFTShift))){
+    methodC = (InterpolateArray1D<Double,Complex>::InterpolationMethod) method;
+    methodF = (InterpolateArray1D<Double,Float>::InterpolationMethod) method;
+  }
+
+  Array<Bool>& yinFlags = r.flags;
+  Array<Bool> yinFlagsUnsmoothed;
+  if(doHanningSmooth){
+    yinFlagsUnsmoothed.assign(yinFlags);
+  }
+
+  // regrid the complex columns; MODEL_DATA is not smoothed and LAG_DATA
+  // does not determine the flags.
+  for(uInt i = 0; i < 4; ++i){
+    if(r.hasCmplx[i]){
+      Array<Complex> yout;
+      Array<Bool> youtFlags;
+      regridCmplx(yout, youtFlags, r.cmplx[i], yinFlags, yinFlagsUnsmoothed,
+                  doHanningSmooth && i != 3, xout, xindd, method, relShift,
+                  methodC, weights, fFFTServer);
+      r.cmplx[i].reference(yout);
+      if(!r.flagsWritten && i != 2){
+        r.flagsOut.reference(youtFlags);
+        r.flagsWritten = True;
+      }
+    }
+  }
+
+  // regrid the Float columns
+  if(r.hasFloat){
+    Array<Float> yinf(r.floatData);
+    Array<Float> youtf;
+    Array<Bool> youtFlags;
+    Array<Float> fYinIntermediate;
+    Array<Bool> yinFlagsIntermediate;
+    if(doHanningSmooth){
+      Array<Float> yinfUnsmoothed;
+      yinfUnsmoothed.assign(yinf);
+
+      Smooth<Float>::hanning(yinf, yinFlags, yinfUnsmoothed, yinFlagsUnsmoothed, False);  
+    }
+
+    if(method==(Int)SubMS::useLinIntThenFFTShift){
+      if(weights){
+        regridSparse(fYinIntermediate, yinFlagsIntermediate, yinf, yinFlags, *weights);
+      }
+      else{
+        InterpolateArray1D<Double,Float>::interpolate(fYinIntermediate, yinFlagsIntermediate, xout, 
+                                                      xindd, yinf, yinFlags,
+                                                      methodF, False, doExtrapolate);
+      }
+      fFFTServer.fftshift(youtf, youtFlags, fYinIntermediate, yinFlagsIntermediate, 
+                          1, relShift, False);
+
+    }
+    else if(method==(Int)SubMS::useFFTShift){
+      fFFTServer.fftshift(youtf, youtFlags, yinf, yinFlags, 
+                          1, relShift, False);
+    }
+    else if(weights){
+      regridSparse(youtf, youtFlags, yinf, yinFlags, *weights);
+    }
+    else{
+      InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout, xindd, 
+                                                     yinf, yinFlags, methodF, False, doExtrapolate);
+    }
+
+    r.floatData.reference(youtf);
+    if(!r.flagsWritten){ 
+      r.flagsOut.reference(youtFlags);
+      r.flagsWritten = True;
+    }
+  }
+
+  if(r.hasSigmaSp){
+    Array<Float> youtf;
+    Array<Bool> youtFlags;
+    if(weights){
+      regridSparse(youtf, youtFlags, r.sigmaSp, yinFlags, *weights);
+    }
+    else{
+      InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout, xindd, 
+                                                     r.sigmaSp, yinFlags, methodF, False, doExtrapolate);
+    }
+    r.sigmaSp.reference(youtf);
+  }
+  if(r.hasWeightSp){
+    Array<Float> youtf;
+    Array<Bool> youtFlags;
+    if(weights){
+      regridSparse(youtf, youtFlags, r.weightSp, yinFlags, *weights);
+    }
+    else{
+      InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout,
+                                                     xindd, r.weightSp, yinFlags,
+                                                     methodF, False, doExtrapolate);
+    }
+    r.weightSp.reference(youtf);
+  }
+
+  // deal with FLAG_CATEGORY
+  if(r.hasFlagCat && weights){
+    // all categories at once
+    Array<Bool> flagCatOut;
+    regridSparseFlags(flagCatOut, r.flagCat, *weights);
+    r.flagCat.reference(flagCatOut);
+  }
+  else if(r.hasFlagCat){
+    Array<Bool>& flagCat = r.flagCat;
+    IPosition flagCatShape = flagCat.shape();
+    Int nCorrelations = flagCatShape(0); // get the dimension of the first axis
+    Int nChannels = flagCatShape(1); // get the dimension of the second axis
+    Int nCat = flagCatShape(2); // the dimension of the third axis ==
+                                // number of categories
+    Int nOutChannels = xout.size();
+	  
+    Vector<Float> dummyYin(nChannels);
+    Vector<Float> dummyYout(nOutChannels);
+    Array<Bool> youtFlags;
+    Array<Bool> flagCatOut(IPosition(3, nCorrelations, nOutChannels, nCat)); 
+	  
+    for(Int i=0; i<nCat; i++){
+      IPosition start(0,0,i), length (nCorrelations,nChannels,i), stride (1,1,0);
+      Slicer slicer (start, length, stride, Slicer::endIsLast);
+      yinFlags.assign(flagCat(slicer));
+      InterpolateArray1D<Double, Float>::interpolate(dummyYout, youtFlags,
+                                                     xout, xindd, 
+                                                     dummyYin, yinFlags,
+                                                     methodF, False, False);
+      // write the slice to the array flagCatOut
+      for(Int j=0; j<nCorrelations; j++){
+        for(Int k=0; k<nOutChannels; k++){
+          flagCatOut(IPosition(3, j, k, i)) = youtFlags(IPosition(2,j,k));
+        }
+      }
+    }
+    flagCat.reference(flagCatOut);
+  }
+}
+
+} // anonymous namespace
+
+
 //typedef ROVisibilityIterator ROVisIter;
 //typedef VisibilityIterator VisIter;
   
@@ -2101,111 +2724,129 @@ Bool SubMS::fillAllTables(const Vector<MS::PredefinedColumns>& datacols)
       progressStep = 0.2;
     }
 
-    // prepare some regridding prerequisites
-    FFTServer<Float, Complex> fFFTServer; // for fftshift, if needed
+    // prepare some regridding prerequisites: an FFTServer (for fftshift,
+    // if needed) per thread, because it cannot be shared
+    Int nThreads = 1;
+#ifdef _OPENMP
+    nThreads = omp_get_max_threads();
+#endif
+    Block<FFTServer<Float, Complex> > fftServers(nThreads);
+
+    // The input channel frequencies of a (field, spw) pair only change when
+    // the time stamp changes, and the rows are sorted in time, so the
+    // frequency conversion is done only once per (field, spw) and time.
+    vector<Double> xinddTime(oldSpwId.size(), -1.);
+    vector<Bool> xinddValid(oldSpwId.size(), False);
+    vector<Vector<Double> > xinddCache(oldSpwId.size());
+    vector<Double> theShiftCache(oldSpwId.size(), 0.);
+    ScalarColumn<Double> mainTimeCol = mainCols.time();
+
+    // The rows are read and written in blocks; in between, the rows of a
+    // block are regridded in parallel (the table access is not thread-safe).
+    // The nearest neighbour and linear interpolation use sparse weights,
+    // made when the input frequencies of a (field, spw) change and kept
+    // per block, so the rows of a block do not share them with the next.
+    const uInt maxBlockRows = 1024;
+    const Double maxBlockBytes = 64. * 1024. * 1024.;
+    vector<RegridRow> block;
+    block.reserve(maxBlockRows);
+    vector<RegridWeights> blockWeights;
+    vector<Int> weightsIndex(oldSpwId.size(), -1);
  
     // start loop over main table
-    for(uInt mainTabRowI=0; mainTabRowI<nMainTabRows; mainTabRowI++){
+    uInt mainTabRowI = 0;
+    while(mainTabRowI<nMainTabRows){
+
+      // Read a block of rows.
+      block.clear();
+      blockWeights.clear();
+      std::fill(weightsIndex.begin(), weightsIndex.end(), -1);
+      Double blockBytes = 0.;
+      for(; mainTabRowI<nMainTabRows && block.size()<maxBlockRows && blockBytes<maxBlockBytes;
+	  mainTabRowI++){
       
-      uInt mainTabRow = sortedI(mainTabRowI); // i.e. mainTabRow is sorted in time
+	uInt mainTabRow = sortedI(mainTabRowI); // i.e. mainTabRow is sorted in time
 
-      //if(mainTabRow!=mainTabRowI){
-      //  cout << "processing row " << mainTabRow << ", index " << mainTabRowI << endl;
-      //}
+	// For each MAIN table row, the FIELD_ID cell and the DATA_DESC_ID cell are read 
+	Int theFieldId = fieldIdCol(sortedI(mainTabRow));
+	Int theDataDescId = DDIdCol(sortedI(mainTabRow));
+	// and the SPW_ID extracted from the corresponding row in the DATA_DESCRIPTION table.
+	Int theSPWId = SPWIdCol(theDataDescId);
 
-      // For each MAIN table row, the FIELD_ID cell and the DATA_DESC_ID cell are read 
-      Int theFieldId = fieldIdCol(sortedI(mainTabRow));
-      Int theDataDescId = DDIdCol(sortedI(mainTabRow));
-      // and the SPW_ID extracted from the corresponding row in the DATA_DESCRIPTION table.
-      Int theSPWId = SPWIdCol(theDataDescId);
-
-      MEpoch theObsTime = mainTimeMeasCol(mainTabRow);
-      
-      //  The pair (theFieldId, theSPWId) is looked up in the "done table". 
-      Int iDone = -1;
-      for (uInt i=0; i<oldSpwId.size(); i++){
-	if(oldSpwId[i]==theSPWId && (oldFieldId[i]==theFieldId || phaseCenterFieldId>=-1)){
-	  // if common phase center is given, treat all fields the same
-	  iDone = i;
-	  break;
+	//  The pair (theFieldId, theSPWId) is looked up in the "done table". 
+	Int iDone = -1;
+	for (uInt i=0; i<oldSpwId.size(); i++){
+	  if(oldSpwId[i]==theSPWId && (oldFieldId[i]==theFieldId || phaseCenterFieldId>=-1)){
+	    // if common phase center is given, treat all fields the same
+	    iDone = i;
+	    break;
+	  }
+	}
+	if(iDone<0){ // should not occur
+	  os << LogIO::SEVERE << "Internal error: Did not find regrid parameters for field ==" 
+	     << theFieldId << " spw ==" <<  theSPWId << LogIO::POST;
+	  return 0;
 	}
-      }
-      if(iDone<0){ // should not occur
-	os << LogIO::SEVERE << "Internal error: Did not find regrid parameters for field ==" 
-	   << theFieldId << " spw ==" <<  theSPWId << LogIO::POST;
-	return 0;
-      }
-      
-      
-      if (DDIdCol(mainTabRow)!=newDataDescId[iDone]){
-	// If the data description actually changed, then DATA_DESC_ID 
-	//	of this main table row is set to the new value given in the "done" table
-	DDIdCol.put(mainTabRow, newDataDescId[iDone]);
-	
-      }
       
-      //Furthermore, if regrid[iDone] is true, the visibilities and all 
-      // channel-number-dependent arrays need to be regridded.
-      if(regrid[iDone]){
-
-	Bool doExtrapolate = False;
+	if (DDIdCol(mainTabRow)!=newDataDescId[iDone]){
+	  // If the data description actually changed, then DATA_DESC_ID 
+	  //	of this main table row is set to the new value given in the "done" table
+	  DDIdCol.put(mainTabRow, newDataDescId[iDone]);
+	}
 
-	// regrid the complex columns
-	Array<Complex> yout;
-	Array<Bool> youtFlags;
-	Bool youtFlagsWritten(False);
-	Array<Complex> yin;
-	Array<Bool> yinFlags((*oldFLAGColP)(mainTabRow));
-	Array<Bool> yinFlagsUnsmoothed;
-	Array<Complex> yinIntermediate;
-	Array<Bool> yinFlagsIntermediate;
-	if(doHanningSmooth){
-	  yinFlagsUnsmoothed.assign(yinFlags);
+	block.push_back(RegridRow());
+	RegridRow& r = block.back();
+	r.row = mainTabRow;
+	r.iDone = iDone;
+      
+	//Furthermore, if regrid[iDone] is true, the visibilities and all 
+	// channel-number-dependent arrays need to be regridded.
+	if(!regrid[iDone]){
+	  continue;
 	}
 
-	Vector<Double> xindd(xold[iDone].size());
-	Double theShift = 0.;
+	Double theTime = mainTimeCol(mainTabRow);
+	if(!xinddValid[iDone] || (transform[iDone] && theTime!=xinddTime[iDone])){
+	  Vector<Double> xindd(xold[iDone].size());
+	  Double theShift = 0.;
 
-	if(transform[iDone]){
+	  if(transform[iDone]){
 
-	  // create frequency machine for this time stamp
-	  MFrequency::Ref fromFrame = MFrequency::Ref(fromFrameTypeV[iDone], MeasFrame(theFieldDirV[iDone], mObsPosV[iDone], theObsTime));
-	  Unit unit(String("Hz"));
-	  MFrequency::Convert freqTrans2(unit, fromFrame, outFrameV[iDone]);
+	    MEpoch theObsTime = mainTimeMeasCol(mainTabRow);
+
+	    // create frequency machine for this time stamp
+	    MFrequency::Ref fromFrame = MFrequency::Ref(fromFrameTypeV[iDone], MeasFrame(theFieldDirV[iDone], mObsPosV[iDone], theObsTime));
+	    Unit unit(String("Hz"));
+	    MFrequency::Convert freqTrans2(unit, fromFrame, outFrameV[iDone]);
 	
-	  if(method[iDone]==(Int)useFFTShift || method[iDone]==(Int)useLinIntThenFFTShift){
-	    uInt centerChan = xold[iDone].size()/2;
-	    theShift = freqTrans2(xold[iDone][centerChan]).get(unit).getValue() - xin[iDone][centerChan];
-	    //cout << "the shift " << theShift << endl;
-	    for(uInt i=0; i<xin[iDone].size(); i++){ // cannot use assign due to different data type
-	      xindd[i] = xin[iDone][i];
+	    if(method[iDone]==(Int)useFFTShift || method[iDone]==(Int)useLinIntThenFFTShift){
+	      uInt centerChan = xold[iDone].size()/2;
+	      theShift = freqTrans2(xold[iDone][centerChan]).get(unit).getValue() - xin[iDone][centerChan];
+	      for(uInt i=0; i<xin[iDone].size(); i++){ // cannot use assign due to different data type
+		xindd[i] = xin[iDone][i];
+	      }
 	    }
-	  }
-	  else{
-	    // transform from this timestamp to the one of the output SPW
-	    for(uInt i=0; i<xindd.size(); i++){
-	      xindd[i] = freqTrans2(xold[iDone][i]).get(unit).getValue();
+	    else{
+	      // transform from this timestamp to the one of the output SPW
+	      for(uInt i=0; i<xindd.size(); i++){
+		xindd[i] = freqTrans2(xold[iDone][i]).get(unit).getValue();
+	      }
 	    }
-	    // 	  if(mainTabRow==0){ // debug output
-	    // 	    Int i = 25;
-	    // 	    cout << "i " << i << " xin " << setprecision(9) << xin[iDone][i] << " xindd " << setprecision(9) << xindd[i] 
-	    // 		 << " xout " << setprecision(9) << xout[iDone][i] << endl;
-	    // 	    cout << "i " << i << " vradxin " << setprecision(9) << vrad(xin[iDone][i], regridVeloRestfrq) 
-	    // 		 << " vradxindd " << setprecision(9) << vrad(xindd[i], regridVeloRestfrq)  
-	    // 		 << " xout " << setprecision(9) << vrad(xout[iDone][i], regridVeloRestfrq) << endl;
-	    // 	  }
 	  }
-	}
-	else{ // no additional transformation of input grid
-	  for(uInt i=0; i<xin[iDone].size(); i++){ // cannot use assign due to different data type
-	    xindd[i] = xin[iDone][i];
+	  else{ // no additional transformation of input grid
+	    for(uInt i=0; i<xin[iDone].size(); i++){ // cannot use assign due to different data type
+	      xindd[i] = xin[iDone][i];
+	    }
 	  }
+	  xinddCache[iDone].reference(xindd);
+	  theShiftCache[iDone] = theShift;
+	  xinddTime[iDone] = theTime;
+	  xinddValid[iDone] = True;
+	  weightsIndex[iDone] = -1;
 	}
-
-
-	Double relShift = 0.;
-	InterpolateArray1D<Double,Complex>::InterpolationMethod  methodC = InterpolateArray1D<Double,Complex>::linear; // the default
-	InterpolateArray1D<Double,Float>::InterpolationMethod  methodF = InterpolateArray1D<Double,Float>::linear;
+	r.xindd.assign(xinddCache[iDone]);
+	r.xout.assign(xout[iDone]);
+	Double theShift = theShiftCache[iDone];
 
 	if(fabs(theShift)>0. && 
 	   (method[iDone]==(Int)useFFTShift || method[iDone]==(Int)useLinIntThenFFTShift)
@@ -2216,261 +2857,128 @@ Bool SubMS::fillAllTables(const Vector<MS::PredefinedColumns>& datacols)
 	    return 0;
 	  }
 	  Double chanWidth = xout[iDone][1] - xout[iDone][0];
-	  relShift = -theShift/(xout[iDone][endChan] - xout[iDone][0] + chanWidth);
-	  //cout << "the relshift " << relShift << endl;
+	  r.relShift = -theShift/(xout[iDone][endChan] - xout[iDone][0] + chanWidth);
 	}
-	else{
-	  methodC = (InterpolateArray1D<Double,Complex>::InterpolationMethod) method[iDone];
-	  methodF = (InterpolateArray1D<Double,Float>::InterpolationMethod) method[iDone];
-	}
-
-	if(!CORRECTED_DATACol.isNull()){
-	  yin.assign((*oldCORRECTED_DATAColP)(mainTabRow));
-
-	  // hanning smooth if requested
-	  if(doHanningSmooth){
-
-	    // copy yin to yinUnsmoothed 
-	    Array<Complex> yinUnsmoothed;
-	    yinUnsmoothed.assign(yin);
-
-	    Smooth<Complex>::hanning(yin, // the output
-				     yinFlags, // the output flags
-				     yinUnsmoothed, // the input
-				     yinFlagsUnsmoothed, // the input flags
-				     False);  // for flagging: good is not true
-	  }
-	  
-	  if(method[iDone]==(Int)useLinIntThenFFTShift){
-	    // first interpolate to equidistant grid at initial timestamp
-	    InterpolateArray1D<Double,Complex>::interpolate(yinIntermediate, // the new visibilities
-							    yinFlagsIntermediate, // the new flags
-							    xout[iDone], // the new channel centers (for the output SPW timestamp)
-							    xindd, // the old channel centers 
-							    yin, // the old visibilities 
-							    yinFlags,// the old flags
-							    methodC, // the interpol method
-							    False, // for flagging: good is not true
-							    doExtrapolate // do not extrapolate
-							    );	    
-	    // shift from this timestamp to the output SPW timestamp
-	    fFFTServer.fftshift(yout, youtFlags, yinIntermediate, yinFlagsIntermediate, 
-				1, // axis 1 of the array is the polarisation axis 
-				relShift, 
-				False, // for flagging: good is not true 
-				False);
-
-	  }
-	  else if(method[iDone]==(Int)useFFTShift){
-	    // shift from this timestamp to the output SPW timestamp
-	    fFFTServer.fftshift(yout, youtFlags, yin, yinFlags, 
-				1, // axis 1 of the array is the polarisation axis 
-				relShift, 
-				False, // for flagging: good is not true 
-				False);
-	  }
-	  else{
-	    InterpolateArray1D<Double,Complex>::interpolate(yout, // the new visibilities
-							    youtFlags, // the new flags
-							    xout[iDone], // the new channel centers
-							    xindd, // the old channel centers
-							    yin, // the old visibilities 
-							    yinFlags,// the old flags
-							    methodC, // the interpol method
-							    False, // for flagging: good is not true
-							    doExtrapolate // do not extrapolate
-							    );
-	  }
 
-	  CORRECTED_DATACol.put(mainTabRow, yout);
-	  if(!youtFlagsWritten){ 
-	    FLAGCol.put(mainTabRow, youtFlags);
-	    youtFlagsWritten = True;
-	  }
+	// the interpolation method (linear before an FFT shift)
+	Int interpMethod = method[iDone];
+	if(fabs(r.relShift)>0. && 
+	   (method[iDone]==(Int)useFFTShift || method[iDone]==(Int)useLinIntThenFFTShift)){
+	  interpMethod = (Int)InterpolateArray1D<Double,Complex>::linear;
 	}
-	if(!DATACol.isNull()){
-	  yin.assign((*oldDATAColP)(mainTabRow));
-	  if(doHanningSmooth){
-	    Array<Complex> yinUnsmoothed;
-	    yinUnsmoothed.assign(yin);
-
-	    Smooth<Complex>::hanning(yin, yinFlags, yinUnsmoothed, yinFlagsUnsmoothed, False);  
-	  }
-
-	  if(method[iDone]==(Int)useLinIntThenFFTShift){
-	    InterpolateArray1D<Double,Complex>::interpolate(yinIntermediate, yinFlagsIntermediate, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);	    
-	    fFFTServer.fftshift(yout, youtFlags, yinIntermediate, yinFlagsIntermediate, 
-				1, relShift, False, False);
-
+	if(interpMethod==(Int)InterpolateArray1D<Double,Complex>::nearestNeighbour ||
+	   interpMethod==(Int)InterpolateArray1D<Double,Complex>::linear){
+	  Int wi = weightsIndex[iDone];
+	  if(wi<0 || blockWeights[wi].method!=interpMethod){
+	    blockWeights.push_back(RegridWeights());
+	    makeRegridWeights(blockWeights.back(), xout[iDone], xinddCache[iDone],
+			      interpMethod);
+	    wi = blockWeights.size()-1;
+	    weightsIndex[iDone] = wi;
 	  }
-	  else if(method[iDone]==(Int)useFFTShift){
-	    fFFTServer.fftshift(yout, youtFlags, yin, yinFlags, 
-				1, relShift, False, False);
-	  }
-	  else{
-	    InterpolateArray1D<Double,Complex>::interpolate(yout, youtFlags, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);
-	  }
-
-	  DATACol.put(mainTabRow, yout);
-	  if(!youtFlagsWritten){ 
-	    FLAGCol.put(mainTabRow, youtFlags);
-	    youtFlagsWritten = True;
-	  }	  
+	  r.weights = wi;
 	}
-	if(!LAG_DATACol.isNull()){
-	  yin.assign((*oldLAG_DATAColP)(mainTabRow));
-	  if(doHanningSmooth){ 
-	    Array<Complex> yinUnsmoothed;
-	    yinUnsmoothed.assign(yin);
 
-	    Smooth<Complex>::hanning(yin, yinFlags, yinUnsmoothed, yinFlagsUnsmoothed, False);  
+	r.flags.reference((*oldFLAGColP)(mainTabRow));
+	ArrayColumn<Complex>* oldCmplxColP[4] = {oldCORRECTED_DATAColP, oldDATAColP,
+						 oldLAG_DATAColP, oldMODEL_DATAColP};
+	for(uInt i=0; i<4; i++){
+	  if(oldCmplxColP[i]){
+	    r.cmplx[i].reference((*oldCmplxColP[i])(mainTabRow));
+	    r.hasCmplx[i] = True;
+	    blockBytes += r.cmplx[i].nelements() * sizeof(Complex);
 	  }
-	  if(method[iDone]==(Int)useLinIntThenFFTShift){
-	    InterpolateArray1D<Double,Complex>::interpolate(yinIntermediate, yinFlagsIntermediate, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);	    
-	    fFFTServer.fftshift(yout, youtFlags, yinIntermediate, yinFlagsIntermediate, 
-				1, relShift, False, False);
+	}
+	if(!FLOAT_DATACol.isNull()){
+	  r.floatData.reference((*oldFLOAT_DATAColP)(mainTabRow));
+	  r.hasFloat = True;
+	  blockBytes += r.floatData.nelements() * sizeof(Float);
+	}
+	if(!SIGMA_SPECTRUMCol.isNull()){
+	  r.sigmaSp.reference((*oldSIGMA_SPECTRUMColP)(mainTabRow));
+	  r.hasSigmaSp = True;
+	}
+	if(!WEIGHT_SPECTRUMCol.isNull() && oldWEIGHT_SPECTRUMColP->isDefined(mainTabRow)){ // required column, but can be empty
+	  r.weightSp.reference((*oldWEIGHT_SPECTRUMColP)(mainTabRow));
+	  r.hasWeightSp = True;
+	}
+	// note: FLAG_CATEGORY is a required column, but it can be undefined (empty)
+	if(FLAG_CATEGORYCol.isDefined(mainTabRow)){
+	  r.flagCat.reference((*oldFLAG_CATEGORYColP)(mainTabRow));
+	  r.hasFlagCat = True;
+	}
+      }
 
+      // Regrid the rows of the block; each thread uses its own FFTServer.
+      Int nBlock = block.size();
+      String errMsg;
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads) if (nBlock > 1)
+      for(Int i=0; i<nBlock; i++){
+	RegridRow& r = block[i];
+	if(regrid[r.iDone]){
+	  Int thread = 0;
+#ifdef _OPENMP
+	  thread = omp_get_thread_num();
+#endif
+	  const RegridWeights* weights = 0;
+	  if(r.weights>=0){
+	    weights = &blockWeights[r.weights];
 	  }
-	  else if(method[iDone]==(Int)useFFTShift){
-	    fFFTServer.fftshift(yout, youtFlags, yin, yinFlags, 
-				1, relShift, False, False);
+	  try{
+	    regridRowCells(r, doHanningSmooth, method[r.iDone], weights,
+			   fftServers[thread]);
 	  }
-	  else{
-	    InterpolateArray1D<Double,Complex>::interpolate(yout, youtFlags, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);
+	  catch(AipsError& x){
+#pragma omp critical(SubMS_regridSpw)
+	    errMsg = x.getMesg();
 	  }
-
-	  LAG_DATACol.put(mainTabRow, yout);
 	}
-	if(!MODEL_DATACol.isNull()){
-	  yin.assign((*oldMODEL_DATAColP)(mainTabRow));
-
-	  if(method[iDone]==(Int)useLinIntThenFFTShift){
-	    InterpolateArray1D<Double,Complex>::interpolate(yinIntermediate, yinFlagsIntermediate, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);	    
-	    fFFTServer.fftshift(yout, youtFlags, yinIntermediate, yinFlagsIntermediate, 
-				1, relShift, False, False);
+      }
+      if(!errMsg.empty()){
+	throw(AipsError("SubMS::regridSpw: " + errMsg));
+      }
 
+      // Write the regridded rows.
+      for(Int i=0; i<nBlock; i++){
+	RegridRow& r = block[i];
+	uInt mainTabRow = r.row;
+	if(regrid[r.iDone]){
+	  if(r.hasCmplx[0]){
+	    CORRECTED_DATACol.put(mainTabRow, r.cmplx[0]);
 	  }
-	  else if(method[iDone]==(Int)useFFTShift){
-	    fFFTServer.fftshift(yout, youtFlags, yin, yinFlags, 
-				1, relShift, False, False);
+	  if(r.hasCmplx[1]){
+	    DATACol.put(mainTabRow, r.cmplx[1]);
 	  }
-	  else{
-	    InterpolateArray1D<Double,Complex>::interpolate(yout, youtFlags, xout[iDone], 
-							    xindd, yin, yinFlags,
-							    methodC, False, doExtrapolate);
+	  if(r.hasCmplx[2]){
+	    LAG_DATACol.put(mainTabRow, r.cmplx[2]);
 	  }
-
-	  MODEL_DATACol.put(mainTabRow, yout);
-	  if(!youtFlagsWritten){ 
-	    FLAGCol.put(mainTabRow, youtFlags);
-	    youtFlagsWritten = True;
+	  if(r.hasCmplx[3]){
+	    MODEL_DATACol.put(mainTabRow, r.cmplx[3]);
 	  }
-	}
-	
-	// regrid the Float columns
-	Array<Float> yinf;
-	Array<Float> youtf;
-	Array<Float> fYinIntermediate;
-	if(!FLOAT_DATACol.isNull()){
-	  yinf.assign((*oldFLOAT_DATAColP)(mainTabRow));
-	  if(doHanningSmooth){
-	    Array<Float> yinfUnsmoothed;
-	    yinfUnsmoothed.assign(yinf);
-
-	    Smooth<Float>::hanning(yinf, yinFlags, yinfUnsmoothed, yinFlagsUnsmoothed, False);  
+	  if(r.hasFloat){
+	    FLOAT_DATACol.put(mainTabRow, r.floatData);
 	  }
-
-	  if(method[iDone]==(Int)useLinIntThenFFTShift){
-	    InterpolateArray1D<Double,Float>::interpolate(fYinIntermediate, yinFlagsIntermediate, xout[iDone], 
-							  xindd, yinf, yinFlags,
-							  methodF, False, doExtrapolate);	    
-	    fFFTServer.fftshift(youtf, youtFlags, fYinIntermediate, yinFlagsIntermediate, 
-				1, relShift, False);
-
+	  if(r.flagsWritten){
+	    FLAGCol.put(mainTabRow, r.flagsOut);
 	  }
-	  else if(method[iDone]==(Int)useFFTShift){
-	    fFFTServer.fftshift(youtf, youtFlags, yinf, yinFlags, 
-				1, relShift, False);
+	  if(r.hasSigmaSp){
+	    SIGMA_SPECTRUMCol.put(mainTabRow, r.sigmaSp);
 	  }
-	  else{
-	    InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout[iDone], xindd, 
-							   yinf, yinFlags, methodF, False, doExtrapolate);
+	  if(r.hasWeightSp){
+	    WEIGHT_SPECTRUMCol.put(mainTabRow, r.weightSp);
 	  }
-
-	  FLOAT_DATACol.put(mainTabRow, youtf);
-	  if(!youtFlagsWritten){ 
-	    FLAGCol.put(mainTabRow, youtFlags);
-	    youtFlagsWritten = True;
+	  if(r.hasFlagCat){
+	    FLAG_CATEGORYCol.put(mainTabRow, r.flagCat);
 	  }
-	}
-
-	if(!SIGMA_SPECTRUMCol.isNull()){
-	  yinf.assign((*oldSIGMA_SPECTRUMColP)(mainTabRow));
-	  InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout[iDone], xindd, 
-							 yinf, yinFlags, methodF, False, doExtrapolate);
-	  SIGMA_SPECTRUMCol.put(mainTabRow, youtf);
-	}
-	if(!WEIGHT_SPECTRUMCol.isNull() && oldWEIGHT_SPECTRUMColP->isDefined(mainTabRow)){ // required column, but can be empty
-	  yinf.assign((*oldWEIGHT_SPECTRUMColP)(mainTabRow));
-	  InterpolateArray1D<Double, Float>::interpolate(youtf, youtFlags, xout[iDone],
-                                                         xindd, yinf, yinFlags,
-                                                         methodF, False, doExtrapolate);
-	  WEIGHT_SPECTRUMCol.put(mainTabRow, youtf);
-	}
 	
-	// deal with FLAG_CATEGORY
-	// note: FLAG_CATEGORY is a required column, but it can be undefined (empty)
+	  msModified = True;
 	
-	if(FLAG_CATEGORYCol.isDefined(mainTabRow)){
-	  Array<Bool> flagCat((*oldFLAG_CATEGORYColP)(mainTabRow));  
-	  IPosition flagCatShape = (*oldFLAG_CATEGORYColP).shape(mainTabRow);
-	  Int nCorrelations = flagCatShape(0); // get the dimension of the first axis
-	  Int nChannels = flagCatShape(1); // get the dimension of the second axis
-	  Int nCat = flagCatShape(2); // the dimension of the third axis ==
-                                      // number of categories
-	  Int nOutChannels = xout[iDone].size();
-	  
-	  Vector<Float> dummyYin(nChannels);
-	  Vector<Float> dummyYout(nOutChannels);
-	  Array<Bool> flagCatOut(IPosition(3, nCorrelations, nOutChannels, nCat)); 
-	  
-	  for(Int i=0; i<nCat; i++){
-	    IPosition start(0,0,i), length (nCorrelations,nChannels,i), stride (1,1,0);
-	    Slicer slicer (start, length, stride, Slicer::endIsLast);
-	    yinFlags.assign(flagCat(slicer));
-	    InterpolateArray1D<Double, Float>::interpolate(dummyYout, youtFlags,
-                                                           xout[iDone], xindd, 
-							   dummyYin, yinFlags,
-                                                           methodF, False, False);
-	    // write the slice to the array flagCatOut
-	    for(Int j=0; j<nCorrelations; j++){
-	      for(Int k=0; k<nOutChannels; k++){
-		flagCatOut(IPosition(3, j, k, i)) = youtFlags(IPosition(2,j,k));
-	      }
-	    }
-	  }
-	  
-	  FLAG_CATEGORYCol.put(mainTabRow, flagCatOut);
-	  
-	}
-	
-	msModified = True;
-	
-      } // end if regridding necessary
+	} // end if regridding necessary
 
-      if(mainTabRow>nMainTabRows*progress){
-	cout << "regridSpw progress: " << progress*100 << "% processed ... " << endl;
-	progress += progressStep;
+	if(mainTabRow>nMainTabRows*progress){
+	  cout << "regridSpw progress: " << progress*100 << "% processed ... " << endl;
+	  progress += progressStep;
+	}
       }
       
     } // end loop over main table rows
@@ -6639,116 +7147,100 @@ Bool SubMS::copyDataFlagsWtSp(const Vector<MS::PredefinedColumns>& colNames,
     columns[4]=MS::DATA_DESC_ID;
     columns[5]=MS::TIME;
 
+    // Work out which input column goes to which output column.
+    uInt ncol = colNames.nelements();
+    Block<VisibilityIterator::DataColumn> inCols(ncol), outCols(ncol);
+    for(uInt k = 0; k < ncol; ++k){
+      Int colnum = ncol - 1 - k;
+      if(writeToDataCol || colNames[colnum] == MS::DATA) {
+        // write DATA, MODEL_DATA, or CORRECTED_DATA to DATA
+        switch (colNames[colnum]) {
+        case MS::DATA:
+          inCols[k] = VisibilityIterator::Observed;
+          break;
+        case MS::MODEL_DATA:
+          inCols[k] = VisibilityIterator::Model;
+          break;
+        case MS::CORRECTED_DATA:
+          inCols[k] = VisibilityIterator::Corrected;
+          break;
+        default:
+          throw(AipsError("Unrecognized input column!"));
+          break;
+        }
+        outCols[k] = VisibilityIterator::Observed;
+      }
+      else if (colNames[colnum] ==  MS::MODEL_DATA) {
+        // write MODEL_DATA to MODEL_DATA
+        inCols[k] = outCols[k] = VisibilityIterator::Model;
+      }
+      else if (colNames[colnum] == MS::CORRECTED_DATA) {
+        // write CORRECTED_DATA to CORRECTED_DATA
+        inCols[k] = outCols[k] = VisibilityIterator::Corrected;
+      }
+      //else if(colNames[colnum] == MS::FLOAT_DATA)              // TBD
+      //	else if(colNames[colnum] == MS::LAG_DATA)      // TBD
+      else
+        return false;
+    }
+
 #ifdef COPYTIMER
     Timer timer;
     timer.mark();
-
-    Vector<Int> inscan, outscan;
+    uInt ncells = 0;
 #endif
 
     ROVisIter viIn(mssel_p,columns,0.0);
     VisIter viOut(msOut_p,columns,0.0);
     viIn.setRowBlocking(1000);
     viOut.setRowBlocking(1000);
-    Int iChunk(0), iChunklet(0);
-    Cube<Complex> data;
-    Cube<Bool> flag;
+    Int iChunk(0);
 
-    Matrix<Float> wtmat;
     viIn.originChunks();                                // Makes me feel better.
     const Bool doWtSp(viIn.existsWeightSpectrum());
-    Cube<Float> wtsp;
 
     uInt ninrows = mssel_p.nrow();
     ProgressMeter meter(0.0, ninrows * 1.0, "split", "rows copied", "", "",
                         True, 1);
     uInt inrowsdone = 0;  // only for the meter.
 
-    for (iChunk=0,viOut.originChunks(),viIn.originChunks();
-	 viOut.moreChunks(),viIn.moreChunks();
-	 viOut.nextChunk(),viIn.nextChunk(),++iChunk) {
+    // The input is read in row blocks of all columns at once, and each
+    // block is written to the output iterator, which is then advanced.
+    // Both iterate in the same order.
+    viOut.originChunks();
+    viOut.origin();
+    for (iChunk=0,viIn.originChunks();
+         viIn.moreChunks();
+         viIn.nextChunk(),++iChunk) {
       inrowsdone += viIn.nRowChunk();
 
-      // The following can help evaluable in/out index alignment
-      /*
-      cout << "****iChunk=" << iChunk 
-	   << " scn: " << viIn.scan(inscan)(0) << "/" << viOut.scan(outscan)(0) << "   "
-	   << "fld: " << viIn.fieldId() << "/"  << viOut.fieldId() << "   "
-	   << "ddi: " << viIn.dataDescriptionId() << "/" << viOut.dataDescriptionId() << "   "
-	   << "spw: " << viIn.spectralWindow() << "/"  << viOut.spectralWindow() << "   "
-	   << endl;
-      */
-      for (iChunklet=0,viIn.origin(),viOut.origin();
-	   viIn.more(),viOut.more();
-	   viIn++,viOut++,++iChunklet) { //  
-
-	//	cout << "nRows = " << viIn.nRow() << "/" << viOut.nRow() << endl;
-
+      for (viIn.origin(); viIn.more(); viIn++) {
+        CopyBlock block(viOut, ncol);
+        viIn.flag(block.flag_p);
+        viIn.weightMat(block.weight_p);
+        viIn.sigmaMat(block.sigma_p);
+        block.doWtSp_p = doWtSp;
+        if(doWtSp)
+          viIn.weightSpectrum(block.wtsp_p);
+        for(uInt k = 0; k < ncol; ++k){
+          viIn.visibility(block.data_p[k], inCols[k]);
+          block.outCol_p[k] = outCols[k];
 #ifdef COPYTIMER
-	timer.mark();
+          ncells += block.data_p[k].nelements();
 #endif
-        viIn.flag(flag);
-        viOut.setFlag(flag);
-        viIn.weightMat(wtmat);
-        viOut.setWeightMat(wtmat);
-        viIn.sigmaMat(wtmat);           // Yes, I'm reusing wtmat.
-        viOut.setSigmaMat(wtmat);
-        if(doWtSp){
-          viIn.weightSpectrum(wtsp);
-          viOut.setWeightSpectrum(wtsp);
-        }
-
-        for(Int colnum = colNames.nelements(); colnum--;){
-          if(writeToDataCol || colNames[colnum] == MS::DATA) {
-            // write DATA, MODEL_DATA, or CORRECTED_DATA to DATA
-            switch (colNames[colnum]) {
-            case MS::DATA:
-              viIn.visibility(data,VisibilityIterator::Observed);
-              break;
-            case MS::MODEL_DATA:
-              viIn.visibility(data,VisibilityIterator::Model);
-              break;
-            case MS::CORRECTED_DATA:
-              viIn.visibility(data,VisibilityIterator::Corrected);
-              break;
-            default:
-              throw(AipsError("Unrecognized input column!"));
-              break;
-            }
-            viOut.setVis(data,VisibilityIterator::Observed);
-          }
-          else if (colNames[colnum] ==  MS::MODEL_DATA) {
-            // write MODEL_DATA to MODEL_DATA
-            viIn.visibility(data,VisibilityIterator::Model);
-            viOut.setVis(data,VisibilityIterator::Model);
-          }
-          else if (colNames[colnum] == MS::CORRECTED_DATA) {
-            // write CORRECTED_DATA to CORRECTED_DATA
-            viIn.visibility(data,VisibilityIterator::Corrected);
-            viOut.setVis(data,VisibilityIterator::Corrected);
-          }
-          //else if(colNames[colnum] == MS::FLOAT_DATA)              // TBD
-          //	else if(colNames[colnum] == MS::LAG_DATA)      // TBD
-          else
-            return false;
         }
-
-#ifdef COPYTIMER	
-	Double t=timer.real();
-	cout << "Chunk: " << iChunk << " " << iChunklet 
-	     << " scn: " << viIn.scan(inscan)(0) << "/" << viOut.scan(outscan)(0) 
-             << "   "
-	     << " spw: " << viIn.spectralWindow() << "/"  << viOut.spectralWindow() 
-             << " : "
-	     << data.nelements() << " cells = " 
-	     << data.nelements()*8.e-6 << " MB in " 
-	     << t << " sec, for " << data.nelements()*8.e-6/t << " MB/s" 
-	     << endl;
-#endif
-	
+        block.write();
       }
       meter.update(inrowsdone);
     }
+
+#ifdef COPYTIMER
+    Double t=timer.real();
+    cout << "Copied " << iChunk << " chunks: "
+         << ncells << " cells = " << ncells*8.e-6 << " MB in "
+         << t << " sec, for " << ncells*8.e-6/t << " MB/s" << endl;
+#endif
+
     msOut_p.flush();
     return true;
   }
@@ -8157,28 +8649,55 @@ Bool SubMS::doTimeAver(const Vector<MS::PredefinedColumns>& dataColNames)
 		      True, 1);
   uInt inrowsdone = 0;  // only for the meter.
 
-  VisChunkAverager vca(dataColNames, doSpWeight);
+  // Two averagers, so that a chunk can be read while the previous one is
+  // averaged.  All table I/O stays on the calling thread: while a
+  // ChunkAverager thread averages chunk N, the calling thread writes the
+  // averaged chunk N-1 and reads chunk N+1.  So at most two chunks are held
+  // in memory at a time.
+  VisChunkAverager vca0(dataColNames, doSpWeight);
+  VisChunkAverager vca1(dataColNames, doSpWeight);
+  VisChunkAverager* vca[2] = {&vca0, &vca1};
+  uInt cur = 0;
+  std::auto_ptr<AverBlock> pending;   // Averaged chunk not yet written.
+  uInt rowsqueued = 0;                // Output rows in pending.
 
   // Iterate through the chunks.  A timebin will have multiple chunks if it has
   // > 1 arrays, fields, or ddids.
-  for(vi.originChunks(); vi.moreChunks(); vi.nextChunk()){
-    vca.reset();        // Should be done at the start of each chunk.
-
+  vi.originChunks();
+  Bool moreChunks = vi.moreChunks();
+  if(moreChunks){
+    vca[cur]->reset();        // Should be done at the start of each chunk.
     inrowsdone += vi.nRowChunk();
-
-    // Fill and time average vi's current chunk.
-    VisBuffer& avb(vca.average(vi));
+    vca[cur]->readChunk(vi);
+  }
+  while(moreChunks){
+    // Time average the chunk just read.
+    ChunkAverager averager(*vca[cur]);
+
+    // Meanwhile write the previous chunk and read the next one.
+    if(pending.get()){
+      pending->write();
+      rowsdone += rowsqueued;
+      pending.reset();
+    }
+    vi.nextChunk();
+    moreChunks = vi.moreChunks();
+    uInt inrowsnext = 0;
+    if(moreChunks){
+      vca[1 - cur]->reset();
+      inrowsnext = vi.nRowChunk();
+      vca[1 - cur]->readChunk(vi);
+    }
+
+    VisBuffer& avb(averager.wait());
     uInt rowsnow = avb.nRow();
 
     if(rowsnow > 0){
-      RefRows rowstoadd(rowsdone, rowsdone + rowsnow - 1);
-
-      // msOut_p.addRow(rowsnow, True);
-      msOut_p.addRow(rowsnow);            // Try it without initialization.
-        
-      //    relabelIDs();
-
-      // avb.freqAveCubes();  // Watch out, weight must currently be handled separately.
+      // Collect all columns of the averaged chunk, so they are appended to
+      // the output in one put per column.
+      pending.reset(new AverBlock(msOut_p, *msc_p, rowsdone, rowsnow, nCmplx));
+      AverBlock* block = pending.get();
+      rowsqueued = rowsnow;
 
       // // Fill in the nonaveraging values from slotv0.
       // // In general, _IDs which are row numbers in a subtable must be
@@ -8187,65 +8706,69 @@ Bool SubMS::doTimeAver(const Vector<MS::PredefinedColumns>& dataColNames)
         remap(avb.antenna1(), antIndexer_p);
         remap(avb.antenna2(), antIndexer_p);
       }
-      msc_p->antenna1().putColumnCells(rowstoadd, avb.antenna1());
-      msc_p->antenna2().putColumnCells(rowstoadd, avb.antenna2());
+      block->ant1_p = avb.antenna1();
+      block->ant2_p = avb.antenna2();
 
-      Vector<Int> arrID(rowsnow);
-      arrID.set(avb.arrayId());                              // Don't remap!
-      msc_p->arrayId().putColumnCells(rowstoadd, arrID);
+      block->arrayId_p.resize(rowsnow);
+      block->arrayId_p.set(avb.arrayId());                   // Don't remap!
 
       // outCmplxCols determines whether the input column is output to DATA or not.
       for(uInt datacol = 0; datacol < nCmplx; ++datacol){
+        block->dataCols_p[datacol] = &outCmplxCols[datacol];
         if(dataColNames[datacol] == MS::DATA)
-          outCmplxCols[datacol].putColumnCells(rowstoadd, avb.visCube());
+          block->data_p[datacol] = avb.visCube();
         else if(dataColNames[datacol] == MS::MODEL_DATA)
-          outCmplxCols[datacol].putColumnCells(rowstoadd, avb.modelVisCube());
+          block->data_p[datacol] = avb.modelVisCube();
         else if(dataColNames[datacol] == MS::CORRECTED_DATA)
-          outCmplxCols[datacol].putColumnCells(rowstoadd, avb.correctedVisCube());
+          block->data_p[datacol] = avb.correctedVisCube();
       }
+      block->doFloat_p = doFloat;
       if(doFloat)
-        msc_p->floatData().putColumnCells(rowstoadd, avb.floatDataCube());
+        block->floatData_p = avb.floatDataCube();
 
       // remap() with a constant value.
-      Vector<Int> ddID(rowsnow);
-      ddID.set(spwRelabel_p[oldDDSpwMatch_p[avb.dataDescriptionId()]]);
-      msc_p->dataDescId().putColumnCells(rowstoadd, ddID);
+      block->ddId_p.resize(rowsnow);
+      block->ddId_p.set(spwRelabel_p[oldDDSpwMatch_p[vca[cur]->dataDescriptionId()]]);
 
-      msc_p->exposure().putColumnCells(rowstoadd, avb.exposure());
-      msc_p->feed1().putColumnCells(rowstoadd, avb.feed1());
-      msc_p->feed2().putColumnCells(rowstoadd, avb.feed2());
+      block->exposure_p = avb.exposure();
+      block->feed1_p = avb.feed1();
+      block->feed2_p = avb.feed2();
 
-      Vector<Int> fieldID(rowsnow);
-      fieldID.set(fieldRelabel_p[avb.fieldId()]);
-      msc_p->fieldId().putColumnCells(rowstoadd, fieldID);
+      block->fieldId_p.resize(rowsnow);
+      block->fieldId_p.set(fieldRelabel_p[avb.fieldId()]);
 
-      msc_p->flagRow().putColumnCells(rowstoadd, avb.flagRow()); 
-      msc_p->flag().putColumnCells(rowstoadd, avb.flagCube());
-      msc_p->interval().putColumnCells(rowstoadd, avb.timeInterval());
+      block->flagRow_p = avb.flagRow();
+      block->flag_p = avb.flagCube();
+      block->interval_p = avb.timeInterval();
 
       remap(avb.observationId(), obsMapper);
-      msc_p->observationId().putColumnCells(rowstoadd, avb.observationId());
+      block->obsId_p = avb.observationId();
 
       remap(avb.processorId(), procMapper);
-      msc_p->processorId().putColumnCells(rowstoadd, avb.processorId());
+      block->procId_p = avb.processorId();
 
-      msc_p->scanNumber().putColumnCells(rowstoadd, avb.scan());	// Don't remap!
-      msc_p->sigma().putColumnCells(rowstoadd, avb.sigmaMat());
+      block->scan_p = avb.scan();                         // Don't remap!
+      block->sigma_p = avb.sigmaMat();
 
       remap(avb.stateId(), stateRemapper_p);
-      msc_p->stateId().putColumnCells(rowstoadd, avb.stateId());
+      block->stateId_p = avb.stateId();
 
-      msc_p->time().putColumnCells(rowstoadd, avb.time());
-      msc_p->timeCentroid().putColumnCells(rowstoadd, avb.timeCentroid());
-      msc_p->uvw().putColumnCells(rowstoadd, avb.uvwMat());
-      msc_p->weight().putColumnCells(rowstoadd, avb.weightMat());
+      block->time_p = avb.time();
+      block->timeCentroid_p = avb.timeCentroid();
+      block->uvw_p = avb.uvwMat();
+      block->weight_p = avb.weightMat();
+      block->doWtSp_p = doSpWeight;
       if(doSpWeight)
-        msc_p->weightSpectrum().putColumnCells(rowstoadd, avb.weightSpectrum());
-      
-      rowsdone += rowsnow;
+        block->wtsp_p = avb.weightSpectrum();
     }
     meter.update(inrowsdone);
-  }   // End of for(vi.originChunks(); vi.moreChunks(); vi.nextChunk())
+    inrowsdone += inrowsnext;
+    cur = 1 - cur;
+  }
+  if(pending.get()){
+    pending->write();
+    rowsdone += rowsqueued;
+  }
   os << LogIO::NORMAL << "Data binned." << LogIO::POST;
 
   //const ColumnDescSet& cds = mssel_p.tableDesc().columnDescSet();
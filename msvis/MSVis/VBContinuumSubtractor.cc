@@ -29,6 +29,9 @@
 //#include <casa/Arrays/ArrayMath.h>
 //#include <casa/Arrays/ArrayUtil.h>
 #include <casa/Arrays/Cube.h>
+#include <casa/Arrays/Matrix.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Containers/Block.h>
 //#include <casa/Arrays/MaskedArray.h>
 //#include <casa/Arrays/MaskArrMath.h>
 //#include <casa/Containers/Record.h>
@@ -45,7 +48,12 @@
 #include <scimath/Fitting/LinearFitSVD.h>
 #include <scimath/Functionals/Polynomial.h>
 
-//#include <algorithm>
+#include <algorithm>
+#include <map>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -132,6 +140,217 @@ void VBContinuumSubtractor::initFromVBGA(VisBuffGroupAcc& vbga)
 VBContinuumSubtractor::~VBContinuumSubtractor()
 {}
 
+namespace {
+
+// The parts of the VisBuffers in a VisBuffGroupAcc used by the continuum
+// fit.  A fit is identified by its "member" number,
+// baseline hash * ncorr + correlation.
+struct ContFitData
+{
+  Block<const Cube<Complex>*> vis;
+  Block<const Matrix<Bool>*>  flag;
+  Block<const Vector<Bool>*>  flagRow;
+  Block<const Matrix<Float>*> weight;
+  Vector<Double> freqs;         // Scaled frequencies of all channels.
+  uInt ncorr;
+
+  // Fill chans and wt with the (overall) channel numbers and weights of the
+  // unflagged channels of a baseline and correlation, and vizzes with their
+  // data if doData is True.  Returns the number of unflagged channels.
+  uInt gather(uInt corrind, uInt blind, Vector<Complex>& vizzes,
+              Vector<Float>& wt, Vector<uInt>& chans, Bool doData) const
+  {
+    uInt nunflagged = 0;
+    uInt totchan = 0;
+    for(uInt ibuf = 0; ibuf < flag.nelements(); ++ibuf){
+      const Matrix<Bool>& flg = *flag[ibuf];
+      uInt nchan = flg.nrow();
+
+      if(!(*flagRow[ibuf])[blind]){
+        Float w = (*weight[ibuf])(corrind, blind);
+
+        // w needs a sanity check, because a VisBuffer from vbga is not
+        // necessarily still attached to the MS and sigmaMat() is not one
+        // of the accumulated quantities (CAS-3135).  Fortunately w isn't
+        // all that important; if all the channels have the same weight the
+        // only consequence of setting w to 1 is that the estimated errors
+        // (which we don't yet use) will be wrong.
+        //
+        // 5e-45 ended up getting squared in the fitter and producing a NaN.
+        if(isnan(w) || w < 1.0e-20 || w > 1.0e20)
+          w = 1.0;  // Emit a warning?
+
+        for(uInt c = 0; c < nchan; ++c){
+          if(!flg(c, blind)){
+            chans[nunflagged] = totchan + c;
+            wt[nunflagged] = w / nchan;
+            if(doData)
+              vizzes[nunflagged] = (*vis[ibuf])(corrind, c, blind);
+            ++nunflagged;
+          }
+        }
+      }
+      totchan += nchan;
+    }
+    return nunflagged;
+  }
+
+  // Form the matrix turning the unflagged data of the given member into
+  // the weighted least squares polynomial coefficients, i.e.
+  // (A^T W A)^-1 A^T W, using a Cholesky factorization of the normal
+  // equations.  Returns False if they are (nearly) singular.
+  Bool formSolver(uInt member, Int fitorder, uInt totnumchan,
+                  Matrix<Double>& solver, Int& locFitOrd) const
+  {
+    Vector<Complex> vizzes;
+    Vector<Float> wt(totnumchan);
+    Vector<uInt> chans(totnumchan);
+    uInt n = gather(member % ncorr, member / ncorr, vizzes, wt, chans, False);
+
+    // Don't try to solve for more coefficients than valid channels.
+    locFitOrd = min(fitorder, static_cast<Int>(n) - 1);
+    uInt np = locFitOrd + 1;
+    Matrix<Double> nm(np, np, 0.0);
+    Vector<Double> pw(np);
+    for(uInt i = 0; i < n; ++i){
+      Double x = freqs[chans[i]];
+      pw[0] = 1.0;
+      for(uInt k = 1; k < np; ++k)
+        pw[k] = x * pw[k - 1];
+      for(uInt j = 0; j < np; ++j)
+        for(uInt k = 0; k <= j; ++k)
+          nm(j, k) += wt[i] * pw[j] * pw[k];
+    }
+    // Cholesky factorization in place (lower triangle).
+    for(uInt j = 0; j < np; ++j){
+      Double d = nm(j, j);
+      for(uInt k = 0; k < j; ++k)
+        d -= nm(j, k) * nm(j, k);
+      if(!(d > 1.0e-12 * nm(j, j)))
+        return False;
+      nm(j, j) = sqrt(d);
+      for(uInt i = j + 1; i < np; ++i){
+        Double sum = nm(i, j);
+        for(uInt k = 0; k < j; ++k)
+          sum -= nm(i, k) * nm(j, k);
+        nm(i, j) = sum / nm(j, j);
+      }
+    }
+    // Solve for each channel's column of A^T W.
+    solver.resize(n, np);
+    Vector<Double> y(np);
+    for(uInt i = 0; i < n; ++i){
+      Double x = freqs[chans[i]];
+      Double b = wt[i];
+      for(uInt k = 0; k < np; ++k){
+        Double sum = b;
+        for(uInt l = 0; l < k; ++l)
+          sum -= nm(k, l) * y[l];
+        y[k] = sum / nm(k, k);
+        b *= x;
+      }
+      for(Int k = np - 1; k >= 0; --k){
+        Double sum = y[k];
+        for(uInt l = k + 1; l < np; ++l)
+          sum -= nm(l, k) * solver(i, l);
+        solver(i, k) = sum / nm(k, k);
+      }
+    }
+    return True;
+  }
+
+  // Store the solution of a member, padding the remaining orders with 0.
+  void store(uInt member, const Vector<Complex>& solution, Int fitorder,
+             Cube<Complex>& coeffs, Cube<Bool>& coeffsOK) const
+  {
+    uInt corrind = member % ncorr;
+    uInt blind = member / ncorr;
+    Int locFitOrd = solution.nelements() - 1;
+    for(Int ordind = 0; ordind <= locFitOrd; ++ordind){      // Note <=.
+      coeffs(corrind, ordind, blind) = solution[ordind];
+      coeffsOK(corrind, ordind, blind) = True;
+    }
+    // Pad remaining orders (if any) with 0.0.  Note <=.
+    for(Int ordind = locFitOrd + 1; ordind <= fitorder; ++ordind){
+      coeffs(corrind, ordind, blind) = 0.0;
+
+      // Since coeffs(corrind, ordind, blind) == 0, it isn't necessary to
+      // pay attention to coeffsOK(corrind, ordind, blind) (especially?) if
+      // ordind > 0.  But Calibrater's SolvableVisCal::keep() and store()
+      // quietly go awry if you try coeffsOK.resize(ncorr_p, 1, nHashes_p);
+      coeffsOK(corrind, ordind, blind) = False;
+    }
+  }
+
+  // Fit a member using the solver of its group.
+  void solve(uInt member, const Matrix<Double>& solver, Int locFitOrd,
+             Int fitorder, Cube<Complex>& coeffs, Cube<Bool>& coeffsOK) const
+  {
+    uInt n = solver.nrow();
+    Vector<Complex> vizzes(n);
+    Vector<Float> wt(n);
+    Vector<uInt> chans(n);
+    gather(member % ncorr, member / ncorr, vizzes, wt, chans, True);
+    Vector<Complex> solution(locFitOrd + 1);
+    const Complex* vp = vizzes.data();
+    for(Int ordind = 0; ordind <= locFitOrd; ++ordind){
+      const Double* sp = solver.data() + ordind * n;
+      Double re = 0.0;
+      Double im = 0.0;
+      for(uInt i = 0; i < n; ++i){
+        re += sp[i] * vp[i].real();
+        im += sp[i] * vp[i].imag();
+      }
+      solution[ordind] = Complex(re, im);
+    }
+    store(member, solution, fitorder, coeffs, coeffsOK);
+  }
+
+  // Fit a member on its own using SVD.
+  void fitSVD(LinearFitSVD<Float>& fitter, uInt member, Int fitorder,
+              uInt totnumchan, Cube<Complex>& coeffs,
+              Cube<Bool>& coeffsOK) const
+  {
+    Vector<Complex> vizzes(totnumchan);
+    Vector<Float> wt(totnumchan);
+    Vector<uInt> chans(totnumchan);
+    uInt n = gather(member % ncorr, member / ncorr, vizzes, wt, chans, True);
+    wt.resize(n, True);
+    Vector<Float> unflaggedfreqs(n);
+    Vector<Float> floatvs(n);
+    for(uInt c = 0; c < n; ++c)
+      unflaggedfreqs[c] = freqs[chans[c]];
+    Int locFitOrd = min(fitorder, static_cast<Int>(n) - 1);
+    Polynomial<AutoDiff<Float> > pnom(locFitOrd);
+
+    // The way LinearFit is templated, "y" can be Complex, but at the cost
+    // of "x" being Complex as well, and worse, wt too.  It is better to
+    // separately fit the reals and imags.
+    // Do reals.
+    for(Int ordind = 0; ordind <= locFitOrd; ++ordind)       // Note <=.
+      pnom.setCoefficient(ordind, 1.0);
+    for(uInt c = 0; c < n; ++c)
+      floatvs[c] = vizzes[c].real();
+    fitter.setFunction(pnom);
+    Vector<Float> realsolution = fitter.fit(unflaggedfreqs, floatvs, wt);
+
+    // Do imags.
+    for(Int ordind = 0; ordind <= locFitOrd; ++ordind)       // Note <=.
+      pnom.setCoefficient(ordind, 1.0);
+    for(uInt c = 0; c < n; ++c)
+      floatvs[c] = vizzes[c].imag();
+    fitter.setFunction(pnom);
+    Vector<Float> imagsolution = fitter.fit(unflaggedfreqs, floatvs, wt);
+
+    Vector<Complex> solution(locFitOrd + 1);
+    for(Int ordind = 0; ordind <= locFitOrd; ++ordind)
+      solution[ordind] = Complex(realsolution[ordind], imagsolution[ordind]);
+    store(member, solution, fitorder, coeffs, coeffsOK);
+  }
+};
+
+} // anonymous namespace
+
 void VBContinuumSubtractor::fit(VisBuffGroupAcc& vbga, const Int fitorder,
                                 MS::PredefinedColumns whichcol,
                                 Cube<Complex>& coeffs,
@@ -166,14 +385,8 @@ void VBContinuumSubtractor::fit(VisBuffGroupAcc& vbga, const Int fitorder,
   if(!checkSize(coeffs, coeffsOK))
     throw(AipsError("Shape mismatch in the coefficient storage cubes."));
 
-  // Make the estimate
-  LinearFitSVD<Float> fitter;
-  fitter.asWeight(true);        // Makes the "sigma" arg = w = 1/sig**2
-
   coeffsOK.set(False);
 
-  // Translate vbga to arrays for use by LinearFitSVD.
-
   // The fitorder will actually be clamped on a baseline-by-baseline basis
   // because of flagging, but a summary note is in order here.
   if(static_cast<Int>(totnumchan_p) < fitorder_p)
@@ -185,177 +398,124 @@ void VBContinuumSubtractor::fit(VisBuffGroupAcc& vbga, const Int fitorder,
   // Scale frequencies to [-1, 1].
   midfreq_p = 0.5 * (lofreq_p + hifreq_p);
   freqscale_p = calcFreqScale();
-  Vector<Float> freqs(totnumchan_p);
+
+  // Fetch what is needed from the VisBuffers up front, so the fits below
+  // can run in parallel without triggering lazy fills.
+  ContFitData fd;
+  fd.ncorr = ncorr_p;
+  uInt nbuf = vbga.nBuf();
+  fd.vis.resize(nbuf);
+  fd.flag.resize(nbuf);
+  fd.flagRow.resize(nbuf);
+  fd.weight.resize(nbuf);
+  fd.freqs.resize(totnumchan_p);
   uInt totchan = 0;
-  for(Int ibuf = 0; ibuf < vbga.nBuf(); ++ibuf){
+  for(uInt ibuf = 0; ibuf < nbuf; ++ibuf){
     VisBuffer& vb(vbga(ibuf));
+    // AAARRGGGHHH!!  With Calibrater you have to use vb.flag(), not
+    // flagCube(), to get the channel selection!
+    fd.vis[ibuf] = &vb.dataCube(whichcol);
+    fd.flag[ibuf] = &vb.flag();
+    fd.flagRow[ibuf] = &vb.flagRow();
+    fd.weight[ibuf] = &vb.weightMat();
     Vector<Double> freq(vb.frequency());
     uInt nchan = vb.nChannel();
 
     for(uInt c = 0; c < nchan; ++c){
-      freqs[totchan] = freqscale_p * (freq[c] - midfreq_p);
+      fd.freqs[totchan] = freqscale_p * (freq[c] - midfreq_p);
       ++totchan;
     }
   }
 
-  Vector<Float> wt(totnumchan_p);
-  Vector<Float> unflaggedfreqs(totnumchan_p);
-  Vector<Complex> vizzes(totnumchan_p);
-  Vector<Float> floatvs(totnumchan_p);
-  Vector<Float> realsolution(fitorder_p + 1);
-  Vector<Float> imagsolution(fitorder_p + 1);
+  // Fits with the same unflagged channels and relative channel weights
+  // share their design, so group them.  The normal equations of a group
+  // are factored once and applied to all of its members.
+  std::map<std::vector<Float>, uInt> groupIndex;
+  std::vector<std::vector<uInt> > groups;
+  {
+    Vector<Complex> vizzes(totnumchan_p);
+    Vector<Float> wt(totnumchan_p);
+    Vector<uInt> chans(totnumchan_p);
+    std::vector<Float> key(totnumchan_p);
 
-  for(uInt corrind = 0; corrind < ncorr_p; ++corrind){
     for(uInt blind = 0; blind < nHashes_p; ++blind){
-      uInt totchan = 0;
-      uInt totunflaggedchan = 0;
-
-      // Fill wt, unflaggedfreqs, and vizzes with the baseline's values for
-      // all channels being used in the fit.
-      wt.resize(totnumchan_p);
-      vizzes.resize(totnumchan_p);
-      unflaggedfreqs.resize(totnumchan_p);
-
-      for(Int ibuf = 0; ibuf < vbga.nBuf(); ++ibuf){
-        VisBuffer& vb(vbga(ibuf));
-        //Int vbrow = vbga.outToInRow(ibuf, False)[blind];
-
-        if(!vb.flagRow()[blind]){
-          uInt nchan = vb.nChannel();
-          Cube<Complex>& viscube(vb.dataCube(whichcol));
-          Float w;
-
-          // 2/24/2011: VisBuffer doesn't (yet) have sigmaSpectrum, and I have
-          // never seen it in an MS anyway.  Settle for 1/sqrt(weightSpectrum)
-          // if it is available or sigmaMat otherwise.
-          //const Bool haveWS = vb.existsWeightSpectrum();
-          // 5/13/2011: Sigh.  VisBuffAccumulator doesn't even handle
-          // WeightSpectrum, let alone sigma.
-          //const Bool haveWS = false;
-
-          //if(!haveWS) // w is needed either way, in case ws == 0.0.
-          w = vb.weightMat()(corrind, blind);
-
-          // w needs a sanity check, because a VisBuffer from vbga is not
-          // necessarily still attached to the MS and sigmaMat() is not one
-          // of the accumulated quantities.  This caused problems for
-          // the last integration in CAS-3135.  checkVisIter() didn't do the
-          // trick in that case.  Fortunately w isn't all that important; if
-          // all the channels have the same weight the only consequence of
-          // setting w to 1 is that the estimated errors (which we don't yet
-          // use) will be wrong.
-          //
-          // 5e-45 ended up getting squared in the fitter and producing a NaN.
-          if(isnan(w) || w < 1.0e-20 || w > 1.0e20)
-            w = 1.0;  // Emit a warning?
-
-          for(uInt c = 0; c < nchan; ++c){
-            // AAARRGGGHHH!!  With Calibrater you have to use vb.flag(), not
-            // flagCube(), to get the channel selection!
-            //if(!vb.flagCube()(corrind, c, vbrow)){
-            if(!vb.flag()(c, blind)){
-              unflaggedfreqs[totunflaggedchan] = freqs[totchan];
-              // if(haveWS){
-              //   Double ws = vb.weightSpectrum()(corrind, c, vbrow);
-
-              //   wt[totunflaggedchan] = ws;
-              // }
-              // else
-                wt[totunflaggedchan] = w / nchan;
-              vizzes[totunflaggedchan] = viscube(corrind, c, blind);
-              ++totunflaggedchan;
-            }
-            ++totchan;
+      for(uInt corrind = 0; corrind < ncorr_p; ++corrind){
+        uInt nunflagged = fd.gather(corrind, blind, vizzes, wt, chans, False);
+
+        if(nunflagged > 0){
+          std::fill(key.begin(), key.end(), Float(0));
+          for(uInt i = 0; i < nunflagged; ++i)
+            key[chans[i]] = wt[i] / wt[0];
+          std::map<std::vector<Float>, uInt>::iterator iter =
+            groupIndex.find(key);
+          if(iter == groupIndex.end()){
+            iter = groupIndex.insert(std::make_pair(key,
+                                                    uInt(groups.size()))).first;
+            groups.push_back(std::vector<uInt>());
           }
+          groups[iter->second].push_back(blind * ncorr_p + corrind);
         }
       }
+    }
+  }
+  os << LogIO::DEBUG1
+     << groups.size() << " distinct flag patterns in "
+     << ncorr_p * nHashes_p << " baseline-correlations"
+     << LogIO::POST;
+
+  // Large groups are solved one at a time with their members spread over
+  // the threads; the small ones (typically odd flag patterns) are spread
+  // over the threads as a whole.
+  Int nthreads = 1;
+#ifdef _OPENMP
+  nthreads = omp_get_max_threads();
+#endif
+  std::vector<uInt> smallGroups;
+  std::vector<Char> failed(groups.size(), False);
+  for(uInt g = 0; g < groups.size(); ++g){
+    if(static_cast<Int>(groups[g].size()) < 4 * nthreads){
+      smallGroups.push_back(g);
+      continue;
+    }
+    Matrix<Double> solver;
+    Int locFitOrd;
+    if(!fd.formSolver(groups[g][0], fitorder_p, totnumchan_p, solver,
+                      locFitOrd)){
+      failed[g] = True;
+      continue;
+    }
+    Int nmember = groups[g].size();
+#pragma omp parallel for schedule(static)
+    for(Int m = 0; m < nmember; ++m)
+      fd.solve(groups[g][m], solver, locFitOrd, fitorder_p, coeffs, coeffsOK);
+  }
+  Int nsmall = smallGroups.size();
+#pragma omp parallel for schedule(dynamic)
+  for(Int ig = 0; ig < nsmall; ++ig){
+    uInt g = smallGroups[ig];
+    Matrix<Double> solver;
+    Int locFitOrd;
+    if(!fd.formSolver(groups[g][0], fitorder_p, totnumchan_p, solver,
+                      locFitOrd)){
+      failed[g] = True;
+      continue;
+    }
+    for(uInt m = 0; m < groups[g].size(); ++m)
+      fd.solve(groups[g][m], solver, locFitOrd, fitorder_p, coeffs, coeffsOK);
+  }
 
-      if(totunflaggedchan > 0){                 // OK, try a fit.
-        // Truncate the Vectors.
-        wt.resize(totunflaggedchan, True);
-        //vizzes.resize(totunflaggedchan, True);
-        floatvs.resize(totunflaggedchan);
-        unflaggedfreqs.resize(totunflaggedchan, True);
-
-        // perform least-squares fit of a polynomial.
-        // Don't try to solve for more coefficients than valid channels.
-        Int locFitOrd = min(fitorder_p, static_cast<Int>(totunflaggedchan) - 1);
-
-        // if(locFitOrd < 1)
-        //   os << LogIO::DEBUG1
-        //      << "locFitOrd = " << locFitOrd
-        //      << LogIO::POST;
-
-        Polynomial<AutoDiff<Float> > pnom(locFitOrd);
-
-        // The way LinearFit is templated, "y" can be Complex, but at the cost
-        // of "x" being Complex as well, and worse, wt too.  It is better to
-        // separately fit the reals and imags.
-        // Do reals.
-        for(Int ordind = 0; ordind <= locFitOrd; ++ordind)       // Note <=.
-          pnom.setCoefficient(ordind, 1.0);
-
-        for(uInt c = 0; c < totunflaggedchan; ++c)
-          floatvs[c] = vizzes[c].real();
-
-        fitter.setFunction(pnom);
-        realsolution = fitter.fit(unflaggedfreqs, floatvs, wt);
-
-        // if(isnan(realsolution[0])){
-        //   os << LogIO::DEBUG1 << "NaN found." << LogIO::POST;
-        //   for(uInt c = 0; c < totunflaggedchan; ++c){
-        //     if(isnan(unflaggedfreqs[c]))
-        //       os << LogIO::DEBUG1
-        //          << "unflaggedfreqs[" << c << "] is a NaN."
-        //          << LogIO::POST;
-        //     if(isnan(floatvs[c]))
-        //       os << LogIO::DEBUG1
-        //          << "floatvs[" << c << "] is a NaN."
-        //          << LogIO::POST;
-        //     if(isnan(wt[c]))
-        //       os << LogIO::DEBUG1
-        //          << "wt[" << c << "] is a NaN."
-        //          << LogIO::POST;
-        //     else if(wt[c] <= 0.0)
-        //       os << LogIO::DEBUG1
-        //          << "wt[" << c << "] = " << wt[c]
-        //          << LogIO::POST;
-        //   }
-        // }
-
-        // Do imags.
-        for(Int ordind = 0; ordind <= locFitOrd; ++ordind)       // Note <=.
-          pnom.setCoefficient(ordind, 1.0);
-
-        for(uInt c = 0; c < totunflaggedchan; ++c)
-          floatvs[c] = vizzes[c].imag();
-
-        fitter.setFunction(pnom);
-        imagsolution = fitter.fit(unflaggedfreqs, floatvs, wt);
-
-          
-
-        for(Int ordind = 0; ordind <= locFitOrd; ++ordind){      // Note <=.
-          coeffs(corrind, ordind, blind) = Complex(realsolution[ordind],
-                                                   imagsolution[ordind]);
-          coeffsOK(corrind, ordind, blind) = True;
-        }
-
-        // Pad remaining orders (if any) with 0.0.  Note <=.
-        for(Int ordind = locFitOrd + 1; ordind <= fitorder_p; ++ordind){
-          coeffs(corrind, ordind, blind) = 0.0;
-
-          // Since coeffs(corrind, ordind, blind) == 0, it isn't necessary to
-          // pay attention to coeffsOK(corrind, ordind, blind) (especially?) if
-          // ordind > 0.  But Calibrater's SolvableVisCal::keep() and store()
-          // quietly go awry if you try coeffsOK.resize(ncorr_p, 1, nHashes_p);
-          coeffsOK(corrind, ordind, blind) = False;
-        }
-
-        // TODO: store uncertainties
-      }
+  // Designs that are (nearly) singular, e.g. because of duplicate
+  // frequencies, are solved one by one using SVD.
+  LinearFitSVD<Float> fitter;
+  fitter.asWeight(true);        // Makes the "sigma" arg = w = 1/sig**2
+  for(uInt g = 0; g < groups.size(); ++g){
+    if(failed[g]){
+      for(uInt m = 0; m < groups[g].size(); ++m)
+        fd.fitSVD(fitter, groups[g][m], fitorder_p, totnumchan_p,
+                  coeffs, coeffsOK);
     }
   }
+  // TODO: store uncertainties
 }
 
 void VBContinuumSubtractor::getMinMaxFreq(VisBuffer& vb,
@@ -484,37 +644,44 @@ Bool VBContinuumSubtractor::apply(VisBuffer& vb,
   // }
   // END DEBUGGING
 
-  Vector<Double> freqpow(fitorder_p + 1);           // sf**ordind
-  freqpow[0] = 1.0;
+  // Scaled frequencies, shared by all rows.
   Vector<Double>& freq(vb.frequency());
-
-  for(uInt c = 0; c < nchan; ++c){
-    Double sf = freqscale_p * (freq[c] - midfreq_p);      // scaled frequency
-  
-    for(Int ordind = 1; ordind <= fitorder_p; ++ordind)
-      freqpow[ordind] = sf * freqpow[ordind - 1];
-
-    for(uInt vbrow = 0; vbrow < nvbrow; ++vbrow){
-      uInt blind = hashFunction(vb.antenna1()[vbrow],
-                                vb.antenna2()[vbrow]);
-
-      for(uInt corrind = 0; corrind < ncorr_p; ++corrind){
-        if(coeffsOK(corrind, 0, blind)){
-          Complex cont = coeffs(corrind, 0, blind);
-
-          for(Int ordind = 1; ordind <= fitorder_p; ++ordind)
-            cont += coeffs(corrind, ordind, blind) * freqpow[ordind];
+  Vector<Double> sf(nchan);
+  for(uInt c = 0; c < nchan; ++c)
+    sf[c] = freqscale_p * (freq[c] - midfreq_p);
+
+  // Get the (lazily filled) columns before going parallel.
+  const Vector<Int>& ant1(vb.antenna1());
+  const Vector<Int>& ant2(vb.antenna2());
+  Cube<Bool>& flagCube(vb.flagCube());
+  Int nrow = nvbrow;
+
+#pragma omp parallel for if (nvbrow * nchan >= 16384)
+  for(Int vbrow = 0; vbrow < nrow; ++vbrow){
+    uInt blind = hashFunction(ant1[vbrow], ant2[vbrow]);
+    std::vector<DComplex> cf(fitorder_p + 1);
+
+    for(uInt corrind = 0; corrind < ncorr_p; ++corrind){
+      if(coeffsOK(corrind, 0, blind)){
+        for(Int ordind = 0; ordind <= fitorder_p; ++ordind)
+          cf[ordind] = coeffs(corrind, ordind, blind);
+        // Evaluate the polynomial using Horner's rule.
+        for(uInt c = 0; c < nchan; ++c){
+          DComplex cont(cf[fitorder_p]);
+
+          for(Int ordind = fitorder_p - 1; ordind >= 0; --ordind)
+            cont = cont * sf[c] + cf[ordind];
           if(doSubtraction)
-            viscube(corrind, c, vbrow) -= cont;
+            viscube(corrind, c, vbrow) -= Complex(cont);
           else
-            viscube(corrind, c, vbrow) = cont;            
-
-          // TODO: Adjust WEIGHT_SPECTRUM (create if necessary?), WEIGHT, and
-          // SIGMA.
+            viscube(corrind, c, vbrow) = Complex(cont);
         }
-        else
-          vb.flagCube()(corrind, c, vbrow) = true;
-        //vb.flag()(c, vbrow) = true;
+        // TODO: Adjust WEIGHT_SPECTRUM (create if necessary?), WEIGHT, and
+        // SIGMA.
+      }
+      else{
+        for(uInt c = 0; c < nchan; ++c)
+          flagCube(corrind, c, vbrow) = true;
       }
     }
   }
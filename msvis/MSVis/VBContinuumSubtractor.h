@@ -125,6 +125,9 @@ public:
   //   coeffs:   Polynomial coefficients for the continuum, indexed by (corr,
   //             order, hash(ant1, ant2).
   //   coeffsOK: and whether or not they're usable.
+  // Baselines and correlations with the same flags (and relative weights)
+  // share the normal equations, which are factored once for all of them.
+  // The fits are done in parallel.
   void fit(VisBuffGroupAcc& vbga, const Int fitorder,
            MS::PredefinedColumns whichcol,
            Cube<Complex>& coeffs, Cube<Bool>& coeffsOK,
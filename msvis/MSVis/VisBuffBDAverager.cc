@@ -0,0 +1,240 @@
+//# VisBuffBDAverager.cc: Implementation of VisBuffBDAverager.h
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+//----------------------------------------------------------------------------
+
+#include <msvis/MSVis/VisBuffBDAverager.h>
+#include <msvis/MSVis/VisBuffer.h>
+#include <casa/Arrays/ArrayMath.h>
+#include <casa/BasicSL/Constants.h>
+#include <casa/Utilities/GenSort.h>
+#include <casa/Exceptions/Error.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+//----------------------------------------------------------------------------
+
+VisBuffBDAverager::VisBuffBDAverager (Double maxUVShift, Int maxChanGroup)
+  : maxUVShift_p   (maxUVShift),
+    maxChanGroup_p (maxChanGroup < 1  ?  1 : maxChanGroup),
+    nIn_p          (0),
+    nOut_p         (0)
+{}
+
+//----------------------------------------------------------------------------
+
+VisBuffBDAverager::~VisBuffBDAverager()
+{}
+
+//----------------------------------------------------------------------------
+
+void VisBuffBDAverager::average (VisBuffer& vb, Bool doObserved,
+                                 Bool doCorrected, Bool doModel)
+{
+  Int nRow  = vb.nRow();
+  Int nChan = vb.nChannel();
+  if (nRow == 0  ||  nChan == 0  ||  maxUVShift_p <= 0) {
+    return;
+  }
+  cubes_p.resize (0);
+  if (doObserved) {
+    cubes_p.resize (cubes_p.nelements() + 1, False, True);
+    cubes_p[cubes_p.nelements() - 1] = &(vb.visCube());
+  }
+  if (doCorrected) {
+    cubes_p.resize (cubes_p.nelements() + 1, False, True);
+    cubes_p[cubes_p.nelements() - 1] = &(vb.correctedVisCube());
+  }
+  if (doModel) {
+    cubes_p.resize (cubes_p.nelements() + 1, False, True);
+    cubes_p[cubes_p.nelements() - 1] = &(vb.modelVisCube());
+  }
+  // Make sure flags and weights are filled before they are changed.
+  const Matrix<Bool>& flag = vb.flag();
+  vb.flagCube();
+  vb.imagingWeight();
+  const Vector<Bool>& flagRow = vb.flagRow();
+  const Vector<RigidVector<Double,3> >& uvw = vb.uvw();
+  const Vector<Double>& freq = vb.frequency();
+  nIn_p += countSamples (vb);
+
+  // Order the rows by baseline; the sort is stable, so within a baseline
+  // the rows stay in time order.
+  const Vector<Int>& ant1 = vb.antenna1();
+  const Vector<Int>& ant2 = vb.antenna2();
+  Int nAnt = max(max(ant1), max(ant2)) + 1;
+  Vector<Int> blKey(nRow);
+  for (Int row=0; row<nRow; ++row) {
+    blKey[row] = ant1[row] * nAnt + ant2[row];
+  }
+  Vector<uInt> order;
+  GenSortIndirect<Int>::sort (order, blKey);
+
+  // Time averaging.  The uv-span is evaluated at the highest frequency.
+  Double toLambda = max(freq) / C::c;
+  Vector<Int> chans(nRow);
+  Vector<Int> rows(nRow);
+  Int start = 0;
+  while (start < nRow) {
+    Int end = start + 1;
+    while (end < nRow  &&  blKey[order[end]] == blKey[order[start]]) {
+      ++end;
+    }
+    // Cut the baseline track into pieces with a small enough uv-span.
+    Int g0 = start;
+    while (g0 < end) {
+      const RigidVector<Double,3>& uvw0 = uvw[order[g0]];
+      Int g1 = g0 + 1;
+      while (g1 < end) {
+        const RigidVector<Double,3>& uvw1 = uvw[order[g1]];
+        Double du = uvw1(0) - uvw0(0);
+        Double dv = uvw1(1) - uvw0(1);
+        Double dw = uvw1(2) - uvw0(2);
+        if (sqrt(du*du + dv*dv + dw*dw) * toLambda > maxUVShift_p) {
+          break;
+        }
+        ++g1;
+      }
+      if (g1 - g0 > 1) {
+        for (Int chan=0; chan<nChan; ++chan) {
+          uInt n = 0;
+          for (Int i=g0; i<g1; ++i) {
+            Int row = order[i];
+            if (!flagRow[row]  &&  !flag(chan,row)) {
+              chans[n] = chan;
+              rows[n]  = row;
+              ++n;
+            }
+          }
+          if (n > 1) {
+            merge (vb, chans, rows, n);
+          }
+        }
+      }
+      g0 = g1;
+    }
+    start = end;
+  }
+
+  // Frequency averaging of the remaining samples.
+  if (maxChanGroup_p > 1  &&  nChan > 1) {
+    Double chanWidth = fabs(freq[1] - freq[0]);
+    chans.resize (maxChanGroup_p);
+    rows.resize (maxChanGroup_p);
+    for (Int row=0; row<nRow; ++row) {
+      if (flagRow[row]) {
+        continue;
+      }
+      Double blen = sqrt(uvw[row](0)*uvw[row](0) + uvw[row](1)*uvw[row](1) +
+                         uvw[row](2)*uvw[row](2));
+      Int nc = maxChanGroup_p;
+      if (blen * chanWidth > 0) {
+        Double ncmax = 1 + maxUVShift_p * C::c / (blen * chanWidth);
+        if (ncmax < nc) {
+          nc = Int(ncmax);
+        }
+      }
+      if (nc < 2) {
+        continue;
+      }
+      for (Int c0=0; c0<nChan; c0+=nc) {
+        Int c1 = min(c0 + nc, nChan);
+        uInt n = 0;
+        for (Int chan=c0; chan<c1; ++chan) {
+          if (!flag(chan,row)) {
+            chans[n] = chan;
+            rows[n]  = row;
+            ++n;
+          }
+        }
+        if (n > 1) {
+          merge (vb, chans, rows, n);
+        }
+      }
+    }
+  }
+  nOut_p += countSamples (vb);
+}
+
+//----------------------------------------------------------------------------
+
+void VisBuffBDAverager::merge (VisBuffer& vb, const Vector<Int>& chans,
+                               const Vector<Int>& rows, uInt n)
+{
+  Matrix<Float>& imwgt   = vb.imagingWeight();
+  Matrix<Bool>& flag     = vb.flag();
+  Cube<Bool>& flagCube   = vb.flagCube();
+  Int nCorr = flagCube.shape()[0];
+  // The sample nearest to the middle of the group gets the result.
+  Int repChan = chans[n/2];
+  Int repRow  = rows[n/2];
+  Float sumWgt = 0;
+  for (uInt i=0; i<n; ++i) {
+    sumWgt += imwgt(chans[i], rows[i]);
+  }
+  for (uInt j=0; j<cubes_p.nelements(); ++j) {
+    Cube<Complex>& data = *cubes_p[j];
+    for (Int corr=0; corr<nCorr; ++corr) {
+      Complex sum(0,0);
+      for (uInt i=0; i<n; ++i) {
+        sum += imwgt(chans[i], rows[i]) * data(corr, chans[i], rows[i]);
+      }
+      data(corr, repChan, repRow) = (sumWgt > 0  ?  sum / sumWgt : sum);
+    }
+  }
+  for (uInt i=0; i<n; ++i) {
+    if (chans[i] != repChan  ||  rows[i] != repRow) {
+      imwgt(chans[i], rows[i]) = 0;
+      flag(chans[i], rows[i])  = True;
+      for (Int corr=0; corr<nCorr; ++corr) {
+        flagCube(corr, chans[i], rows[i]) = True;
+      }
+    }
+  }
+  imwgt(repChan, repRow) = sumWgt;
+}
+
+//----------------------------------------------------------------------------
+
+Double VisBuffBDAverager::countSamples (const VisBuffer& vb) const
+{
+  const Matrix<Bool>& flag = vb.flag();
+  const Vector<Bool>& flagRow = vb.flagRow();
+  Double nsamp = 0;
+  for (uInt row=0; row<flag.ncolumn(); ++row) {
+    if (!flagRow[row]) {
+      for (uInt chan=0; chan<flag.nrow(); ++chan) {
+        if (!flag(chan,row)) {
+          nsamp++;
+        }
+      }
+    }
+  }
+  return nsamp;
+}
+
+
+} //# NAMESPACE CASA - END
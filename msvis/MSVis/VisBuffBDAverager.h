@@ -0,0 +1,166 @@
+//# VisBuffBDAverager.h: baseline-dependent in-place averaging of a VisBuffer
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef MSVIS_VISBUFFBDAVERAGER_H
+#define MSVIS_VISBUFFBDAVERAGER_H
+
+#include <casa/aips.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Arrays/Cube.h>
+#include <casa/Containers/Block.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+class VisBuffer;
+
+// <summary>
+// Baseline-dependent time and frequency averaging of a VisBuffer in place
+// </summary>
+//
+// <use visibility=export>
+//
+// <reviewed reviewer="" date="yyyy/mm/dd" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> VisBuffer
+//   <li> FTMachine
+// </prerequisite>
+//
+// <etymology>
+// From "VisBuffer", "baseline-dependent" and "averaging".
+// </etymology>
+//
+// <synopsis>
+// Short baselines move slowly through the uv-plane, so consecutive samples
+// of such a baseline (in time and in frequency) usually fall well within a
+// single uv-cell.  This class merges those samples before they are handed
+// to an FTMachine, so that the gridder has to convolve far fewer samples.
+//
+// Samples of one baseline are merged as long as their uv-span (computed at
+// the highest frequency in the VisBuffer) does not exceed the given
+// maximum uv-shift (in wavelengths).  The merged value is the
+// imaging-weighted mean of the samples and its imaging weight is the sum of
+// their imaging weights, so the weight normalization of the gridder is not
+// affected.  The result is stored in the sample nearest to the middle of the
+// group, which keeps its own uvw, time and frequency; the other samples of
+// the group are flagged.  In this way the VisBuffer keeps its shape and can
+// be passed on unchanged to FTMachine::get and FTMachine::put.
+//
+// Time averaging needs a VisBuffer containing multiple time slots, so the
+// VisibilityIterator should use row blocking.  Frequency averaging is only
+// done when maxChanGroup is larger than one; the caller has to make sure
+// that all channels of the VisBuffer end up in the same image channel.
+//
+// Only samples for which no correlation is flagged take part in the
+// averaging; partially flagged samples are left untouched.
+// </synopsis>
+//
+// <example>
+// <srcblock>
+//   // Allow a uv-shift of 0.1 uv-cell for a 5 degree field of view.
+//   VisBuffBDAverager bda(0.1 / (5*C::pi/180), 1);
+//   for (vi.origin(); vi.more(); vi++) {
+//     bda.average (vb, False, True, False);
+//     ft.put (vb, -1, False, FTMachine::CORRECTED);
+//   }
+// </srcblock>
+// </example>
+//
+// <motivation>
+// VisBuffAccumulator, VisChunkAverager and MsAverager average with a fixed
+// interval for all baselines and create a new VisBuffer or MS.  For imaging
+// the averaging can be much more aggressive on short baselines and it has
+// to be done on the fly.
+// </motivation>
+
+class VisBuffBDAverager
+{
+public:
+  // Construct from the maximum uv-shift (in wavelengths) allowed when
+  // merging samples and the maximum number of channels to merge.
+  VisBuffBDAverager (Double maxUVShift, Int maxChanGroup=1);
+
+  ~VisBuffBDAverager();
+
+  // Average the VisBuffer in place.  The flags and imaging weights are
+  // always averaged; the observed, corrected and model data cubes only if
+  // requested.  Use no data cubes when making a PSF.
+  void average (VisBuffer& vb, Bool doObserved, Bool doCorrected,
+                Bool doModel);
+
+  // Get or set the maximum uv-shift (in wavelengths).
+  // <group>
+  Double maxUVShift() const
+    { return maxUVShift_p; }
+  void setMaxUVShift (Double maxUVShift)
+    { maxUVShift_p = maxUVShift; }
+  // </group>
+
+  // Get or set the maximum number of channels to merge.
+  // <group>
+  Int maxChanGroup() const
+    { return maxChanGroup_p; }
+  void setMaxChanGroup (Int maxChanGroup)
+    { maxChanGroup_p = (maxChanGroup < 1  ?  1 : maxChanGroup); }
+  // </group>
+
+  // Number of unflagged samples seen and left after averaging.
+  // <group>
+  Double nSamplesIn() const
+    { return nIn_p; }
+  Double nSamplesOut() const
+    { return nOut_p; }
+  void resetCounts()
+    { nIn_p = nOut_p = 0; }
+  // </group>
+
+private:
+  // Prohibit copy constructor and assignment.
+  VisBuffBDAverager (const VisBuffBDAverager&);
+  VisBuffBDAverager& operator= (const VisBuffBDAverager&);
+
+  // Merge the samples at the given (channel,row) positions into the
+  // middle one.
+  void merge (VisBuffer& vb, const Vector<Int>& chans,
+              const Vector<Int>& rows, uInt n);
+
+  // Count the unflagged samples in the VisBuffer.
+  Double countSamples (const VisBuffer& vb) const;
+
+  Double maxUVShift_p;
+  Int    maxChanGroup_p;
+  Double nIn_p;
+  Double nOut_p;
+  // The data cubes to average in the current call.
+  Block<Cube<Complex>*> cubes_p;
+};
+
+
+} //# NAMESPACE CASA - END
+
+#endif
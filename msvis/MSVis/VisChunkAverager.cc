@@ -26,6 +26,8 @@
 //----------------------------------------------------------------------------
 
 #include <msvis/MSVis/VisChunkAverager.h>
+#include <casa/Containers/Block.h>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -36,7 +38,8 @@ VisChunkAverager::VisChunkAverager(const Vector<MS::PredefinedColumns>& dataCols
   : colEnums_p(dataCols),
     doSpWeight_p(doSpWeight),
     readyToHash_p(false),
-    haveHashMap_p(false)
+    haveHashMap_p(false),
+    ddId_p(-1)
 {
   reset();
 }
@@ -45,7 +48,16 @@ VisChunkAverager::VisChunkAverager(const Vector<MS::PredefinedColumns>& dataCols
 
 VisChunkAverager::~VisChunkAverager()
 {
-// Null default destructor
+  clearChunklets();
+}
+
+//----------------------------------------------------------------------------
+
+void VisChunkAverager::clearChunklets()
+{
+  for(uInt i = 0; i < chunklets_p.size(); ++i)
+    delete chunklets_p[i];
+  chunklets_p.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -132,23 +144,85 @@ Bool VisChunkAverager::setupHashFunction(ROVisibilityIterator& vi)
 
 VisBuffer& VisChunkAverager::average(ROVisibilityIterator& vi)
 {
+  readChunk(vi);
+  return averageChunk();
+}
+
+void VisChunkAverager::readChunk(ROVisibilityIterator& vi)
+{
+  clearChunklets();
+
   // Just in case findCollision() returned before doing it.
   // makeHashMap will return right away if it can.
   haveHashMap_p = makeHashMap(vi);
 
   VisBuffer vb(vi);
-  uInt chunkletNum = 0;
+
+  for(vi.origin(); vi.more(); ++vi){
+    fill_vb(vb);
+    if(chunklets_p.empty()){
+      // avBuf_p gets its univalued columns from vi, so it has to be set up
+      // while vi is still at this chunk.
+      initialize(vb);
+      ddId_p = vb.dataDescriptionId();
+    }
+    // The copy has its own cache, which holds everything averageChunk()
+    // needs, so it never goes back to vi.
+    chunklets_p.push_back(new VisBuffer(vb));
+  }
+}
+
+VisBuffer& VisChunkAverager::averageChunk()
+{
   Bool firstValidOutRowInChunk = true;
   Double time, minTime, maxTime, firstinterval, lastinterval;
   Vector<Bool> firstrowinslot(sphash_to_inprows_p.size());
   firstrowinslot.set(true);
 
-  initialize(vb);
-  for(vi.origin(); vi.more(); ++vi){
+  // The output columns to accumulate into.
+  Block<Cube<Complex>*> inCubes, outCubes;
+  Block<Int> cubeCols;
+  Bool doFloat = False;
+  for(Int i = colEnums_p.nelements(); i--;){
+    Cube<Complex>* outCube = 0;
+    if(colEnums_p[i] == MS::CORRECTED_DATA)
+      outCube = &avBuf_p.correctedVisCube();
+    else if(colEnums_p[i] == MS::MODEL_DATA)
+      outCube = &avBuf_p.modelVisCube();
+    // else if(colEnums_p[i] == MS::LAG_DATA)
+    //  VisBuffer doesn't handle LAG_DATA
+    else if(colEnums_p[i] == MS::FLOAT_DATA)
+      doFloat = True;
+    else if(colEnums_p[i] == MS::DATA)
+      outCube = &avBuf_p.visCube();
+    if(outCube){
+      outCubes.resize(outCubes.nelements() + 1, False, True);
+      outCubes[outCubes.nelements() - 1] = outCube;
+      cubeCols.resize(outCubes.nelements(), False, True);
+      cubeCols[outCubes.nelements() - 1] = colEnums_p[i];
+    }
+  }
+  inCubes.resize(outCubes.nelements());
+  Cube<Float>* outFloat = doFloat ? &avBuf_p.floatDataCube() : 0;
+  Cube<Bool>& outFlag(avBuf_p.flagCube());
+  Matrix<Float>& outWtM(avBuf_p.weightMat());
+  Cube<Float>* outWtSp = doSpWeight_p ? &avBuf_p.weightSpectrum() : 0;
+  Matrix<Double>& outUVW(avBuf_p.uvwMat());
+  Vector<Double>& outTimeCentroid(avBuf_p.timeCentroid());
+  Vector<Double>& outExposure(avBuf_p.exposure());
+
+  std::vector<Int> outrows, inrows;
+  outrows.reserve(sphash_to_inprows_p.size());
+  inrows.reserve(sphash_to_inprows_p.size());
+
+  for(uInt chunkletNum = 0; chunkletNum < chunklets_p.size(); ++chunkletNum){
     // Iterate through the current VisBuffer
+    VisBuffer& vb = *chunklets_p[chunkletNum];
     Int outrow = 0;
     Bool firstValidOutRowInIntegration = true;
 
+    outrows.clear();
+    inrows.clear();
     mapuIvIType::iterator sphend = sphash_to_inprows_p.end();
     for(mapuIvIType::iterator sphit = sphash_to_inprows_p.begin();
         sphit != sphend; ++sphit){
@@ -189,92 +263,93 @@ VisBuffer& VisChunkAverager::average(ROVisibilityIterator& vi)
           avBuf_p.scan()[outrow] = vb.scan()[inrow];
           avBuf_p.stateId()[outrow] = vb.stateId()[inrow];
         }
+        outrows.push_back(outrow);
+        inrows.push_back(inrow);
+      }
+      ++outrow;
+    }                   // End of loop over sphit for chunkletNum.
 
-        Vector<Float> wtM(vb.weightMat().column(inrow));
-
-        // Accumulate the visibilities and weights, and set the flags.
-        Double totwt = 0.0;                       // Total weight for inrow.
-        for(Int cor = 0; cor < nCorr_p; ++cor){
-          Double channellesswt = 0.0;
-          Double constwtperchan = wtM[cor] / nChan_p;
+    // Get the input columns before going parallel; every slot only
+    // touches its own output row, so the slots can be accumulated in
+    // parallel.
+    for(uInt i = 0; i < outCubes.nelements(); ++i){
+      if(cubeCols[i] == MS::CORRECTED_DATA)
+        inCubes[i] = &vb.correctedVisCube();
+      else if(cubeCols[i] == MS::MODEL_DATA)
+        inCubes[i] = &vb.modelVisCube();
+      else
+        inCubes[i] = &vb.visCube();
+    }
+    const Cube<Float>* inFloat = doFloat ? &vb.floatDataCube() : 0;
+    const Cube<Bool>& inFlag(vb.flagCube());
+    const Matrix<Float>& inWtM(vb.weightMat());
+    const Cube<Float>* inWtSp = doSpWeight_p ? &vb.weightSpectrum() : 0;
+    const Matrix<Double>& inUVW(vb.uvwMat());
+    const Vector<Double>& inTimeCentroid(vb.timeCentroid());
+    const Vector<Double>& inExposure(vb.exposure());
+    uInt nCube = outCubes.nelements();
+    Int nslot = outrows.size();
+
+#pragma omp parallel for if (nslot * nCorr_p * nChan_p >= 16384)
+    for(Int islot = 0; islot < nslot; ++islot){
+      Int outrow = outrows[islot];
+      Int inrow = inrows[islot];
+
+      // Accumulate the visibilities and weights, and set the flags.
+      Double totwt = 0.0;                       // Total weight for inrow.
+      for(Int cor = 0; cor < nCorr_p; ++cor){
+        Double channellesswt = 0.0;
+        Double constwtperchan = inWtM(cor, inrow) / nChan_p;
 
-          for(Int chn = 0; chn < nChan_p; ++chn){
-            if(!vb.flagCube()(cor, chn, inrow)){
-              Double wt = doSpWeight_p ? vb.weightSpectrum()(cor, chn, inrow) :
-                constwtperchan;
+        for(Int chn = 0; chn < nChan_p; ++chn){
+          if(!inFlag(cor, chn, inrow)){
+            Double wt = inWtSp ? (*inWtSp)(cor, chn, inrow) : constwtperchan;
 
-              if(doSpWeight_p)
-                avBuf_p.weightSpectrum()(cor, chn, outrow) += wt;
-              channellesswt += wt;
-              avBuf_p.flagCube()(cor, chn, outrow) = False;
+            if(inWtSp)
+              (*outWtSp)(cor, chn, outrow) += wt;
+            channellesswt += wt;
+            outFlag(cor, chn, outrow) = False;
 
-              // FLAG_CATEGORY?
+            // FLAG_CATEGORY?
             
-              for(Int i = colEnums_p.nelements(); i--;){
-                if(colEnums_p[i] == MS::CORRECTED_DATA)
-                  avBuf_p.correctedVisCube()(cor, chn, outrow) += 
-                    (wt * vb.correctedVisCube()(cor, chn, inrow));
-                else if(colEnums_p[i] == MS::MODEL_DATA)
-                  avBuf_p.modelVisCube()(cor, chn, outrow) += 
-                    (wt * vb.modelVisCube()(cor, chn, inrow));
-                // else if(colEnums_p[i] == MS::LAG_DATA)
-                //  VisBuffer doesn't handle LAG_DATA
-                else if(colEnums_p[i] == MS::FLOAT_DATA)
-                  avBuf_p.floatDataCube()(cor, chn, outrow) += 
-                    (wt * vb.floatDataCube()(cor, chn, inrow));
-                else if(colEnums_p[i] == MS::DATA)
-                  avBuf_p.visCube()(cor, chn, outrow) += 
-                    (wt * vb.visCube()(cor, chn, inrow));
-              }
-            }
+            for(uInt i = 0; i < nCube; ++i)
+              (*outCubes[i])(cor, chn, outrow) +=
+                (wt * (*inCubes[i])(cor, chn, inrow));
+            if(inFloat)
+              (*outFloat)(cor, chn, outrow) +=
+                (wt * (*inFloat)(cor, chn, inrow));
           }
-          avBuf_p.weightMat()(cor, outrow) += channellesswt;
-          totwt += channellesswt;
         }
+        outWtM(cor, outrow) += channellesswt;
+        totwt += channellesswt;
+      }
 
-        Double totslotwt = 0.0;
-
-        for(Int cor = 0; cor < nCorr_p; ++cor)
-          totslotwt += avBuf_p.weightMat()(cor, outrow);
-
-        // totwt > 0.0 implies totslotwt > 0.0, as required by
-        // the running averages (mandatory for timeCentroid!).
-        if(totwt > 0.0){
-          Double leverage = totwt / totslotwt;
-
-          // UVW (weighted only by weight for now)
-      // // Iterate through slots.
-      // for(ui2vmap::iterator slotit = bin_slots_p[tbn].begin();
-      //     slotit != bin_slots_p[tbn].end(); ++slotit){
-      //   for(uivector::iterator toikit = slotv.begin();
-      //       toikit != slotv.end(); ++toikit){
-      //       Double wv = 0.0;
-      //       Array<Complex>::const_iterator dataEnd = data_toikit.end();
-      //       for(Array<Complex>::const_iterator dit = data_toikit.begin();
-      //           dit != dataEnd; ++dit)
-      //         wv += fabs(*dit);
-      //       if(wv > 0.0){
-      //         swv += wv;
-      //         outUVW += (wv / swv) * (inUVW(*toikit) - outUVW);
-      //       }
-      //   } // End of loop through the slot's rows.
-          for(uInt ax = 0; ax < 3; ++ax)
-            avBuf_p.uvwMat()(ax, outrow) += leverage * (vb.uvwMat()(ax, inrow) -
-                                                        avBuf_p.uvwMat()(ax, outrow));
-
-          avBuf_p.timeCentroid()[outrow] += leverage *
-            (vb.timeCentroid()[inrow] - avBuf_p.timeCentroid()[outrow]);
-          avBuf_p.exposure()[outrow] += totwt * vb.exposure()[inrow];
-        }
-        else if(totslotwt == 0.0){      // Put in a representative UVW.
-          for(uInt ax = 0; ax < 3; ++ax)
-            avBuf_p.uvwMat()(ax, outrow) = vb.uvwMat()(ax, inrow);
-        }
+      Double totslotwt = 0.0;
+
+      for(Int cor = 0; cor < nCorr_p; ++cor)
+        totslotwt += outWtM(cor, outrow);
+
+      // totwt > 0.0 implies totslotwt > 0.0, as required by
+      // the running averages (mandatory for timeCentroid!).
+      if(totwt > 0.0){
+        Double leverage = totwt / totslotwt;
+
+        // UVW (weighted only by weight for now)
+        for(uInt ax = 0; ax < 3; ++ax)
+          outUVW(ax, outrow) += leverage * (inUVW(ax, inrow) -
+                                            outUVW(ax, outrow));
+
+        outTimeCentroid[outrow] += leverage *
+          (inTimeCentroid[inrow] - outTimeCentroid[outrow]);
+        outExposure[outrow] += totwt * inExposure[inrow];
       }
-      ++outrow;
-    }                   // End of loop over sphit for chunkletNum.
-    ++chunkletNum;
+      else if(totslotwt == 0.0){      // Put in a representative UVW.
+        for(uInt ax = 0; ax < 3; ++ax)
+          outUVW(ax, outrow) = inUVW(ax, inrow);
+      }
+    }
   }             // End of loop over chunkletNums (integrations) in vi's current chunk.
+  clearChunklets();
   normalize(minTime, maxTime, firstinterval, lastinterval);
 
   return avBuf_p;
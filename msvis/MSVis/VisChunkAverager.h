@@ -111,6 +111,18 @@ public:
   //                                          "integration".
   VisBuffer& average(ROVisibilityIterator& vi);
 
+  // The two halves of average().  readChunk() reads all the columns of vi's
+  // current chunk into memory (AND advances vi to the end of that chunk).
+  // It is the only part that uses vi or the MS, so averageChunk() can run
+  // on another thread while the calling thread reads or writes other
+  // chunks.  The chunk is released by averageChunk().
+  void readChunk(ROVisibilityIterator& vi);
+  VisBuffer& averageChunk();
+
+  // The DATA_DESC_ID of the chunk read by readChunk().  Use it instead of
+  // the averaged VisBuffer's, which asks vi (possibly at another chunk).
+  Int dataDescriptionId() const { return ddId_p; }
+
   // Checks whether the interval of vi needs to be truncated in order to
   // prevent collisions where two rows have the same MS key (ignoring TIME) but
   // different SCAN_NUMBER, STATE_ID, and/or OBSERVATION_ID.  ARRAY_ID is
@@ -141,6 +153,9 @@ private:
   void normalize(const Double minTime, const Double maxTime,
                  const Double firstinterval, const Double lastinterval);
 
+  // Delete the chunklets read by readChunk().
+  void clearChunklets();
+
   // Force vb to read all the columns (modified by colEnums_p and
   // doSpWeight_p).
   //
@@ -222,6 +237,13 @@ private:
 
   // Averaging buffer
   CalVisBuffer avBuf_p;
+
+  // Copies of the VisBuffers (integrations) of the chunk being averaged,
+  // with all the columns used by averageChunk() filled.
+  std::vector<VisBuffer*> chunklets_p;
+
+  // DATA_DESC_ID of the chunk.
+  Int ddId_p;
 };
 
 
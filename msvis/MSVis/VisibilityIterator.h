@@ -216,6 +216,10 @@ public:
   // size determines the actual maximum.
   virtual void setRowBlocking(Int nRows=0);
 
+  // Get the 'blocking' size set by setRowBlocking.
+  Int getRowBlocking() const
+  { return nRowBlocking_p; }
+
   // Return False if no more data (in current chunk)
   virtual Bool more() const;
 
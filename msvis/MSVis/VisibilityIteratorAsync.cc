@@ -554,11 +554,29 @@ ROVisibilityIteratorAsync::getVisBuffer ()
     return vb;
 }
 
+namespace {
+
+    // -1 means no override: use the AipsRc value.
+
+    Int asynchronousIoOverride = -1;
+}
+
+void
+ROVisibilityIteratorAsync::setAsynchronousIoEnabled (Bool enabled)
+{
+    asynchronousIoOverride = enabled ? 1 : 0;
+}
+
 Bool
 ROVisibilityIteratorAsync::isAsynchronousIoEnabled()
 {
     // Determines whether asynchronous I/O is enabled by looking for the
     // expected AipsRc value.  If not found then async i/o is disabled.
+    // An explicit setAsynchronousIoEnabled call takes precedence.
+
+    if (asynchronousIoOverride >= 0){
+        return asynchronousIoOverride == 1;
+    }
 
     Bool isDisabled;
     AipsrcValue<Bool>::find (isDisabled, getAipsRcBase () + ".disabled", True);
@@ -195,6 +195,9 @@ public:
     static int getDefaultNBuffers ();
     static String getAipsRcBase();
     static Bool isAsynchronousIoEnabled ();
+    // Overrides the AipsRc setting for the rest of the process (e.g. for an
+    // application that always wants its reads done on the lookahead thread).
+    static void setAsynchronousIoEnabled (Bool enabled);
     static PrefetchColumns prefetchColumnsAll ();
     static PrefetchColumns prefetchAllColumnsExcept (int firstColumnId, ...);
     static PrefetchColumns prefetchColumns (int firstColumnId, ...);
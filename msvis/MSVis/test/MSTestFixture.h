@@ -0,0 +1,154 @@
+//# MSTestFixture.h: Build small MeasurementSets for the test programs
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef MSVIS_MSTESTFIXTURE_H
+#define MSVIS_MSTESTFIXTURE_H
+
+#include <casa/aips.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Arrays/Matrix.h>
+#include <casa/BasicSL/String.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <tables/Tables/SetupNewTab.h>
+#include <measures/Measures/Stokes.h>
+#include <measures/Measures/MFrequency.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+// <summary>
+// Build small MeasurementSets for the test programs
+// </summary>
+
+// <use visibility=local>
+
+// <synopsis>
+// The test programs of msvis, synthesis and flagging make their own tiny
+// MS in the working directory. These functions make an empty MS and add
+// the subtable rows a test needs; the test itself fills the main table.
+// Only what is needed by the code under test should be added.
+// </synopsis>
+
+// <group name=MSTestFixture>
+
+// Create a new MS with the default subtables and (optionally) a DATA
+// column of 2 dimensions. It is deleted when the last object using it
+// goes out of scope.
+inline MeasurementSet newTestMS (const String& name, Bool withData=True)
+{
+  TableDesc td = MS::requiredTableDesc();
+  if (withData) {
+    MS::addColumnToDesc (td, MS::DATA, 2);
+  }
+  SetupNewTable newTab (name, td, Table::New);
+  MeasurementSet ms (newTab);
+  ms.createDefaultSubtables (Table::New);
+  ms.markForDelete();
+  return ms;
+}
+
+// Add nAnt antennas of 25 m near the earth's surface, each with a feed of
+// 2 receptors.
+inline void addTestAntennas (MeasurementSet& ms, Int nAnt)
+{
+  MSColumns cols (ms);
+  for (Int i=0; i<nAnt; ++i) {
+    uInt row = ms.antenna().nrow();
+    ms.antenna().addRow();
+    cols.antenna().name().put (row, "ANT" + String::toString(row));
+    cols.antenna().position().put (row, Vector<Double>(3, 6.4e6 + row));
+    cols.antenna().dishDiameter().put (row, 25.);
+    ms.feed().addRow();
+    cols.feed().antennaId().put (row, Int(row));
+    cols.feed().numReceptors().put (row, 2);
+    cols.feed().beamOffset().put (row, Matrix<Double>(2, 2, 0.));
+    cols.feed().polarizationType().put (row, Vector<String>(2, "R"));
+    cols.feed().polResponse().put (row, Matrix<Complex>(2, 2, Complex()));
+    cols.feed().receptorAngle().put (row, Vector<Double>(2, 0.));
+    cols.feed().position().put (row, Vector<Double>(3, 0.));
+  }
+}
+
+// Add a field with all directions at (0.5,0.5) rad.
+inline void addTestField (MeasurementSet& ms)
+{
+  MSColumns cols (ms);
+  uInt row = ms.field().nrow();
+  ms.field().addRow();
+  cols.field().numPoly().put (row, 0);
+  cols.field().delayDir().put (row, Matrix<Double>(2, 1, 0.5));
+  cols.field().phaseDir().put (row, Matrix<Double>(2, 1, 0.5));
+  cols.field().referenceDir().put (row, Matrix<Double>(2, 1, 0.5));
+}
+
+// Add a polarization setup with correlations RR and LL.
+inline void addTestPolarization (MeasurementSet& ms)
+{
+  MSColumns cols (ms);
+  uInt row = ms.polarization().nrow();
+  ms.polarization().addRow();
+  Vector<Int> corrType(2);
+  corrType[0] = Stokes::RR;
+  corrType[1] = Stokes::LL;
+  Matrix<Int> corrProduct(2, 2, 0);
+  corrProduct(1,1) = 1;
+  cols.polarization().numCorr().put (row, 2);
+  cols.polarization().corrType().put (row, corrType);
+  cols.polarization().corrProduct().put (row, corrProduct);
+}
+
+// Add a TOPO spectral window with the given channel frequencies and
+// widths, and a data description of it and polarization 0.
+// The data description id is returned.
+inline Int addTestSpw (MeasurementSet& ms, const Vector<Double>& freqs,
+                       Double chanWidth)
+{
+  MSColumns cols (ms);
+  uInt nChan = freqs.nelements();
+  uInt spw = ms.spectralWindow().nrow();
+  ms.spectralWindow().addRow();
+  cols.spectralWindow().numChan().put (spw, Int(nChan));
+  cols.spectralWindow().refFrequency().put (spw, freqs[0]);
+  cols.spectralWindow().chanFreq().put (spw, freqs);
+  Vector<Double> widths(nChan, chanWidth);
+  cols.spectralWindow().chanWidth().put (spw, widths);
+  cols.spectralWindow().effectiveBW().put (spw, widths);
+  cols.spectralWindow().resolution().put (spw, widths);
+  cols.spectralWindow().totalBandwidth().put (spw, nChan*chanWidth);
+  cols.spectralWindow().measFreqRef().put (spw, MFrequency::TOPO);
+  uInt ddId = ms.dataDescription().nrow();
+  ms.dataDescription().addRow();
+  cols.dataDescription().spectralWindowId().put (ddId, Int(spw));
+  cols.dataDescription().polarizationId().put (ddId, 0);
+  return ddId;
+}
+
+// </group>
+
+} //# NAMESPACE CASA - END
+
+#endif
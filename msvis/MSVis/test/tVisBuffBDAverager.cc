@@ -0,0 +1,154 @@
+//# tVisBuffBDAverager.cc: Test baseline-dependent averaging of a VisBuffer
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <casa/aips.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/iostream.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <msvis/MSVis/VisBuffBDAverager.h>
+#include <msvis/MSVis/VisibilityIterator.h>
+#include <msvis/MSVis/VisImagingWeight.h>
+#include <msvis/MSVis/VisBuffer.h>
+#include <msvis/MSVis/test/MSTestFixture.h>
+#include <casa/namespace.h>
+
+// The MS has 3 antennas, one channel and 2 correlations, observed in
+// 4 time slots. Baseline 0-1 hardly moves in the uv-plane, baseline 0-2
+// moves 500 m per time slot.
+const Int nTime = 4;
+const Double freq = 1.4e9;
+
+Double uCoord (Int ant2, Int t)
+{
+  return (ant2 == 1  ?  10 + 0.01*t : 1000 + 500*t);
+}
+
+MeasurementSet createMS (const String& name)
+{
+  MeasurementSet ms = newTestMS (name);
+  addTestAntennas (ms, 3);
+  addTestField (ms);
+  addTestPolarization (ms);
+  addTestSpw (ms, Vector<Double>(1, freq), 1e6);
+  ms.observation().addRow();
+
+  MSColumns cols (ms);
+
+  // Row t*2+b holds baseline 0-(b+1) of time slot t. The data value and
+  // the weight of a row are t+1.
+  Int row = 0;
+  for (Int t=0; t<nTime; ++t) {
+    for (Int ant2=1; ant2<=2; ++ant2) {
+      ms.addRow();
+      cols.time().put (row, 4.5e9 + 10*t);
+      cols.timeCentroid().put (row, 4.5e9 + 10*t);
+      cols.interval().put (row, 10.);
+      cols.exposure().put (row, 10.);
+      cols.antenna1().put (row, 0);
+      cols.antenna2().put (row, ant2);
+      Vector<Double> uvw(3, 0.);
+      uvw[0] = uCoord (ant2, t);
+      cols.uvw().put (row, uvw);
+      cols.data().put (row, Matrix<Complex>(2, 1, Complex(t+1, 0)));
+      cols.flag().put (row, Matrix<Bool>(2, 1, False));
+      cols.flagRow().put (row, False);
+      cols.weight().put (row, Vector<Float>(2, t+1));
+      cols.sigma().put (row, Vector<Float>(2, 1.));
+      ++row;
+    }
+  }
+  return ms;
+}
+
+int main()
+{
+  try {
+    MeasurementSet ms = createMS ("tVisBuffBDAverager_tmp.ms");
+    Block<Int> sort(0);
+    VisibilityIterator vi (ms, sort);
+    vi.setRowBlocking (1000);
+    vi.useImagingWeight (VisImagingWeight("natural"));
+    VisBuffer vb (vi);
+    vi.originChunks();
+    vi.origin();
+    AlwaysAssertExit (vb.nRow() == 2*nTime);
+    // Remember the original uvw per row.
+    Vector<RigidVector<Double,3> > uvwOrig (vb.uvw().copy());
+
+    // Allow a uv-shift of 1 wavelength (0.21 m), so only the 4 samples of
+    // baseline 0-1 are merged.
+    VisBuffBDAverager bda (1.0);
+    bda.average (vb, True, False, False);
+    AlwaysAssertExit (near (bda.nSamplesIn(), 8.));
+    AlwaysAssertExit (near (bda.nSamplesOut(), 5.));
+
+    const Matrix<Float>& imwgt = vb.imagingWeight();
+    const Matrix<Bool>& flag = vb.flag();
+    const Cube<Complex>& data = vb.visCube();
+    Int nMerged = 0;
+    for (Int row=0; row<vb.nRow(); ++row) {
+      // The uvw coordinates are never changed.
+      for (Int i=0; i<3; ++i) {
+        AlwaysAssertExit (vb.uvw()(row)(i) == uvwOrig(row)(i));
+      }
+      Int t = Int((vb.time()(row) - 4.5e9) / 10 + 0.5);
+      if (vb.antenna2()(row) == 2) {
+        // Long baseline untouched.
+        AlwaysAssertExit (!flag(0,row));
+        AlwaysAssertExit (near (imwgt(0,row), Float(t+1)));
+        AlwaysAssertExit (near (data(0,0,row), Complex(t+1, 0)));
+      } else if (!flag(0,row)) {
+        // The middle sample (time slot 2) gets the sum of the weights
+        // (1+2+3+4) and the weighted mean (1+4+9+16)/10 of the data.
+        ++nMerged;
+        AlwaysAssertExit (t == nTime/2);
+        AlwaysAssertExit (near (imwgt(0,row), 10.f));
+        AlwaysAssertExit (near (data(0,0,row), Complex(3, 0)));
+        AlwaysAssertExit (near (data(1,0,row), Complex(3, 0)));
+        AlwaysAssertExit (near (uvwOrig(row)(0), uCoord(1, nTime/2)));
+      } else {
+        AlwaysAssertExit (imwgt(0,row) == 0);
+        AlwaysAssertExit (vb.flagCube()(0,0,row)  &&  vb.flagCube()(1,0,row));
+      }
+    }
+    AlwaysAssertExit (nMerged == 1);
+
+    // A tolerance below the shortest step merges nothing.
+    vi.origin();
+    VisBuffBDAverager bda2 (0.01);
+    bda2.average (vb, True, False, False);
+    AlwaysAssertExit (near (bda2.nSamplesOut(), bda2.nSamplesIn()));
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
@@ -101,7 +101,7 @@ SDDataSampling::SDDataSampling(MeasurementSet& ms,
   MDirection worldPosMeas;
 
   // First try the POINTING sub-table
-  Int pointIndex=getIndex(mspc, vb.time()(0));
+  Int pointIndex=getIndex(mspc, vb.time()(0), vb.antenna1()(0));
   // If no valid POINTING entry, then use FIELD phase center
   ROMSColumns msc(ms);
   if(pointIndex >= 0 || pointIndex < static_cast<Int>(mspc.time().nrow()))
@@ -150,7 +150,7 @@ SDDataSampling::SDDataSampling(MeasurementSet& ms,
   for (vi.originChunks();vi.moreChunks();vi.nextChunk()) {
     for (vi.origin(); vi.more(); vi++) {
       for (Int row=0;row<vb.nRow();row++) {
-	Int pointIndex=getIndex(mspc, vb.time()(row));
+	Int pointIndex=getIndex(mspc, vb.time()(row), vb.antenna1()(row));
 	if(pointIndex >= 0 || pointIndex < static_cast<Int>(mspc.time().nrow())){
 	  imagePosMeas =
 	    pointingToImage(mspc.directionMeas(pointIndex));
@@ -220,25 +220,14 @@ SDDataSampling::~SDDataSampling() {
 void SDDataSampling::ok() {
 }
 
-Int SDDataSampling::getIndex(const ROMSPointingColumns& mspc, const Double& time) {
-  Int start=lastIndex_p;
-  // Search forwards
-  Int nrows=mspc.time().nrow();
-  for (Int i=start;i<nrows;i++) {
-    if(abs(mspc.time()(i)-time) < mspc.interval()(i)) {
-      lastIndex_p=i;
-      return i;
-    }
-  }
-  // Search backwards
-  for (Int i=start;i>=0;i--) {
-    if(abs(mspc.time()(i)-time) < mspc.interval()(i)) {
-      lastIndex_p=i;
-      return i;
-    }
+Int SDDataSampling::getIndex(const ROMSPointingColumns& mspc, const Double& time,
+			     Int antid) {
+  pointingIndex_p.attach(mspc);
+  Int index=pointingIndex_p.find(time, antid, 1.0, False);
+  if(index>=0) {
+    lastIndex_p=index;
   }
-  // No match!
-  return -1;
+  return index;
 }
 
 } //# NAMESPACE CASA - END
@@ -35,6 +35,7 @@
 #include <casa/Arrays/Vector.h>
 #include <casa/Arrays/Matrix.h>
 #include <coordinates/Coordinates/DirectionCoordinate.h>
+#include <synthesis/MeasurementComponents/PointingIndex.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -94,7 +95,11 @@ private:
 
   Int nRows_p;
 
-  Int getIndex(const ROMSPointingColumns& mspc, const Double& time);
+  // In-memory index of the POINTING table
+  PointingIndex pointingIndex_p;
+
+  Int getIndex(const ROMSPointingColumns& mspc, const Double& time,
+	       Int antid=-1);
 
   void ok();
 
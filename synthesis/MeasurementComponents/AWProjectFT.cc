@@ -929,6 +929,33 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 	  }
   }
   //
+  //---------------------------------------------------------------
+  //
+  // Sample the PA of the current field once a minute from now to the
+  // end of the observation, and let the CFCache read the conv. funcs.
+  // of the PA bins found along the way.  The CFCache stops reading
+  // before its memory limit would be exceeded.
+  //
+  void AWProjectFT::preloadConvFunctions(const VisBuffer& vb)
+  {
+    Double t0=getCurrentTimeStamp(vb), tEnd=t0;
+    const ROMSObservationColumns& obsCols=vb.msColumns().observation();
+    for(uInt i=0;i<obsCols.nrow();i++)
+      {
+	Vector<Double> timeRange=obsCols.timeRange()(i);
+	tEnd=max(tEnd,timeRange(1));
+      }
+    const Double tStep=60.0;
+    Int nPA=Int((tEnd-t0)/tStep);
+    if (nPA <= 0) return;
+    Vector<Float> paTrack(nPA);
+    for(Int i=0;i<nPA;i++)
+      paTrack(i)=getPA(vb, t0+(i+1)*tStep);
+    cfCache_p->preload(paTrack,
+		       paChangeDetector.getParAngleTolerance().getValue("rad"),
+		       wConvSize);
+  }
+  //
   // Locate a convlution function.  It will be either in the cache
   // (mem. or disk cache) or will be computed and cached for possible
   // later use.
@@ -973,6 +1000,13 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 	cfCache_p->flush(); // Write the aux info file to the disk
 			    // cache
       }
+    //
+    // A conv. func. had to be read from the disk.  Read the ones for
+    // the rest of the PA track now, so that gridding does not stall on
+    // the disk cache again at each PA bin.
+    //
+    else if (cfSource==CFDefs::DISKCACHE)
+      preloadConvFunctions(vb);
 
     // For now, functions for weight gridding is the same as the
     // function for visibility gridding.
@@ -357,6 +357,9 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     // Find the convolution function
     void findConvFunction(const ImageInterface<Complex>& image,
 			  const VisBuffer& vb);
+    // Read the cached convolution functions for the PA values still to
+    // come in the observation from the disk cache.
+    void preloadConvFunctions(const VisBuffer& vb);
     
     // Get the appropriate data pointer
     Array<Complex>* getDataPointer(const IPosition&, Bool);
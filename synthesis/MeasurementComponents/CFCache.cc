@@ -31,12 +31,20 @@
 #include <lattices/Lattices/LatticeExpr.h>
 #include <casa/Exceptions/Error.h>
 #include <casa/OS/Directory.h>
+#include <casa/OS/HostInfo.h>
 #include <fstream>
 
 namespace casa{
   CFCache::~CFCache()  {}
   //
   //-------------------------------------------------------------------------
+  //
+  Long CFCache::defaultMemCacheLimit()
+  {
+    return (HostInfo::memoryTotal(true)/8)*1024;
+  }
+  //
+  //-------------------------------------------------------------------------
   // Load just the axillary info. if found.  The convolution functions
   // are loaded on-demand.
   //
@@ -129,6 +137,10 @@ namespace casa{
     paCD_p = other.paCD_p;
     memCache_p = other.memCache_p;
     memCacheWt_p = other.memCacheWt_p;
+    memCacheLimit_p = other.memCacheLimit_p;
+    memCacheUse_p = other.memCacheUse_p;
+    memCacheWtUse_p = other.memCacheWtUse_p;
+    useCount_p = other.useCount_p;
     return *this;
   };
   //
@@ -138,15 +150,60 @@ namespace casa{
   {
     Long s=0;
     for(uInt i=0;i<memCache_p.nelements();i++)
-      s+=memCache_p[0].data->size();
+      if (!memCache_p[i].null()) s+=memCache_p[i].data->size();
     for(uInt i=0;i<memCacheWt_p.nelements();i++)
-      s+=memCacheWt_p[0].data->size();
+      if (!memCacheWt_p[i].null()) s+=memCacheWt_p[i].data->size();
 
     return s*sizeof(Complex);
   }
   //
   //-----------------------------------------------------------------------
   //
+  void CFCache::touch(CFStoreCacheType& cfCache, Int where)
+  {
+    Block<Int64>& use = (&cfCache == &memCacheWt_p) ? memCacheWtUse_p : memCacheUse_p;
+    uInt n=use.nelements();
+    if ((Int)n <= where)
+      {
+	use.resize(where+1, False, True);
+	for(uInt i=n;i<use.nelements();i++) use[i]=0;
+      }
+    use[where] = ++useCount_p;
+    evict();
+  }
+  //
+  //-----------------------------------------------------------------------
+  // Drop the data of the least recently used conv. funcs. until the
+  // memory cache fits.  The supports etc. are kept, so the aux. info. on
+  // the disk stays complete.  The conv. func. used last is never
+  // dropped.  Copies held by the FTMachines are not affected.
+  //
+  void CFCache::evict()
+  {
+    if (memCacheLimit_p <= 0) return;
+    Long s=size();
+    while (s > memCacheLimit_p)
+      {
+	CFStoreCacheType* cache=0;
+	Int which=-1;
+	Int64 oldest=useCount_p;
+	for(uInt i=0;i<memCache_p.nelements();i++)
+	  if (!memCache_p[i].null() && i<memCacheUse_p.nelements() &&
+	      memCacheUse_p[i] < oldest)
+	    {cache=&memCache_p; which=i; oldest=memCacheUse_p[i];}
+	for(uInt i=0;i<memCacheWt_p.nelements();i++)
+	  if (!memCacheWt_p[i].null() && i<memCacheWtUse_p.nelements() &&
+	      memCacheWtUse_p[i] < oldest)
+	    {cache=&memCacheWt_p; which=i; oldest=memCacheWtUse_p[i];}
+	if (which < 0) break;
+	s -= (*cache)[which].data->size()*sizeof(Complex);
+	(*cache)[which].data = static_cast<CFType*>(0);
+	(*cache)[which].rdata = static_cast<CFTypeReal*>(0);
+      }
+  }
+  //
+  //-----------------------------------------------------------------------
+  //
   void CFCache::makeFTCoordSys(const CoordinateSystem& coords,
 			       const Int& convSize,
 			       const Vector<Double>& ftRef,
@@ -245,6 +302,7 @@ namespace casa{
 				    maxXSup,maxYSup,Quantity(pa,"rad"),
 				    0);
       }
+    touch(memCache_l, where);
     
     return where;
   }
@@ -483,42 +541,91 @@ namespace casa{
   //
   // Return TRUE if loaded from disk and FLASE if found in the mem. cache.
   //
-  Int CFCache::loadFromDisk(Int where, Float pa, Float dPA,
+  Int CFCache::loadFromDisk(Int where, Float /*pa*/, Float /*dPA*/,
 			    Int Nw, CFStoreCacheType &convFuncCache,
 			    CFStore& cfs, String nameQualifier)
   {
     LogIO log_l(LogOrigin("CFCache", "loadFromDisk"));
 
-    Vector<Int> xconvSupport,yconvSupport;;
-    Vector<Float> convSampling;
-    Double cfRefFreq; CoordinateSystem coordSys;
-    Array<Complex> cfBuf;
-    Float samplingFromMisc, paFromMisc;
     if (Dir.length() == 0) 
       throw(SynthesisFTMachineError("Cache dir. name not set"));
       
     if (where < (Int)convFuncCache.nelements() && (!convFuncCache[where].data.null())) 
-      return MEMCACHE;
+      {
+	touch(convFuncCache, where);
+	return MEMCACHE;
+      }
 
-    Int wConvSize, polInUse=2;
     Int N=convFuncCache.nelements();
-
     //
     // Re-size the conv. func. memory cache if required, and set the
-    // new members of the resized cache to NULL.  This is used in the
-    // loop below to make a decision about allocating new memory or
-    // not.
+    // new members of the resized cache to NULL.
     //
     convFuncCache.resize(max(where+1,N), True);
-    //    for(Int i=N;i<=where;i++) convFuncCache[i].data=NULL;
-    //
-    // Each w-plan is in a separate disk file.  Each file contains all
-    // polarization planes. Memory cache holds all w-planes and
-    // poln-planes in a single complex array.  The loop below read
-    // each w-plane image from the disk, and fills in the 3D
-    // mem. cache for each computed PA.
-    //
-    wConvSize = Nw;
+    CFStore diskCFS;
+    readFromDisk(where, Nw, nameQualifier, diskCFS);
+
+    where=addToMemCache(convFuncCache, diskCFS.pa.getValue("rad"), &(*diskCFS.data),
+			diskCFS.coordSys, diskCFS.xSupport, diskCFS.ySupport,
+			diskCFS.sampling[0]);
+    cfs=convFuncCache[where];
+    //    convFuncCache[where].show("loadFromDisk: ");
+
+    return DISKCACHE;
+  };
+  //
+  //-----------------------------------------------------------------------
+  //
+  Int CFCache::preload(const Vector<Float>& pa, const Float dPA, const Int Nw)
+  {
+    LogIO log_l(LogOrigin("CFCache", "preload"));
+
+    if (Dir.length() == 0) return 0;
+
+    Vector<Bool> seen(paList.nelements(), False);
+    Long cfSize=0;
+    Int nRead=0;
+    for(uInt i=0;i<pa.nelements();i++)
+      {
+	Int where;
+	if ((!searchConvFunction(where, pa[i], dPA)) || seen[where]) continue;
+	seen[where]=True;
+	if (where < (Int)memCache_p.nelements() && !memCache_p[where].null() &&
+	    where < (Int)memCacheWt_p.nelements() && !memCacheWt_p[where].null())
+	  continue;
+	//
+	// The conv. funcs. of a track all have the same shape, so the
+	// last one read tells how much the next one will take.
+	//
+	if ((memCacheLimit_p > 0) && (size()+2*cfSize > memCacheLimit_p)) break;
+	CFStore cfs, cfwts;
+	loadFromDisk(where, pa[i], dPA, Nw, memCache_p, cfs, "");
+	loadFromDisk(where, pa[i], dPA, Nw, memCacheWt_p, cfwts, "WT");
+	cfSize=memCache_p[where].data->size()*sizeof(Complex);
+	nRead++;
+      }
+    if (nRead > 0)
+      log_l << "Preloaded " << nRead << " conv. funcs. from the disk cache"
+	    << LogIO::POST;
+    return nRead;
+  }
+  //
+  //-----------------------------------------------------------------------
+  // Read all w-planes of a conv. func. from the disk cache.  Each
+  // w-plane is in a separate disk file.  Each file contains all
+  // polarization planes. Memory cache holds all w-planes and
+  // poln-planes in a single complex array.
+  //
+  void CFCache::readFromDisk(Int where, Int Nw, const String& nameQualifier,
+			     CFStore& cfs) const
+  {
+    Vector<Int> xconvSupport,yconvSupport;;
+    Vector<Float> convSampling;
+    CoordinateSystem coordSys;
+    Array<Complex> cfBuf;
+    Float samplingFromMisc=0, paFromMisc=0;
+    Int wConvSize=Nw, polInUse=2;
+
     for(Int iw=0;iw<Nw;iw++)
       {
 	ostringstream name;
@@ -533,21 +640,16 @@ namespace casa{
 	    miscInfo.get("Ysupport", yconvSupport);
 	    miscInfo.get("sampling", samplingFromMisc);
 	    miscInfo.get("ParallacticAngle", paFromMisc);
+	    convSampling.resize(1);
 	    convSampling = samplingFromMisc;
 
-
-	    Int index= tmp.coordinates().findCoordinate(Coordinate::SPECTRAL);
 	    coordSys = tmp.coordinates();
-	    SpectralCoordinate spCS = coordSys.spectralCoordinate(index);
-
-	    cfRefFreq=spCS.referenceValue()(0);
 	
 	    polInUse = tmp.shape()(2);
 	    IPosition ts=tmp.shape(),ndx(4,0,0,0,0),ts2(4,0,0,0,0);
 	    Array<Complex> imBuf=tmp.get();
-	    if (convFuncCache[where].data.null())
+	    if (iw == 0)
 	      cfBuf.resize(IPosition(4,ts(0),ts(1), wConvSize,polInUse));
-	    //	      cfBuf = new CFType(IPosition(4,ts(0),ts(1), wConvSize,polInUse));
 	
 	    ndx(CFDefs::NWPOS)=iw;                  // The w-axis
 	    for(ndx(CFDefs::NPOLPOS)=0;ndx(CFDefs::NPOLPOS)<polInUse;ndx(CFDefs::NPOLPOS)++)  // The Poln. axis.
@@ -567,25 +669,10 @@ namespace casa{
 					  name + String("\": ") + x.getMesg()));
 	  }
       }
-    // xconvSupport.resize(wConvSize,True);
-    // yconvSupport.resize(wConvSize,True);
-    // for(Int i=0;i<wConvSize;i++)
-    //   {
-    // 	xconvSupport(i) = XSup(i,where);
-    // 	yconvSupport(i) = YSup(i,where);
-    //   }
-
-    // convSampling = Sampling[where];
-
-    // where=addToMemCache(convFuncCache, pa, &cfBuf, coordSys, 
-    // 			xconvSupport, yconvSupport, Sampling[where]);
-    where=addToMemCache(convFuncCache, paFromMisc, &cfBuf, coordSys, 
-			xconvSupport, yconvSupport, samplingFromMisc);
-    cfs=convFuncCache[where];
-    //    convFuncCache[where].show("loadFromDisk: ");
-
-    return DISKCACHE;
-  };
+    cfs = CFStore(&cfBuf, coordSys, convSampling, xconvSupport, yconvSupport,
+		  max(xconvSupport), max(yconvSupport),
+		  Quantity(paFromMisc,"rad"), 0);
+  }
   //
   //-----------------------------------------------------------------------
   //
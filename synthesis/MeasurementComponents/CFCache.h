@@ -35,6 +35,7 @@
 #include <images/Images/PagedImage.h>
 #include <casa/Arrays/Array.h>
 #include <casa/Arrays/Vector.h>
+#include <casa/Containers/Block.h>
 #include <casa/Logging/LogIO.h>
 #include <casa/Logging/LogSink.h>
 #include <casa/Logging/LogMessage.h>
@@ -88,6 +89,11 @@ namespace casa { //# NAMESPACE CASA - BEGIN
   // class=PBWProjectFT>PBWProjectFT</linkto>, the disk cache is
   // updated using the services of this class as well.
   //
+  // The memory cache is an LRU cache limited in size (by default to
+  // 1/8 of the memory).  A convolution function that is dropped from
+  // the memory cache is reloaded from the disk cache when needed
+  // again.
+  //
   // </synopsis> 
   //
   // <example>
@@ -117,7 +123,8 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     CFCache(const char *cfDir="CF"):
       memCache_p(), memCacheWt_p(), XSup(), YSup(), paList(), key2IndexMap(),
       cfPrefix(cfDir), aux("aux.dat"), paCD_p(), avgPBReady_p(False),
-      avgPBReadyQualifier_p("")
+      avgPBReadyQualifier_p(""), memCacheLimit_p(defaultMemCacheLimit()),
+      memCacheUse_p(), memCacheWtUse_p(), useCount_p(0)
     {};
     CFCache& operator=(const CFCache& other);
     ~CFCache();
@@ -134,6 +141,13 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     //
     Long size();
     //
+    // Set the maximum size (in bytes) of the memory cache.  The least
+    // recently used convolution functions are dropped from the memory
+    // cache if it gets larger.  0 means no limit.
+    //
+    void setMemCacheLimit(const Long limit) {memCacheLimit_p = limit; evict();};
+    Long getMemCacheLimit() const {return memCacheLimit_p;};
+    //
     // Method to set the class to caluclate the differential
     // Parallactic Angle.  The ParAngleChangeDetector also holds the
     // delta PA value (user defined).
@@ -180,6 +194,15 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 		     Int Nx, CFStoreCacheType & convFuncCache,
 		     CFStore& cfs, String nameQualifier="");
     //
+    // Read the convolution functions (and their weights) for the
+    // given PA values from the disk into the memory cache, in the
+    // order of the PA values.  Functions that are not in the disk
+    // cache are skipped.  Reading stops before the memory cache would
+    // exceed its limit, so none of them is dropped again.  Returns the
+    // number of functions read.
+    //
+    Int preload(const Vector<Float>& pa, const Float dPA, const Int Nw);
+    //
     // Method to locate a convolution function for the given w-term
     // index and PA value.  This is the top level function that must
     // be used by the clients.  This uses searchConvFunction() and
@@ -248,9 +271,25 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 		      Vector<Int>& yConvSupport,
 		      Float convSampling);
     CFStoreCacheType& getMEMCacheObj(const String& nameQualifier);
+    //
+    // Read a convolution function from the disk cache.  This does not
+    // change the state of this object.
+    //
+    void readFromDisk(Int where, Int Nw, const String& nameQualifier,
+		      CFStore& cfs) const;
+    //
+    // Mark the conv. func. as most recently used and drop the least
+    // recently used ones if the memory cache has become too large.
+    //
+    void touch(CFStoreCacheType& cfCache, Int where);
+    void evict();
+    static Long defaultMemCacheLimit();
 
     Bool avgPBReady_p;
     String avgPBReadyQualifier_p;
+    Long memCacheLimit_p;
+    Block<Int64> memCacheUse_p, memCacheWtUse_p;
+    Int64 useCount_p;
   };
 }
 
@@ -45,6 +45,7 @@
 #include <msvis/MSVis/StokesVector.h>
 #include <synthesis/MeasurementEquations/StokesImageUtil.h>
 #include <msvis/MSVis/VisBuffer.h>
+#include <msvis/MSVis/VisBufferAsync.h>
 #include <msvis/MSVis/VisSet.h>
 #include <images/Images/ImageInterface.h>
 #include <images/Images/PagedImage.h>
@@ -81,6 +82,7 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 			   useDoubleGrid_p(False), 
 			   freqFrameValid_p(False), 
 			   freqInterpMethod_p(InterpolateArray1D<Double,Complex>::nearestNeighbour), 
+			   freqConvInterval_p(60.0), chanMapAligned_p(),
 			   pointingDirCol_p("DIRECTION"),
 			   cfStokes_p(), cfCache_p(), cfs_p(), cfwts_p(), canComputeResiduals_p(False)
   {
@@ -97,6 +99,7 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     useDoubleGrid_p(False), 
     freqFrameValid_p(False), 
     freqInterpMethod_p(InterpolateArray1D<Double,Complex>::nearestNeighbour), 
+    freqConvInterval_p(60.0), chanMapAligned_p(),
     pointingDirCol_p("DIRECTION"),
     cfStokes_p(), cfCache_p(cfcache), cfs_p(), cfwts_p(),
     convFuncCtor_p(cf),canComputeResiduals_p(False)
@@ -139,8 +142,13 @@ namespace casa { //# NAMESPACE CASA - BEGIN
       else
 	uvwMachine_p=0;
       doUVWRotation_p=other.doUVWRotation_p;
+      uvwRotations_p=other.uvwRotations_p;
       //Spectral and pol stuff 
       freqInterpMethod_p=other.freqInterpMethod_p;
+      chanMatches_p=other.chanMatches_p;
+      freqConvInterval_p=other.freqConvInterval_p;
+      chanMapAligned_p.resize();
+      chanMapAligned_p=other.chanMapAligned_p;
       spwChanSelFlag_p.resize();
       spwChanSelFlag_p=other.spwChanSelFlag_p;
       freqFrameValid_p=other.freqFrameValid_p;
@@ -469,7 +477,7 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     else{
       throw(AipsError("Don't know which column is being regridded"));
     }
-    if((imageFreq_p.nelements()==1) || (freqInterpMethod_p== InterpolateArray1D<Double, Complex>::nearestNeighbour) || (vb.nChannel()==1)){
+    if((imageFreq_p.nelements()==1) || (freqInterpMethod_p== InterpolateArray1D<Double, Complex>::nearestNeighbour) || (vb.nChannel()==1) || chanMapAligned(vb.spectralWindow())){
       data.reference(origdata);
       // do something here for apply flag based on spw chan sels
       // e.g. 
@@ -712,7 +720,7 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     else{
       origdata=&(vb.visCube());
     }
-    if((imageFreq_p.nelements()==1) || (freqInterpMethod_p== InterpolateArray1D<Double, Complex>::nearestNeighbour)){
+    if((imageFreq_p.nelements()==1) || (freqInterpMethod_p== InterpolateArray1D<Double, Complex>::nearestNeighbour) || chanMapAligned(vb.spectralWindow())){
       origdata->reference(data);
       return False;
     }
@@ -784,19 +792,60 @@ namespace casa { //# NAMESPACE CASA - BEGIN
       
       AlwaysAssert(uvwMachine_p, AipsError);
       
-      // Always force a recalculation 
-      uvwMachine_p->reCalculate();
+      // The conversion is linear in uvw, so it is fully described by
+      // the conversions of the unit vectors. Find those in the cache or
+      // let the UVWMachine calculate them for this epoch.
+      std::vector<Double> key(8);
+      {
+	Vector<Double> phaseCenter=vb.phaseCenter().getAngle().getValue();
+	Vector<Double> imageCenter=mImage_p.getAngle().getValue();
+	key[0]=vb.msId();
+	key[1]=phaseCenter(0);
+	key[2]=phaseCenter(1);
+	key[3]=imageCenter(0);
+	key[4]=imageCenter(1);
+	key[5]=tangentSpecified_p;
+	key[6]=vb.fieldId();
+	key[7]=vb.time()(0);
+      }
+      std::map<std::vector<Double>, std::vector<Double> >::iterator
+	rot=uvwRotations_p.find(key);
+      if(rot==uvwRotations_p.end()) {
+	// Always force a recalculation 
+	uvwMachine_p->reCalculate();
+	std::vector<Double> conv(12);
+	Vector<Double> thisRow(3);
+	for (uInt j=0;j<3;j++) {
+	  thisRow=0.0;
+	  thisRow(j)=1.0;
+	  uvwMachine_p->convertUVW(conv[9+j], thisRow);
+	  for (uInt i=0;i<3;i++) conv[3*i+j]=thisRow(i);
+	}
+	// Keep the cache bounded; it only grows with the number of
+	// different times seen.
+	if(uvwRotations_p.size()>=100000) uvwRotations_p.clear();
+	rot=uvwRotations_p.insert(std::make_pair(key, conv)).first;
+      }
       
       // Now do the conversions
+      const std::vector<Double>& m=rot->second;
       uInt nrows=dphase.nelements();
-      Vector<Double> thisRow(3);
-      thisRow=0.0;
-      uInt i;
+      AlwaysAssert(uvw.nrow()==3 && uvw.ncolumn()>=nrows, AipsError);
+      Bool delUVW, delPhase;
+      Double* uvwData=uvw.getStorage(delUVW);
+      Double* phaseData=dphase.getStorage(delPhase);
       for (uInt row=0;row<nrows;row++) {
-	for (i=0;i<3;i++) thisRow(i)=uvw(i,row);
-	uvwMachine_p->convertUVW(dphase(row), thisRow);
-	for (i=0;i<3;i++) uvw(i,row)=thisRow(i);
+	Double* u=uvwData+3*row;
+	Double u0=u[0];
+	Double u1=u[1];
+	Double u2=u[2];
+	phaseData[row]=m[9]*u0+m[10]*u1+m[11]*u2;
+	u[0]=m[0]*u0+m[1]*u1+m[2]*u2;
+	u[1]=m[3]*u0+m[4]*u1+m[5]*u2;
+	u[2]=m[6]*u0+m[7]*u1+m[8]*u2;
       }
+      uvw.putStorage(uvwData, delUVW);
+      dphase.putStorage(phaseData, delPhase);
     }
     
   }
@@ -988,50 +1037,49 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     
     logIO() << LogOrigin("FTMachine", "makeImage0") << LogIO::NORMAL;
     
-    // Loop over all visibilities and pixels
-    VisBuffer vb(vi);
+    // Loop over all visibilities and pixels.  The iterator may be an
+    // asynchronous one, so the VisBuffer has to come from VisBufferAutoPtr.
+    VisBufferAutoPtr vb(vi);
     
     // Initialize put (i.e. transform to Sky) for this model
+    vi.originChunks();
     vi.origin();
     
-    if(vb.polFrame()==MSIter::Linear) {
+    if(vb->polFrame()==MSIter::Linear) {
       StokesImageUtil::changeCStokesRep(theImage, SkyModel::LINEAR);
     }
     else {
       StokesImageUtil::changeCStokesRep(theImage, SkyModel::CIRCULAR);
     }
     
-    initializeToSky(theImage,weight,vb);
-    Bool useCorrected= !(vi.msColumns().correctedData().isNull());
-    if((type==FTMachine::CORRECTED) && (!useCorrected))
-      type=FTMachine::OBSERVED;
+    initializeToSky(theImage,weight,*vb);
     // Loop over the visibilities, putting VisBuffers
     for (vi.originChunks();vi.moreChunks();vi.nextChunk()) {
       for (vi.origin(); vi.more(); vi++) {
 	
 	switch(type) {
 	case FTMachine::RESIDUAL:
-	  vb.visCube()=vb.correctedVisCube();
-	  vb.visCube()-=vb.modelVisCube();
-	  put(vb, -1, False);
+	  vb->visCube()=vb->correctedVisCube();
+	  vb->visCube()-=vb->modelVisCube();
+	  put(*vb, -1, False);
 	  break;
 	case FTMachine::MODEL:
-	  put(vb, -1, False, FTMachine::MODEL);
+	  put(*vb, -1, False, FTMachine::MODEL);
 	  break;
 	case FTMachine::CORRECTED:
-	  put(vb, -1, False, FTMachine::CORRECTED);
+	  put(*vb, -1, False, FTMachine::CORRECTED);
 	  break;
 	case FTMachine::PSF:
-	  vb.visCube()=Complex(1.0,0.0);
-	  put(vb, -1, True);
+	  vb->visCube()=Complex(1.0,0.0);
+	  put(*vb, -1, True);
 	  break;
 	case FTMachine::COVERAGE:
-	  vb.visCube()=Complex(1.0);
-	  put(vb, -1, True);
+	  vb->visCube()=Complex(1.0);
+	  put(*vb, -1, True);
 	  break;
 	case FTMachine::OBSERVED:
 	default:
-	  put(vb, -1, False);
+	  put(*vb, -1, False);
 	  break;
 	}
       }
@@ -1161,6 +1209,8 @@ namespace casa { //# NAMESPACE CASA - BEGIN
       selectedSpw_p.resize();
       selectedSpw_p=spws;
       multiChanMap_p.resize(max(spws)+1);
+      chanMapAligned_p.resize(max(spws)+1);
+      chanMapAligned_p.set(False);
       return True;
     }
     
@@ -1175,6 +1225,8 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     doConversion_p.set(False);
     
     multiChanMap_p.resize(max(selectedSpw_p)+1, True);
+    chanMapAligned_p.resize(max(selectedSpw_p)+1);
+    chanMapAligned_p.set(False);
     
     Bool anymatchChan=False;
     Bool anyTopo=False;
@@ -1208,6 +1260,41 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     nvischan  = nVisChan_p[spw];
     chanMap.resize(nvischan);
     chanMap.set(-1);
+    for (Int i=chanMapAligned_p.nelements(); i<=spw; i++) {
+      chanMapAligned_p.resize(i+1, True);
+      chanMapAligned_p[i]=False;
+    }
+    chanMapAligned_p[spw]=False;
+
+    // The frame conversion changes slowly, so the result is reused for
+    // VisBuffers of the same field in the same time interval.
+    std::vector<Double> key;
+    if(freqConvInterval_p > 0) {
+      key.push_back(vb.msId());
+      key.push_back(spw);
+      key.push_back(vb.fieldId());
+      key.push_back(nvischan);
+      key.push_back(freqFrameValid_p);
+      key.push_back(freqFrameValid_p ?
+		    floor(vb.time()(0)/freqConvInterval_p) : 0);
+      key.push_back(nchan);
+      key.push_back(spectralCoord_p.referenceValue()(0));
+      key.push_back(spectralCoord_p.referencePixel()(0));
+      key.push_back(spectralCoord_p.increment()(0));
+      std::map<std::vector<Double>, ChanMatch>::const_iterator
+	match=chanMatches_p.find(key);
+      if(match!=chanMatches_p.end()) {
+	doConversion_p[spw]=match->second.convert;
+	lsrFreq_p.resize(match->second.lsrFreq.nelements());
+	lsrFreq_p=match->second.lsrFreq;
+	chanMap=match->second.chanMap;
+	chanMapAligned_p[spw]=match->second.aligned;
+	multiChanMap_p[spw].resize();
+	multiChanMap_p[spw]=chanMap;
+	return match->second.nFound>0;
+      }
+    }
+
     Vector<Double> lsrFreq(0);
     Bool condoo=False;
     
@@ -1259,7 +1346,31 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     
     multiChanMap_p[spw].resize();
     multiChanMap_p[spw]=chanMap;
-    
+
+    // Check if the channels map one to one onto image channels with the
+    // same frequencies (to 0.1% of a channel).
+    if(nFound==nvischan && nvischan>1 && imageFreq_p.nelements()>1) {
+      Double tol=1.0e-3*fabs(imageFreq_p[1]-imageFreq_p[0]);
+      Bool aligned=True;
+      for (Int chan=0;chan<nvischan && aligned;chan++) {
+	aligned = (chanMap(chan)==chanMap(0)+chan) &&
+	  (chanMap(chan)<Int(imageFreq_p.nelements())) &&
+	  (fabs(lsrFreq[chan]-imageFreq_p[chanMap(chan)]) <= tol);
+      }
+      chanMapAligned_p[spw]=aligned;
+    }
+
+    if(key.size()>0) {
+      if(chanMatches_p.size()>=10000) chanMatches_p.clear();
+      ChanMatch& match=chanMatches_p[key];
+      match.lsrFreq.resize(lsrFreq.nelements());
+      match.lsrFreq=lsrFreq;
+      match.convert=doConversion_p[spw];
+      match.chanMap.resize(nvischan);
+      match.chanMap=chanMap;
+      match.nFound=nFound;
+      match.aligned=chanMapAligned_p[spw];
+    }
     
     if(nFound==0) {
       /*
@@ -1324,6 +1435,11 @@ namespace casa { //# NAMESPACE CASA - BEGIN
     
   }
   
+  void FTMachine::setFreqConversionInterval(Double interval){
+    freqConvInterval_p=interval;
+    chanMatches_p.clear();
+  }
+  
   void FTMachine::setFreqInterpolation(const String& method){
     
     String meth=method;
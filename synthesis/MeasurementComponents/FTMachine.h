@@ -44,6 +44,8 @@
 #include <scimath/Mathematics/InterpolateArray1D.h>
 #include <synthesis/MeasurementComponents/CFCache.h>
 #include <synthesis/MeasurementComponents/ConvolutionFunction.h>
+#include <map>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -181,7 +183,9 @@ public:
 			 VisSet& vs,
 			 ImageInterface<Complex>& image,
 			 Matrix<Float>& weight);
-  // Make the entire image using a ROVisIter
+  // Make the entire image using a ROVisIter. The iterator can be an
+  // asynchronous one, so no table is accessed here; the caller has to ask
+  // for OBSERVED instead of CORRECTED if there is no CORRECTED_DATA column.
   virtual void makeImage(FTMachine::Type type,
 			 ROVisibilityIterator& vi,
 			 ImageInterface<Complex>& image,
@@ -235,6 +239,12 @@ public:
   //set frequency interpolation type
   virtual void setFreqInterpolation(const String& method);
 
+  // Set the time interval (in seconds) within which the conversion of the
+  // visibility frequencies to the image frame and the resulting channel
+  // map are reused (default 60). A value <= 0 recomputes them for every
+  // VisBuffer.
+  void setFreqConversionInterval(Double interval);
+
   //tell ftmachine which Pointing table column to use for Direction
   //Mosaic or Single dish ft use this for example
   virtual void setPointingDirColumn(const String& column="DIRECTION");
@@ -310,6 +320,13 @@ protected:
   // Set if uvwrotation is necessary
 
   Bool doUVWRotation_p;
+
+  // The uvw rotation matrix and phase gradient (9+3 values) calculated
+  // by the UVWMachine, per MS, phase center, image center, tangent and
+  // time. They are kept over major cycles and applied to all rows of a
+  // VisBuffer at once.
+  std::map<std::vector<Double>, std::vector<Double> > uvwRotations_p;
+
   virtual void ok();
 
   // check if image is big enough for gridding
@@ -357,6 +374,23 @@ protected:
   Vector<Double> lsrFreq_p;
   Vector<Double> interpVisFreq_p;
   InterpolateArray1D<Double,Complex>::InterpolationMethod freqInterpMethod_p;
+  // The results of matchChannel per MS, spectral window, field, image
+  // spectral axis and time interval.
+  struct ChanMatch {
+    Vector<Double> lsrFreq;
+    Bool convert;
+    Vector<Int> chanMap;
+    Int nFound;
+    Bool aligned;
+  };
+  std::map<std::vector<Double>, ChanMatch> chanMatches_p;
+  Double freqConvInterval_p;
+  // Per spectral window (like multiChanMap_p), set if its channel map
+  // maps the visibility channels one to one onto image channels with the
+  // same frequencies, so no interpolation is needed.
+  Vector<Bool> chanMapAligned_p;
+  Bool chanMapAligned(Int spw) const
+    {return spw>=0 && spw<Int(chanMapAligned_p.nelements()) && chanMapAligned_p[spw];}
   String pointingDirCol_p;
   Cube<Int> spwChanSelFlag_p;
   Vector<Int> cfStokes_p;
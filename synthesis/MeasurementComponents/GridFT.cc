@@ -65,12 +65,14 @@
 #include <lattices/Lattices/LCBox.h>
 #include <lattices/Lattices/LatticeCache.h>
 #include <lattices/Lattices/LatticeFFT.h>
+#include <synthesis/MeasurementComponents/MappedGrid.h>
 #include <lattices/Lattices/LatticeIterator.h>
 #include <lattices/Lattices/LatticeStepper.h>
 #include <scimath/Mathematics/ConvolveGridder.h>
 #include <casa/Utilities/CompositeNumber.h>
 #include <casa/OS/Timer.h>
 #include <casa/sstream.h>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
   //  using namespace casa::async;
@@ -265,6 +267,50 @@ void GridFT::init() {
   }
 }
 
+void GridFT::resizeGrids(const IPosition& gridShape, Bool doDouble)
+{
+  Double gridBytes = Double(gridShape.product()) *
+    (sizeof(Complex) + (doDouble ? sizeof(DComplex) : 0));
+  Bool doMap = MappedGrid::useMapping(gridBytes,
+				      Double(cachesize)*sizeof(Complex));
+  // The lattices refer to griddedData, so they have to go before the
+  // mapping is changed.
+  if((doMap || !mappedGrid_p.null()) && !griddedData.shape().isEqual(gridShape)) {
+    arrayLattice=0;
+    lattice=0;
+    griddedData.resize();
+    griddedData2.resize();
+    mappedGrid_p=0;
+    mappedGrid2_p=0;
+  }
+  if(doMap) {
+    if(mappedGrid_p.null()) {
+      logIO() << LogOrigin("GridFT", "resizeGrids") << LogIO::NORMAL
+	      << "Grid of " << Int(gridBytes/(1024*1024))
+	      << " MB does not fit in memory; mapping it to disk"
+	      << LogIO::POST;
+      mappedGrid_p = new MappedGrid();
+      mappedGrid_p->map(griddedData, gridShape);
+    }
+    if(doDouble && mappedGrid2_p.null()) {
+      griddedData2.resize();
+      mappedGrid2_p = new MappedGrid();
+      mappedGrid2_p->map(griddedData2, gridShape);
+    }
+  }
+  else {
+    griddedData.resize(gridShape);
+    if(doDouble) {
+      griddedData2.resize(gridShape);
+    }
+  }
+}
+
+Double GridFT::fftBufferSize() const
+{
+  return max(Double(cachesize)*sizeof(Complex), 64.*1024.*1024.);
+}
+
 // This is nasty, we should use CountedPointers here.
 GridFT::~GridFT() {
   if(imageCache) delete imageCache; imageCache=0;
@@ -301,7 +347,7 @@ void GridFT::initializeToVis(ImageInterface<Complex>& iimage,
   }
   else {
      IPosition gridShape(4, nx, ny, npol, nchan);
-     griddedData.resize(gridShape);
+     resizeGrids(gridShape, False);
      //griddedData can be a reference of image data...if not using model col
      //hence using an undocumented feature of resize that if 
      //the size is the same as old data it is not changed.
@@ -341,7 +387,10 @@ void GridFT::initializeToVis(ImageInterface<Complex>& iimage,
     }
   
     // Now do the FFT2D in place
-    LatticeFFT::cfft2d(*lattice);
+    if(!mappedGrid_p.null())
+      MappedGrid::fft2d(griddedData, True, fftBufferSize());
+    else
+      LatticeFFT::cfft2d(*lattice);
     
     logIO() << LogIO::DEBUGGING
 	    << "Finished grid correction and FFT of image" << LogIO::POST;
@@ -397,10 +446,9 @@ void GridFT::initializeToSky(ImageInterface<Complex>& iimage,
   }
   else {
     IPosition gridShape(4, nx, ny, npol, nchan);
-    griddedData.resize(gridShape);
+    resizeGrids(gridShape, useDoubleGrid_p);
     griddedData=Complex(0.0);
     if(useDoubleGrid_p){
-      griddedData2.resize(gridShape);
       griddedData2=DComplex(0.0);
     }
     //iimage.get(griddedData, False);
@@ -705,6 +753,242 @@ void GridFT::put(const VisBuffer& vb, Int row, Bool dopsf,
 }
 
 
+namespace {
+
+  // Fortran-style nearest integer (halves are rounded away from zero).
+  inline Int nearestInt (Double x)
+  {
+    return (x < 0  ?  Int(x - 0.5) : Int(x + 0.5));
+  }
+
+  // Grid the visibilities into the grids of all terms. It does the same as
+  // the Fortran routines ggrids/ggrid, but the convolution weights and the
+  // phasor of a sample are computed once and then used for all terms.
+  // The grids and sums of weights are indexed as in Fortran, but 0-based.
+  template<class T>
+  void gridMultiTerm (const Double* uvw, const Double* dphase,
+		      const Complex* values, Int nvispol, Int nvischan,
+		      Bool dopsf, const Int* flag, const Int* rflag,
+		      const Float* weight, Int nrow, Int rownum,
+		      const Double* scale, const Double* offset,
+		      const Block<T*>& grids, const Block<Double*>& sumwt,
+		      const Float* termWeight, Int nx, Int ny, Int npol,
+		      Int nchan, const Double* freq, Double c, Int support,
+		      Int sampling, const Double* convFunc,
+		      const Int* chanmap, const Int* polmap)
+  {
+    Int nterm=grids.nelements();
+    Int nsupp=2*support+1;
+    std::vector<Double> wtx(nsupp), wty(nsupp);
+    std::vector<Float> wterm(nterm);
+    std::vector<DComplex> nvalue(nterm);
+    Int rbeg=0, rend=nrow-1;
+    if (rownum >= 0) {
+      rbeg=rownum;
+      rend=rownum;
+    }
+    for (Int irow=rbeg; irow<=rend; ++irow) {
+      if (rflag[irow] != 0) continue;
+      const Double* rowuvw=uvw + 3*irow;
+      for (Int ichan=0; ichan<nvischan; ++ichan) {
+	Int achan=chanmap[ichan];
+	Float wgt=weight[ichan + irow*nvischan];
+	if (achan < 0  ||  achan >= nchan  ||  wgt == 0.0) continue;
+	// Position on the grid (as in sgrid) and check if it is on the grid.
+	// Like sgrid and ogrid the 1-based location is used here.
+	Int loc[2], off[2];
+	for (Int idim=0; idim<2; ++idim) {
+	  Double pos=scale[idim]*rowuvw[idim]*freq[ichan]/c +
+	    (offset[idim]+1.0);
+	  loc[idim]=nearestInt(pos);
+	  off[idim]=nearestInt((loc[idim]-pos)*sampling);
+	}
+	if (loc[0]-support < 1  ||  loc[0]+support > nx  ||
+	    loc[1]-support < 1  ||  loc[1]+support > ny) continue;
+	// sgrid uses a single precision value of pi.
+	Double phase=-2.0*Double(Float(C::pi))*dphase[irow]*freq[ichan]/c;
+	Complex phasor(cos(phase), sin(phase));
+	// Convolution weights are the same for all terms and polarizations.
+	Double norm=0.0;
+	for (Int i=0; i<nsupp; ++i) {
+	  wtx[i]=convFunc[abs(sampling*(i-support)+off[0])];
+	  wty[i]=convFunc[abs(sampling*(i-support)+off[1])];
+	}
+	for (Int iy=0; iy<nsupp; ++iy) {
+	  for (Int ix=0; ix<nsupp; ++ix) {
+	    norm+=wtx[ix]*wty[iy];
+	  }
+	}
+	for (Int t=0; t<nterm; ++t) {
+	  wterm[t]=wgt * termWeight[ichan + t*nvischan];
+	}
+	for (Int ipol=0; ipol<nvispol; ++ipol) {
+	  Int apol=polmap[ipol];
+	  Int iflag=ipol + (ichan + irow*nvischan)*nvispol;
+	  if (flag[iflag] == 1  ||  apol < 0  ||  apol >= npol) continue;
+	  for (Int t=0; t<nterm; ++t) {
+	    if (dopsf) {
+	      nvalue[t]=DComplex(wterm[t]);
+	    } else {
+	      Complex v=values[iflag]*phasor;
+	      nvalue[t]=DComplex(wterm[t]*v.real(), wterm[t]*v.imag());
+	    }
+	  }
+	  size_t plane=size_t(apol + achan*npol) * nx * ny;
+	  for (Int iy=0; iy<nsupp; ++iy) {
+	    size_t start=plane + size_t(loc[1]-1-support+iy)*nx +
+	      (loc[0]-1-support);
+	    for (Int t=0; t<nterm; ++t) {
+	      T* gridrow=grids[t] + start;
+	      DComplex nv=nvalue[t]*wty[iy];
+	      for (Int ix=0; ix<nsupp; ++ix) {
+		gridrow[ix]=T(DComplex(gridrow[ix]) + nv*wtx[ix]);
+	      }
+	    }
+	  }
+	  for (Int t=0; t<nterm; ++t) {
+	    sumwt[t][apol + achan*npol]+=wterm[t]*norm;
+	  }
+	}
+      }
+    }
+  }
+
+} // end anonymous namespace
+
+Bool GridFT::putMultiTerm(const Block<GridFT*>& terms, const VisBuffer& vb,
+			  const Matrix<Float>& termWeight, Int row,
+			  Bool dopsf, FTMachine::Type type)
+{
+  uInt nterm=terms.nelements();
+  if (nterm == 0) {
+    return False;
+  }
+  GridFT& ft0=*terms[0];
+  // All grids must be in memory and have the same shape and precision.
+  for (uInt t=0; t<nterm; ++t) {
+    const GridFT& ft=*terms[t];
+    if (ft.isTiled  ||  ft.useDoubleGrid_p != ft0.useDoubleGrid_p  ||
+	!ft.griddedData.shape().isEqual(ft0.griddedData.shape())) {
+      return False;
+    }
+  }
+  if (termWeight.nrow() != uInt(vb.nChannel())  ||
+      termWeight.ncolumn() != nterm) {
+    throw(AipsError("GridFT::putMultiTerm: termWeight has wrong shape"));
+  }
+  ft0.gridOk(ft0.gridder->cSupport()(0));
+
+  // Do the channel matching for all machines, so their state is the
+  // same as after a normal put.
+  for (uInt t=0; t<nterm; ++t) {
+    GridFT& ft=*terms[t];
+    if(vb.newMS())
+      ft.matchAllSpwChans(vb);
+    if(ft.doConversion_p[vb.spectralWindow()]){
+      ft.matchChannel(vb.spectralWindow(), vb);
+    }
+    else{
+      ft.chanMap.resize();
+      ft.chanMap=ft.multiChanMap_p[vb.spectralWindow()];
+    }
+  }
+  if(max(ft0.chanMap)==-1)
+    return True;
+
+  // The term weights are given per data channel, so the data must not
+  // need interpolation onto the image channels (see
+  // FTMachine::interpolateFrequencyTogrid).
+  if(!((ft0.imageFreq_p.nelements()==1) ||
+       (ft0.freqInterpMethod_p==InterpolateArray1D<Double, Complex>::nearestNeighbour) ||
+       (vb.nChannel()==1) || ft0.chanMapAligned(vb.spectralWindow()))) {
+    return False;
+  }
+
+  if(dopsf) {type=FTMachine::PSF;}
+  Cube<Complex> data;
+  Cube<Int> flags;
+  Matrix<Float> elWeight;
+  ft0.interpolateFrequencyTogrid(vb, vb.imagingWeight(), data, flags,
+				 elWeight, type);
+
+  Int startRow, endRow;
+  if (row==-1) {
+    startRow=0;
+    endRow=vb.nRow()-1;
+  } else {
+    startRow=row;
+    endRow=row;
+  }
+  Matrix<Double> uvw(3, vb.uvw().nelements());
+  uvw=0.0;
+  Vector<Double> dphase(vb.uvw().nelements());
+  dphase=0.0;
+  //NEGATING to correct for an image inversion problem
+  for (Int i=startRow;i<=endRow;i++) {
+    for (Int idim=0;idim<2;idim++) uvw(idim,i)=-vb.uvw()(i)(idim);
+    uvw(2,i)=vb.uvw()(i)(2);
+  }
+  ft0.rotateUVW(uvw, dphase, vb);
+  ft0.refocus(uvw, vb.antenna1(), vb.antenna2(), dphase, vb);
+
+  Vector<Int> rowFlags(vb.nRow());
+  rowFlags=0;
+  rowFlags(vb.flagRow())=True;
+  if(!ft0.usezero_p) {
+    for (Int rownr=startRow; rownr<=endRow; rownr++) {
+      if(vb.antenna1()(rownr)==vb.antenna2()(rownr)) rowFlags(rownr)=1;
+    }
+  }
+
+  // The grids and weight sums are contiguous (see resizeGrids).
+  Bool del;
+  Bool isCopy;
+  const Complex *datStorage=0;
+  if(!dopsf)
+    datStorage=data.getStorage(isCopy);
+  Bool iswgtCopy;
+  const Float *wgtStorage=elWeight.getStorage(iswgtCopy);
+  Block<Double*> sumwt(nterm);
+  for (uInt t=0; t<nterm; ++t) {
+    sumwt[t]=terms[t]->sumWeight.data();
+  }
+  const IPosition& fs=flags.shape();
+  if(ft0.useDoubleGrid_p){
+    Block<DComplex*> grids(nterm);
+    for (uInt t=0; t<nterm; ++t) {
+      grids[t]=terms[t]->griddedData2.data();
+    }
+    gridMultiTerm(uvw.data(), dphase.data(), datStorage, fs(0), fs(1),
+		  dopsf, flags.getStorage(del), rowFlags.data(), wgtStorage,
+		  fs(2), row, ft0.uvScale.data(), ft0.uvOffset.data(),
+		  grids, sumwt, termWeight.data(), ft0.nx, ft0.ny,
+		  ft0.npol, ft0.nchan, ft0.interpVisFreq_p.data(), C::c,
+		  ft0.gridder->cSupport()(0), ft0.gridder->cSampling(),
+		  ft0.gridder->cFunction().data(), ft0.chanMap.data(),
+		  ft0.polMap.data());
+  }
+  else{
+    Block<Complex*> grids(nterm);
+    for (uInt t=0; t<nterm; ++t) {
+      grids[t]=terms[t]->griddedData.data();
+    }
+    gridMultiTerm(uvw.data(), dphase.data(), datStorage, fs(0), fs(1),
+		  dopsf, flags.getStorage(del), rowFlags.data(), wgtStorage,
+		  fs(2), row, ft0.uvScale.data(), ft0.uvOffset.data(),
+		  grids, sumwt, termWeight.data(), ft0.nx, ft0.ny,
+		  ft0.npol, ft0.nchan, ft0.interpVisFreq_p.data(), C::c,
+		  ft0.gridder->cSupport()(0), ft0.gridder->cSampling(),
+		  ft0.gridder->cFunction().data(), ft0.chanMap.data(),
+		  ft0.polMap.data());
+  }
+
+  if(!dopsf)
+    data.freeStorage(datStorage, isCopy);
+  elWeight.freeStorage(wgtStorage, iswgtCopy);
+  return True;
+}
+
 void GridFT::get(VisBuffer& vb, Int row)
 {
 
@@ -918,12 +1202,19 @@ ImageInterface<Complex>& GridFT::getImage(Matrix<Float>& weights, Bool normalize
     //
     if(useDoubleGrid_p)
       {
-	ArrayLattice<DComplex> darrayLattice(griddedData2);
-	LatticeFFT::cfft2d(darrayLattice,False);
+	if(!mappedGrid2_p.null())
+	  MappedGrid::fft2d(griddedData2, False, fftBufferSize());
+	else {
+	  ArrayLattice<DComplex> darrayLattice(griddedData2);
+	  LatticeFFT::cfft2d(darrayLattice,False);
+	}
 	convertArray(griddedData, griddedData2);
 	//Don't need the double-prec grid anymore...
 	griddedData2.resize();
+	mappedGrid2_p=0;
       }
+    else if(!mappedGrid_p.null())
+      MappedGrid::fft2d(griddedData, False, fftBufferSize());
     else
       LatticeFFT::cfft2d(*lattice,False);
 
@@ -1104,7 +1395,7 @@ Bool GridFT::fromRecord(String& error, const RecordInterface& inRec)
       // Make the grid the correct shape and turn it into an array lattice
       // Check the section from the image BEFORE converting to a lattice 
       IPosition gridShape(4, nx, ny, npol, nchan);
-      griddedData.resize(gridShape);
+      resizeGrids(gridShape, False);
       griddedData=Complex(0.0);
       IPosition blc(4, (nx-image->shape()(0)+(nx%2==0))/2, (ny-image->shape()(1)+(ny%2==0))/2, 0, 0);
       IPosition start(4, 0);
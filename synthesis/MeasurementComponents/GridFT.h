@@ -42,6 +42,7 @@
 #include <scimath/Mathematics/ConvolveGridder.h>
 #include <lattices/Lattices/LatticeCache.h>
 #include <lattices/Lattices/ArrayLattice.h>
+#include <synthesis/MeasurementComponents/MappedGrid.h>
 //#include <synthesis/MeasurementComponents/SynthesisPeek.h>
 
 
@@ -184,7 +185,20 @@ public:
   // Put coherence to grid by gridding.
   void put(const VisBuffer& vb, Int row=-1, Bool dopsf=False,
 	   FTMachine::Type type=FTMachine::OBSERVED);
-  
+
+  // Put coherence to the grids of several machines in a single pass, as
+  // needed for multi-term (Taylor) imaging. For machine <src>i</src> the
+  // imaging weights are multiplied by <src>termWeight(chan,i)</src>. The
+  // convolution footprint and phasor of a sample are computed only once.
+  // All machines must have been initialized on images of the same shape.
+  // False is returned (and nothing is gridded) if the machines cannot be
+  // gridded together, e.g. if frequency interpolation is needed; the
+  // caller should then put the data to each machine separately.
+  static Bool putMultiTerm(const Block<GridFT*>& terms, const VisBuffer& vb,
+			   const Matrix<Float>& termWeight, Int row=-1,
+			   Bool dopsf=False,
+			   FTMachine::Type type=FTMachine::OBSERVED);
+
   // Make the entire image
   void makeImage(FTMachine::Type type,
 		 VisSet& vs,
@@ -230,6 +244,13 @@ protected:
 
   void init();
 
+  // Resize the grid (and the double precision grid if needed) to the
+  // given shape. A grid too large for memory is mapped onto a scratch file.
+  void resizeGrids(const IPosition& gridShape, Bool doDouble);
+
+  // Size (in bytes) of the buffer used by the out-of-core FFT.
+  Double fftBufferSize() const;
+
   // Is this record on Grid? check both ends. This assumes that the
   // ends bracket the middle
   Bool recordOnGrid(const VisBuffer& vb, Int rownr) const;
@@ -247,6 +268,10 @@ protected:
   // Is this tiled?
   Bool isTiled;
 
+  // Mapped storage of griddedData and griddedData2 (if too large for
+  // memory). Declared before the arrays, so it is removed after them.
+  CountedPtr<MappedGrid> mappedGrid_p, mappedGrid2_p;
+
   // Array lattice
   CountedPtr<Lattice<Complex> > arrayLattice;
 
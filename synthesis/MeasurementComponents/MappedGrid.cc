@@ -0,0 +1,202 @@
+//# MappedGrid.cc: Implementation of MappedGrid
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+
+#include <synthesis/MeasurementComponents/MappedGrid.h>
+#include <scimath/Mathematics/FFTServer.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Containers/Block.h>
+#include <casa/Utilities/CountedPtr.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/OS/HostInfo.h>
+#include <vector>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+MappedGrid::MappedGrid()
+  : data_p   (0),
+    nbytes_p (0)
+{}
+
+MappedGrid::~MappedGrid()
+{
+  unmap();
+}
+
+void MappedGrid::unmap()
+{
+  if (data_p != 0) {
+    munmap (data_p, nbytes_p);
+    data_p   = 0;
+    nbytes_p = 0;
+  }
+}
+
+void* MappedGrid::mapFile (uInt64 nbytes, const String& directory)
+{
+  String templ = directory + "/MappedGrid_XXXXXX";
+  std::vector<char> name(templ.chars(), templ.chars() + templ.size() + 1);
+  int fd = mkstemp (&name[0]);
+  if (fd < 0) {
+    throw AipsError ("MappedGrid: cannot create grid file in " + directory +
+		     ": " + strerror(errno));
+  }
+  // The file is not needed anymore once it is mapped.
+  unlink (&name[0]);
+  // Reserve the disk space, otherwise a full disk gives a SIGBUS.
+  int sts = posix_fallocate (fd, 0, nbytes);
+  if (sts != 0) {
+    close (fd);
+    throw AipsError ("MappedGrid: cannot allocate " +
+		     String::toString(nbytes/(1024*1024)) + " MB in " +
+		     directory + ": " + strerror(sts));
+  }
+  void* ptr = mmap (0, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close (fd);
+  if (ptr == MAP_FAILED) {
+    throw AipsError ("MappedGrid: cannot map grid file: " +
+		     String(strerror(errno)));
+  }
+  return ptr;
+}
+
+void MappedGrid::map (Array<Complex>& grid, const IPosition& shape,
+		      const String& directory)
+{
+  unmap();
+  nbytes_p = shape.product() * sizeof(Complex);
+  data_p   = mapFile (nbytes_p, directory);
+  grid.takeStorage (shape, static_cast<Complex*>(data_p), SHARE);
+}
+
+void MappedGrid::map (Array<DComplex>& grid, const IPosition& shape,
+		      const String& directory)
+{
+  unmap();
+  nbytes_p = shape.product() * sizeof(DComplex);
+  data_p   = mapFile (nbytes_p, directory);
+  grid.takeStorage (shape, static_cast<DComplex*>(data_p), SHARE);
+}
+
+Bool MappedGrid::useMapping (Double gridBytes, Double cacheBytes)
+{
+  return gridBytes > cacheBytes  &&
+    gridBytes > HostInfo::memoryTotal(True) * 1024. / 2;
+}
+
+// Transform the rows of each plane in place and the columns in blocks
+// gathered into a buffer, so the grid is accessed sequentially.
+template<class T, class S>
+static void fft2dPlanes (Array<S>& grid, Bool toFrequency, Double bufferBytes)
+{
+  AlwaysAssert (grid.contiguousStorage(), AipsError);
+  const IPosition& shape = grid.shape();
+  Int nx = shape[0];
+  Int ny = shape[1];
+  if (nx == 0  ||  ny == 0) {
+    return;
+  }
+  Int64 nplane = shape.product() / (Int64(nx) * ny);
+  Int nblk = max(1, min(nx, Int(bufferBytes / (Double(ny) * sizeof(S)))));
+  Int nthr = 1;
+#ifdef _OPENMP
+  nthr = omp_get_max_threads();
+#endif
+  // FFTServer planning is not thread-safe, so each thread gets its own
+  // servers which are set up before the parallel loops.
+  Block<CountedPtr<FFTServer<T,S> > > rowServers(nthr);
+  Block<CountedPtr<FFTServer<T,S> > > colServers(nthr);
+  for (Int i=0; i<nthr; ++i) {
+    rowServers[i] = new FFTServer<T,S>(IPosition(1, nx), FFTEnums::COMPLEX);
+    colServers[i] = new FFTServer<T,S>(IPosition(1, ny), FFTEnums::COMPLEX);
+  }
+  std::vector<S> buf(Int64(nblk) * ny);
+  Bool deleteIt;
+  S* data = grid.getStorage (deleteIt);
+  for (Int64 p=0; p<nplane; ++p) {
+    S* plane = data + p * nx * ny;
+#pragma omp parallel for schedule(static)
+    for (Int y=0; y<ny; ++y) {
+      Int thr = 0;
+#ifdef _OPENMP
+      thr = omp_get_thread_num();
+#endif
+      Vector<S> row(IPosition(1, nx), plane + Int64(y) * nx, SHARE);
+      rowServers[thr]->fft (row, toFrequency);
+    }
+    for (Int x0=0; x0<nx; x0+=nblk) {
+      Int nb = min(nblk, nx - x0);
+#pragma omp parallel for schedule(static)
+      for (Int y=0; y<ny; ++y) {
+	const S* src = plane + Int64(y) * nx + x0;
+	for (Int b=0; b<nb; ++b) {
+	  buf[Int64(b) * ny + y] = src[b];
+	}
+      }
+#pragma omp parallel for schedule(static)
+      for (Int b=0; b<nb; ++b) {
+	Int thr = 0;
+#ifdef _OPENMP
+	thr = omp_get_thread_num();
+#endif
+	Vector<S> col(IPosition(1, ny), &buf[Int64(b) * ny], SHARE);
+	colServers[thr]->fft (col, toFrequency);
+      }
+#pragma omp parallel for schedule(static)
+      for (Int y=0; y<ny; ++y) {
+	S* dst = plane + Int64(y) * nx + x0;
+	for (Int b=0; b<nb; ++b) {
+	  dst[b] = buf[Int64(b) * ny + y];
+	}
+      }
+    }
+  }
+  grid.putStorage (data, deleteIt);
+}
+
+void MappedGrid::fft2d (Array<Complex>& grid, Bool toFrequency,
+			Double bufferBytes)
+{
+  fft2dPlanes<Float,Complex> (grid, toFrequency, bufferBytes);
+}
+
+void MappedGrid::fft2d (Array<DComplex>& grid, Bool toFrequency,
+			Double bufferBytes)
+{
+  fft2dPlanes<Double,DComplex> (grid, toFrequency, bufferBytes);
+}
+
+} //# NAMESPACE CASA - END
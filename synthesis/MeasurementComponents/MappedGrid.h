@@ -0,0 +1,139 @@
+//# MappedGrid.h: Memory-mapped storage and out-of-core FFT for uv-grids
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef SYNTHESIS_MAPPEDGRID_H
+#define SYNTHESIS_MAPPEDGRID_H
+
+#include <casa/aips.h>
+#include <casa/BasicSL/Complex.h>
+#include <casa/BasicSL/String.h>
+#include <casa/Arrays/Array.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+// <summary>
+// Memory-mapped storage and out-of-core FFT for uv-grids
+// </summary>
+
+// <use visibility=local>
+
+// <reviewed reviewer="" date="" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> <linkto class=GridFT>GridFT</linkto>
+// </prerequisite>
+//
+// <etymology>
+// A grid whose storage is a mapped file.
+// </etymology>
+//
+// <synopsis>
+// GridFT and WProjectFT keep the full padded uv-grid in memory. If the grid
+// does not fit in memory, its storage can be a MappedGrid: an anonymous
+// (unlinked) file in the working directory mapped into memory. The Array
+// refers to the mapped storage, so the gridders work unchanged and the
+// operating system pages the parts of the grid in and out as needed.
+// <p>
+// The FFT of a plane of such a grid is done out-of-core: first the rows
+// are transformed in place (sequential access), thereafter the columns
+// are transformed in blocks; the columns of a block are gathered into a
+// buffer, transformed and scattered back, so each pass reads the plane
+// sequentially. The result is the same as that of LatticeFFT::cfft2d.
+// </synopsis>
+//
+// <example>
+// <srcblock>
+//   MappedGrid mgrid;
+//   Array<Complex> grid;
+//   mgrid.map (grid, IPosition(4, nx, ny, npol, nchan));
+//   ... grid the data
+//   MappedGrid::fft2d (grid, False, 256*1024*1024);
+//   grid.resize();          // release the reference before unmapping
+//   mgrid.unmap();
+// </srcblock>
+// </example>
+//
+// <motivation>
+// Make images whose padded grid is larger than the memory of a node.
+// </motivation>
+
+class MappedGrid
+{
+public:
+  MappedGrid();
+
+  // The mapping is removed; arrays referring to it must not be used anymore.
+  ~MappedGrid();
+
+  // Let the array refer to a zero-filled mapped grid of the given shape.
+  // The backing file is created in the given directory and removed
+  // immediately, so it disappears when the grid is unmapped.
+  // <group>
+  void map (Array<Complex>& grid, const IPosition& shape,
+	    const String& directory=".");
+  void map (Array<DComplex>& grid, const IPosition& shape,
+	    const String& directory=".");
+  // </group>
+
+  // Remove the mapping.
+  void unmap();
+
+  // Is a grid mapped?
+  Bool isMapped() const
+    { return data_p != 0; }
+
+  // Tell if a grid of the given size (in bytes) should be mapped.
+  // That is the case if it exceeds the gridding cache size (in bytes)
+  // and half of the memory of the machine.
+  static Bool useMapping (Double gridBytes, Double cacheBytes);
+
+  // Do an in-place 2D FFT (with the origin in the center like
+  // FFTServer::fft) of each plane of the grid, using at most bufferBytes
+  // for the column blocks. The grid must be contiguous.
+  // <group>
+  static void fft2d (Array<Complex>& grid, Bool toFrequency,
+		     Double bufferBytes);
+  static void fft2d (Array<DComplex>& grid, Bool toFrequency,
+		     Double bufferBytes);
+  // </group>
+
+private:
+  // Forbid copy and assignment.
+  MappedGrid (const MappedGrid&);
+  MappedGrid& operator= (const MappedGrid&);
+
+  // Map a zero-filled file of the given size.
+  void* mapFile (uInt64 nbytes, const String& directory);
+
+  void*  data_p;
+  uInt64 nbytes_p;
+};
+
+} //# NAMESPACE CASA - END
+
+#endif
@@ -1495,7 +1495,8 @@ Bool MosaicFT::getXYPos(const VisBuffer& vb, Int row) {
   
   
   const ROMSPointingColumns& act_mspc=vb.msColumns().pointing();
-  uInt pointIndex=getIndex(act_mspc, vb.time()(row), vb.timeInterval()(row));
+  uInt pointIndex=getIndex(act_mspc, vb.time()(row), vb.timeInterval()(row),
+			   vb.antenna1()(row));
   if((pointIndex<0)||(pointIndex>=act_mspc.time().nrow())) {
     //    ostringstream o;
     //    o << "Failed to find pointing information for time " <<
@@ -1543,56 +1544,26 @@ Bool MosaicFT::getXYPos(const VisBuffer& vb, Int row) {
   return result;
   
 }
-// Get the index into the pointing table for this time. Note that the 
-// in the pointing table, TIME specifies the beginning of the spanned
-// time range, whereas for the main table, TIME is the centroid.
-// Note that the behavior for multiple matches is not specified! i.e.
-// if there are multiple matches, the index returned depends on the
-// history of previous matches. It is deterministic but not obvious.
-// One could cure this by searching but it would be considerably
-// costlier.
+// Get the index into the pointing table for this time and antenna. Note
+// that in the pointing table, TIME is the midpoint of the spanned time
+// range, as for the main table. The rows are looked up in an in-memory
+// index; if multiple rows match, the one with the nearest midpoint is
+// returned. If the table contains rows with a negative interval, the
+// previous match is returned if no row matches.
 Int MosaicFT::getIndex(const ROMSPointingColumns& mspc, const Double& time,
-		       const Double& interval) {
-  Int start=lastIndex_p;
-  // Search forwards
-  Int nrows=mspc.time().nrow();
-  if(nrows<1) {
+		       const Double& interval, const Int& antid) {
+  pointingIndex_p.attach(mspc);
+  if(pointingIndex_p.nrow()<1) {
     //    logIO_p << "No rows in POINTING table - cannot proceed" << LogIO::EXCEPTION;
     return -1;
   }
-  for (Int i=start;i<nrows;i++) {
-    Double midpoint = mspc.time()(i); // time in POINTING table is midpoint
-    // If the interval in the pointing table is negative, use the last
-    // entry. Note that this may be invalid (-1) but in that case 
-    // the calling routine will generate an error
-    if(mspc.interval()(i)<0.0) {
-      return lastIndex_p;
-    }
-    // Pointing table interval is specified so we have to do a match
-    else {
-      // Is the midpoint of this pointing table entry within the specified
-      // tolerance of the main table entry?
-      if(abs(midpoint-time) < (mspc.interval()(i)/2.0)) {
-	lastIndex_p=i;
-	return i;
-      }
-    }
+  Int index=pointingIndex_p.find(time, antid, 0.5, False);
+  if(index>=0) {
+    lastIndex_p=index;
+    return index;
   }
-  // Search backwards
-  for (Int i=start;i>=0;i--) {
-    Double midpoint = mspc.time()(i); // time in POINTING table is midpoint
-    if(mspc.interval()(i)<0.0) {
-      return lastIndex_p;
-    }
-    // Pointing table interval is specified so we have to do a match
-    else {
-      // Is the midpoint of this pointing table entry within the specified
-      // tolerance of the main table entry?
-      if(abs(midpoint-time) < (mspc.interval()(i)/2.0)) {
-	lastIndex_p=i;
-	return i;
-      }
-    }
+  if(pointingIndex_p.hasNegativeInterval()) {
+    return lastIndex_p;
   }
   // No match!
   return -1;
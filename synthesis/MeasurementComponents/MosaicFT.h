@@ -48,6 +48,7 @@
 #include <measures/Measures/MDirection.h>
 #include <measures/Measures/MPosition.h>
 #include <coordinates/Coordinates/DirectionCoordinate.h>
+#include <synthesis/MeasurementComponents/PointingIndex.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -317,8 +318,11 @@ protected:
 
   Int lastIndex_p;
 
+  // In-memory index of the POINTING table
+  PointingIndex pointingIndex_p;
+
   Int getIndex(const ROMSPointingColumns& mspc, const Double& time,
-	       const Double& interval);
+	       const Double& interval, const Int& antid=-1);
 
   Bool getXYPos(const VisBuffer& vb, Int row);
 
@@ -245,6 +245,41 @@ void MultiTermFT::put(VisBuffer& vb, Int row, Bool dopsf,
   if(dotime_p) time_put += tmr_p.real();
 }
 
+Bool MultiTermFT::putAllTerms(const Block<MultiTermFT*>& terms, VisBuffer& vb,
+			      Int row, Bool dopsf, FTMachine::Type type)
+{
+  uInt nterms=terms.nelements();
+  if(nterms==0) return False;
+  MultiTermFT& ft0=*terms[0];
+  Block<GridFT*> subfts(nterms);
+  for (uInt term=0; term<nterms; term++)
+    {
+      MultiTermFT& ft=*terms[term];
+      if( ft.thisterm_p!=Int(term) || ft.reffreq_p!=ft0.reffreq_p ||
+          ft.subftm_p->name()!="GridFT" ) return False;
+      subfts[term]=static_cast<GridFT*>(&(*ft.subftm_p));
+    }
+
+  if(ft0.dotime_p) ft0.tmr_p.mark();
+
+  // Taylor-weights per channel, computed as in modifyVisWeights.
+  Float freq=0.0,mulfactor=1.0;
+  Vector<Double> selfreqlist(vb.frequency());
+  Matrix<Float> termWeight(vb.nChannel(), nterms);
+  for (Int chn=0; chn<vb.nChannel(); chn++)
+    {
+      freq = selfreqlist(chn);
+      mulfactor = ((freq-ft0.reffreq_p)/ft0.reffreq_p);
+      termWeight(chn,0) = 1.0;
+      for (uInt term=1; term<nterms; term++)
+	termWeight(chn,term) = termWeight(chn,term-1)*mulfactor;
+    }
+  Bool done=GridFT::putMultiTerm(subfts, vb, termWeight, row, dopsf, type);
+
+  if(ft0.dotime_p) ft0.time_put += ft0.tmr_p.real();
+  return done;
+}
+
 void MultiTermFT::finalizeToSky()
 {  
   if(dbg_p) cerr << "MTFT::finalizeToSky for term " << thisterm_p << endl;
@@ -93,6 +93,15 @@ public:
 	   FTMachine::Type type=FTMachine::OBSERVED)
   {throw(AipsError("MultiTermFT::put called with a const vb. This FTM needs to modify the vb."));};
 
+  // Grid a VisBuffer for all Taylor terms of a field in a single pass.
+  // The machines must be given in ascending Taylor-term order.
+  // The imaging weights of the VisBuffer are not modified.
+  // This is only possible if all sub-ftms are GridFT machines; otherwise
+  // False is returned and put() has to be called for each term.
+  static Bool putAllTerms(const Block<MultiTermFT*>& terms, VisBuffer& vb,
+			  Int row=-1, Bool dopsf=False,
+			  FTMachine::Type type=FTMachine::OBSERVED);
+
   // Calculate residual visibilities if possible.
   // The purpose is to allow rGridFT to make this multi-threaded
   virtual void ComputeResiduals(VisBuffer&vb, Bool useCorrected); 
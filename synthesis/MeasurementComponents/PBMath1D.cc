@@ -57,13 +57,16 @@
 #include <casa/BasicSL/String.h>
 #include <casa/Utilities/Assert.h>
 #include <casa/Exceptions/Error.h>
+#include <casa/OS/HostInfo.h>
 
 
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
 PBMath1D::PBMath1D()
-  : composite_p(2048)
+  : composite_p(2048),
+    vpCacheBytes_p(0),
+    vpCacheLimit_p((HostInfo::memoryTotal(true)/16)*1024)
 {
 };
 
@@ -76,7 +79,9 @@ PBMath1D::PBMath1D(Quantity maximumRadius,
   PBMathInterface(isThisVP, squint, useSymmetricBeam),
   maximumRadius_p(maximumRadius),
   refFreq_p(refFreq),
-  composite_p(2048)
+  composite_p(2048),
+  vpCacheBytes_p(0),
+  vpCacheLimit_p((HostInfo::memoryTotal(true)/16)*1024)
 {
   fScale_p = refFreq_p.getValue("GHz");  // scale is ratio of refFreq_p to 1GHz
   refFreq_p = Quantity( 1.0, "GHz");  // internal Ref Freq is now 1GHz
@@ -502,8 +507,6 @@ PBMath1D::apply(const ImageInterface<Complex>& in,
   LatticeIterator<Complex> oli(out, LatticeStepper(in.shape(), ncs, IPosition(4,0,1,2,3)) );
 
   Complex taper;
-  Float r2=0.0;
-  Float r=0.0;
 
   Vector<Double> increment = directionCoord.increment();
   Int rrplane = -1;
@@ -521,7 +524,6 @@ PBMath1D::apply(const ImageInterface<Complex>& in,
   Int laststokes = -1;  Int ichan;
   Int istokes;
   Int ix0, iy0;
-  Int indx;
   for(li.reset(),oli.reset();!li.atEnd();li++,oli++) {
 
     IPosition itsShape(li.matrixCursor().shape());
@@ -556,56 +558,46 @@ PBMath1D::apply(const ImageInterface<Complex>& in,
     }
 
     Double factor = 60.0 * spectralCache(ichan)/1.0e+9 ;  // arcminutes * GHz
-    Double rmax2 = square( maximumRadius_p.getValue("'") / factor );
-
-    Vector<Float> rx2(itsShape(0));
-    Vector<Float> ry2(itsShape(1));
-    for(Int ix=0;ix<itsShape(0);ix++) {
-      rx2(ix) =  square( increment(0)*((Double)(ix+ix0) - xPixel) );
-    }
-    for(Int iy=0;iy<itsShape(1);iy++) {
-      ry2(iy) =  square( increment(1)*((Double)(iy+iy0) - yPixel) );
-    }
-
+    const VPPlane& plane = vpPlane(xPixel, yPixel, factor, increment,
+                                   in.shape()(0), in.shape()(1));
+
+    // Apply the taper row by row to the part of the cursor that overlaps
+    // with the voltage pattern plane; the rest is outside the beam.
+    const Matrix<Complex>& inMat = li.matrixCursor();
+    Matrix<Complex>& outMat = oli.rwMatrixCursor();
+    Int nx = itsShape(0);
+    Int xs = max(ix0, plane.x0) - ix0;
+    Int xe = min(ix0 + nx, plane.x0 + Int(plane.vp.nrow())) - ix0;
+    Bool doConj = (conjugate != !forward);
     for(Int iy=0;iy<itsShape(1);iy++) {
-      for(Int ix=0;ix<itsShape(0);ix++) {
-
-	r2 =  rx2(ix) +  ry2(iy);
-	
-	if (r2 > rmax2) {
-	  oli.rwMatrixCursor()(ix, iy) = 0.0;
-	} else {
-	  r = sqrt(r2) * factor;
-	  indx = Int(r*inverseIncrementRadius_p);
-	  if (norm(vp_p(indx)) > 0.0) {
-	    if(iPower==2) {
-	      taper = vp_p(indx) * conj(vp_p(indx));
-	    }
-	    else {
-	      taper = vp_p(indx);
-	    }
-	  } else {
-	    taper = 0.0;
-	  }
-	  if (conjugate) {
-	    taper =  conj(taper);
-	  }
-	  // Differentiate between forward (Sky->UV) and
-	  // inverse (UV->Sky) - these need different
-	  // applications of the PB
-	  if(!forward) {
-	    taper =  conj(taper);
-	  }
-	  if (inverse) {
-	    if (abs(taper) < cutoff ) {
-	      oli.rwMatrixCursor()(ix, iy) = 0.0;
-	    } else {
-	      oli.rwMatrixCursor()(ix, iy) = li.matrixCursor()(ix, iy) / taper ;
-	    }
-	  } else {  // not inverse!
-	    oli.rwMatrixCursor()(ix, iy) = li.matrixCursor()(ix, iy) * taper;
-	  }
-	}
+      Int py = iy + iy0 - plane.y0;
+      Complex* outRow = &(outMat(0, iy));
+      const Complex* inRow = &(inMat(0, iy));
+      if (py < 0 || py >= Int(plane.vp.ncolumn()) || xs >= xe) {
+        for(Int ix=0;ix<nx;ix++) outRow[ix] = 0.0;
+        continue;
+      }
+      for(Int ix=0;ix<xs;ix++) outRow[ix] = 0.0;
+      for(Int ix=xe;ix<nx;ix++) outRow[ix] = 0.0;
+      const Complex* vpRow = &(plane.vp(0, py)) + (ix0 - plane.x0);
+      for(Int ix=xs;ix<xe;ix++) {
+        taper = vpRow[ix];
+        if (iPower == 2) {
+          taper = taper * conj(taper);
+        }
+        if (doConj) {
+          taper = conj(taper);
+        }
+        if (inverse) {
+          // Also outside the maximum radius (taper 0) the result is 0.
+          if (abs(taper) < cutoff || taper == Complex(0.0)) {
+            outRow[ix] = 0.0;
+          } else {
+            outRow[ix] = inRow[ix] / taper;
+          }
+        } else {  // not inverse!
+          outRow[ix] = inRow[ix] * taper;
+        }
       }
     }
   }
@@ -739,8 +731,6 @@ PBMath1D::apply(const ImageInterface<Float>& in,
   LatticeIterator<Float> oli(out, LatticeStepper(in.shape(), ncs, IPosition(4,0,1,2,3)) );
 
   Float taper;
-  Float r2=0.0;
-  Float r=0.0;
 
   Vector<Double> increment = directionCoord.increment();
   Int rrplane = -1;
@@ -754,7 +744,6 @@ PBMath1D::apply(const ImageInterface<Float>& in,
   Int ichan;
   Int istokes;
   Int ix0, iy0;
-  Int indx;
 
   for(li.reset(),oli.reset();!li.atEnd();li++,oli++) {
 
@@ -786,35 +775,30 @@ PBMath1D::apply(const ImageInterface<Float>& in,
     }
 
     Double factor = 60.0 * spectralCache(ichan)/1.0e+9 ;  // arcminutes * GHz
-    Double rmax2 = square( maximumRadius_p.getValue("'") / factor );
-
-    Vector<Float> rx2(itsShape(0));
-    Vector<Float> ry2(itsShape(1));
-    for(Int ix=0;ix<itsShape(0);ix++) {
-      rx2(ix) =  square( increment(0)*((Double)(ix+ix0) - xPixel) );
-    }
-    for(Int iy=0;iy<itsShape(1);iy++) {
-      ry2(iy) =  square( increment(1)*((Double)(iy+iy0) - yPixel) );
-    }
-
+    const VPPlane& plane = vpPlane(xPixel, yPixel, factor, increment,
+                                   in.shape()(0), in.shape()(1));
+
+    const Matrix<Float>& inMat = li.matrixCursor();
+    Matrix<Float>& outMat = oli.rwMatrixCursor();
+    Int nx = itsShape(0);
+    Int xs = max(ix0, plane.x0) - ix0;
+    Int xe = min(ix0 + nx, plane.x0 + Int(plane.vp.nrow())) - ix0;
     for(Int iy=0;iy<itsShape(1);iy++) {
-      for(Int ix=0;ix<itsShape(0);ix++) {
-
-	r2 =  rx2(ix) +  ry2(iy);
-	if (r2 > rmax2) {
-	  oli.rwMatrixCursor()(ix, iy) = 0.0;
-	} else {
-	  r = sqrt(r2) * factor;
-	  indx = Int(r*inverseIncrementRadius_p);
-	  if (norm(vp_p(indx)) > 0.0) {
-	    taper = real(vp_p(indx) * conj(vp_p(indx)));
-	    if(ipower==4)
-	      taper *= taper;
-	  } else {
-	    taper = 0.0;
-	  }
-	  oli.rwMatrixCursor()(ix, iy) = li.matrixCursor()(ix, iy) * taper;
-	}
+      Int py = iy + iy0 - plane.y0;
+      Float* outRow = &(outMat(0, iy));
+      const Float* inRow = &(inMat(0, iy));
+      if (py < 0 || py >= Int(plane.vp.ncolumn()) || xs >= xe) {
+        for(Int ix=0;ix<nx;ix++) outRow[ix] = 0.0;
+        continue;
+      }
+      for(Int ix=0;ix<xs;ix++) outRow[ix] = 0.0;
+      for(Int ix=xe;ix<nx;ix++) outRow[ix] = 0.0;
+      const Complex* vpRow = &(plane.vp(0, py)) + (ix0 - plane.x0);
+      for(Int ix=xs;ix<xe;ix++) {
+        taper = norm(vpRow[ix]);
+        if(ipower==4)
+          taper *= taper;
+        outRow[ix] = inRow[ix] * taper;
       }
     }
   }
@@ -939,6 +923,84 @@ PBMath1D::apply(SkyComponent& in,
 
 };
 
+void PBMath1D::setCacheSize(Long nbytes)
+{
+  vpCacheLimit_p = nbytes;
+  while (vpCacheBytes_p > vpCacheLimit_p && !vpCache_p.empty()) {
+    vpCacheBytes_p -= vpCache_p.back().vp.nelements() * sizeof(Complex);
+    vpCache_p.pop_back();
+  }
+};
+
+const PBMath1D::VPPlane&
+PBMath1D::vpPlane(Double xPixel, Double yPixel, Double factor,
+                  const Vector<Double>& increment, Int nx, Int ny)
+{
+  std::vector<Double> key(7);
+  key[0] = xPixel;
+  key[1] = yPixel;
+  key[2] = factor;
+  key[3] = increment(0);
+  key[4] = increment(1);
+  key[5] = nx;
+  key[6] = ny;
+  for (std::list<VPPlane>::iterator iter=vpCache_p.begin();
+       iter!=vpCache_p.end(); ++iter) {
+    if (iter->key == key) {
+      vpCache_p.splice(vpCache_p.begin(), vpCache_p, iter);
+      return vpCache_p.front();
+    }
+  }
+
+  // The box (within the image) containing the maximum radius.
+  Double rmax = maximumRadius_p.getValue("'") / factor;
+  Double rmax2 = square(rmax);
+  Double hx = rmax / abs(increment(0));
+  Double hy = rmax / abs(increment(1));
+  Int x0 = max(0, Int(floor(xPixel - hx)));
+  Int x1 = min(nx-1, Int(ceil(xPixel + hx)));
+  Int y0 = max(0, Int(floor(yPixel - hy)));
+  Int y1 = min(ny-1, Int(ceil(yPixel + hy)));
+
+  VPPlane plane;
+  plane.key = key;
+  plane.x0 = x0;
+  plane.y0 = y0;
+  plane.vp.resize(max(0, x1-x0+1), max(0, y1-y0+1));
+  plane.vp = Complex(0.0);
+  Vector<Double> rx2(plane.vp.nrow());
+  for(uInt ix=0;ix<rx2.nelements();ix++) {
+    rx2(ix) = square( increment(0)*((Double)(ix+x0) - xPixel) );
+  }
+  Double scale = factor * inverseIncrementRadius_p;
+  for(uInt iy=0;iy<plane.vp.ncolumn();iy++) {
+    Double ry2 = square( increment(1)*((Double)(iy+y0) - yPixel) );
+    Complex* vpRow = &(plane.vp(0, iy));
+    for(uInt ix=0;ix<rx2.nelements();ix++) {
+      Double r2 = rx2(ix) + ry2;
+      if (r2 <= rmax2) {
+        vpRow[ix] = vp_p(Int(sqrt(r2) * scale));
+      }
+    }
+  }
+
+  Long nbytes = plane.vp.nelements() * sizeof(Complex);
+  if (nbytes > vpCacheLimit_p) {
+    vpScratch_p.key = plane.key;
+    vpScratch_p.x0 = plane.x0;
+    vpScratch_p.y0 = plane.y0;
+    vpScratch_p.vp.reference(plane.vp);
+    return vpScratch_p;
+  }
+  vpCache_p.push_front(plane);
+  vpCacheBytes_p += nbytes;
+  while (vpCacheBytes_p > vpCacheLimit_p && vpCache_p.size() > 1) {
+    vpCacheBytes_p -= vpCache_p.back().vp.nelements() * sizeof(Complex);
+    vpCache_p.pop_back();
+  }
+  return vpCache_p.front();
+};
+
 void PBMath1D::summary(Int nValues)
 {
   String  name;
@@ -31,6 +31,9 @@
 
 #include <casa/aips.h>
 #include <synthesis/MeasurementComponents/PBMathInterface.h>
+#include <casa/Arrays/Matrix.h>
+#include <list>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -110,6 +113,13 @@ class CoordinateSystem;
 // apply's then call a lower level private polymorphic apply, which are defined
 // in PBMath1D and in PBMath2D.  These two different apply's deal with the
 // different details of 1D and 2D primary beam application.
+//
+// The voltage pattern values of an image plane only depend on the
+// pointing position (in pixels), the frequency and the pixel size.
+// They are cached for the part of the plane within the maximum radius,
+// so applying the beam again for the same pointing (e.g. in the next
+// major cycle of a mosaic) only needs a multiplication.  The size of the
+// cache is limited (see setCacheSize).
 // <example>
 // <srcblock>
 //
@@ -307,7 +317,36 @@ protected:
   // CompositeNumber (for beam application and the like)
   CompositeNumber composite_p;
 
+public:
+  // Set the maximum size (in bytes) of the cache of voltage pattern
+  // planes.  The default is 1/16 of the memory; 0 switches caching off.
+  void setCacheSize(Long nbytes);
+
+protected:
+  // The voltage pattern values for the pixels of an image plane within
+  // the maximum radius of a beam centred at (xPixel,yPixel).  The
+  // values are stored for the box [x0,x0+vp.nrow()> by
+  // [y0,y0+vp.ncolumn()>; pixels outside the maximum radius are 0.
+  struct VPPlane {
+    std::vector<Double> key;
+    Int x0, y0;
+    Matrix<Complex> vp;
+  };
+
+  // Get the voltage pattern plane for the given pointing pixel, frequency
+  // factor (arcmin*GHz per degree), pixel increments and plane shape
+  // from the cache, or compute and cache it.
+  const VPPlane& vpPlane(Double xPixel, Double yPixel, Double factor,
+                         const Vector<Double>& increment,
+                         Int nx, Int ny);
+
 private:    
+  // Most recently used planes are at the front.
+  std::list<VPPlane> vpCache_p;
+  Long vpCacheBytes_p;
+  Long vpCacheLimit_p;
+  // A plane too large to cache.
+  VPPlane vpScratch_p;
 
 };
 
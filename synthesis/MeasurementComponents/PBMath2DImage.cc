@@ -47,6 +47,7 @@
 #include <components/ComponentModels/ComponentType.h>
 #include <casa/Quanta.h>
 #include <measures/Measures.h>
+#include <casa/OS/HostInfo.h>
 
 namespace casa {
 
@@ -55,7 +56,8 @@ PBMath2DImage::PBMath2DImage(ImageInterface<Float>& reJonesImage):
   imJonesImage_p(0), imRegridJonesImage_p(0),
   incrementsReJones_p(0), incrementsImJones_p(0),
   referencePixelReJones_p(0), referencePixelImJones_p(0),
-  pa_p(0.0)
+  pa_p(0.0), regridCacheBytes_p(0),
+  regridCacheLimit_p((HostInfo::memoryTotal(true)/16)*1024)
 {
   LogIO os(LogOrigin("PBMath2DImage", "PBMath2DImage"));
 
@@ -74,7 +76,8 @@ PBMath2DImage::PBMath2DImage(ImageInterface<Float>& reJonesImage,
   imJonesImage_p(0), imRegridJonesImage_p(0), 
   incrementsReJones_p(0), incrementsImJones_p(0),
   referencePixelReJones_p(0), referencePixelImJones_p(0),
-  pa_p(0.0)
+  pa_p(0.0), regridCacheBytes_p(0),
+  regridCacheLimit_p((HostInfo::memoryTotal(true)/16)*1024)
 {
 
   LogIO os(LogOrigin("PBMath2DImage", "PBMath2DImage"));
@@ -103,6 +106,11 @@ PBMath2DImage::~PBMath2DImage()
   if(incrementsImJones_p) delete incrementsImJones_p; incrementsImJones_p=0;
   if(referencePixelReJones_p) delete referencePixelReJones_p; referencePixelReJones_p=0;
   if(referencePixelImJones_p) delete referencePixelImJones_p; referencePixelImJones_p=0;
+  for (std::list<RegridJones>::iterator iter=regridCache_p.begin();
+       iter!=regridCache_p.end(); ++iter) {
+    delete iter->re;
+    delete iter->im;
+  }
 };
 
 PBMath2DImage& PBMath2DImage::operator=(const PBMath2DImage& other)
@@ -822,14 +830,45 @@ void PBMath2DImage::updateJones(const CoordinateSystem& coords,
   desiredShape(2)=reJonesImage_p->shape()(2);
   desiredShape(3)=reJonesImage_p->shape()(3);
 
+  // The regridded images only depend on the direction axes of the image,
+  // the pointing, the parallactic angle and the frequency.  Look them up
+  // in the cache.
+  std::vector<Double> key;
+  {
+    Int directionIndex=coords.findCoordinate(Coordinate::DIRECTION);
+    AlwaysAssert(directionIndex>=0, AipsError);
+    const DirectionCoordinate&
+      imageDirectionCoord=coords.directionCoordinate(directionIndex);
+    Vector<Double> pcAngle(pc.getAngle().getValue("rad"));
+    key.push_back(imageDirectionCoord.directionType());
+    for (uInt i=0; i<2; i++) {
+      key.push_back(imageDirectionCoord.referenceValue()(i));
+      key.push_back(imageDirectionCoord.referencePixel()(i));
+      key.push_back(imageDirectionCoord.increment()(i));
+      key.push_back(pcAngle(i));
+      key.push_back(shape(i));
+    }
+    key.push_back(pa);
+    key.push_back(desiredFrequency);
+  }
+  for (std::list<RegridJones>::iterator iter=regridCache_p.begin();
+       iter!=regridCache_p.end(); ++iter) {
+    if (iter->key == key) {
+      regridCache_p.splice(regridCache_p.begin(), regridCache_p, iter);
+      reRegridJonesImage_p=regridCache_p.front().re;
+      imRegridJonesImage_p=regridCache_p.front().im;
+      return;
+    }
+  }
+
   // Now set the desired coordinates for the regridded Jones images
   // The desired coordinates should have the same direction axis
   // as the image to input image and the same stokes and frequency
   // axes as the input Jones images.
   {
-    // Delete any old images
-    if(reRegridJonesImage_p) delete reRegridJonesImage_p; reRegridJonesImage_p=0;
-    if(imRegridJonesImage_p) delete imRegridJonesImage_p; imRegridJonesImage_p=0;
+    // The old images are owned by the cache
+    reRegridJonesImage_p=0;
+    imRegridJonesImage_p=0;
 
     Int directionIndex=coords.findCoordinate(Coordinate::DIRECTION);
     AlwaysAssert(directionIndex>=0, AipsError);
@@ -931,13 +970,33 @@ void PBMath2DImage::updateJones(const CoordinateSystem& coords,
   // Check for empty PB
   LatticeExprNode maxRePB=max(*reRegridJonesImage_p);  
   LatticeExprNode maxImPB=max(*reRegridJonesImage_p);  
-  if(maxRePB.getFloat()==0.0) {
-    throw(AipsError("PBMath2DImage: regridded real Jones image is empty"));
-  }
-  if(maxImPB.getFloat()==0.0) {
+  if(maxRePB.getFloat()==0.0 || maxImPB.getFloat()==0.0) {
+    delete reRegridJonesImage_p; reRegridJonesImage_p=0;
+    if(imRegridJonesImage_p) delete imRegridJonesImage_p; imRegridJonesImage_p=0;
+    if(maxRePB.getFloat()==0.0) {
+      throw(AipsError("PBMath2DImage: regridded real Jones image is empty"));
+    }
     throw(AipsError("PBMath2DImage: regridded imag Jones image is empty"));
   }
 
+  // Add the new images to the cache and drop the least recently used
+  // ones if it gets too large.
+  RegridJones entry;
+  entry.key=key;
+  entry.re=reRegridJonesImage_p;
+  entry.im=imRegridJonesImage_p;
+  regridCache_p.push_front(entry);
+  regridCacheBytes_p += (imRegridJonesImage_p ? 2 : 1) *
+                        desiredShape.product() * Long(sizeof(Float));
+  while (regridCacheBytes_p > regridCacheLimit_p && regridCache_p.size() > 1) {
+    RegridJones& last=regridCache_p.back();
+    regridCacheBytes_p -= (last.im ? 2 : 1) *
+                          last.re->shape().product() * Long(sizeof(Float));
+    delete last.re;
+    delete last.im;
+    regridCache_p.pop_back();
+  }
+
   // For debugging purposes
 //   if(0) {
 //     PagedImage<Float> reRegridJones(reRegridJonesImage_p->shape(),
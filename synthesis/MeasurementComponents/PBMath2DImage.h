@@ -33,6 +33,8 @@
 #include <synthesis/MeasurementComponents/PBMath2D.h>
 #include <images/Images/ImageInterface.h>
 #include <measures/Measures.h>
+#include <list>
+#include <vector>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -70,6 +72,10 @@ typedef SquareMatrix<Float,2> mjJones2F;
 // which the tabulated VP is intended are also required for construction.
 // The PBMath2DImage constructor proceeds by performing SINC interpolation
 // on the input vector to generate the highly oversampled lookup vector.
+//
+// The Jones images regridded to the image to be corrected are cached
+// per pointing, parallactic angle and frequency (up to 1/16 of the
+// memory), so applying the beam again for a pointing does not regrid.
 // 
 // </synopsis> 
 //
@@ -179,7 +185,8 @@ private:
   void checkImageCongruent(ImageInterface<Float>& image);
 
 
-  // Update the Jones Matrix
+  // Update the Jones Matrix (reRegridJonesImage_p and
+  // imRegridJonesImage_p), taking it from the cache if possible.
   void updateJones(const CoordinateSystem& coords,
 		   const IPosition& shape,
 		   const MDirection& pc,
@@ -221,6 +228,17 @@ private:
   Vector<Double>* referencePixelImJones_p;
 
   Float pa_p;
+
+  // The cached regridded Jones images, most recently used first.
+  // The cache owns the images.
+  struct RegridJones {
+    std::vector<Double> key;
+    TempImage<Float>* re;
+    TempImage<Float>* im;
+  };
+  std::list<RegridJones> regridCache_p;
+  Long regridCacheBytes_p;
+  Long regridCacheLimit_p;
 };
 
 
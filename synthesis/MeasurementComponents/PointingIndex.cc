@@ -0,0 +1,177 @@
+//# PointingIndex.cc: Implementation of PointingIndex
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+
+#include <synthesis/MeasurementComponents/PointingIndex.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <algorithm>
+#include <cmath>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+namespace {
+  // Compare row numbers on their time.
+  struct TimeLess
+  {
+    explicit TimeLess (const Double* time) : time_p(time) {}
+    bool operator() (uInt r1, uInt r2) const
+      { return time_p[r1] < time_p[r2]; }
+    bool operator() (uInt r, Double t) const
+      { return time_p[r] < t; }
+    const Double* time_p;
+  };
+}
+
+PointingIndex::PointingIndex()
+  : timeColumn_p     (0),
+    maxInterval_p    (0),
+    hasNegInterval_p (False)
+{}
+
+void PointingIndex::clear()
+{
+  table_p          = Table();
+  timeColumn_p     = 0;
+  time_p.resize (0);
+  interval_p.resize (0);
+  antenna_p.resize (0);
+  antRows_p.clear();
+  allRows_p.clear();
+  antPos_p.clear();
+  antMaxInterval_p.clear();
+  maxInterval_p    = 0;
+  hasNegInterval_p = False;
+}
+
+void PointingIndex::attach (const ROMSPointingColumns& mspc)
+{
+  const BaseColumn* timeColumn = mspc.time().baseColPtr();
+  uInt nrow = mspc.time().nrow();
+  if (timeColumn == timeColumn_p  &&  nrow == time_p.nelements()) {
+    return;
+  }
+  clear();
+  table_p      = mspc.time().table();
+  timeColumn_p = timeColumn;
+  if (nrow == 0) {
+    return;
+  }
+  // Read the columns at once instead of cell by cell.
+  time_p     = mspc.time().getColumn();
+  interval_p = mspc.interval().getColumn();
+  antenna_p  = mspc.antennaId().getColumn();
+  Int nant = 0;
+  for (uInt i=0; i<nrow; ++i) {
+    nant = std::max (nant, antenna_p[i] + 1);
+    if (interval_p[i] < 0) {
+      hasNegInterval_p = True;
+    } else {
+      maxInterval_p = std::max (maxInterval_p, interval_p[i]);
+    }
+  }
+  antRows_p.resize (nant);
+  antMaxInterval_p.assign (nant, 0.);
+  allRows_p.resize (nrow);
+  for (uInt i=0; i<nrow; ++i) {
+    allRows_p[i] = i;
+    Int ant = antenna_p[i];
+    if (ant >= 0) {
+      antRows_p[ant].push_back (i);
+      if (interval_p[i] > antMaxInterval_p[ant]) {
+	antMaxInterval_p[ant] = interval_p[i];
+      }
+    }
+  }
+  // The table is usually in time order already, so a stable sort keeps
+  // the table order for equal times.
+  TimeLess less(time_p.data());
+  std::stable_sort (allRows_p.begin(), allRows_p.end(), less);
+  antPos_p.assign (nrow, 0);
+  for (uInt ant=0; ant<antRows_p.size(); ++ant) {
+    std::vector<uInt>& rows = antRows_p[ant];
+    std::stable_sort (rows.begin(), rows.end(), less);
+    for (uInt i=0; i<rows.size(); ++i) {
+      antPos_p[rows[i]] = i;
+    }
+  }
+}
+
+Int PointingIndex::find (Double time, Int antenna, Double tolFactor,
+			 Bool inclusive) const
+{
+  if (antenna >= 0  &&  antenna < Int(antRows_p.size())  &&
+      !antRows_p[antenna].empty()) {
+    return findSorted (antRows_p[antenna], antMaxInterval_p[antenna],
+		       time, tolFactor, inclusive);
+  }
+  return findSorted (allRows_p, maxInterval_p, time, tolFactor, inclusive);
+}
+
+Int PointingIndex::findSorted (const std::vector<uInt>& rows,
+			       Double maxInterval, Double time,
+			       Double tolFactor, Bool inclusive) const
+{
+  // Only rows with a midpoint within the largest tolerance can match.
+  Double maxTol = tolFactor * maxInterval;
+  std::vector<uInt>::const_iterator iter =
+    std::lower_bound (rows.begin(), rows.end(), time - maxTol,
+		      TimeLess(time_p.data()));
+  Int best = -1;
+  Double bestDiff = 0;
+  for (; iter != rows.end()  &&  time_p[*iter] <= time + maxTol; ++iter) {
+    uInt row = *iter;
+    if (interval_p[row] < 0) {
+      continue;
+    }
+    Double diff = fabs(time_p[row] - time);
+    Double tol  = tolFactor * interval_p[row];
+    if ((inclusive  ?  diff <= tol : diff < tol)  &&
+	(best < 0  ||  diff < bestDiff)) {
+      best     = row;
+      bestDiff = diff;
+    }
+  }
+  return best;
+}
+
+void PointingIndex::neighbours (Int row, Int& before, Int& after) const
+{
+  before = after = -1;
+  Int ant = antenna_p[row];
+  const std::vector<uInt>& rows = (ant >= 0  ?  antRows_p[ant] : allRows_p);
+  uInt pos = (ant >= 0  ?  antPos_p[row] :
+	      std::lower_bound (rows.begin(), rows.end(), time_p[row],
+				TimeLess(time_p.data())) - rows.begin());
+  if (pos > 0) {
+    before = rows[pos-1];
+  }
+  if (pos+1 < rows.size()) {
+    after = rows[pos+1];
+  }
+}
+
+} //# NAMESPACE CASA - END
@@ -0,0 +1,154 @@
+//# PointingIndex.h: In-memory index of the POINTING table
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef SYNTHESIS_POINTINGINDEX_H
+#define SYNTHESIS_POINTINGINDEX_H
+
+#include <casa/aips.h>
+#include <casa/Arrays/Vector.h>
+#include <tables/Tables/Table.h>
+#include <vector>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+//# Forward declarations
+class ROMSPointingColumns;
+class BaseColumn;
+
+// <summary>
+// In-memory index of the POINTING table for fast time lookup
+// </summary>
+
+// <use visibility=local>
+
+// <reviewed reviewer="" date="" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> <linkto class=ROMSPointingColumns>ROMSPointingColumns</linkto>
+// </prerequisite>
+//
+// <etymology>
+// An index into the POINTING table.
+// </etymology>
+//
+// <synopsis>
+// SDGrid, MosaicFT and SDDataSampling have to find the POINTING table row
+// valid for the time of each visibility row. Scanning the table from the
+// previous match, reading TIME and INTERVAL cell by cell, dominates the
+// gridding time for on-the-fly maps with millions of pointing rows.
+// <p>
+// A PointingIndex reads the TIME, INTERVAL and ANTENNA_ID columns once and
+// keeps the rows of each antenna sorted in time, so a row is found with a
+// binary search. A row matches if the time is within the given fraction
+// of its interval from its TIME (the midpoint). If several rows match, the
+// one with the nearest midpoint is taken. If an antenna has no rows in the
+// POINTING table, the rows of all antennas are searched.
+// <p>
+// The neighbours in time of a row (of the same antenna) can be obtained
+// for interpolation of the pointing direction.
+// </synopsis>
+//
+// <example>
+// <srcblock>
+//   PointingIndex index;
+//   index.attach (vb.msColumns().pointing());
+//   Int row = index.find (vb.time()(0), vb.antenna1()(0));
+// </srcblock>
+// </example>
+//
+// <motivation>
+// Make single dish and mosaic gridding of OTF data fast.
+// </motivation>
+
+class PointingIndex
+{
+public:
+  PointingIndex();
+
+  // Index the given POINTING table. Nothing is done if that table
+  // (with the same number of rows) is already indexed. That check only
+  // compares the TIME column object, so it is cheap enough to be done
+  // for each visibility row.
+  void attach (const ROMSPointingColumns& mspc);
+
+  // Clear the index.
+  void clear();
+
+  // Find the row of the given antenna (-1 is any antenna) valid for the
+  // given time. The time has to be within tolFactor*INTERVAL of TIME;
+  // if inclusive is False, it has to be strictly within. Rows with a
+  // negative interval never match. -1 is returned if no row matches.
+  Int find (Double time, Int antenna=-1, Double tolFactor=0.5,
+	    Bool inclusive=True) const;
+
+  // Get the rows before and after the given row in time, for the same
+  // antenna. -1 is returned if there is no such row.
+  void neighbours (Int row, Int& before, Int& after) const;
+
+  // Get the TIME and INTERVAL of a row.
+  // <group>
+  Double time (Int row) const
+    { return time_p[row]; }
+  Double interval (Int row) const
+    { return interval_p[row]; }
+  // </group>
+
+  // Get the number of rows in the indexed table.
+  uInt nrow() const
+    { return time_p.nelements(); }
+
+  // Does the table contain rows with a negative interval?
+  Bool hasNegativeInterval() const
+    { return hasNegInterval_p; }
+
+private:
+  // Find the best match in the sorted rows of an antenna.
+  Int findSorted (const std::vector<uInt>& rows, Double maxInterval,
+		  Double time, Double tolFactor, Bool inclusive) const;
+
+  // The indexed table and its TIME column. The table is kept open, so
+  // the column object cannot be reused for a table opened later.
+  Table             table_p;
+  const BaseColumn* timeColumn_p;
+  Vector<Double> time_p;
+  Vector<Double> interval_p;
+  Vector<Int>    antenna_p;
+  // Row numbers per antenna and of all antennas, sorted in time.
+  std::vector<std::vector<uInt> > antRows_p;
+  std::vector<uInt>               allRows_p;
+  // Position of each row in its antenna's sorted row numbers.
+  std::vector<uInt>               antPos_p;
+  // The largest positive interval per antenna and of all antennas.
+  std::vector<Double>             antMaxInterval_p;
+  Double                          maxInterval_p;
+  Bool                            hasNegInterval_p;
+};
+
+} //# NAMESPACE CASA - END
+
+#endif
@@ -76,6 +76,7 @@
 #include <lattices/Lattices/LatticeStepper.h>
 #include <casa/OS/Timer.h>
 #include <casa/sstream.h>
+#include <map>
 
 namespace casa {
 
@@ -301,7 +302,7 @@ void SDGrid::findPBAsConvFunction(const ImageInterface<Complex>& image,
     const ROMSPointingColumns& act_mspc = vb.msColumns().pointing();
     // uInt pointIndex=getIndex(*mspc, vb.time()(row), vb.timeInterval()(row));
     uInt pointIndex=getIndex(act_mspc, vb.time()(row), 
-			     vb.timeInterval()(row));
+			     vb.timeInterval()(row), vb.antenna1()(row));
     if((pointIndex<0)||(pointIndex>=act_mspc.time().nrow())) {
       ostringstream o;
       o << "Failed to find pointing information for time " <<
@@ -693,19 +694,25 @@ void SDGrid::put(const VisBuffer& vb, Int row, Bool dopsf,
   Int idopsf=0;
   if(dopsf) idopsf=1;
 
+  // The positions of all rows, converted at once
+  Matrix<Double> xyPositions;
+  Vector<Bool> validPos;
+  getXYPositions(vb, startRow, endRow, xyPositions, validPos);
+
   if(isTiled) {
     for (Int rownr=startRow; rownr<=endRow; rownr++) {
       
-      if(getXYPos(vb, rownr)) {
+      if(validPos(rownr)) {
 	
-	IPosition centerLoc2D(2, Int(xyPos(0)), Int(xyPos(1)));
+	IPosition centerLoc2D(2, Int(xyPositions(0, rownr)),
+			      Int(xyPositions(1, rownr)));
 	Array<Complex>* dataPtr=getDataPointer(centerLoc2D, False);
 	Array<Float>*  wDataPtr=getWDataPointer(centerLoc2D, False);
 	Int aNx=dataPtr->shape()(0);
 	Int aNy=dataPtr->shape()(1);
 	Vector<Double> actualPos(2);
 	for (Int i=0;i<2;i++) {
-	  actualPos(i)=xyPos(i)-Double(offsetLoc(i));
+	  actualPos(i)=xyPositions(i, rownr)-Double(offsetLoc(i));
 	}
 	// Now use FORTRAN to do the gridding. Remember to 
 	// ensure that the shape and offsets of the tile are 
@@ -743,14 +750,6 @@ void SDGrid::put(const VisBuffer& vb, Int row, Bool dopsf,
     }
   }
   else {
-    Matrix<Double> xyPositions(2, endRow-startRow+1);
-    xyPositions=0.0;
-    for (Int rownr=startRow; rownr<=endRow; rownr++) {
-      if(getXYPos(vb, rownr)) {
-	xyPositions(0, rownr)=xyPos(0);
-	xyPositions(1, rownr)=xyPos(1);
-      }
-    }
     {
       Bool del;
       //      IPosition s(data.shape());
@@ -843,14 +842,20 @@ void SDGrid::get(VisBuffer& vb, Int row)
     if(vb.flagRow()(rownr)) rowFlags(rownr)=1;
   }
 
+  // The positions of all rows, converted at once
+  Matrix<Double> xyPositions;
+  Vector<Bool> validPos;
+  getXYPositions(vb, startRow, endRow, xyPositions, validPos);
+
   if(isTiled) {
     
     for (Int rownr=startRow; rownr<=endRow; rownr++) {
       
-      if(getXYPos(vb, rownr)) {
+      if(validPos(rownr)) {
 	  
 	  // Get the tile
-	IPosition centerLoc2D(2, Int(xyPos(0)), Int(xyPos(1)));
+	IPosition centerLoc2D(2, Int(xyPositions(0, rownr)),
+			      Int(xyPositions(1, rownr)));
 	Array<Complex>* dataPtr=getDataPointer(centerLoc2D, True);
 	Int aNx=dataPtr->shape()(0);
 	Int aNy=dataPtr->shape()(1);
@@ -861,7 +866,7 @@ void SDGrid::get(VisBuffer& vb, Int row)
 	Bool del;
 	Vector<Double> actualPos(2);
 	for (Int i=0;i<2;i++) {
-	  actualPos(i)=xyPos(i)-Double(offsetLoc(i));
+	  actualPos(i)=xyPositions(i, rownr)-Double(offsetLoc(i));
 	}
 	//	IPosition s(data.shape());
 	const IPosition& fs=data.shape();
@@ -889,15 +894,6 @@ void SDGrid::get(VisBuffer& vb, Int row)
     }
   }
   else {
-    Matrix<Double> xyPositions(2, endRow-startRow+1);
-    xyPositions=0.0;
-    for (Int rownr=startRow; rownr<=endRow; rownr++) {
-      if(getXYPos(vb, rownr)) {
-	xyPositions(0, rownr)=xyPos(0);
-	xyPositions(1, rownr)=xyPos(1);
-      }
-    }
-
     Bool del;
     //    IPosition s(data.shape());
     const IPosition& fs=data.shape();
@@ -984,64 +980,74 @@ void SDGrid::ok() {
   AlwaysAssert(image, AipsError);
 }
 
-// Get the index into the pointing table for this time. Note that the 
-// in the pointing table, TIME specifies the beginning of the spanned
-// time range, whereas for the main table, TIME is the centroid.
-// Note that the behavior for multiple matches is not specified! i.e.
-// if there are multiple matches, the index returned depends on the
-// history of previous matches. It is deterministic but not obvious.
-// One could cure this by searching but it would be considerably
-// costlier.
+// Get the index into the pointing table for this time and antenna. Note
+// that in the pointing table, TIME is the midpoint of the spanned time
+// range, as for the main table. The rows are looked up in an in-memory
+// index; if multiple rows match, the one with the nearest midpoint is
+// returned. If the table contains rows with a negative interval, the
+// previous match is returned if no row matches.
 Int SDGrid::getIndex(const ROMSPointingColumns& mspc, const Double& time,
-		     const Double& interval) {
-  Int start=lastIndex_p;
-  // Search forwards
-  Int nrows=mspc.time().nrow();
-  for (Int i=start;i<nrows;i++) {
-    Double midpoint = mspc.time()(i); // time in POINTING table is midpoint
-    // If the interval in the pointing table is negative, use the last
-    // entry. Note that this may be invalid (-1) but in that case 
-    // the calling routine will generate an error
-    if(mspc.interval()(i)<0.0) {
-      return lastIndex_p;
-    }
-    // Pointing table interval is specified so we have to do a match
-    else {
-      // Is the midpoint of this pointing table entry within the specified
-      // tolerance of the main table entry?
-      //if(abs(midpoint-time) < (mspc.interval()(i)/2.0)) {
-      if(abs(midpoint-time) <= (mspc.interval()(i)/2.0)) {
-      	lastIndex_p=i;
-	return i;
-      }
-    }
+		     const Double& interval, const Int& antid) {
+  pointingIndex_p.attach(mspc);
+  Int index=pointingIndex_p.find(time, antid, 0.5, True);
+  if(index>=0) {
+    lastIndex_p=index;
+    return index;
+  }
+  if(pointingIndex_p.hasNegativeInterval()) {
+    return lastIndex_p;
   }
-  // Search backwards
-  for (Int i=start;i>=0;i--) {
-    Double midpoint = mspc.time()(i); // time in POINTING table is midpoint
-    if(mspc.interval()(i)<0.0) {
-      return lastIndex_p;
+  // No match!
+  return -1;
+}
+
+// Get the pixel positions of the rows startRow..endRow of the VisBuffer.
+// Rows with the same pointing row and time (e.g. the baselines of a time
+// slot) have the same position, so the pointing direction is converted
+// only once for each distinct pointing row and time in the buffer.
+void SDGrid::getXYPositions(const VisBuffer& vb, Int startRow, Int endRow,
+			    Matrix<Double>& xyPositions, Vector<Bool>& valid)
+{
+  xyPositions.resize(2, vb.nRow());
+  xyPositions=0.0;
+  valid.resize(vb.nRow());
+  valid=False;
+  const ROMSPointingColumns& act_mspc=vb.msColumns().pointing();
+  // The first row converted for a (pointing row, time, interpolation).
+  std::map<std::pair<std::pair<Int,Bool>,Double>, Int> converted;
+  for (Int rownr=startRow; rownr<=endRow; rownr++) {
+    Int pointIndex=getIndex(act_mspc, vb.time()(rownr),
+			    vb.timeInterval()(rownr), vb.antenna1()(rownr));
+    if(pointIndex<0) {
+      continue;
+    }
+    Bool dointerp=(vb.timeInterval()(rownr) <
+		   pointingIndex_p.interval(pointIndex));
+    std::pair<std::pair<Int,Bool>,Double>
+      key(std::make_pair(pointIndex, dointerp), vb.time()(rownr));
+    std::map<std::pair<std::pair<Int,Bool>,Double>, Int>::const_iterator
+      iter=converted.find(key);
+    if(iter!=converted.end()) {
+      valid(rownr)=valid(iter->second);
+      xyPositions.column(rownr)=xyPositions.column(iter->second);
     }
-    // Pointing table interval is specified so we have to do a match
     else {
-      // Is the midpoint of this pointing table entry within the specified
-      // tolerance of the main table entry?
-      //if(abs(midpoint-time) < (mspc.interval()(i)/2.0)) {
-      if(abs(midpoint-time) <= (mspc.interval()(i)/2.0)) {
-	lastIndex_p=i;
-	return i;
+      converted[key]=rownr;
+      if(getXYPos(vb, rownr)) {
+	valid(rownr)=True;
+	xyPositions(0, rownr)=xyPos(0);
+	xyPositions(1, rownr)=xyPos(1);
       }
     }
   }
-  // No match!
-  return -1;
 }
 
 Bool SDGrid::getXYPos(const VisBuffer& vb, Int row) {
 
   Bool dointerp;
   const ROMSPointingColumns& act_mspc=vb.msColumns().pointing();
-  uInt pointIndex=getIndex(act_mspc, vb.time()(row), vb.timeInterval()(row));
+  uInt pointIndex=getIndex(act_mspc, vb.time()(row), vb.timeInterval()(row),
+			   vb.antenna1()(row));
   if((pointIndex<0)||(pointIndex>=act_mspc.time().nrow())) {
     ostringstream o;
     o << "Failed to find pointing information for time " <<
@@ -1052,7 +1058,7 @@ Bool SDGrid::getXYPos(const VisBuffer& vb, Int row) {
   }
 
   dointerp = False;
-  if (vb.timeInterval()(row)<act_mspc.interval()(pointIndex)) {
+  if (vb.timeInterval()(row)<pointingIndex_p.interval(pointIndex)) {
      dointerp=True;
   }
   MEpoch epoch(Quantity(vb.time()(row), "s"));
@@ -1161,27 +1167,34 @@ Bool SDGrid::getXYPos(const VisBuffer& vb, Int row) {
   // when data sampling rate higher than the pointing data recording 
   // (e.g. fast OTF)
   MDirection SDGrid::directionMeas(const ROMSPointingColumns& mspc, const Int& index, const Double& time){
+    // Interpolate between the neighbouring rows of the same antenna.
+    Int before, after;
+    pointingIndex_p.neighbours(index, before, after);
     Int index1, index2;
-    if(time < mspc.time()(index)) {
-      if(index > 0) {
-         index1 = index-1;
+    if(time < pointingIndex_p.time(index)) {
+      if(before >= 0) {
+         index1 = before;
          index2 = index;
       }
-      else if(index==0){
+      else {
          index1 = index;
-         index2 = index+1;
+         index2 = after;
       }
     }
     else {
-      if(index < (mspc.nrow()-1)) {
+      if(after >= 0) {
         index1 = index;
-        index2 = index+1;
+        index2 = after;
       }
-      else if(index == (mspc.nrow()-1) || (mspc.time()(index)-mspc.time()(index+1))>2*mspc.interval()(index)) {
-        index1 = index-1;
+      else {
+        index1 = before;
         index2 = index;
       }
     }
+    if(index1 < 0 || index2 < 0) {
+      // a single pointing; nothing to interpolate
+      return directionMeas(mspc, index);
+    }
     return interpolateDirectionMeas(mspc, time, index, index1, index2);
   }
 
@@ -1237,25 +1250,25 @@ Bool SDGrid::getXYPos(const VisBuffer& vb, Int row) {
     }
     dLon=dir2(0)-dir1(0);
     dLat=dir2(1)-dir1(1);
-    ftime=floor(mspc.time()(indx1));
-    ftime2=mspc.time()(indx2)-ftime;
-    ftime1=mspc.time()(indx1)-ftime;
+    ftime=floor(pointingIndex_p.time(indx1));
+    ftime2=pointingIndex_p.time(indx2)-ftime;
+    ftime1=pointingIndex_p.time(indx1)-ftime;
     dtime=ftime2-ftime1;
     scanRate(0) = dLon/dtime;
     scanRate(1) = dLat/dtime;
     //scanRate(0) = dir2(0)/dtime-dir1(0)/dtime;
     //scanRate(1) = dir2(1)/dtime-dir1(1)/dtime;
-    //Double delT = mspc.time()(index)-time;
+    //Double delT = pointingIndex_p.time(index)-time;
     //cerr<<"index="<<index<<" dLat="<<dLat<<" dtime="<<dtime<<" delT="<< delT<<endl;
     //cerr<<"deldirlat="<<scanRate(1)*fabs(delT)<<endl;
     if (isfirstRefPt) {
-      newdir(0) = dir1(0)+scanRate(0)*fabs(mspc.time()(index)-time);
-      newdir(1) = dir1(1)+scanRate(1)*fabs(mspc.time()(index)-time);
+      newdir(0) = dir1(0)+scanRate(0)*fabs(pointingIndex_p.time(index)-time);
+      newdir(1) = dir1(1)+scanRate(1)*fabs(pointingIndex_p.time(index)-time);
       rf = mspc.directionMeas(indx1).getRef();
     }
     else {
-      newdir(0) = dir2(0)-scanRate(0)*fabs(mspc.time()(index)-time);
-      newdir(1) = dir2(1)-scanRate(1)*fabs(mspc.time()(index)-time);
+      newdir(0) = dir2(0)-scanRate(0)*fabs(pointingIndex_p.time(index)-time);
+      newdir(1) = dir2(1)-scanRate(1)*fabs(pointingIndex_p.time(index)-time);
       rf = mspc.directionMeas(indx2).getRef();
     }
     //default  return this
@@ -46,6 +46,7 @@
 #include <measures/Measures/MDirection.h>
 #include <measures/Measures/MPosition.h>
 #include <coordinates/Coordinates/DirectionCoordinate.h>
+#include <synthesis/MeasurementComponents/PointingIndex.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -258,11 +259,20 @@ private:
 
   Int lastIndex_p;
 
+  // In-memory index of the POINTING table
+  PointingIndex pointingIndex_p;
+
   Int getIndex(const ROMSPointingColumns& mspc, const Double& time,
-	       const Double& interval);
+	       const Double& interval, const Int& antid=-1);
 
   Bool getXYPos(const VisBuffer& vb, Int row);
 
+  // Get the pixel positions (in xyPositions(2,nrow)) of the rows
+  // startRow..endRow of the VisBuffer, converting each distinct pointing
+  // only once. valid tells if a row has a position.
+  void getXYPositions(const VisBuffer& vb, Int startRow, Int endRow,
+		      Matrix<Double>& xyPositions, Vector<Bool>& valid);
+
   //get the MDirection from a chosen column of pointing table
   MDirection directionMeas(const ROMSPointingColumns& mspc, const Int& index);
   MDirection directionMeas(const ROMSPointingColumns& mspc, const Int& index, const Double& time);
@@ -150,10 +150,18 @@ namespace casa{
   // Compute the Parallactic Angle for the give VisBuffer
   //
   Double getPA(const VisBuffer& vb)
+  {
+    return getPA(vb, getCurrentTimeStamp(vb));
+  }
+  //
+  //---------------------------------------------------------------------
+  // Compute the Parallactic Angle at the given time
+  //
+  Double getPA(const VisBuffer& vb, const Double time)
   {
     Double pa=0;
     Int n=0;
-    Vector<Float> antPA = vb.feed_pa(getCurrentTimeStamp(vb));
+    Vector<Float> antPA = vb.feed_pa(time);
     for (uInt i=0;i<antPA.nelements();i++)
       {
 	if (!vb.msColumns().antenna().flagRow()(i))
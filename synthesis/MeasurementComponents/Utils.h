@@ -51,6 +51,7 @@ namespace casa
   Double getCurrentTimeStamp(const VisBuffer& vb);
   void makeStokesAxis(Int npol_p, Vector<String>& polType, Vector<Int>& whichStokes);
   Double getPA(const VisBuffer& vb);
+  Double getPA(const VisBuffer& vb, const Double time);
   void storeImg(String fileName,ImageInterface<Complex>& theImg, Bool writeReIm=False);
   void storeImg(String fileName,ImageInterface<Float>& theImg);
   void storeArrayAsImage(String fileName, const CoordinateSystem& coords, const Array<Complex>& cf);
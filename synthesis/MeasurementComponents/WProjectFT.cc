@@ -71,6 +71,7 @@
 #include <lattices/Lattices/LatticeExpr.h>
 #include <lattices/Lattices/LatticeCache.h>
 #include <lattices/Lattices/LatticeFFT.h>
+#include <synthesis/MeasurementComponents/MappedGrid.h>
 #include <lattices/Lattices/LatticeIterator.h>
 #include <lattices/Lattices/LatticeStepper.h>
 #include <casa/Utilities/CompositeNumber.h>
@@ -272,6 +273,50 @@ void WProjectFT::init() {
   }
 }
 
+void WProjectFT::resizeGrids(const IPosition& gridShape, Bool doDouble)
+{
+  Double gridBytes = Double(gridShape.product()) *
+    (sizeof(Complex) + (doDouble ? sizeof(DComplex) : 0));
+  Bool doMap = MappedGrid::useMapping(gridBytes,
+				      Double(cachesize)*sizeof(Complex));
+  // The lattices refer to griddedData, so they have to go before the
+  // mapping is changed.
+  if((doMap || !mappedGrid_p.null()) && !griddedData.shape().isEqual(gridShape)) {
+    arrayLattice=0;
+    lattice=0;
+    griddedData.resize();
+    griddedData2.resize();
+    mappedGrid_p=0;
+    mappedGrid2_p=0;
+  }
+  if(doMap) {
+    if(mappedGrid_p.null()) {
+      logIO() << LogOrigin("WProjectFT", "resizeGrids") << LogIO::NORMAL
+	      << "Grid of " << Int(gridBytes/(1024*1024))
+	      << " MB does not fit in memory; mapping it to disk"
+	      << LogIO::POST;
+      mappedGrid_p = new MappedGrid();
+      mappedGrid_p->map(griddedData, gridShape);
+    }
+    if(doDouble && mappedGrid2_p.null()) {
+      griddedData2.resize();
+      mappedGrid2_p = new MappedGrid();
+      mappedGrid2_p->map(griddedData2, gridShape);
+    }
+  }
+  else {
+    griddedData.resize(gridShape);
+    if(doDouble) {
+      griddedData2.resize(gridShape);
+    }
+  }
+}
+
+Double WProjectFT::fftBufferSize() const
+{
+  return max(Double(cachesize)*sizeof(Complex), 64.*1024.*1024.);
+}
+
 // This is nasty, we should use CountedPointers here.
 WProjectFT::~WProjectFT() {
   if(imageCache) delete imageCache; imageCache=0;
@@ -357,7 +402,7 @@ void WProjectFT::initializeToVis(ImageInterface<Complex>& iimage,
   }
   else {
     IPosition gridShape(4, nx, ny, npol, nchan);
-    griddedData.resize(gridShape);
+    resizeGrids(gridShape, False);
     griddedData=Complex(0.0);
     
     IPosition stride(4, 1);
@@ -407,7 +452,10 @@ void WProjectFT::initializeToVis(ImageInterface<Complex>& iimage,
   }
 
   // Now do the FFT2D in place
-  LatticeFFT::cfft2d(*lattice);
+  if(!mappedGrid_p.null())
+    MappedGrid::fft2d(griddedData, True, fftBufferSize());
+  else
+    LatticeFFT::cfft2d(*lattice);
   
   logIO() << LogIO::DEBUGGING << "Finished FFT" << LogIO::POST;
   
@@ -477,10 +525,9 @@ void WProjectFT::initializeToSky(ImageInterface<Complex>& iimage,
   }
   else {
     IPosition gridShape(4, nx, ny, npol, nchan);
-    griddedData.resize(gridShape);
+    resizeGrids(gridShape, useDoubleGrid_p);
     griddedData=Complex(0.0);
     if(useDoubleGrid_p){
-      griddedData2.resize(gridShape);
       griddedData2=DComplex(0.0);
     }
     //if(arrayLattice) delete arrayLattice; arrayLattice=0;
@@ -940,6 +987,7 @@ ImageInterface<Complex>& WProjectFT::getImage(Matrix<Float>& weights,
     if(useDoubleGrid_p){
       convertArray(griddedData, griddedData2);
       griddedData2.resize();
+      mappedGrid2_p=0;
     }
     const IPosition latticeShape = lattice->shape();
     
@@ -947,7 +995,10 @@ ImageInterface<Complex>& WProjectFT::getImage(Matrix<Float>& weights,
 	    << "Starting FFT and scaling of image" << LogIO::POST;
     
     // x and y transforms
-    LatticeFFT::cfft2d(*lattice,False);
+    if(!mappedGrid_p.null())
+      MappedGrid::fft2d(griddedData, False, fftBufferSize());
+    else
+      LatticeFFT::cfft2d(*lattice,False);
     
     {
       Int inx = lattice->shape()(0);
@@ -1143,7 +1194,7 @@ Bool WProjectFT::fromRecord(String& error, const RecordInterface& inRec)
       // Make the grid the correct shape and turn it into an array lattice
       // Check the section from the image BEFORE converting to a lattice 
       IPosition gridShape(4, nx, ny, npol, nchan);
-      griddedData.resize(gridShape);
+      resizeGrids(gridShape, False);
       griddedData=Complex(0.0);
       IPosition blc(4, (nx-image->shape()(0)+(nx%2==0))/2,
 		    (ny-image->shape()(1)+(ny%2==0))/2, 0, 0);
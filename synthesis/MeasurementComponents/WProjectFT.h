@@ -42,6 +42,7 @@
 #include <scimath/Mathematics/ConvolveGridder.h>
 #include <lattices/Lattices/LatticeCache.h>
 #include <lattices/Lattices/ArrayLattice.h>
+#include <synthesis/MeasurementComponents/MappedGrid.h>
 #include <ms/MeasurementSets/MSColumns.h>
 #include <measures/Measures/Measure.h>
 #include <measures/Measures/MDirection.h>
@@ -247,6 +248,13 @@ protected:
 
   void init();
 
+  // Resize the grid (and the double precision grid if needed) to the
+  // given shape. A grid too large for memory is mapped onto a scratch file.
+  void resizeGrids(const IPosition& gridShape, Bool doDouble);
+
+  // Size (in bytes) of the buffer used by the out-of-core FFT.
+  Double fftBufferSize() const;
+
   // Is this record on Grid? check both ends. This assumes that the
   // ends bracket the middle
   Bool recordOnGrid(const VisBuffer& vb, Int rownr) const;
@@ -264,6 +272,10 @@ protected:
   // Is this tiled?
   Bool isTiled;
 
+  // Mapped storage of griddedData and griddedData2 (if too large for
+  // memory). Declared before the arrays, so it is removed after them.
+  CountedPtr<MappedGrid> mappedGrid_p, mappedGrid2_p;
+
   // Array lattice
   CountedPtr<Lattice<Complex> > arrayLattice;
 
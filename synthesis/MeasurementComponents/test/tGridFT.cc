@@ -0,0 +1,284 @@
+//# tGridFT.cc: Test the channel mapping and gridding of GridFT
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <casa/aips.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/Arrays/ArrayMath.h>
+#include <casa/Arrays/ArrayLogical.h>
+#include <casa/iostream.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <measures/Measures/MFrequency.h>
+#include <coordinates/Coordinates/CoordinateSystem.h>
+#include <coordinates/Coordinates/CoordinateUtil.h>
+#include <coordinates/Coordinates/SpectralCoordinate.h>
+#include <images/Images/TempImage.h>
+#include <msvis/MSVis/VisibilityIterator.h>
+#include <msvis/MSVis/VisImagingWeight.h>
+#include <msvis/MSVis/VisBuffer.h>
+#include <msvis/MSVis/test/MSTestFixture.h>
+#include <synthesis/MeasurementComponents/GridFT.h>
+#include <casa/namespace.h>
+
+// The MS has 3 antennas, 2 correlations and 2 spectral windows of 4
+// channels. The channels of spw 1 lie exactly on the image channels;
+// those of spw 0 are shifted by 0.4 channel, so they map onto the same
+// image channels but need interpolation.
+const Int nChan = 4;
+const Double freq0 = 1.4e9;
+const Double chanWidth = 1e6;
+const Double spwOffset[2] = {0.4, 0};
+
+MeasurementSet createMS (const String& name)
+{
+  MeasurementSet ms = newTestMS (name);
+  addTestAntennas (ms, 3);
+  addTestField (ms);
+  addTestPolarization (ms);
+  for (Int spw=0; spw<2; ++spw) {
+    Vector<Double> freqs(nChan);
+    for (Int i=0; i<nChan; ++i) {
+      freqs[i] = freq0 + (i + spwOffset[spw]) * chanWidth;
+    }
+    addTestSpw (ms, freqs, chanWidth);
+  }
+  ms.observation().addRow();
+
+  MSColumns cols (ms);
+  // One time slot with all 3 baselines per spw. The data value of a
+  // channel is its channel number.
+  Matrix<Complex> data(2, nChan);
+  for (Int i=0; i<nChan; ++i) {
+    data.column(i) = Complex(i, 0);
+  }
+  Int row = 0;
+  for (Int spw=0; spw<2; ++spw) {
+    for (Int ant1=0; ant1<3; ++ant1) {
+      for (Int ant2=ant1+1; ant2<3; ++ant2) {
+        ms.addRow();
+        cols.time().put (row, 4.5e9);
+        cols.timeCentroid().put (row, 4.5e9);
+        cols.interval().put (row, 10.);
+        cols.exposure().put (row, 10.);
+        cols.antenna1().put (row, ant1);
+        cols.antenna2().put (row, ant2);
+        cols.dataDescId().put (row, spw);
+        Vector<Double> uvw(3, 0.);
+        uvw[0] = 100 * (ant2 - ant1);
+        uvw[1] = 30 * ant1;
+        cols.uvw().put (row, uvw);
+        cols.data().put (row, data);
+        cols.flag().put (row, Matrix<Bool>(2, nChan, False));
+        cols.flagRow().put (row, False);
+        cols.weight().put (row, Vector<Float>(2, 1.));
+        cols.sigma().put (row, Vector<Float>(2, 1.));
+        ++row;
+      }
+    }
+  }
+  return ms;
+}
+
+// An image of 32x32 pixels, 1 polarization and nChan channels lying on
+// the channels of spw 1.
+CoordinateSystem imageCoords()
+{
+  CoordinateSystem coords = CoordinateUtil::defaultCoords4D();
+  Int specIndex = coords.findCoordinate (Coordinate::SPECTRAL);
+  SpectralCoordinate spec (MFrequency::TOPO, freq0, chanWidth, 0., freq0);
+  coords.replaceCoordinate (spec, specIndex);
+  return coords;
+}
+
+// Give access to the channel mapping, the grid and the weight sums of GridFT.
+class ChanMapFT : public GridFT
+{
+public:
+  ChanMapFT() : GridFT (1000000, 16, "SF") {}
+  void setImage (ImageInterface<Complex>& img)
+    { image = &img; }
+  const Array<Complex>& grid() const
+    { return griddedData; }
+  const Matrix<Double>& sumWeights() const
+    { return sumWeight; }
+  using FTMachine::initMaps;
+  using FTMachine::chanMapAligned;
+  using FTMachine::interpolateFrequencyTogrid;
+};
+
+// Only one of the two spectral windows is aligned with the image channels.
+// The aligned spw is matched last, so a single (not per-spw) flag would
+// make the data of spw 0 bypass the interpolation.
+void testAlignedPerSpw (const MeasurementSet& ms)
+{
+  TempImage<Complex> img (IPosition(4, 32, 32, 1, nChan), imageCoords());
+  ChanMapFT ft;
+  ft.setImage (img);
+  ft.setFreqInterpolation ("linear");
+  Block<Int> sort(0);
+  VisibilityIterator vi (const_cast<MeasurementSet&>(ms), sort);
+  vi.useImagingWeight (VisImagingWeight("natural"));
+  VisBuffer vb (vi);
+  Bool first = True;
+  Int nSpw = 0;
+  for (vi.originChunks(); vi.moreChunks(); vi.nextChunk()) {
+    for (vi.origin(); vi.more(); vi++) {
+      if (first) {
+        ft.initMaps (vb);
+        AlwaysAssertExit (!ft.chanMapAligned(0));
+        AlwaysAssertExit (ft.chanMapAligned(1));
+        first = False;
+      }
+      Int spw = vb.spectralWindow();
+      Cube<Complex> data;
+      Cube<Int> flags;
+      Matrix<Float> weight;
+      Bool interpolated = ft.interpolateFrequencyTogrid
+        (vb, vb.imagingWeight(), data, flags, weight, FTMachine::OBSERVED);
+      AlwaysAssertExit (data.shape()[1] == nChan);
+      if (spw == 0) {
+        // Image channel k lies 0.4 channel below data channel k.
+        AlwaysAssertExit (interpolated);
+        for (Int k=1; k<nChan; ++k) {
+          AlwaysAssertExit (flags(0,k,0) == 0);
+          AlwaysAssertExit (near (data(0,k,0), Complex(k-0.4, 0), 1e-5));
+        }
+      } else {
+        AlwaysAssertExit (!interpolated);
+        AlwaysAssertExit (data.data() == vb.visCube().data());
+      }
+      ++nSpw;
+    }
+  }
+  AlwaysAssertExit (nSpw == 2);
+}
+
+// The weight of channel chan for Taylor term t; it is negative for the
+// odd terms of the lower channels.
+Float termWeight (Int chan, uInt t)
+{
+  Float wgt = 1;
+  for (uInt i=0; i<t; ++i) {
+    wgt *= chan - 1.5f;
+  }
+  return wgt;
+}
+
+// Put the data to a single machine with the imaging weights multiplied
+// by the weights of the given term, as MultiTermFT does per term.
+void putTerm (GridFT& ft, VisBuffer& vb, const Matrix<Float>& termWgt,
+              uInt term, Bool dopsf)
+{
+  Matrix<Float> imwgt (vb.imagingWeight().copy());
+  Matrix<Float>& wgt = vb.imagingWeight();
+  for (Int row=0; row<vb.nRow(); ++row) {
+    for (Int chan=0; chan<vb.nChannel(); ++chan) {
+      wgt(chan,row) = imwgt(chan,row) * termWgt(chan,term);
+    }
+  }
+  ft.put (vb, -1, dopsf);
+  vb.imagingWeight() = imwgt;
+}
+
+// Grid all data in a single pass with GridFT::putMultiTerm and term by
+// term with GridFT::put. The grids and weight sums must be the same.
+// With linear frequency interpolation the data of spw 0 cannot be gridded
+// in a single pass, so it has to be put per term.
+void testMultiTerm (const MeasurementSet& ms, uInt nterms, Bool dopsf,
+                    const String& interp)
+{
+  AlwaysAssertExit (nterms <= 3);
+  TempImage<Complex> img (IPosition(4, 32, 32, 1, nChan), imageCoords());
+  Block<Int> sort(0);
+  VisibilityIterator vi (const_cast<MeasurementSet&>(ms), sort);
+  vi.useImagingWeight (VisImagingWeight("natural"));
+  VisBuffer vb (vi);
+  vi.originChunks();
+  vi.origin();
+  ChanMapFT multi[3];
+  ChanMapFT single[3];
+  Block<GridFT*> terms(nterms);
+  for (uInt t=0; t<nterms; ++t) {
+    Matrix<Float> weight;
+    multi[t].setFreqInterpolation (interp);
+    single[t].setFreqInterpolation (interp);
+    multi[t].initializeToSky (img, weight, vb);
+    single[t].initializeToSky (img, weight, vb);
+    terms[t] = &multi[t];
+  }
+  Int nSpw = 0;
+  for (vi.originChunks(); vi.moreChunks(); vi.nextChunk()) {
+    for (vi.origin(); vi.more(); vi++) {
+      Matrix<Float> termWgt (vb.nChannel(), nterms);
+      for (uInt t=0; t<nterms; ++t) {
+        for (Int chan=0; chan<vb.nChannel(); ++chan) {
+          termWgt(chan,t) = termWeight (chan, t);
+        }
+      }
+      Bool done = GridFT::putMultiTerm (terms, vb, termWgt, -1, dopsf);
+      AlwaysAssertExit (done == (interp == "nearest"  ||
+                                 vb.spectralWindow() == 1));
+      for (uInt t=0; t<nterms; ++t) {
+        if (!done) {
+          putTerm (multi[t], vb, termWgt, t, dopsf);
+        }
+        putTerm (single[t], vb, termWgt, t, dopsf);
+      }
+      ++nSpw;
+    }
+  }
+  AlwaysAssertExit (nSpw == 2);
+  for (uInt t=0; t<nterms; ++t) {
+    const Array<Complex>& grid = single[t].grid();
+    Float maxAmp = max(amplitude(grid));
+    AlwaysAssertExit (maxAmp > 0);
+    AlwaysAssertExit (max(amplitude(multi[t].grid() - grid)) <= 1e-5*maxAmp);
+    AlwaysAssertExit (allNear (multi[t].sumWeights(), single[t].sumWeights(),
+                               1e-6));
+    AlwaysAssertExit (anyNE (single[t].sumWeights(), 0.));
+  }
+}
+
+int main()
+{
+  try {
+    MeasurementSet ms = createMS ("tGridFT_tmp.ms");
+    testAlignedPerSpw (ms);
+    for (uInt nterms=2; nterms<=3; ++nterms) {
+      testMultiTerm (ms, nterms, False, "nearest");
+      testMultiTerm (ms, nterms, True, "nearest");
+    }
+    testMultiTerm (ms, 2, False, "linear");
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
@@ -0,0 +1,164 @@
+//# tPointingIndex.cc: Test the in-memory index of the POINTING table
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <casa/aips.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/iostream.h>
+#include <ms/MeasurementSets/MeasurementSet.h>
+#include <ms/MeasurementSets/MSColumns.h>
+#include <msvis/MSVis/test/MSTestFixture.h>
+#include <synthesis/MeasurementComponents/PointingIndex.h>
+#include <casa/namespace.h>
+
+// The POINTING rows, in table order. Antenna 0 has 3 rows of 10 s,
+// antenna 1 has 2 rows of 4 s and a row with a negative interval, and
+// antenna 2 has no rows.
+const Int    nPoint = 6;
+const Int    pointAnt[nPoint]      = {0,   1,  0,  1,  0,  1};
+const Double pointTime[nPoint]     = {30, 12, 10, 40, 20, 22};
+const Double pointInterval[nPoint] = {10,  4, 10, -1, 10,  4};
+
+void addPointing (MeasurementSet& ms, Int ant, Double time, Double interval)
+{
+  MSPointingColumns cols (ms.pointing());
+  uInt row = ms.pointing().nrow();
+  ms.pointing().addRow();
+  cols.antennaId().put (row, ant);
+  cols.time().put (row, time);
+  cols.interval().put (row, interval);
+}
+
+MeasurementSet createMS (const String& name)
+{
+  MeasurementSet ms = newTestMS (name, False);
+  for (Int i=0; i<nPoint; ++i) {
+    addPointing (ms, pointAnt[i], pointTime[i], pointInterval[i]);
+  }
+  return ms;
+}
+
+void testFind (const PointingIndex& index)
+{
+  AlwaysAssertExit (index.nrow() == uInt(nPoint));
+  AlwaysAssertExit (index.hasNegativeInterval());
+  AlwaysAssertExit (index.time(4) == 20);
+  AlwaysAssertExit (index.interval(3) == -1);
+  // Exact matches.
+  AlwaysAssertExit (index.find (10, 0) == 2);
+  AlwaysAssertExit (index.find (20, 0) == 4);
+  AlwaysAssertExit (index.find (30, 0) == 0);
+  AlwaysAssertExit (index.find (12, 1) == 1);
+  AlwaysAssertExit (index.find (22, 1) == 5);
+  // On the boundary of two rows the first one in time is taken if the
+  // boundary is inclusive, and no row if it is not.
+  AlwaysAssertExit (index.find (15, 0, 0.5, True) == 2);
+  AlwaysAssertExit (index.find (15, 0, 0.5, False) == -1);
+  AlwaysAssertExit (index.find (14.9, 0, 0.5, False) == 2);
+  AlwaysAssertExit (index.find (15.1, 0, 0.5, False) == 4);
+  // The edges of the first and last row.
+  AlwaysAssertExit (index.find (5, 0) == 2);
+  AlwaysAssertExit (index.find (4.99, 0) == -1);
+  AlwaysAssertExit (index.find (35, 0) == 0);
+  AlwaysAssertExit (index.find (35.01, 0) == -1);
+  // With a larger tolerance the nearest midpoint is taken.
+  AlwaysAssertExit (index.find (15.5, 0, 1.0, False) == 4);
+  AlwaysAssertExit (index.find (14.5, 0, 1.0, False) == 2);
+  AlwaysAssertExit (index.find (39, 0, 1.0, False) == 0);
+  AlwaysAssertExit (index.find (40, 0, 1.0, False) == -1);
+  AlwaysAssertExit (index.find (40, 0, 1.0, True) == 0);
+  // Between the rows of antenna 1 nothing matches, although a row of
+  // antenna 0 would.
+  AlwaysAssertExit (index.find (17, 1) == -1);
+  // A row with a negative interval never matches.
+  AlwaysAssertExit (index.find (40, 1) == -1);
+  AlwaysAssertExit (index.find (40, 1, 100.) == 5);
+  // Antenna 2 has no rows, so the rows of all antennas are searched.
+  // At time 22 rows 4 (antenna 0) and 5 (antenna 1) match; row 5 has the
+  // nearest midpoint.
+  AlwaysAssertExit (index.find (22, 2) == 5);
+  AlwaysAssertExit (index.find (25, 2) == 4);
+  AlwaysAssertExit (index.find (17, 2) == 4);
+  AlwaysAssertExit (index.find (22, -1) == 5);
+  AlwaysAssertExit (index.find (22, 10) == 5);
+  AlwaysAssertExit (index.find (50, -1) == -1);
+}
+
+void testNeighbours (const PointingIndex& index)
+{
+  // The neighbours are the rows of the same antenna in time order.
+  Int before, after;
+  index.neighbours (4, before, after);
+  AlwaysAssertExit (before == 2  &&  after == 0);
+  index.neighbours (2, before, after);
+  AlwaysAssertExit (before == -1  &&  after == 4);
+  index.neighbours (0, before, after);
+  AlwaysAssertExit (before == 4  &&  after == -1);
+  index.neighbours (1, before, after);
+  AlwaysAssertExit (before == -1  &&  after == 5);
+  index.neighbours (5, before, after);
+  AlwaysAssertExit (before == 1  &&  after == 3);
+}
+
+int main()
+{
+  try {
+    MeasurementSet ms = createMS ("tPointingIndex_tmp.ms");
+    PointingIndex index;
+    AlwaysAssertExit (index.nrow() == 0);
+    AlwaysAssertExit (index.find (10, 0) == -1);
+    {
+      ROMSPointingColumns mspc (ms.pointing());
+      index.attach (mspc);
+      testFind (index);
+      testNeighbours (index);
+      // Attaching the same table again keeps the index.
+      index.attach (mspc);
+      AlwaysAssertExit (index.nrow() == uInt(nPoint));
+    }
+    // A new row is indexed when the table is attached again, also
+    // through another columns object.
+    addPointing (ms, 2, 50, 2);
+    {
+      ROMSPointingColumns mspc (ms.pointing());
+      index.attach (mspc);
+      AlwaysAssertExit (index.nrow() == uInt(nPoint+1));
+      AlwaysAssertExit (index.find (50, 2) == nPoint);
+      AlwaysAssertExit (index.find (22, 2) == -1);
+      AlwaysAssertExit (index.find (22, 3) == 5);
+      testNeighbours (index);
+    }
+    index.clear();
+    AlwaysAssertExit (index.nrow() == 0);
+    AlwaysAssertExit (!index.hasNegativeInterval());
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
@@ -34,6 +34,7 @@
 #include <lattices/Lattices/TiledLineStepper.h>
 #include <lattices/Lattices/TempLattice.h>
 #include <lattices/Lattices/LatticeIterator.h>
+#include <lattices/Lattices/LatticeStepper.h>
 #include <casa/Arrays/Slice.h>
 #include <casa/Arrays/Matrix.h>
 #include <casa/Arrays/Vector.h>
@@ -43,6 +44,9 @@
 #include <casa/Arrays/VectorIter.h>
 #include <casa/Logging/LogOrigin.h>
 #include <casa/BasicMath/Math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include <casa/Exceptions/Error.h>
 #include <casa/Utilities/Assert.h>
 #include <casa/System/PGPlotter.h>
@@ -623,16 +627,37 @@ Float CEMemModel::formFlux()
   itsModelMax = -1e+20;
 
   Lattice<Float> &model = *itsModel_ptr;
-  TiledLineStepper mtls(model.shape(), model.niceCursorShape(), 0);
-  RO_LatticeIterator<Float> mod( model, mtls); 
+  RO_LatticeIterator<Float> 
+    mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
+  Bool modDeleteIt;
   for (mod.reset(); !mod.atEnd(); mod++) {
-    for (uInt i=0;i<mod.vectorCursor().nelements();i++) {
-      itsFlux +=  mod.vectorCursor()(i);
-      if (mod.vectorCursor()(i) > itsModelMax)
-	itsModelMax = mod.vectorCursor()(i);
-      if (mod.vectorCursor()(i) < itsModelMin)
-	itsModelMin = mod.vectorCursor()(i);
+    const Float *modStore = mod.cursor().getStorage(modDeleteIt);
+    Int n = mod.cursor().nelements();
+    Double flux = 0;
+    Float modMax = itsModelMax;
+    Float modMin = itsModelMin;
+#pragma omp parallel if (n >= 16384)
+    {
+      Double tflux = 0;
+      Float tmax = modMax;
+      Float tmin = modMin;
+#pragma omp for
+      for (Int i=0;i<n;i++) {
+	tflux += modStore[i];
+	if (modStore[i] > tmax) tmax = modStore[i];
+	if (modStore[i] < tmin) tmin = modStore[i];
+      }
+#pragma omp critical(CEMemModel_formFlux)
+      {
+	flux += tflux;
+	if (tmax > modMax) modMax = tmax;
+	if (tmin < modMin) modMin = tmin;
+      }
     }
+    itsFlux += flux;
+    itsModelMax = modMax;
+    itsModelMin = modMin;
+    mod.cursor().freeStorage(modStore, modDeleteIt);
   }
   return itsFlux;
 };
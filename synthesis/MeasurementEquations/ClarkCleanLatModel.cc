@@ -27,6 +27,7 @@
 
 #include <synthesis/MeasurementEquations/ClarkCleanLatModel.h>
 #include <synthesis/MeasurementEquations/ClarkCleanProgress.h>
+#include <synthesis/MeasurementEquations/ClarkCleanMinorCycle.h>
 #include <casa/Arrays/Slice.h>
 #include <lattices/Lattices/LatticeStepper.h>
 #include <lattices/Lattices/LatticeIterator.h>
@@ -63,9 +64,6 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 #define absmaxf absmaxf_
 #define absmax2f absmax2f_
 #define absmax4f absmax4f_
-#define subcomf subcomf_
-#define subcom2f subcom2f_
-#define subcom4f subcom4f_
 #define maxabsf maxabsf_
 #define maxabs2f maxabs2f_
 #define maxabs4f maxabs4f_
@@ -102,15 +100,6 @@ extern "C" {
 		const Float * arr, const Int * npix);
   void absmax4f(Float * maxelem, Float * maxval, Int * maxpos, 
 		const Float * arr, const Int * npix);
-  void subcomf(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
-  void subcom2f(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
-  void subcom4f(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
   void maxabsf(Float * maxval, const Float * arr, const Int * npix);
   void maxabs2f(Float * maxval, const Float * arr, const Int * npix);
   void maxabs4f(Float * maxval, const Float * arr, const Int * npix);
@@ -719,6 +708,10 @@ doMinorIterations(CCList & activePixels, Matrix<Float> & psfPatch,
   // declare variables used inside the main loop
   Int curIter = 0;
   Float iterFluxLimit = std::max(fluxLimit, threshold());
+  const Int psfNx = psfPatch.nrow();
+  const Int psfNy = psfPatch.ncolumn();
+  Bool psfIsACopy;
+  const Float * psfPtr = psfPatch.getStorage(psfIsACopy);
   Float Fac = pow(fluxLimit/absRes, itsSpeedup);
 //   itsLog << "Initial maximum residual:" << maxRes 
 // 	 << " (" << absRes << ") "
@@ -732,11 +725,13 @@ doMinorIterations(CCList & activePixels, Matrix<Float> & psfPatch,
     // Add the new component to the clean components list
     cleanComponents.addComp(maxRes, maxPos);
     // Subtract the component from the current list of active pixels
-    subtractComponent(activePixels, maxRes, maxPos, psfPatch);
+    // and find the next residual
+    clarkSubtractAndFindMax(activePixels.fluxPtr(), activePixels.positionPtr(),
+			    activePixels.nComp(), npol, maxRes.storage(),
+			    maxPos.storage(), psfPtr, psfNx, psfNy,
+			    maxRes.storage(), absRes, offRes);
     // We have now done an iteration
     curIter++;
-    // find the next residual
-    maxVect(maxRes, absRes, offRes, activePixels);
     maxPosPtr =  activePixels.pixelPosition(offRes);
     maxPos.replaceStorage(2, maxPosPtr, False);
     // Update the uncertainty factors and fluxlimits
@@ -753,6 +748,7 @@ doMinorIterations(CCList & activePixels, Matrix<Float> & psfPatch,
     }
   }
 
+  psfPatch.freeStorage(psfPtr, psfIsACopy);
   itsMaxRes= absRes;
   // Now copy the clean components into the image. 
   updateModel(cleanComponents);
@@ -1160,37 +1156,6 @@ maxVect(Block<Float> & maxVal, Float & absVal, Int & offset,
   }
 }
 
-//----------------------------------------------------------------------
-void ClarkCleanLatModel::
-subtractComponent(CCList & activePixels, const Block<Float> & maxVal,
-		  const Block<Int> & maxPos, const Matrix<Float> & psfPatch) {
-  const Int nx = psfPatch.nrow();
-  const Int ny = psfPatch.ncolumn();
-  
-  const Int numComp = activePixels.nComp();
-  Float * pixFluxPtr = activePixels.fluxPtr();
-  const Int * pixPosPtr = activePixels.positionPtr();
-  const Float * maxValPtr = maxVal.storage();
-  const Int * maxPosPtr = maxPos.storage();
-  Bool psfIsACopy;
-  const Float * psfPtr = psfPatch.getStorage(psfIsACopy);
-  switch (activePixels.nPol()){
-  case 1:
-    subcomf(pixFluxPtr, pixPosPtr, &numComp, maxValPtr, maxPosPtr, 
-	    psfPtr, &nx, &ny);
-    break;
-  case 2:
-    subcom2f(pixFluxPtr, pixPosPtr, &numComp, maxValPtr, maxPosPtr, 
-	     psfPtr, &nx, &ny);
-    break;
-  case 4:
-    subcom4f(pixFluxPtr, pixPosPtr, &numComp, maxValPtr, maxPosPtr, 
-	     psfPtr, &nx, &ny);
-    break;
-  }
-  psfPatch.freeStorage(psfPtr, psfIsACopy);
-}
-
 //----------------------------------------------------------------------
 // For an Array make a vector which gives the peak beyond distance n, p(n):
 // p(0)= central value, p(n)=max value outside hypercube with side 2n-1
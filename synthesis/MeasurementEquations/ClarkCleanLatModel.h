@@ -305,8 +305,6 @@ private:
   Float maxResidual(const Lattice<Float> & residual);
   void maxVect(Block<Float> & maxVal, Float & absVal, Int & offset,
 	       const CCList & activePixels);
-  void subtractComponent(CCList & activePixels, const Block<Float> & maxVal,
-			 const Block<Int> & maxPos, const Matrix<Float> & psf);
   Float absMaxBeyondDist(const IPosition & maxDist, const IPosition & centre,
 			 const Lattice<Float> & psf);
   Bool stopnow();
@@ -0,0 +1,116 @@
+//# ClarkCleanMinorCycle.cc: The minor cycle step shared by the Clark cleans
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <synthesis/MeasurementEquations/ClarkCleanMinorCycle.h>
+#include <vector>
+#include <algorithm>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+//# These are the definitions of the fortran functions
+
+#define NEED_FORTRAN_UNDERSCORES
+
+#if defined(NEED_FORTRAN_UNDERSCORES)
+#define absmaxf absmaxf_
+#define absmax2f absmax2f_
+#define absmax4f absmax4f_
+#define subcomf subcomf_
+#define subcom2f subcom2f_
+#define subcom4f subcom4f_
+#endif
+
+extern "C" {
+  void absmaxf(Float * maxelem, Float * maxval, Int * maxpos, 
+	       const Float * arr, const Int * npix);
+  void absmax2f(Float * maxelem, Float * maxval, Int * maxpos, 
+		const Float * arr, const Int * npix);
+  void absmax4f(Float * maxelem, Float * maxval, Int * maxpos, 
+		const Float * arr, const Int * npix);
+  void subcomf(Float * pixval, const Int * pixpos, const Int * npix, 
+	       const Float * maxpix, const Int * maxpos, 
+	       const Float * psf, const Int * nx, const Int * ny);
+  void subcom2f(Float * pixval, const Int * pixpos, const Int * npix, 
+	       const Float * maxpix, const Int * maxpos, 
+	       const Float * psf, const Int * nx, const Int * ny);
+  void subcom4f(Float * pixval, const Int * pixpos, const Int * npix, 
+	       const Float * maxpix, const Int * maxpos, 
+	       const Float * psf, const Int * nx, const Int * ny);
+};
+
+void clarkSubtractAndFindMax(Float * pixVal, const Int * pixPos,
+			     const Int numPix, const Int npol,
+			     const Float * maxVal, const Int * maxPos,
+			     const Float * psf, const Int nx, const Int ny,
+			     Float * newMaxVal, Float & absVal, Int & offset)
+{
+  Int nChunk = 1;
+#ifdef _OPENMP
+  if (numPix >= 16384) {
+    nChunk = omp_get_max_threads();
+  }
+#endif
+  const Int chunkSize = (numPix + nChunk - 1) / nChunk;
+  std::vector<Float> chunkMaxVal(4*nChunk);
+  std::vector<Float> chunkAbsVal(nChunk, -1);
+  std::vector<Int> chunkOffset(nChunk, 0);
+#pragma omp parallel for num_threads(nChunk) if(nChunk > 1)
+  for (Int c = 0; c < nChunk; c++) {
+    const Int start = c*chunkSize;
+    Int n = std::min(chunkSize, numPix - start);
+    if (n > 0) {
+      Float * val = pixVal + start*npol;
+      const Int * pos = pixPos + 2*start;
+      switch (npol) {
+      case 1:
+	subcomf(val, pos, &n, maxVal, maxPos, psf, &nx, &ny);
+	absmaxf(&chunkMaxVal[4*c], &chunkAbsVal[c], &chunkOffset[c], val, &n);
+	break;
+      case 2:
+	subcom2f(val, pos, &n, maxVal, maxPos, psf, &nx, &ny);
+	absmax2f(&chunkMaxVal[4*c], &chunkAbsVal[c], &chunkOffset[c], val, &n);
+	break;
+      case 4:
+	subcom4f(val, pos, &n, maxVal, maxPos, psf, &nx, &ny);
+	absmax4f(&chunkMaxVal[4*c], &chunkAbsVal[c], &chunkOffset[c], val, &n);
+	break;
+      }
+    }
+  }
+  Int best = 0;
+  for (Int c = 1; c < nChunk; c++) {
+    if (chunkAbsVal[c] > chunkAbsVal[best]) best = c;
+  }
+  absVal = chunkAbsVal[best];
+  offset = best*chunkSize + chunkOffset[best];
+  for (Int p = 0; p < npol; p++) newMaxVal[p] = chunkMaxVal[4*best + p];
+}
+
+} //# NAMESPACE CASA - END
@@ -0,0 +1,64 @@
+//# ClarkCleanMinorCycle.h: The minor cycle step shared by the Clark cleans
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#ifndef SYNTHESIS_CLARKCLEANMINORCYCLE_H
+#define SYNTHESIS_CLARKCLEANMINORCYCLE_H
+
+#include <casa/aips.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+// <summary>
+// The minor cycle step shared by the Clark clean models
+// </summary>
+
+// <use visibility=local>
+
+// <synopsis>
+// ClarkCleanModel and ClarkCleanLatModel keep their active pixels as
+// packed flux values (npol per pixel) and (x,y) positions. Both use this
+// function in each minor iteration.
+// </synopsis>
+
+// Subtract a component from the active pixels and find the new absolute
+// maximum in the same pass. The list of active pixels is split in chunks
+// that are done in parallel by the Fortran kernels, after which the
+// largest of the chunk maxima is taken. Short lists are done serially.
+// <br>The component has flux <src>maxVal</src> (npol values) at
+// <src>maxPos</src>; <src>psf</src> is the nx by ny PSF patch. The new
+// maximum is returned in <src>newMaxVal</src> (which may be
+// <src>maxVal</src>), its absolute value in <src>absVal</src> and its
+// index in the active pixel list in <src>offset</src>.
+void clarkSubtractAndFindMax(Float * pixVal, const Int * pixPos,
+			     const Int numPix, const Int npol,
+			     const Float * maxVal, const Int * maxPos,
+			     const Float * psf, const Int nx, const Int ny,
+			     Float * newMaxVal, Float & absVal, Int & offset);
+
+} //# NAMESPACE CASA - END
+
+#endif
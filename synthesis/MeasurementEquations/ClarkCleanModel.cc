@@ -27,6 +27,7 @@
 
 #include <synthesis/MeasurementEquations/ClarkCleanModel.h>
 #include <synthesis/MeasurementEquations/ClarkCleanProgress.h>
+#include <synthesis/MeasurementEquations/ClarkCleanMinorCycle.h>
 #include <casa/Arrays/IPosition.h>
 #include <casa/Arrays/Slice.h>
 #include <casa/Arrays/Matrix.h>
@@ -57,9 +58,6 @@ namespace casa { //# NAMESPACE CASA - BEGIN
 #define absmaxf absmaxf_
 #define absmax2f absmax2f_
 #define absmax4f absmax4f_
-#define subcomf subcomf_
-#define subcom2f subcom2f_
-#define subcom4f subcom4f_
 #define maxabsf maxabsf_
 #define maxabs2f maxabs2f_
 #define maxabs4f maxabs4f_
@@ -96,15 +94,6 @@ extern "C" {
 		const Float * arr, const Int * npix);
   void absmax4f(Float * maxelem, Float * maxval, Int * maxpos, 
 		const Float * arr, const Int * npix);
-  void subcomf(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
-  void subcom2f(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
-  void subcom4f(Float * pixval, const Int * pixpos, const Int * npix, 
-	       const Float * maxpix, const Int * maxpos, 
-	       const Float * psf, const Int * nx, const Int * ny);
   void maxabsf(Float * maxval, const Float * arr, const Int * npix);
   void maxabs2f(Float * maxval, const Float * arr, const Int * npix);
   void maxabs4f(Float * maxval, const Float * arr, const Int * npix);
@@ -613,6 +602,15 @@ void ClarkCleanModel::doMinorIterations(Array<Float> & model,
   Float iterFluxLimit = max(fluxLimit, threshold());
   Float Fac = pow(fluxLimit/absRes, theSpeedup);
   IPosition position(model.ndim(), 0);
+  const Int psfNx = psfPatch.nrow();
+  const Int psfNy = psfPatch.ncolumn();
+  Bool pixValCopy, pixPosCopy, psfCopy;
+  Float * pixValPtr = pixVal.getStorage(pixValCopy);
+  const Int * pixPosPtr = pixPos.getStorage(pixPosCopy);
+  const Float * psfPtr = psfPatch.getStorage(psfCopy);
+  // maxRes and maxPos are contiguous Vectors
+  Float * maxResPtr = maxRes.data();
+  const Int * maxPosPtr = maxPos.data();
 //   theLog << "Initial maximum residual:" << maxRes 
 // 	 << " (" << absRes << ") "
 // 	 << " @ " << maxPos << endl;
@@ -641,13 +639,13 @@ void ClarkCleanModel::doMinorIterations(Array<Float> & model,
 //     theLog << " Subtracting:" << maxRes 
 //   	   << " @ " << position;
     // Subtract the component from the current list of active pixels
-    subtractComponent(pixVal, pixPos, numPix, 
-		      maxRes, maxPos, psfPatch);
+    // and find the next residual
+    clarkSubtractAndFindMax(pixValPtr, pixPosPtr, numPix, npol,
+			    maxResPtr, maxPosPtr, psfPtr, psfNx, psfNy,
+			    maxResPtr, absRes, offRes);
     // We have now done an iteration
     curIter++;
     theIterCounter++;
-    // find the next residual
-    maxVect(maxRes, absRes, offRes, pixVal, numPix);
     maxPos = pixPos.column(offRes);
 //     theLog << " After Iteration: " << curIter 
 //  	   << " the Maximum residual is:" << maxRes 
@@ -672,6 +670,9 @@ void ClarkCleanModel::doMinorIterations(Array<Float> & model,
       } 
     }
   }
+  psfPatch.freeStorage(psfPtr, psfCopy);
+  pixPos.freeStorage(pixPosPtr, pixPosCopy);
+  pixVal.putStorage(pixValPtr, pixValCopy);
   // Data returned to the main routine
   numberIterations = curIter;
   fluxLimit = absRes;
@@ -1007,51 +1008,6 @@ void ClarkCleanModel::maxVect(Vector<Float> & maxVal,
   maxVal.putStorage(maxPtr, dataCopy);
 };
 //----------------------------------------------------------------------
-void ClarkCleanModel::subtractComponent(Matrix<Float> & pixVal, 
-					const Matrix<Int> & pixPos,
-					const Int numPix,
-					const Vector<Float> & maxVal,
-					const Vector<Int> & maxPos, 
-					const Matrix<Float> & psf){
-  const Int npol = pixVal.nrow();
-  DebugAssert(npol == 1 || npol == 2 || npol == 4, AipsError);
-  DebugAssert(numPix <= Int(pixVal.ncolumn()), AipsError);
-  DebugAssert(0 < numPix , AipsError);
-  DebugAssert(pixPos.nrow() == 2, AipsError);
-  DebugAssert(pixPos.ncolumn() == pixVal.ncolumn(), AipsError);
-  DebugAssert(Int(maxVal.nelements()) == npol, AipsError);
-  DebugAssert(maxPos.nelements() == 2, AipsError);
-  const Int nx = psf.nrow();
-  const Int ny = psf.ncolumn();
-  DebugAssert(nx > 0, AipsError);
-  DebugAssert(ny > 0, AipsError);
-  
-  Bool pixValCopy, pixPosCopy, maxValCopy, maxPosCopy, psfCopy;
-  Float * pixValPtr = pixVal.getStorage(pixValCopy);
-  const Int * pixPosPtr = pixPos.getStorage(pixPosCopy);
-  const Float * maxValPtr = maxVal.getStorage(maxValCopy);
-  const Int * maxPosPtr = maxPos.getStorage(maxPosCopy);
-  const Float * psfPtr = psf.getStorage(psfCopy);
-  switch (npol){
-  case 1:
-    subcomf(pixValPtr, pixPosPtr, &numPix, maxValPtr, maxPosPtr, 
-	    psfPtr, &nx, &ny);
-    break;
-  case 2:
-    subcom2f(pixValPtr, pixPosPtr, &numPix, maxValPtr, maxPosPtr, 
-	     psfPtr, &nx, &ny);
-    break;
-  case 4:
-    subcom4f(pixValPtr, pixPosPtr, &numPix, maxValPtr, maxPosPtr, 
-	     psfPtr, &nx, &ny);
-  }
-  psf.freeStorage(psfPtr, psfCopy);
-  maxPos.freeStorage(maxPosPtr, maxPosCopy);
-  maxVal.freeStorage(maxValPtr, maxValCopy);
-  pixPos.freeStorage(pixPosPtr, pixPosCopy);
-  pixVal.putStorage(pixValPtr, pixValCopy);
-};
-//----------------------------------------------------------------------
 // For an Array make a vector which gives the peak beyond distance n, p(n):
 // p(0)= central value, p(n)=max value outside hypercube with side 2n-1
 // Distance is measured from the point centre in the array
@@ -275,9 +275,6 @@ private:
   Float maxResidual(const Array<Float> & residual);
   void maxVect(Vector<Float> & maxVal, Float & absVal, Int & offset,
 	       const Matrix<Float> & pixVal, const Int numPix);
-  void subtractComponent(Matrix<Float> & pixVal, const Matrix<Int> & pixPos,
-			 const Int numPix, const Vector<Float> & maxVal,
-			 const Vector<Int> & maxPos, const Matrix<Float> & psf);
   Float absMaxBeyondDist(const IPosition &maxDist, const IPosition &centre,
 			 const Array<Float> &array);
   Bool stopnow();
@@ -82,7 +82,8 @@ CubeSkyEquation::CubeSkyEquation(SkyModel& sm, VisSet& vs, FTMachine& ft,
   internalChangesPut_p(False),
   internalChangesGet_p(False),
   firstOneChangesPut_p(False),
-  firstOneChangesGet_p(False)
+  firstOneChangesGet_p(False),
+  bdaRowBlocking_p(0)
 {
 
     init(ft);
@@ -96,7 +97,8 @@ CubeSkyEquation::CubeSkyEquation(SkyModel& sm, ROVisibilityIterator& vi, FTMachi
   internalChangesPut_p(False),
   internalChangesGet_p(False),
   firstOneChangesPut_p(False),
-  firstOneChangesGet_p(False)
+  firstOneChangesGet_p(False),
+  bdaRowBlocking_p(0)
 {
     init(ft);
 }
@@ -481,6 +483,44 @@ void CubeSkyEquation::makeSimplePSF(PtrBlock<TempImage<Float> * >& psfs) {
     Bool changedVI=False;
     // Initialize the gradients
     sm_->initializeGradients();
+    // Averaging in time needs multiple time slots per VisBuffer
+    Int oldRowBlocking=rvi_p->getRowBlocking();
+    if(!bdAverager_p.null() && bdaRowBlocking_p > 0)
+        rvi_p->setRowBlocking(bdaRowBlocking_p);
+
+    // With asynchronous I/O a lookahead thread reads the flags and
+    // weights while the PSF is gridded.  No data column is needed.
+    ROVisibilityIterator * oldRvi = NULL;
+
+    if (ROVisibilityIteratorAsync::isAsynchronousIoEnabled()){
+        using namespace casa::asyncio;
+        PrefetchColumns prefetchColumns = ROVIA::prefetchColumns (Ant1,
+                                                                  Ant2,
+                                                                  ArrayId,
+                                                                  CorrType,
+                                                                  Feed1,
+                                                                  Feed1_pa,
+                                                                  Feed2,
+                                                                  Feed2_pa,
+                                                                  FieldId,
+                                                                  FlagCube,
+                                                                  FlagRow,
+                                                                  Freq,
+                                                                  ImagingWeight,
+                                                                  LSRFreq,
+                                                                  NChannel,
+                                                                  NCorr,
+                                                                  NRow,
+                                                                  PhaseCenter,
+                                                                  PolFrame,
+                                                                  SpW,
+                                                                  casa::asyncio::Time,
+                                                                  Uvw,
+                                                                  -1);
+        oldRvi = rvi_p;
+        rvi_p = ROVisibilityIteratorAsync::create (* rvi_p, prefetchColumns);
+        vb_p.set (rvi_p);  // detach from current vi
+    }
     ROVisIter& vi(*rvi_p);
     //Lets get the channel selection for later use
     vi.getChannelSelection(blockNumChanGroup_p, blockChanStart_p,
@@ -526,6 +566,9 @@ void CubeSkyEquation::makeSimplePSF(PtrBlock<TempImage<Float> * >& psfs) {
                     //This here forces the modelVisCube shape and prevents reading model column
                     vb->setModelVisCube(Complex(0.0,0.0));
                 }
+                //Only flags and weights matter for the psf
+                if(!bdAverager_p.null())
+                    bdAverager_p->average(* vb, False, False, False);
                 putSlice(* vb, doPSF, FTMachine::MODEL, cubeSlice, nCubeSlice);
                 cohDone+=vb->nRow();
                 pm.update(Double(cohDone));
@@ -541,6 +584,17 @@ void CubeSkyEquation::makeSimplePSF(PtrBlock<TempImage<Float> * >& psfs) {
     if(changedVI)
         vi.selectChannel(blockNumChanGroup_p, blockChanStart_p,
                          blockChanWidth_p, blockChanInc_p, blockSpw_p);
+
+    // If using async, put things back the way they were.
+
+    if (oldRvi != NULL){
+        delete vb.release(); // get rid of local attached to Vi
+        vb_p.set (oldRvi);   // reattach vb_p to the old vi
+        delete rvi_p;        // kill the new vi
+        rvi_p = oldRvi;      // make the old vi the current vi
+    }
+    if(!bdAverager_p.null() && bdaRowBlocking_p > 0)
+        rvi_p->setRowBlocking(oldRowBlocking);
     sm_->finalizeGradients();
     fixImageScale();
     for(Int model=0; model < nmodels; ++model){
@@ -659,6 +713,11 @@ void CubeSkyEquation::gradientsChiSquared(Bool /*incr*/, Bool commitModel){
 //        destroyVisibilityIterator_p = True;
 //        vb_p.set (rvi_p); // replace existing VB with a potentially async one
 
+    // Averaging in time needs multiple time slots per VisBuffer
+    Int oldRowBlocking=rvi_p->getRowBlocking();
+    if(!bdAverager_p.null() && bdaRowBlocking_p > 0)
+        rvi_p->setRowBlocking(bdaRowBlocking_p);
+
     ROVisibilityIterator * oldRvi = NULL;
 
     if (! commitModel && ROVisibilityIteratorAsync::isAsynchronousIoEnabled()){
@@ -772,6 +831,11 @@ void CubeSkyEquation::gradientsChiSquared(Bool /*incr*/, Bool commitModel){
                     //This here forces the modelVisCube shape and prevents reading model column
                     vb->setModelVisCube(Complex(0.0,0.0));
                 }
+                //Merge the samples before predicting and gridding them.
+                //Not possible if the model has to be written back.
+                if(!bdAverager_p.null() && !commitModel)
+                    bdAverager_p->average(* vb, !useCorrected, useCorrected,
+                                          predictedComp || incremental);
                 // get the model visibility and write it to the model MS
 		//	Timers tGetSlice=Timers::getTime();
 		//		Timers tgetSlice=Timers::getTime();
@@ -817,6 +881,14 @@ void CubeSkyEquation::gradientsChiSquared(Bool /*incr*/, Bool commitModel){
 	// aFinalizePutSlice += tDoneFinalizePutSlice - tFinalizePutSlice;
     }
 
+    if(!bdAverager_p.null() && bdAverager_p->nSamplesOut() > 0){
+        LogIO os(LogOrigin("CubeSkyEquation", "gradientsChiSquared"));
+        os << LogIO::DEBUG1 << "Baseline-dependent averaging gridded "
+           << bdAverager_p->nSamplesOut() << " of "
+           << bdAverager_p->nSamplesIn() << " samples" << LogIO::POST;
+        bdAverager_p->resetCounts();
+    }
+
     for (Int model=0;model<sm_->numberOfModels();model++) {
         //unScaleImage(model, incremental);
         ft_=&(*ftm_p[model]);
@@ -839,6 +911,8 @@ void CubeSkyEquation::gradientsChiSquared(Bool /*incr*/, Bool commitModel){
         delete rvi_p;        // kill the new vi
         rvi_p = oldRvi;      // make the old vi the current vi
     }
+    if(!bdAverager_p.null() && bdaRowBlocking_p > 0)
+        rvi_p->setRowBlocking(oldRowBlocking);
    // cerr << "gradChiSq: "
    // 	<< "InitGrad = " << aInitGrad.formatAverage().c_str() << " " 
    // 	<< "GetChanSel = " << aGetChanSel.formatAverage().c_str() << " " 
@@ -929,6 +1003,19 @@ void CubeSkyEquation::initializePutSlice(const VisBuffer& vb,
   vb_p->updateCoordInfo(& vb, dirDep);
 }
 
+void CubeSkyEquation::setBDAveraging(Double maxUVShift, Int maxChanGroup,
+                                     Int rowBlocking){
+  bdaRowBlocking_p=rowBlocking;
+  if(maxUVShift <= 0.0){
+    bdAverager_p=0;
+    return;
+  }
+  //Channels can only be merged if they all go to the same image plane
+  if(sm_->image(0).shape()(3) > 1)
+    maxChanGroup=1;
+  bdAverager_p=new VisBuffBDAverager(maxUVShift, maxChanGroup);
+}
+
 void CubeSkyEquation::getCoverageImage(Int model, ImageInterface<Float>& im){
   if ((sm_->doFluxScale(model)) && (ftm_p.nelements() > uInt(model))){
     ftm_p[model]->getFluxImage(im);
@@ -973,9 +1060,7 @@ CubeSkyEquation::putSlice(VisBuffer & vb, Bool dopsf, FTMachine::Type col, Int c
                 initializePutSlice(vb, cubeSlice, nCubeSlice);
             }
 
-            for (Int model=0; model<sm_->numberOfModels(); ++model){
-                     iftm_p[model]->put(vb, row, dopsf, col);
-            }
+            putAllModels(vb, row, dopsf, col);
         }
     }
     else if (IFTChanged || firstOneChangesPut_p || firstOneChangesGet_p) {
@@ -988,20 +1073,37 @@ CubeSkyEquation::putSlice(VisBuffer & vb, Bool dopsf, FTMachine::Type col, Int c
         }
         initializePutSlice(vb, cubeSlice, nCubeSlice);
         isBeginingOfSkyJonesCache_p=False;
-        for (Int model=0; model<sm_->numberOfModels(); ++model){
-                 iftm_p[model]->put(vb, -1, dopsf, col);
-        }
+        putAllModels(vb, -1, dopsf, col);
     }
     else {
-        for (Int model=0; model<sm_->numberOfModels(); ++model){
-                iftm_p[model]->put(vb, -1, dopsf, col);
-        }
+        putAllModels(vb, -1, dopsf, col);
     }
 
     isBeginingOfSkyJonesCache_p=False;
 
 }
 
+void CubeSkyEquation::putAllModels(VisBuffer& vb, Int row, Bool dopsf,
+                                   FTMachine::Type col){
+    Int nmodels=sm_->numberOfModels();
+    if(nmodels > 1 && iftm_p[0]->name()=="MultiTermFT"){
+        // Models are ordered by Taylor term, so for a single field the
+        // model index is the Taylor index.
+        Bool oneField=True;
+        Block<MultiTermFT*> terms(nmodels);
+        for (Int model=0; model<nmodels && oneField; ++model){
+            oneField=(sm_->getTaylorIndex(model)==model) &&
+                     (iftm_p[model]->name()=="MultiTermFT");
+            terms[model]=static_cast<MultiTermFT*>(&(*iftm_p[model]));
+        }
+        if(oneField && MultiTermFT::putAllTerms(terms, vb, row, dopsf, col))
+            return;
+    }
+    for (Int model=0; model<nmodels; ++model){
+        iftm_p[model]->put(vb, row, dopsf, col);
+    }
+}
+
 void CubeSkyEquation::finalizePutSlice(const VisBuffer& vb,  
 				       Int cubeSlice, Int nCubeSlice) {
 
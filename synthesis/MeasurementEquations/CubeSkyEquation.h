@@ -28,6 +28,7 @@
 #define SYNTHESIS_CUBESKYEQUATION_H
 
 #include <synthesis/MeasurementEquations/SkyEquation.h>
+#include <msvis/MSVis/VisBuffBDAverager.h>
 //#include <synthesis/Utilities/ThreadTimers.h>
 
 
@@ -74,6 +75,16 @@ class CubeSkyEquation : public SkyEquation {
 
   //Get the flux scale that the ftmachines have if they have
   virtual void getCoverageImage(Int model, ImageInterface<Float>& im);
+
+  // Average the visibilities baseline-dependently before gridding; samples
+  // are merged as long as their uv-span stays below maxUVShift (in
+  // wavelengths). Channels are only merged if the image has one channel.
+  // A maxUVShift <= 0 switches averaging off. Time averaging needs multiple
+  // time slots in a VisBuffer, so the visibility iterator is set to return
+  // rowBlocking rows at a time while gridding; the previous row blocking is
+  // restored afterwards.
+  void setBDAveraging(Double maxUVShift, Int maxChanGroup=1,
+                      Int rowBlocking=0);
  protected:
 
   //Different versions of psf making
@@ -99,6 +110,10 @@ class CubeSkyEquation : public SkyEquation {
   // about it
   void init(FTMachine& ft);
 
+  // Put the VisBuffer to the ftmachines of all models. The Taylor terms
+  // of a single field are gridded in one pass if possible.
+  void putAllModels(VisBuffer& vb, Int row, Bool dopsf, FTMachine::Type col);
+
   Bool destroyVisibilityIterator_p;
 
   Bool internalChangesPut_p;
@@ -112,6 +127,11 @@ class CubeSkyEquation : public SkyEquation {
   Block<CountedPtr<FTMachine> > ftm_p;
   Block<CountedPtr<FTMachine> > iftm_p;
 
+  // Baseline-dependent averager (null if not used)
+  CountedPtr<VisBuffBDAverager> bdAverager_p;
+  // Row blocking used while averaging
+  Int bdaRowBlocking_p;
+
   // DT aInitGrad, aGetChanSel, aCheckVisRows, aGetFreq, aOrigChunks, aVBInValid, aInitGetSlice, aInitPutSlice, aPutSlice, aFinalizeGetSlice, aFinalizePutSlice, aChangeStokes, aInitModel, aGetSlice, aSetModel, aGetRes, aExtra;
 
 };
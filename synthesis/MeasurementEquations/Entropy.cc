@@ -33,9 +33,205 @@
 #include <lattices/Lattices/LatticeStepper.h>
 #include <lattices/Lattices/LatticeIterator.h>
 #include <casa/BasicMath/Math.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
+namespace {
+
+  // Entropy gradient and inverse Hessian diagonal of a pixel for I*log(I).
+  struct GradEntropyI {
+    GradEntropyI (Float ggc, Float logDef) : itsGgc(ggc), itsLogDef(logDef) {}
+    void operator() (Float mod, const Float *pri, Int i,
+		     Double &gradH, Float &rHess) const {
+      rHess = mod/(1 + itsGgc * mod);
+      if (pri) {
+	gradH = -log( mod / pri[i]);
+      } else {
+	gradH = -log(mod) + itsLogDef;
+      }
+    }
+    Float itsGgc;
+    Float itsLogDef;
+  };
+
+  // Entropy gradient and inverse Hessian diagonal of a pixel for
+  // maximum emptiness.
+  struct GradEmptiness {
+    GradEmptiness (Float ggc, Float defLev, Float aFit)
+      : itsGgc(ggc), itsDefLev(defLev), itsAFit(aFit) {}
+    void operator() (Float mod, const Float *pri, Int i,
+		     Double &gradH, Float &rHess) const {
+      if (pri) {
+	gradH = -tanh( (mod - pri[i])/itsAFit );
+      } else {
+	gradH = -tanh( (mod - itsDefLev)/itsAFit );
+      }
+      rHess = 1.0/( square(1.0-gradH)/itsAFit + itsGgc) ;
+    }
+    Float itsGgc;
+    Float itsDefLev;
+    Float itsAFit;
+  };
+
+  // Accumulate the GDG sums (HH, HC, HF, CC, CF, FF) of a chunk of pixels
+  // and fill the step if needed. The gradients and the step are computed
+  // in the same pass; the sums are reduced over the threads.
+  template<class Grad> struct GDGChunk {
+    GDGChunk (const Grad &grad, Float alpha, Float beta)
+      : itsGrad(grad), itsAlpha(alpha), itsBeta(beta)
+    { for (uInt k=0; k<6; k++) itsSums[k] = 0.0; }
+    void operator() (Int n, const Float *mod, const Float *res,
+		     const Float *mas, const Float *pri, Float *stp) {
+      Double hh=0, hc=0, hf=0, cc=0, cf=0, ff=0;
+#pragma omp parallel for reduction(+:hh,hc,hf,cc,cf,ff) if (n >= 16384)
+      for (Int i=0; i<n; i++) {
+	if (mas == 0  ||  mas[i] > 0.0) {
+	  Double gradH;
+	  Float rHess;
+	  itsGrad (mod[i], pri, i, gradH, rHess);
+	  Double gradC = -2*res[i];
+	  if (stp) {
+	    Double gradJ = gradH - itsAlpha*gradC - itsBeta;
+	    stp[i] = rHess * gradJ;
+	  }
+	  hh += gradH * rHess * gradH;
+	  hc += gradH * rHess * gradC;
+	  hf += gradH * rHess;
+	  cc += gradC * rHess * gradC;
+	  cf += gradC * rHess;
+	  ff += rHess;
+	}
+      }
+      itsSums[0] += hh; itsSums[1] += hc; itsSums[2] += hf;
+      itsSums[3] += cc; itsSums[4] += cf; itsSums[5] += ff;
+    }
+    Grad itsGrad;
+    Float itsAlpha;
+    Float itsBeta;
+    Double itsSums[6];
+  };
+
+  // Accumulate the gradient dot step of a chunk of pixels.
+  // If WeightByMask is True, each pixel is weighted by its mask value
+  // (as EntropyEmptiness does) instead of being selected by mask > 0.
+  template<class Grad, Bool WeightByMask> struct GDSChunk {
+    GDSChunk (const Grad &grad, Float alpha, Float beta)
+      : itsGrad(grad), itsAlpha(alpha), itsBeta(beta), itsGDS(0.0) {}
+    void operator() (Int n, const Float *mod, const Float *res,
+		     const Float *mas, const Float *pri, Float *stp) {
+      Double gds = 0;
+#pragma omp parallel for reduction(+:gds) if (n >= 16384)
+      for (Int i=0; i<n; i++) {
+	if (WeightByMask  ||  mas == 0  ||  mas[i] > 0.0) {
+	  Double gradH;
+	  Float rHess;
+	  itsGrad (mod[i], pri, i, gradH, rHess);
+	  Double term = stp[i] * (gradH + 2.0*itsAlpha * res[i] - itsBeta);
+	  if (WeightByMask  &&  mas) {
+	    term *= mas[i];
+	  }
+	  gds += term;
+	}
+      }
+      itsGDS += gds;
+    }
+    Grad itsGrad;
+    Float itsAlpha;
+    Float itsBeta;
+    Double itsGDS;
+  };
+
+  // Accumulate -I*log(I/prior) (or -I*log(I) without prior) of a chunk.
+  struct EntropyIChunk {
+    EntropyIChunk() : itsSum(0.0) {}
+    void operator() (Int n, const Float *mod, const Float *,
+		     const Float *mas, const Float *pri, Float *) {
+      Double ent = 0;
+#pragma omp parallel for reduction(+:ent) if (n >= 16384)
+      for (Int i=0; i<n; i++) {
+	if (mas == 0  ||  mas[i] > 0.0) {
+	  if (pri) {
+	    ent -= mod[i] * log( mod[i] / pri[i] );
+	  } else {
+	    ent -= mod[i] * log( mod[i] );
+	  }
+	}
+      }
+      itsSum += ent;
+    }
+    Double itsSum;
+  };
+
+  // Iterate synchronously over the model and the optional residual, mask,
+  // prior and step lattices and apply the chunk function to each cursor.
+  // The step is only written back if writeStep is True.
+  template<class Chunk>
+  void iterateMem (Chunk &chunk, Lattice<Float> &model,
+		   Lattice<Float> *resid, Lattice<Float> *mask,
+		   Lattice<Float> *prior, Lattice<Float> *step,
+		   Bool writeStep)
+  {
+    LatticeStepper stepper(model.shape(), model.niceCursorShape());
+    RO_LatticeIterator<Float> mod(model, stepper);
+    RO_LatticeIterator<Float> *res = 0;
+    RO_LatticeIterator<Float> *mas = 0;
+    RO_LatticeIterator<Float> *pri = 0;
+    LatticeIterator<Float> *stp = 0;
+    if (resid) res = new RO_LatticeIterator<Float>(*resid, stepper);
+    if (mask)  mas = new RO_LatticeIterator<Float>(*mask, stepper);
+    if (prior) pri = new RO_LatticeIterator<Float>(*prior, stepper);
+    if (step)  stp = new LatticeIterator<Float>(*step, stepper);
+    Bool modDeleteIt, resDeleteIt, masDeleteIt, priDeleteIt, stpDeleteIt;
+    for (mod.reset(); !mod.atEnd(); mod++) {
+      const Float *modStore = mod.cursor().getStorage(modDeleteIt);
+      const Float *resStore = res ? res->cursor().getStorage(resDeleteIt) : 0;
+      const Float *masStore = mas ? mas->cursor().getStorage(masDeleteIt) : 0;
+      const Float *priStore = pri ? pri->cursor().getStorage(priDeleteIt) : 0;
+      Float *stpStore = 0;
+      if (stp) {
+	if (writeStep) {
+	  stpStore = stp->rwCursor().getStorage(stpDeleteIt);
+	} else {
+	  stpStore = const_cast<Float*>(stp->cursor().getStorage(stpDeleteIt));
+	}
+      }
+      chunk (mod.cursor().nelements(), modStore, resStore, masStore,
+	     priStore, stpStore);
+      mod.cursor().freeStorage(modStore, modDeleteIt);
+      if (res) {
+	res->cursor().freeStorage(resStore, resDeleteIt);
+	(*res)++;
+      }
+      if (mas) {
+	mas->cursor().freeStorage(masStore, masDeleteIt);
+	(*mas)++;
+      }
+      if (pri) {
+	pri->cursor().freeStorage(priStore, priDeleteIt);
+	(*pri)++;
+      }
+      if (stp) {
+	if (writeStep) {
+	  stp->rwCursor().putStorage(stpStore, stpDeleteIt);
+	} else {
+	  const Float *cstpStore = stpStore;
+	  stp->cursor().freeStorage(cstpStore, stpDeleteIt);
+	}
+	(*stp)++;
+      }
+    }
+    delete res;
+    delete mas;
+    delete pri;
+    delete stp;
+  }
+
+}
+
+
 //----------------------------------------------------------------------
 Entropy::Entropy()
 {
@@ -53,6 +249,32 @@ Entropy::~Entropy()
 
 
 
+//----------------------------------------------------------------------
+void Entropy::fillGDG(Matrix<Double>& GDG, const Double* sums,
+		      Float alpha, Float beta)
+{
+  Double GDGHH = sums[0];
+  Double GDGHC = sums[1];
+  Double GDGHF = sums[2];
+  Double GDGCC = sums[3];
+  Double GDGCF = sums[4];
+  Double GDGFF = sums[5];
+  GDG.resize(4,4);
+  GDG.set(0.0);
+  GDG(H,H) = GDGHH;
+  GDG(H,C) = GDGHC;
+  GDG(H,F) = GDGHF;
+  GDG(C,C) = GDGCC;
+  GDG(C,F) = GDGCF;
+  GDG(F,F) = GDGFF;
+  GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
+  GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
+  GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
+  GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
+    + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
+    - 2*alpha*GDGHC - 2*beta*GDGHF;
+}
+
 //----------------------------------------------------------------------
 EntropyI::EntropyI()
 {
@@ -80,87 +302,20 @@ Float EntropyI::formEntropy()
 
   cemem_ptr->itsFlux = flux;
   Float defLev = cemem_ptr->itsDefaultLevel;
-  LatticeExprNode myEntropyLEN;
-  Float myEntropy = 0;
-
-  if (cemem_ptr->itsMask_ptr) {
-    
-    Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
 
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-    
-    if (cemem_ptr->itsPrior_ptr) {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(model.shape(), model.niceCursorShape()));
-      uInt i;
-      Bool modDeleteIt;
-      Bool masDeleteIt;
-      Bool priDeleteIt;
-      
-      for (mod.reset(), mas.reset(), pri.reset(); !mod.atEnd(); mod++, mas++, pri++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *modIter = modStore;
-	const Float *masIter = masStore;
-	const Float *priIter = priStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, masIter++, priIter++) {
-	  if (*masIter > 0.0) {
-	    myEntropy -=  ( *modIter * log( *modIter / *priIter ) );
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-    } else {
-      
-      uInt i;
-      Bool modDeleteIt;
-      Bool masDeleteIt;
-      for (mod.reset(), mas.reset(); !mod.atEnd(); mod++, mas++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *modIter = modStore;
-	const Float *masIter = masStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    myEntropy -=  ( *modIter * log( *modIter ) );
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-      }
-      myEntropy +=  flux * log(defLev);
-    }    
-    if (flux > 0.0) {
-      myEntropy = myEntropy/flux + 
-	log(cemem_ptr->itsNumberPixels);
-    } else {
-      myEntropy = 0.0;
-    }
-    
-  } else { // No Mask;  Oh for the joy of LEL!
-    
-    if (cemem_ptr->itsPrior_ptr) {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      myEntropyLEN = - sum(model * log(model/prior)) ;
-      myEntropy = myEntropyLEN.getFloat();
-    } else {
-      myEntropyLEN = - sum(model * log(model)) ;
-      myEntropy = myEntropyLEN.getFloat() + flux * log(defLev);
-    }
-    if (flux > 0.0) {
-      myEntropy = myEntropy/flux + 
-	log(cemem_ptr->itsNumberPixels);
-    } else {
-      myEntropy = 0.0;
-    }
+  // The masked pixels and the prior are handled by the chunk function.
+  EntropyIChunk chunk;
+  iterateMem (chunk, model, 0, cemem_ptr->itsMask_ptr,
+	      cemem_ptr->itsPrior_ptr, 0, False);
+  Float myEntropy = chunk.itsSum;
+  if (cemem_ptr->itsPrior_ptr == 0) {
+    myEntropy +=  flux * log(defLev);
+  }
+  if (flux > 0.0) {
+    myEntropy = myEntropy/flux + 
+      log(cemem_ptr->itsNumberPixels);
+  } else {
+    myEntropy = 0.0;
   }
 
   return myEntropy;
@@ -171,559 +326,45 @@ Float EntropyI::formEntropy()
 //----------------------------------------------------------------------
 void EntropyI::formGDG(Matrix<Double>& GDG)
 {
-  if (cemem_ptr->itsMask_ptr) {
-    Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-    Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
-    
-    GDG.resize(4,4);
-    GDG.set(0.0);
-    Float alpha = cemem_ptr->itsAlpha;
-    Float beta  = cemem_ptr->itsBeta;
-    Float defLev = cemem_ptr->itsDefaultLevel;
-    
-    // should not use Lattice Expression Language for efficiency
-    // using it right now to get up and running
-    Float ggc = 2 * alpha * cemem_ptr->itsQ;
-    Float rHess;
-    
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      res( resid, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-    uInt i;
-    Bool modDeleteIt;
-    Bool resDeleteIt;
-    Bool masDeleteIt; 
-    Double GDGHH = 0.0;
-    Double GDGHC = 0.0;
-    Double GDGHF = 0.0;
-    Double GDGCC = 0.0;
-    Double GDGCF = 0.0;
-    Double GDGFF = 0.0;
-    Double gradH = 0.0;
-    Double gradC = 0.0;
-    if (cemem_ptr->itsPrior_ptr ==  0) {
-      Float logDef = log(defLev);
-      for (mod.reset(), res.reset(), mas.reset(); !mod.atEnd(); mod++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    rHess = (*modIter)/(1 + ggc * (*modIter));
-	    gradH = -log(*modIter) + logDef;
-	    gradC = -2*(*resIter);
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), mas.reset(), pri.reset(); !mod.atEnd(); 
-	   mod++, res++, mas++, pri++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	const Float *priIter = priStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, masIter++, priIter++) {
-	  if (*masIter > 0.0) {
-	    rHess = (*modIter)/(1 + ggc* (*modIter));
-	    gradH = -log( (*modIter) / (*priIter));
-	    gradC = -2*(*resIter);
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
- 	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-    }
-    GDG(H,H) = GDGHH;
-    GDG(H,C) = GDGHC;
-    GDG(H,F) = GDGHF;
-    GDG(C,C) = GDGCC;
-    GDG(C,F) = GDGCF;
-    GDG(F,F) = GDGFF;
-    GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-    GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-    GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-    GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-      + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-      - 2*alpha*GDGHC - 2*beta*GDGHF;
-
-  } else { // no mask
-
-    Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-    Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);    
-    GDG.resize(4,4);
-    GDG.set(0.0);
-    Float alpha = cemem_ptr->itsAlpha;
-    Float beta  = cemem_ptr->itsBeta;
-    Float defLev = cemem_ptr->itsDefaultLevel;
-    
-    // should not use Lattice Expression Language for efficiency
-    // using it right now to get up and running
-    Float ggc = 2 * alpha * cemem_ptr->itsQ;
-    Float rHess;
-    
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      res( resid, LatticeStepper(model.shape(), model.niceCursorShape()));
-    uInt i;
-    Bool modDeleteIt;
-    Bool resDeleteIt;
-    Double GDGHH = 0.0;
-    Double GDGHC = 0.0;
-    Double GDGHF = 0.0;
-    Double GDGCC = 0.0;
-    Double GDGCF = 0.0;
-    Double GDGFF = 0.0;
-    Double gradH = 0.0;
-    Double gradC = 0.0;
-    if (cemem_ptr->itsPrior_ptr ==  0) {
-      Float logDef = log(defLev);
-      for (mod.reset(), res.reset(); !mod.atEnd(); mod++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++) {
-	  rHess = (*modIter)/(1 + ggc * (*modIter));
-	  gradH = -log(*modIter) + logDef;
-	  gradC = -2*(*resIter);
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(); !mod.atEnd(); mod++, res++, pri++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *priIter = priStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, priIter++) {
-	  rHess = (*modIter)/(1 + ggc* (*modIter));
-	  gradH = -log( (*modIter) / (*priIter));
-	  gradC = -2*(*resIter);
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-    }
-    GDG(H,H) = GDGHH;
-    GDG(H,C) = GDGHC;
-    GDG(H,F) = GDGHF;
-    GDG(C,C) = GDGCC;
-    GDG(C,F) = GDGCF;
-    GDG(F,F) = GDGFF;
-    GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-    GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-    GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-    GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-      + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-      - 2*alpha*GDGHC - 2*beta*GDGHF;
-  }
+  Float alpha = cemem_ptr->itsAlpha;
+  Float beta  = cemem_ptr->itsBeta;
+  Float ggc = 2 * alpha * cemem_ptr->itsQ;
+  GDGChunk<GradEntropyI> chunk (GradEntropyI(ggc,
+					     log(cemem_ptr->itsDefaultLevel)),
+				alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr, 0, False);
+  fillGDG (GDG, chunk.itsSums, alpha, beta);
 };
 
 //----------------------------------------------------------------------
 void EntropyI::formGDGStep(Matrix<Double>& GDG)
 {
-
-  if (cemem_ptr->itsMask_ptr) {
-
-    Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-    Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-    Lattice<Float> &step  = *(cemem_ptr->itsStep_ptr);
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
-
-    GDG.resize(4,4);
-    GDG.set(0.0);
-    Float alpha = cemem_ptr->itsAlpha;
-    Float beta  = cemem_ptr->itsBeta;
-    Float defLev = cemem_ptr->itsDefaultLevel;
-    
-    // should not use Lattice Expression Language for efficiency
-    // using it right now to get up and running
-    Float ggc = 2 * alpha * cemem_ptr->itsQ;
-    Float rHess;
-    
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      res( resid, LatticeStepper(resid.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-    LatticeIterator<Float> 
-      stp( step, LatticeStepper(step.shape(), model.niceCursorShape()));
-    uInt i;
-    Bool modDeleteIt;
-    Bool resDeleteIt;
-    Bool stpDeleteIt;
-    Bool masDeleteIt;
-    Double GDGHH = 0.0;
-    Double GDGHC = 0.0;
-    Double GDGHF = 0.0;
-    Double GDGCC = 0.0;
-    Double GDGCF = 0.0;
-    Double GDGFF = 0.0;
-    Double gradH = 0.0;
-    Double gradC = 0.0;
-    Double gradJ = 0.0;
-    Float stepValue;
-    if ( cemem_ptr->itsPrior_ptr == 0) {
-      Float logDef = log(defLev);
-      for (mod.reset(), res.reset(), mas.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, stp++, mas++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, stpIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    rHess = (*modIter)/(1 + ggc * (*modIter));
-	    gradH = -log(*modIter) + logDef;
-	    gradC = -2*(*resIter);
-	    gradJ = gradH - alpha*gradC - beta;
-	    stepValue = rHess * gradJ;
-	    (*stpIter) = stepValue;
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-       }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(), mas.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, pri++, mas++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *priIter = priStore;
-	const Float *masIter = masStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();
-	     i++,modIter++, resIter++, priIter++, stpIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    rHess = (*modIter)/(1 + ggc* (*modIter));
-	    gradH = -log( (*modIter) / (*priIter));
-	    gradC = -2*(*resIter);
-	    gradJ = gradH - alpha*gradC - beta;
-	    stepValue = rHess * gradJ;
-	    (*stpIter) = stepValue;
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    }
-    GDG(H,H) = GDGHH;
-    GDG(H,C) = GDGHC;
-    GDG(H,F) = GDGHF;
-    GDG(C,C) = GDGCC;
-    GDG(C,F) = GDGCF;
-    GDG(F,F) = GDGFF;
-    GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-    GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-    GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-    GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-      + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-      - 2*alpha*GDGHC - 2*beta*GDGHF;
-
-
-  } else { // no mask
-
-
-    Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-    Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-    Lattice<Float> &step  = *(cemem_ptr->itsStep_ptr);
-    
-    GDG.resize(4,4);
-    GDG.set(0.0);
-    Float alpha = cemem_ptr->itsAlpha;
-    Float beta  = cemem_ptr->itsBeta;
-    Float defLev = cemem_ptr->itsDefaultLevel;
-    
-    Float ggc = 2 * alpha * cemem_ptr->itsQ;
-    Float rHess;
-    
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      res( resid, LatticeStepper(resid.shape(), model.niceCursorShape()));
-    LatticeIterator<Float> 
-      stp( step, LatticeStepper(step.shape(), model.niceCursorShape()));
-    uInt i;
-    Bool modDeleteIt;
-    Bool resDeleteIt;
-    Bool stpDeleteIt;
-    Double GDGHH = 0.0;
-    Double GDGHC = 0.0;
-    Double GDGHF = 0.0;
-    Double GDGCC = 0.0;
-    Double GDGCF = 0.0;
-    Double GDGFF = 0.0;
-    Double gradH = 0.0;
-    Double gradC = 0.0;
-    Double gradJ = 0.0;
-    Float stepValue;
-    if ( cemem_ptr->itsPrior_ptr == 0) {
-      Float logDef = log(defLev);
-      for (mod.reset(), res.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, stpIter++) {
-	  rHess = (*modIter)/(1 + ggc * (*modIter));
-	  gradH = -log(*modIter) + logDef;
-	  gradC = -2*(*resIter);
-	  gradJ = gradH - alpha*gradC - beta;
-	  stepValue = rHess * gradJ;
-	  (*stpIter) = stepValue;
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, pri++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *priIter = priStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();
-	     i++,modIter++, resIter++, priIter++, stpIter++) {
-	  rHess = (*modIter)/(1 + ggc* (*modIter));
-	  gradH = -log( (*modIter) / (*priIter));
-	  gradC = -2*(*resIter);
-	  gradJ = gradH - alpha*gradC - beta;
-	  stepValue = rHess * gradJ;
-	  (*stpIter) = stepValue;
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    }
-    GDG(H,H) = GDGHH;
-    GDG(H,C) = GDGHC;
-    GDG(H,F) = GDGHF;
-    GDG(C,C) = GDGCC;
-    GDG(C,F) = GDGCF;
-    GDG(F,F) = GDGFF;
-    GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-    GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-    GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-    GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-      + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-      - 2*alpha*GDGHC - 2*beta*GDGHF;
-
-  }
-
+  Float alpha = cemem_ptr->itsAlpha;
+  Float beta  = cemem_ptr->itsBeta;
+  Float ggc = 2 * alpha * cemem_ptr->itsQ;
+  GDGChunk<GradEntropyI> chunk (GradEntropyI(ggc,
+					     log(cemem_ptr->itsDefaultLevel)),
+				alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr,
+	      cemem_ptr->itsStep_ptr, True);
+  fillGDG (GDG, chunk.itsSums, alpha, beta);
 };
 
 //----------------------------------------------------------------------
 Double EntropyI::formGDS()
 {
-  Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-  Lattice<Float> &step  = *(cemem_ptr->itsStep_ptr);
-  Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-
   Float alpha = cemem_ptr->itsAlpha;
   Float beta = cemem_ptr->itsBeta;
-  Float defLev = cemem_ptr->itsDefaultLevel;
-
-  Double gds = 0;
-
-  if (cemem_ptr->itsMask_ptr) { // Do Mask
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
-
-    RO_LatticeIterator<Float> 
-      mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-    LatticeIterator<Float> 
-      stp( step, LatticeStepper(step.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      res( resid, LatticeStepper(resid.shape(), model.niceCursorShape()));
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-    Bool modDeleteIt;
-    Bool masDeleteIt;
-    Bool stpDeleteIt;
-    Bool resDeleteIt;
-    Bool priDeleteIt;
-
-    if (cemem_ptr->itsPrior_ptr) { // mask AND prior
-
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(model.shape(), model.niceCursorShape()));
-
-
-      for (mod.reset(), mas.reset(), pri.reset(), res.reset(), stp.reset();
-	   !mod.atEnd(); mod++, mas++, pri++, stp++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *stpStore = stp.cursor().getStorage(stpDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *modIter = modStore;
-	const Float *masIter = masStore;
-	const Float *priIter = priStore;
-	const Float *stpIter = stpStore;
-	const Float *resIter = resStore;
-	for (uInt i=0;i<mod.cursor().nelements();
-	     i++,modIter++, masIter++, priIter++, stpIter++,resIter++ ) {
-	  if (*masIter > 0.0) {
-	    gds += (*stpIter) * (-log( (*modIter)/(*priIter) ) + 2.0*alpha * (*resIter) - beta);
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	stp.cursor().freeStorage(stpStore, stpDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-
-    }  else {  // Mask, but no prior
-      
-      Float logDefLev = log(defLev);
-      for (mod.reset(), mas.reset(), res.reset(), stp.reset();
-	   !mod.atEnd(); mod++, mas++, stp++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *stpStore = stp.cursor().getStorage(stpDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *modIter = modStore;
-	const Float *masIter = masStore;
-	const Float *stpIter = stpStore;
-	const Float *resIter = resStore;
-	for (uInt i=0;i<mod.cursor().nelements();i++,modIter++, masIter++, stpIter++, resIter++) {
-	  if (*masIter > 0.0) {
-	    gds += (*stpIter) * (-log( *modIter ) +logDefLev + 2.0*alpha * (*resIter) - beta);
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	stp.cursor().freeStorage(stpStore, stpDeleteIt);
-      }
-    }
-
-  }  else {  // No Mask
-
-    if (cemem_ptr->itsPrior_ptr == 0) {
-      Float logDefLev = log(defLev);
-      gds = sum( step *
-		 ( -log(model)+logDefLev+2.0*alpha * resid -beta)).getDouble();
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      gds = sum( step *
-		 ( -log(model/prior) + 2.0*alpha * resid - beta)).getDouble();
-    }
-  }
-  
-  return gds;
-
+  Float ggc = 2 * alpha * cemem_ptr->itsQ;
+  GDSChunk<GradEntropyI, False> chunk (GradEntropyI(ggc,
+						    log(cemem_ptr->itsDefaultLevel)),
+				       alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr,
+	      cemem_ptr->itsStep_ptr, False);
+  return chunk.itsGDS;
 };
 
 
@@ -840,368 +481,33 @@ Float EntropyEmptiness::formEntropy()
 //----------------------------------------------------------------------
 void EntropyEmptiness::formGDG(Matrix<Double>& GDG)
 {
-  Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-  Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-
-  GDG.resize(4,4);
-  GDG.set(0.0);
-  Float aFit = cemem_ptr->itsAFit;
   Float alpha = cemem_ptr->itsAlpha;
   Float beta  = cemem_ptr->itsBeta;
-
   Float ggc = 2 * alpha * cemem_ptr->itsQ;
-  Float rHess;
-
-  RO_LatticeIterator<Float> 
-    mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-  RO_LatticeIterator<Float> 
-    res( resid, LatticeStepper(model.shape(), model.niceCursorShape()));
-  uInt i;
-  Bool modDeleteIt;
-  Bool resDeleteIt;
-  Bool masDeleteIt;
-  Double GDGHH = 0.0;
-  Double GDGHC = 0.0;
-  Double GDGHF = 0.0;
-  Double GDGCC = 0.0;
-  Double GDGCF = 0.0;
-  Double GDGFF = 0.0;
-  Double gradH = 0.0;
-  Double gradC = 0.0;
-
-  if (cemem_ptr->itsMask_ptr) { // Do MASK
-
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-
-    if (cemem_ptr->itsPrior_ptr ==  0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      for (mod.reset(), res.reset(); !mod.atEnd(); mod++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    gradH = -tanh( (*modIter - defLev)/aFit );
-	    rHess = 1.0/( square(1.0-gradH) /aFit + ggc) ;
-	    gradC = -2*(*resIter);
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(); !mod.atEnd(); mod++, res++, pri++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	const Float *priIter = priStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, masIter++, priIter++) {
-	  if (*masIter > 0.0) {
-	    gradH = -tanh( (*modIter - *priIter)/aFit );
-	    rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	    gradC = -2*(*resIter);
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-    }
-
-  }  else {  // No Mask
-
-    if (cemem_ptr->itsPrior_ptr ==  0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      for (mod.reset(), res.reset(); !mod.atEnd(); mod++, res++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++) {
-	  gradH = -tanh( (*modIter - defLev)/aFit );
-	  rHess = 1.0/( square(1.0-gradH) /aFit + ggc) ;
-	  gradC = -2*(*resIter);
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(); !mod.atEnd(); mod++, res++, pri++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *priIter = priStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, priIter++) {
-	  gradH = -tanh( (*modIter - *priIter)/aFit );
-	  rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	  gradC = -2*(*resIter);
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-      }
-    }
-
-  }
-  GDG(H,H) = GDGHH;
-  GDG(H,C) = GDGHC;
-  GDG(H,F) = GDGHF;
-  GDG(C,C) = GDGCC;
-  GDG(C,F) = GDGCF;
-  GDG(F,F) = GDGFF;
-  GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-  GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-  GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-  GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-    + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-    - 2*alpha*GDGHC - 2*beta*GDGHF;
+  GDGChunk<GradEmptiness> chunk (GradEmptiness(ggc,
+					       cemem_ptr->itsDefaultLevel,
+					       cemem_ptr->itsAFit),
+				 alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr, 0, False);
+  fillGDG (GDG, chunk.itsSums, alpha, beta);
 };
 
 
 //----------------------------------------------------------------------
 void EntropyEmptiness::formGDGStep(Matrix<Double>& GDG)
 {
-  Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-  Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
-  Lattice<Float> &step  = *(cemem_ptr->itsStep_ptr);
-
-  GDG.resize(4,4);
-  GDG.set(0.0);
   Float alpha = cemem_ptr->itsAlpha;
   Float beta  = cemem_ptr->itsBeta;
-  Float aFit = cemem_ptr->itsAFit;
-
-  // should not use Lattice Expression Language for efficiency
-  // using it right now to get up and running
   Float ggc = 2 * alpha * cemem_ptr->itsQ;
-  Float rHess;
-
-  RO_LatticeIterator<Float> 
-    mod( model, LatticeStepper(model.shape(), model.niceCursorShape()));
-  RO_LatticeIterator<Float> 
-    res( resid, LatticeStepper(resid.shape(), model.niceCursorShape()));
-  LatticeIterator<Float> 
-    stp( step, LatticeStepper(step.shape(), model.niceCursorShape()));
-  uInt i;
-  Bool modDeleteIt;
-  Bool resDeleteIt;
-  Bool stpDeleteIt;
-  Bool masDeleteIt;
-  Double GDGHH = 0.0;
-  Double GDGHC = 0.0;
-  Double GDGHF = 0.0;
-  Double GDGCC = 0.0;
-  Double GDGCF = 0.0;
-  Double GDGFF = 0.0;
-  Double gradH = 0.0;
-  Double gradC = 0.0;
-  Double gradJ = 0.0;
-  Float stepValue;
-
-  if (cemem_ptr->itsMask_ptr) { // Mask
-    Lattice<Float> &mask  = *(cemem_ptr->itsMask_ptr);
-    RO_LatticeIterator<Float> 
-      mas( mask, LatticeStepper(model.shape(), model.niceCursorShape()));
-
-    if ( cemem_ptr->itsPrior_ptr == 0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      for (mod.reset(), res.reset(), stp.reset(), mas.reset(); 
-	   !mod.atEnd(); mod++, res++, stp++, mas++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, stpIter++, masIter++) {
-	  if (*masIter > 0.0) {
-	    gradH = -tanh( (*modIter - defLev)/aFit );
-	    rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	    gradC = -2*(*resIter);
-	    gradJ = gradH - alpha*gradC - beta;
-	    stepValue = rHess * gradJ;
-	    (*stpIter) = stepValue;
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), mas.reset(), pri.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, mas++, pri++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *masStore = mas.cursor().getStorage(masDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *masIter = masStore;
-	const Float *priIter = priStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();
-	     i++,modIter++, resIter++, masIter++, priIter++, stpIter++) {
-	  if (*masIter > 0.0) {
-	    gradH = -tanh( (*modIter - *priIter)/aFit );
-	    rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	    gradC = -2*(*resIter);
-	    gradJ = gradH - alpha*gradC - beta;
-	    stepValue = rHess * gradJ;
-	    (*stpIter) = stepValue;
-	    GDGHH = GDGHH + gradH * rHess * gradH;
-	    GDGHC = GDGHC + gradH * rHess * gradC;
-	    GDGHF = GDGHF + gradH * rHess;
-	    GDGCC = GDGCC + gradC * rHess * gradC;
-	    GDGCF = GDGCF + gradC * rHess;
-	    GDGFF = GDGFF + rHess;
-	  }
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	mas.cursor().freeStorage(masStore, masDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    }
-
-  } else { // No Mask
-
-    if ( cemem_ptr->itsPrior_ptr == 0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      for (mod.reset(), res.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();i++,modIter++, resIter++, stpIter++) {
-	  gradH = -tanh( (*modIter - defLev)/aFit );
-	  rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	  gradC = -2*(*resIter);
-	  gradJ = gradH - alpha*gradC - beta;
-	  stepValue = rHess * gradJ;
-	  (*stpIter) = stepValue;
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      RO_LatticeIterator<Float> 
-	pri( prior, LatticeStepper(prior.shape(), model.niceCursorShape()));    
-      Bool priDeleteIt;
-      for (mod.reset(), res.reset(), pri.reset(), stp.reset(); 
-	   !mod.atEnd(); mod++, res++, pri++, stp++) {
-	const Float *modStore = mod.cursor().getStorage(modDeleteIt);
-	const Float *resStore = res.cursor().getStorage(resDeleteIt);
-	const Float *priStore = pri.cursor().getStorage(priDeleteIt);
-	Float *stpStore = stp.rwCursor().getStorage(stpDeleteIt);
-	const Float *modIter = modStore;
-	const Float *resIter = resStore;
-	const Float *priIter = priStore;
-	Float *stpIter = stpStore;
-	for (i=0;i<mod.cursor().nelements();
-	     i++,modIter++, resIter++, priIter++, stpIter++) {
-	  gradH = -tanh( (*modIter - *priIter)/aFit );
-	  rHess = 1.0/( square(1.0-gradH)/aFit + ggc) ;
-	  gradC = -2*(*resIter);
-	  gradJ = gradH - alpha*gradC - beta;
-	  stepValue = rHess * gradJ;
-	  (*stpIter) = stepValue;
-	  GDGHH = GDGHH + gradH * rHess * gradH;
-	  GDGHC = GDGHC + gradH * rHess * gradC;
-	  GDGHF = GDGHF + gradH * rHess;
-	  GDGCC = GDGCC + gradC * rHess * gradC;
-	  GDGCF = GDGCF + gradC * rHess;
-	  GDGFF = GDGFF + rHess;
-	}
-	mod.cursor().freeStorage(modStore, modDeleteIt);
-	res.cursor().freeStorage(resStore, resDeleteIt);
-	pri.cursor().freeStorage(priStore, priDeleteIt);
-	stp.rwCursor().putStorage(stpStore, stpDeleteIt);
-      }
-    }
-  }
-  GDG(H,H) = GDGHH;
-  GDG(H,C) = GDGHC;
-  GDG(H,F) = GDGHF;
-  GDG(C,C) = GDGCC;
-  GDG(C,F) = GDGCF;
-  GDG(F,F) = GDGFF;
-  GDG(H,J) = GDGHH -  alpha * GDGHC - beta * GDGHF;
-  GDG(C,J) = GDGHC -  alpha * GDGCC - beta * GDGCF;
-  GDG(F,J) = GDGHF -  alpha * GDGCF - beta * GDGFF;
-  GDG(J,J) = GDGHH +  square(alpha) * GDGCC 
-    + square(beta)*GDGFF  + 2*alpha*beta*GDGCF  
-    - 2*alpha*GDGHC - 2*beta*GDGHF;
+  GDGChunk<GradEmptiness> chunk (GradEmptiness(ggc,
+					       cemem_ptr->itsDefaultLevel,
+					       cemem_ptr->itsAFit),
+				 alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr,
+	      cemem_ptr->itsStep_ptr, True);
+  fillGDG (GDG, chunk.itsSums, alpha, beta);
 };
 
 
@@ -1209,43 +515,17 @@ void EntropyEmptiness::formGDGStep(Matrix<Double>& GDG)
 //----------------------------------------------------------------------
 Double EntropyEmptiness::formGDS()
 {
-  Lattice<Float> &model = *(cemem_ptr->itsModel_ptr);
-  Lattice<Float> &step  = *(cemem_ptr->itsStep_ptr);
-  Lattice<Float> &resid = *(cemem_ptr->itsResidual_ptr);
   Float alpha = cemem_ptr->itsAlpha;
   Float beta = cemem_ptr->itsBeta;
-  Float aFit = cemem_ptr->itsAFit;
-
-  Double gds = 0;
-
-  if (cemem_ptr->itsMask_ptr) {
-    Lattice<Float> &mask = *(cemem_ptr->itsMask_ptr);
- 
-    if (cemem_ptr->itsPrior_ptr == 0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      gds = sum( mask * (step *
-		 (-tanh((model - defLev)/aFit) + 2.0*alpha * resid -beta)))
-	.getDouble();
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      gds = sum( mask * (step *
-		 (-tanh((model - prior)/aFit) + 2.0*alpha * resid -beta)))
-	.getDouble();
-    }
-  }  else {  // no mask
-    if (cemem_ptr->itsPrior_ptr == 0) {
-      Float defLev = cemem_ptr->itsDefaultLevel;
-      gds = sum( step *
-		 (-tanh((model - defLev)/aFit) + 2.0*alpha * resid -beta))
-	.getDouble();
-    } else {
-      Lattice<Float> &prior = *(cemem_ptr->itsPrior_ptr);
-      gds = sum( step *
-		 (-tanh((model - prior)/aFit) + 2.0*alpha * resid -beta))
-	.getDouble();
-    }
-  }
-  return gds;
+  Float ggc = 2 * alpha * cemem_ptr->itsQ;
+  GDSChunk<GradEmptiness, True> chunk (GradEmptiness(ggc,
+						     cemem_ptr->itsDefaultLevel,
+						     cemem_ptr->itsAFit),
+				       alpha, beta);
+  iterateMem (chunk, *(cemem_ptr->itsModel_ptr), cemem_ptr->itsResidual_ptr,
+	      cemem_ptr->itsMask_ptr, cemem_ptr->itsPrior_ptr,
+	      cemem_ptr->itsStep_ptr, False);
+  return chunk.itsGDS;
 };
 
 
@@ -149,6 +149,10 @@ class Entropy
 
   
   enum GRADTYPE {H=0, C, F, J };
+
+  // Form the GDG matrix from the sums HH, HC, HF, CC, CF and FF.
+  void fillGDG(Matrix<Double>& GDG, const Double* sums,
+               Float alpha, Float beta);
   
   
   CEMemModel *cemem_ptr;
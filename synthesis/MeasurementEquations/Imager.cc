@@ -303,6 +303,8 @@ traceEvent(1,"Entering imager::defaults",25);
   singlePrec_p=False;
   spwchansels_p.resize();
   flatnoise_p=True;
+  bdaTolerance_p=0.0;
+  bdaMaxChanGroup_p=1;
 #ifdef PABLO_IO
   traceEvent(1,"Exiting imager::defaults",24);
 #endif
@@ -397,6 +399,8 @@ Imager &Imager::operator=(const Imager & other)
     }
     imageTileVol_p=other.imageTileVol_p;
     flatnoise_p=other.flatnoise_p;
+    bdaTolerance_p=other.bdaTolerance_p;
+    bdaMaxChanGroup_p=other.bdaMaxChanGroup_p;
   }
   return *this;
 }
@@ -1669,6 +1673,18 @@ Bool Imager::setmfcontrol(const Float cyclefactor,
   return True;
 }  
 
+Bool Imager::setbdaveraging(const Double tolerance, const Int maxchangroup)
+{
+  LogIO os(LogOrigin("imager", "setbdaveraging()", WHERE));
+  if(maxchangroup < 1){
+    os << LogIO::SEVERE << "maxchangroup must be >= 1" << LogIO::POST;
+    return False;
+  }
+  bdaTolerance_p=tolerance;
+  bdaMaxChanGroup_p=maxchangroup;
+  return True;
+}
+
 
 Bool Imager::setvp(const Bool dovp,
 		   const Bool doDefaultVPs,
@@ -3247,9 +3263,62 @@ Bool Imager::makeimage(const String& type, const String& image,
     if (!ft_p)
       createFTMachine();
     
-    // Now make the required image
+    // Now make the required image.  With asynchronous I/O enabled, a
+    // lookahead thread reads the visibilities of all MSs while the
+    // FTMachine grids the ones read before.
     Matrix<Float> weight;
-    ft_p->makeImage(seType, *rvi_p, cImageImage, weight);
+    Bool useCorrected= !(rvi_p->msColumns().correctedData().isNull());
+    if((seType==FTMachine::CORRECTED) && (!useCorrected))
+      seType=FTMachine::OBSERVED;
+    if (!doSD && ROVisibilityIteratorAsync::isAsynchronousIoEnabled()) {
+      using namespace casa::asyncio;
+      PrefetchColumns prefetchColumns = ROVIA::prefetchColumns (Ant1,
+                                                                Ant2,
+                                                                ArrayId,
+                                                                CorrType,
+                                                                Feed1,
+                                                                Feed1_pa,
+                                                                Feed2,
+                                                                Feed2_pa,
+                                                                FieldId,
+                                                                FlagCube,
+                                                                FlagRow,
+                                                                Freq,
+                                                                ImagingWeight,
+                                                                LSRFreq,
+                                                                NChannel,
+                                                                NCorr,
+                                                                NRow,
+                                                                PhaseCenter,
+                                                                PolFrame,
+                                                                SpW,
+                                                                casa::asyncio::Time,
+                                                                Uvw,
+                                                                -1);
+      switch (seType) {
+      case FTMachine::RESIDUAL:
+        prefetchColumns.insert (CorrectedCube);
+        prefetchColumns.insert (ModelCube);
+        break;
+      case FTMachine::MODEL:
+        prefetchColumns.insert (ModelCube);
+        break;
+      case FTMachine::CORRECTED:
+        prefetchColumns.insert (CorrectedCube);
+        break;
+      case FTMachine::PSF:
+      case FTMachine::COVERAGE:
+        break;
+      default:
+        prefetchColumns.insert (ObservedCube);
+        break;
+      }
+      CountedPtr<ROVisibilityIterator> asyncVi
+        (ROVisibilityIteratorAsync::create (*rvi_p, prefetchColumns));
+      ft_p->makeImage(seType, *asyncVi, cImageImage, weight);
+    } else {
+      ft_p->makeImage(seType, *rvi_p, cImageImage, weight);
+    }
     StokesImageUtil::To(imageImage, cImageImage);
     imageImage.setUnits(Unit("Jy/beam"));
     cImageImage.setUnits(Unit("Jy/beam"));
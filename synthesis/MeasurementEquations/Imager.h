@@ -432,6 +432,14 @@ class Imager
 		    const Float constPB,
 		    const Vector<String>& fluxscale,
 		    const Bool flatnoise=True);
+
+  // Baseline-dependent averaging of the visibilities before gridding.
+  // Samples of a baseline are merged in time (and in frequency if the image
+  // has a single channel) as long as their uv-span stays below tolerance
+  // times the uv-cell size of the image (1/field of view).
+  // A tolerance <= 0 switches it off. maxchangroup limits the number of
+  // channels merged. It is only used by the ft and wproject FTMachines.
+  Bool setbdaveraging(const Double tolerance, const Int maxchangroup=1);
   
   // Feathering algorithm
   Bool feather(const String& image,
@@ -657,6 +665,10 @@ protected:
 
   Bool flatnoise_p;
 
+  // Baseline-dependent averaging parameters (see setbdaveraging)
+  Double bdaTolerance_p;
+  Int bdaMaxChanGroup_p;
+
   // Set the defaults
   void defaults();
 
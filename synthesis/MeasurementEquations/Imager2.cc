@@ -4157,7 +4157,24 @@ void Imager::setSkyEquation(){
 //     se_p = new SkyEquation(*sm_p, *vs_p, *ft_p, *cft_p, !useModelCol_p);
 //    }
 //  else
-  se_p = new CubeSkyEquation(*sm_p, *rvi_p, *ft_p, *cft_p, !useModelCol_p);
+  CubeSkyEquation* cse = new CubeSkyEquation(*sm_p, *rvi_p, *ft_p, *cft_p,
+                                             !useModelCol_p);
+  se_p = cse;
+  if(bdaTolerance_p > 0.0 &&
+     (ft_p->name()=="GridFT" || ft_p->name()=="WProjectFT")){
+    LogIO os(LogOrigin("imager", "setSkyEquation()", WHERE));
+    // The uv-cell size of the image is 1/(field of view)
+    Double fov=max(nx_p*mcellx_p.get("rad").getValue(),
+                   ny_p*mcelly_p.get("rad").getValue());
+    // Time averaging needs multiple time slots in a VisBuffer; the sky
+    // equation only uses this row blocking while gridding.
+    Int nAnt=ms_p->antenna().nrow();
+    cse->setBDAveraging(bdaTolerance_p/fov, bdaMaxChanGroup_p,
+                        max(1000, 64*nAnt*(nAnt+1)/2));
+    os << LogIO::NORMAL
+       << "Baseline-dependent averaging with a uv-shift of at most "
+       << bdaTolerance_p << " uv-cell" << LogIO::POST;
+  }
   return;
 }
 
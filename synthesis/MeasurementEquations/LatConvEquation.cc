@@ -31,15 +31,70 @@
 #include <lattices/Lattices/LatticeExprNode.h>
 #include <lattices/Lattices/SubLattice.h>
 #include <lattices/Lattices/LCBox.h>
+#include <lattices/Lattices/LatticeIterator.h>
+#include <lattices/Lattices/LatticeStepper.h>
 #include <casa/Utilities/Assert.h>
 #include <casa/Arrays/Vector.h>
 #include <casa/Arrays/Array.h>
 #include <casa/Arrays/ArrayMath.h>
 #include <casa/Arrays/IPosition.h>
 #include <casa/Exceptions/Error.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
+// Replace result by (meas - result) * mask (meas and mask are optional)
+// and return the sum of squares of the new result. It is done in a single
+// pass over the lattices instead of a pass for each lattice expression.
+static Double subtractAndSumSquares(Lattice<Float> & result,
+                                    const Lattice<Float> * meas,
+                                    const Lattice<Float> * mask)
+{
+  LatticeStepper stepper(result.shape(), result.niceCursorShape());
+  LatticeIterator<Float> res(result, stepper);
+  RO_LatticeIterator<Float> *mea = 0;
+  RO_LatticeIterator<Float> *mas = 0;
+  if (meas) {
+    mea = new RO_LatticeIterator<Float>(*meas, stepper);
+  }
+  if (mask) {
+    mas = new RO_LatticeIterator<Float>(*mask, stepper);
+  }
+  Double chisq = 0;
+  Bool resDeleteIt, meaDeleteIt, masDeleteIt;
+  for (res.reset(); !res.atEnd(); res++) {
+    Float *resStore = res.rwCursor().getStorage(resDeleteIt);
+    const Float *meaStore = mea ? mea->cursor().getStorage(meaDeleteIt) : 0;
+    const Float *masStore = mas ? mas->cursor().getStorage(masDeleteIt) : 0;
+    Int n = res.rwCursor().nelements();
+    Double sumsq = 0;
+#pragma omp parallel for reduction(+:sumsq) if (n >= 16384)
+    for (Int i=0; i<n; i++) {
+      Float val = meaStore ? meaStore[i] - resStore[i] : resStore[i];
+      if (masStore) {
+        val *= masStore[i];
+      }
+      resStore[i] = val;
+      sumsq += val * val;
+    }
+    chisq += sumsq;
+    res.rwCursor().putStorage(resStore, resDeleteIt);
+    if (mea) {
+      mea->cursor().freeStorage(meaStore, meaDeleteIt);
+      (*mea)++;
+    }
+    if (mas) {
+      mas->cursor().freeStorage(masStore, masDeleteIt);
+      (*mas)++;
+    }
+  }
+  delete mea;
+  delete mas;
+  return chisq;
+}
+
 LatConvEquation::LatConvEquation(Lattice<Float> & psf, 
 				 Lattice<Float> & dirtyImage)
   :itsMeas(&dirtyImage),
@@ -173,8 +228,7 @@ Bool LatConvEquation::residual(Lattice<Float> & result,
 			       const LinearModel< Lattice<Float> > & model) {
 
   if (evaluate(result, model)) {
-    LatticeExpr<Float> expr = *itsMeas - result;
-    result.copyData(expr);
+    subtractAndSumSquares(result, itsMeas, 0);
     return True;
   }
   return False;
@@ -184,9 +238,8 @@ Bool LatConvEquation::residual(Lattice<Float> & result,
 Bool LatConvEquation::residual(Lattice<Float> & result, 
 			       Float & chisq,
 			       const LinearModel<Lattice<Float> > & model) {
-  if (residual(result, model)) {
-    LatticeExprNode myChisq = sum(result * result);
-    chisq = myChisq.getFloat();
+  if (evaluate(result, model)) {
+    chisq = subtractAndSumSquares(result, itsMeas, 0);
     return True;
   }
   return False;
@@ -197,10 +250,8 @@ Bool LatConvEquation::residual(Lattice<Float> & result,
 			       Float & chisq,
 			       Lattice<Float> & mask,
 			       const LinearModel<Lattice<Float> > & model) {
-  if (residual(result, model)) {
-    result.copyData( (LatticeExpr<Float>) (result * mask) );
-    LatticeExprNode myChisq = sum(result * result);
-    chisq = myChisq.getFloat();
+  if (evaluate(result, model)) {
+    chisq = subtractAndSumSquares(result, itsMeas, &mask);
     return True;
   }
   return False;
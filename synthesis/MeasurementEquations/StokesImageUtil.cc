@@ -52,11 +52,15 @@
 #include <synthesis/MeasurementEquations/StokesImageUtil.h>
 #include <images/Images/PagedImage.h>
 #include <images/Images/SubImage.h>
+#include <images/Images/TempImage.h>
 #include <casa/OS/File.h>
+#include <casa/OS/HostInfo.h>
+#include <casa/Utilities/CountedPtr.h>
 
 #include <casa/Quanta/UnitMap.h>
 #include <casa/Quanta/UnitVal.h>
 #include <measures/Measures/Stokes.h>
+#include <msvis/MSVis/AsynchronousTools.h>
 #include <coordinates/Coordinates/CoordinateSystem.h>
 #include <coordinates/Coordinates/DirectionCoordinate.h>
 #include <coordinates/Coordinates/SpectralCoordinate.h>
@@ -67,6 +71,11 @@
 
 
 #include <casa/iostream.h>
+#include <list>
+#include <vector>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace casa {
 
@@ -95,7 +104,132 @@ namespace casa {
 // <todo asof="">
 // </todo>
 
+// The transfer functions of the most recently used PSFs, most recent
+// first.  Restoring the planes of a cube, or a series of images with the
+// same beam, then needs only one FFT of the PSF.  A PSF is recognized by
+// its shape and two checksums, so the PSF itself is not kept.  The cache
+// is guarded by a mutex; callers get a copy of the transfer function, so
+// no array storage (with its non-atomic reference count) is shared
+// outside it.
+struct ConvolveTransfer {
+  IPosition shape;
+  Double sum;
+  Double weightedSum;
+  Matrix<Complex> xfr;
+};
+static std::list<ConvolveTransfer> convolveTransferCache;
+static const uInt convolveTransferCacheSize = 2;
+static async::Mutex convolveTransferMutex;
+
+static Matrix<Complex> convolveTransfer(const Matrix<Float>& psf)
+{
+  // The pixels are also summed with weights that vary with the position,
+  // so PSFs with the same pixel values in other places differ.
+  Double sum = 0;
+  Double weightedSum = 0;
+  Bool deleteIt;
+  const Float* data = psf.getStorage(deleteIt);
+  uInt n = psf.nelements();
+  for (uInt i=0; i<n; i++) {
+    sum += data[i];
+    weightedSum += data[i] * Double(i%1021 + 1);
+  }
+  psf.freeStorage(data, deleteIt);
+
+  async::MutexLocker locker(convolveTransferMutex);
+  for (std::list<ConvolveTransfer>::iterator iter=convolveTransferCache.begin();
+       iter!=convolveTransferCache.end(); ++iter) {
+    if (iter->shape.isEqual(psf.shape()) && iter->sum == sum &&
+        iter->weightedSum == weightedSum) {
+      convolveTransferCache.splice(convolveTransferCache.begin(),
+                                   convolveTransferCache, iter);
+      return convolveTransferCache.front().xfr.copy();
+    }
+  }
+  ConvolveTransfer entry;
+  entry.shape = psf.shape();
+  entry.sum = sum;
+  entry.weightedSum = weightedSum;
+  FFTServer<Float,Complex> fft(psf.shape());
+  fft.fft0(entry.xfr, psf);
+  convolveTransferCache.push_front(entry);
+  if (convolveTransferCache.size() > convolveTransferCacheSize) {
+    convolveTransferCache.pop_back();
+  }
+  return entry.xfr.copy();
+}
+
+// The non-zero pixels of the PSF as offsets in the (flipped) image plane,
+// used to convolve sparse planes directly.
+struct ConvolvePSF {
+  std::vector<Int> x;
+  std::vector<Int> y;
+  std::vector<Float> value;
+};
+
+// Convolve a plane in place.  If the plane has few enough non-zero pixels
+// (as a model of clean components usually has), the PSF is added directly
+// for each of them; otherwise the plane is multiplied by the transfer
+// function in the Fourier domain.  Both give the same circular convolution.
+static void convolvePlane(Matrix<Float>& plane, Matrix<Complex>& cft,
+                          const Complex* xfr,
+                          FFTServer<Float,Complex>& fwd,
+                          FFTServer<Float,Complex>& bwd,
+                          const ConvolvePSF& psf, Double maxDirect)
+{
+  Int nx = plane.nrow();
+  Int ny = plane.ncolumn();
+  Bool deleteIt;
+  Float* data = plane.getStorage(deleteIt);
+  Int nPsf = psf.value.size();
+  if (nPsf > 0) {
+    // Count the non-zero pixels up to the number where the FFT is cheaper.
+    Int maxPixels = Int(maxDirect / nPsf);
+    Int nPixels = 0;
+    for (Int i=0; i<nx*ny && nPixels<=maxPixels; i++) {
+      if (data[i] != 0) nPixels++;
+    }
+    if (nPixels <= maxPixels) {
+      std::vector<Int> pixels;
+      pixels.reserve(nPixels);
+      std::vector<Float> values;
+      values.reserve(nPixels);
+      for (Int i=0; i<nx*ny; i++) {
+        if (data[i] != 0) {
+          pixels.push_back(i);
+          values.push_back(data[i]);
+          data[i] = 0;
+        }
+      }
+      for (uInt k=0; k<pixels.size(); k++) {
+        Int i = pixels[k] % nx;
+        Int j = pixels[k] / nx;
+        for (Int p=0; p<nPsf; p++) {
+          Int x = i + psf.x[p];
+          if (x >= nx) x -= nx;
+          Int y = j + psf.y[p];
+          if (y >= ny) y -= ny;
+          data[x + y*nx] += values[k] * psf.value[p];
+        }
+      }
+      plane.putStorage(data, deleteIt);
+      return;
+    }
+  }
+  plane.putStorage(data, deleteIt);
+  fwd.fft0(cft, plane);
+  Complex* cdata = cft.data();
+  Int nc = cft.nelements();
+  for (Int i=0; i<nc; i++) {
+    cdata[i] *= xfr[i];
+  }
+  bwd.fft0(plane, cft, False);
+  bwd.flip(plane, False, False);
+}
+
 // In-place convolve. image is 4 dimensional. RA and Dec first.
+// The transfer function of the PSF is cached, and the planes are
+// convolved in parallel if OpenMP is used.
 void StokesImageUtil::Convolve(ImageInterface<Float>& image,
 			       ImageInterface<Float>& psf) {
   
@@ -108,33 +242,84 @@ void StokesImageUtil::Convolve(ImageInterface<Float>& image,
   Int nx = image.shape()(map(0));
   Int ny = image.shape()(map(1));
   
-  // Make FFT machine
-  FFTServer<Float,Complex> fft(IPosition(2, nx, ny));
-  
-  // Get the image into a Matrix for Fourier transformation
-  Array<Complex> xfr;
-  Matrix<Complex> cft;
-  
-  LatticeStepper ls(image.shape(), IPosition(4, nx, ny, 1, 1),
-		    IPosition(4, map(0), map(1), map(2), map(3)));
-  LatticeIterator<Float> li(image, ls);
-  
-  // Get the PSF into a Matrix for Fourier transformation
+  // Get the PSF into a Matrix and find its transfer function
   LatticeStepper psfls(psf.shape(), IPosition(4, nx, ny, 1, 1),
 		       IPosition(4, map(0), map(1), map(2), map(3)));
   RO_LatticeIterator<Float> psfli(psf, psfls);
   psfli.reset();
-  //fft.fft(xfr, psfli.matrixCursor());
-  fft.fft0(xfr, psfli.matrixCursor());
-  
-  // Loop over all planes
-  for (li.reset();!li.atEnd();li++) {
-    //fft.fft(cft, li.matrixCursor());
-    fft.fft0(cft,li.matrixCursor());
-    cft *= xfr;
-    // fft.fft(li.rwMatrixCursor(), cft);
-    fft.fft0(li.rwMatrixCursor(),cft,False);
-    fft.flip(li.rwMatrixCursor(), False, False);
+  Matrix<Float> psfPlane(psfli.matrixCursor().copy());
+  Matrix<Complex> xfr(convolveTransfer(psfPlane));
+  const Complex* xfrData = xfr.data();
+
+  // The non-zero PSF pixels for direct convolution, shifted like the
+  // flip of the FFT result.  Only done for even sizes, where the shift
+  // of flip is exactly half the size.
+  ConvolvePSF directPsf;
+  if (nx%2 == 0 && ny%2 == 0) {
+    for (Int j=0; j<ny; j++) {
+      for (Int i=0; i<nx; i++) {
+        if (psfPlane(i,j) != 0) {
+          directPsf.x.push_back((i + nx/2) % nx);
+          directPsf.y.push_back((j + ny/2) % ny);
+          directPsf.value.push_back(psfPlane(i,j));
+        }
+      }
+    }
+  }
+  // Direct convolution is used while it takes fewer operations than
+  // the two FFTs.
+  Double maxDirect = 2. * nx * ny * log(Double(nx) * ny) / log(2.);
+
+  // Find the planes to convolve
+  LatticeStepper ls(image.shape(), IPosition(4, nx, ny, 1, 1),
+		    IPosition(4, map(0), map(1), map(2), map(3)));
+  IPosition cursorShape(ls.cursorShape());
+  std::vector<IPosition> planes;
+  for (ls.reset(); !ls.atEnd(); ls++) {
+    planes.push_back(ls.position());
+  }
+  Int nThreads = 1;
+#ifdef _OPENMP
+  nThreads = max(1, min(omp_get_max_threads(), Int(planes.size())));
+#endif
+  // Each thread needs a real and a complex plane plus the buffers of its
+  // two FFT servers; limit the number of threads so these take at most
+  // 1/8 of the memory.
+  Double threadBytes = Double(nx) * ny * (sizeof(Float) + 3*sizeof(Complex));
+  Double maxBytes = Double(HostInfo::memoryTotal(true)) * 1024. / 8.;
+  nThreads = max(1, min(nThreads, Int(maxBytes / threadBytes)));
+
+  // Each thread gets its own work arrays and its own FFT servers for the
+  // forward and the backward transform, so the FFT plans are made once.
+  // The servers are primed here, because planning is not thread-safe.
+  std::vector<Matrix<Float> > work(nThreads);
+  std::vector<Matrix<Complex> > cft(nThreads);
+  std::vector<CountedPtr<FFTServer<Float,Complex> > > fwd(nThreads);
+  std::vector<CountedPtr<FFTServer<Float,Complex> > > bwd(nThreads);
+  for (Int t=0; t<nThreads; t++) {
+    work[t].resize(nx, ny);
+    fwd[t] = new FFTServer<Float,Complex>(IPosition(2, nx, ny));
+    bwd[t] = new FFTServer<Float,Complex>(IPosition(2, nx, ny));
+    fwd[t]->fft0(cft[t], psfPlane);
+    bwd[t]->fft0(work[t], cft[t], False);
+  }
+  AlwaysAssert(cft[0].shape().isEqual(xfr.shape()), AipsError);
+
+  // Convolve the planes in batches of one plane per thread; the image
+  // itself is only accessed outside the parallel loop.
+  for (uInt first=0; first<planes.size(); first+=nThreads) {
+    Int n = min(nThreads, Int(planes.size()-first));
+    for (Int k=0; k<n; k++) {
+      work[k] = image.getSlice(planes[first+k], cursorShape, True);
+    }
+#pragma omp parallel for schedule(dynamic) num_threads(n)
+    for (Int k=0; k<n; k++) {
+      convolvePlane(work[k], cft[k], xfrData, *fwd[k], *bwd[k],
+                    directPsf, maxDirect);
+    }
+    for (Int k=0; k<n; k++) {
+      image.putSlice(work[k].reform(cursorShape), planes[first+k]);
+    }
   }
 };
 
@@ -157,11 +342,9 @@ void StokesImageUtil::Convolve(ImageInterface<Float>& image, Float bmaj,
   beam(0)=bmaj*C::arcsec;
   beam(1)=bmin*C::arcsec;
   beam(2)=(bpa+90.0)*C::degree;
-  PagedImage<Float>
+  TempImage<Float>
     cleanpsf(IPosition(4, image.shape()(0), image.shape()(1), 1, 1),
-	     image.coordinates(),
-	     File::newUniqueName("./","imagesolver::cleanpsf").originalName());
-  cleanpsf.table().markForDelete();
+	     image.coordinates());
   MakeGaussianPSF(cleanpsf, beam, normalizeVolume);
   Convolve(image, cleanpsf);
 }
@@ -89,7 +89,10 @@ public:
   static void locatePeakPSF(ImageInterface<Float>& psf, Int& xpos, Int& ypos, 
 			    Float& amp, Matrix<Float>& psfplane);
 
-  // Convolve a Stokes Image in place
+  // Convolve a Stokes Image in place. The transfer function of the
+  // PSF is cached between calls and the planes are convolved in
+  // parallel. Planes with few non-zero pixels (e.g. clean component
+  // models) are convolved directly with the PSF pixels.
   //<group>
   static void Convolve(ImageInterface<Float>& image,
 		       ImageInterface<Float>& psf);
@@ -34,6 +34,7 @@
 #include <synthesis/MeasurementComponents/PredictAlgorithm.h>
 #include <synthesis/MeasurementComponents/ResidualAlgorithm.h>
 #include <casa/BasicMath/Math.h>
+#include <casa/System/AipsrcValue.h>
 #include <synthesis/Parallel/MPIError.h>
 #ifdef PABLO_IO
 #include <synthesis/Parallel/PabloIO.h>
@@ -105,6 +106,19 @@ void Applicator::initThreads(){
   return;
 }
 
+void Applicator::initProcesses(Int nProcs)
+{
+// Initialize a transport layer with worker processes forked on this node
+//
+  comm = new LocalTransport(nProcs);
+  setupProcStatus();
+  // If controller then exit, else loop, waiting for an assigned task
+  if (isWorker()) {
+    loop();
+  }
+  return;
+}
+
 void Applicator::init(Int argc, Char *argv[])
 {
 // Initialize the process and parallel transport layer
@@ -118,7 +132,14 @@ void Applicator::init(Int argc, Char *argv[])
 #ifdef PABLO_IO
      PabloIO::init(argc, argv, 0);
 #endif
-  initThreads();
+  // Without MPI, worker processes can be forked on this node.
+  Int nLocal;
+  AipsrcValue<Int>::find(nLocal, "Applicator.nprocs", 1);
+  if (nLocal > 1) {
+    initProcesses(nLocal);
+  } else {
+    initThreads();
+  }
 #endif
   return;
 }
@@ -102,6 +102,10 @@ class Applicator {
   void initThreads(Int argc, Char *argv[]);
   void initThreads();
 
+  // Initialize a local multi-process transport with the given total
+  // number of processes. The worker processes go into the wait loop.
+  void initProcesses(Int nProcs);
+
   // define an Algorithm if we need too;
   void defineAlgorithm(Algorithm *);
 
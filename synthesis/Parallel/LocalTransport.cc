@@ -0,0 +1,417 @@
+//# LocalTransport.cc: parallel transport between processes on one node
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This library is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU Library General Public License as published by
+//# the Free Software Foundation; either version 2 of the License, or (at your
+//# option) any later version.
+//#
+//# This library is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU Library General Public
+//# License for more details.
+//#
+//# You should have received a copy of the GNU Library General Public License
+//# along with this library; if not, write to the Free Software Foundation,
+//# Inc., 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+//# Includes
+#include <synthesis/Parallel/PTransport.h>
+#include <casa/Containers/Record.h>
+#include <casa/Containers/Block.h>
+#include <casa/BasicMath/Math.h>
+#include <casa/IO/AipsIO.h>
+#include <casa/IO/MemoryIO.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/iostream.h>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+
+namespace casa { //# NAMESPACE CASA - BEGIN
+
+namespace {
+
+  // The fixed part of a message.
+  struct MsgHeader {
+    Int tag;
+    Int type;
+    Int ndim;
+    uInt64 nbytes;
+  };
+
+  void writeAll(int fd, const void *buf, uInt64 n)
+  {
+    const char *ptr = static_cast<const char*>(buf);
+    while (n > 0) {
+      ssize_t nw = ::write(fd, ptr, n);
+      if (nw < 0) {
+        if (errno == EINTR) continue;
+        throw(AipsError("LocalTransport: write failed: " +
+                        String(strerror(errno))));
+      }
+      ptr += nw;
+      n   -= nw;
+    }
+  }
+
+  void readAll(int fd, void *buf, uInt64 n)
+  {
+    char *ptr = static_cast<char*>(buf);
+    while (n > 0) {
+      ssize_t nr = ::read(fd, ptr, n);
+      if (nr < 0) {
+        if (errno == EINTR) continue;
+        throw(AipsError("LocalTransport: read failed: " +
+                        String(strerror(errno))));
+      }
+      if (nr == 0) {
+        throw(AipsError("LocalTransport: connection closed unexpectedly"));
+      }
+      ptr += nr;
+      n   -= nr;
+    }
+  }
+
+}
+
+LocalTransport::LocalTransport(Int nProcs) : PTransport()
+{
+  numprocs = max(nProcs, 1);
+  myCpu = 0;
+  fds_p.assign(numprocs, -1);
+  pending_p.resize(numprocs);
+  // Flush the output buffers, otherwise the workers inherit and
+  // write them again.
+  cout.flush();
+  cerr.flush();
+  fflush(0);
+  for (Int rank=1; rank<numprocs; rank++) {
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0) {
+      throw(AipsError("LocalTransport: socketpair failed: " +
+                      String(strerror(errno))));
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+      throw(AipsError("LocalTransport: fork failed: " +
+                      String(strerror(errno))));
+    }
+    if (pid == 0) {
+      // Worker; it only talks to the controller.
+      ::close(sv[0]);
+      for (Int i=1; i<rank; i++) {
+        ::close(fds_p[i]);
+        fds_p[i] = -1;
+      }
+      fds_p[controllerRank()] = sv[1];
+      children_p.clear();
+      myCpu = rank;
+      break;
+    }
+    ::close(sv[1]);
+    fds_p[rank] = sv[0];
+    children_p.push_back(pid);
+  }
+  // Set default tag and source/destination
+  setAnyTag();
+  connectAnySource();
+}
+
+LocalTransport::~LocalTransport()
+{
+  for (uInt i=0; i<fds_p.size(); i++) {
+    if (fds_p[i] >= 0) {
+      ::close(fds_p[i]);
+    }
+  }
+  for (uInt i=0; i<children_p.size(); i++) {
+    int status;
+    waitpid(children_p[i], &status, 0);
+  }
+}
+
+Int LocalTransport::send(Int type, const IPosition &shape, const void *data,
+                         uInt64 nbytes)
+{
+  if (aWorker < 0  ||  aWorker >= numprocs  ||  fds_p[aWorker] < 0) {
+    throw(AipsError("LocalTransport: invalid destination"));
+  }
+  int fd = fds_p[aWorker];
+  MsgHeader hdr;
+  hdr.tag    = aTag;
+  hdr.type   = type;
+  hdr.ndim   = shape.nelements();
+  hdr.nbytes = nbytes;
+  writeAll(fd, &hdr, sizeof(hdr));
+  if (hdr.ndim > 0) {
+    Block<Int> shp(hdr.ndim);
+    for (Int i=0; i<hdr.ndim; i++) {
+      shp[i] = shape[i];
+    }
+    writeAll(fd, shp.storage(), hdr.ndim*sizeof(Int));
+  }
+  writeAll(fd, data, nbytes);
+  return(0);
+}
+
+void LocalTransport::readHeader(Int rank, Message &msg)
+{
+  int fd = fds_p[rank];
+  MsgHeader hdr;
+  readAll(fd, &hdr, sizeof(hdr));
+  msg.tag    = hdr.tag;
+  msg.type   = hdr.type;
+  msg.nbytes = hdr.nbytes;
+  msg.shape.resize(hdr.ndim, False);
+  if (hdr.ndim > 0) {
+    Block<Int> shp(hdr.ndim);
+    readAll(fd, shp.storage(), hdr.ndim*sizeof(Int));
+    for (Int i=0; i<hdr.ndim; i++) {
+      msg.shape[i] = shp[i];
+    }
+  }
+  msg.data.clear();
+  msg.pending = (msg.nbytes > 0);
+}
+
+void LocalTransport::readData(Int rank, Message &msg)
+{
+  if (msg.pending) {
+    msg.data.resize(msg.nbytes);
+    readAll(fds_p[rank], &msg.data[0], msg.nbytes);
+    msg.pending = False;
+  }
+}
+
+void LocalTransport::copyData(Int rank, Message &msg, void *buf)
+{
+  if (msg.pending) {
+    readAll(fds_p[rank], buf, msg.nbytes);
+    msg.pending = False;
+  } else if (msg.nbytes > 0) {
+    memcpy(buf, &msg.data[0], msg.nbytes);
+  }
+}
+
+Int LocalTransport::receive(Int type, Message &msg)
+{
+  Bool anySrc = (aWorker == anySource());
+  Bool anyTg  = (aTag == anyTag());
+  if (!anySrc  &&  (aWorker < 0  ||  aWorker >= numprocs  ||
+                    fds_p[aWorker] < 0)) {
+    throw(AipsError("LocalTransport: invalid source"));
+  }
+  Int source = -1;
+  // First look if a matching message has been queued.
+  for (Int rank=0; rank<numprocs && source<0; rank++) {
+    if (anySrc || rank == aWorker) {
+      std::deque<Message> &que = pending_p[rank];
+      for (std::deque<Message>::iterator iter=que.begin();
+           iter!=que.end(); ++iter) {
+        if (anyTg || iter->tag == aTag) {
+          msg = *iter;
+          que.erase(iter);
+          source = rank;
+          break;
+        }
+      }
+    }
+  }
+  // Otherwise read messages until a matching one arrives.
+  std::vector<struct pollfd> pfds;
+  std::vector<Int> ranks;
+  for (Int rank=0; rank<numprocs; rank++) {
+    if (fds_p[rank] >= 0  &&  (anySrc || rank == aWorker)) {
+      struct pollfd pfd;
+      pfd.fd = fds_p[rank];
+      pfd.events = POLLIN;
+      pfd.revents = 0;
+      pfds.push_back(pfd);
+      ranks.push_back(rank);
+    }
+  }
+  if (source < 0  &&  pfds.empty()) {
+    throw(AipsError("LocalTransport: no process to receive from"));
+  }
+  while (source < 0) {
+    if (pfds.size() > 1) {
+      if (poll(&pfds[0], pfds.size(), -1) < 0) {
+        if (errno == EINTR) continue;
+        throw(AipsError("LocalTransport: poll failed: " +
+                        String(strerror(errno))));
+      }
+    } else {
+      pfds[0].revents = POLLIN;
+    }
+    for (uInt i=0; i<pfds.size() && source<0; i++) {
+      if (pfds[i].revents != 0) {
+        // Only the header is read; the data of the message asked for
+        // are left in the socket to be read straight into their target.
+        Message m;
+        readHeader(ranks[i], m);
+        if (anyTg || m.tag == aTag) {
+          msg = m;
+          source = ranks[i];
+        } else {
+          readData(ranks[i], m);
+          pending_p[ranks[i]].push_back(m);
+        }
+      }
+    }
+  }
+  if (msg.type != type) {
+    // Keep the connection in a consistent state.
+    readData(source, msg);
+    throw(AipsError("LocalTransport: received message of unexpected type"));
+  }
+  aWorker = source;
+  aTag    = msg.tag;
+  return(source);
+}
+
+template<class T> Int LocalTransport::getArray(Array<T> &arr, Int type)
+{
+  Message msg;
+  Int source = receive(type, msg);
+  arr.resize(msg.shape);
+  if (arr.nelements()*sizeof(T) != msg.nbytes) {
+    readData(source, msg);
+    throw(AipsError("LocalTransport: inconsistent array message"));
+  }
+  // Read the data directly into the array storage (which is the array
+  // itself if it is contiguous).
+  Bool deleteIt;
+  T *data = arr.getStorage(deleteIt);
+  copyData(source, msg, data);
+  arr.putStorage(data, deleteIt);
+  return(source);
+}
+
+template<class T> Int LocalTransport::getScalar(T &val, Int type)
+{
+  Message msg;
+  Int source = receive(type, msg);
+  if (msg.nbytes != sizeof(T)) {
+    readData(source, msg);
+    throw(AipsError("LocalTransport: inconsistent scalar message"));
+  }
+  copyData(source, msg, &val);
+  return(source);
+}
+
+// The array data are sent straight from their storage.
+#define LOCALTRANSPORT_PUTARRAY(T, TYPE) \
+Int LocalTransport::put(const Array<T> &af){ \
+   Bool deleteit; \
+   const T *data = af.getStorage(deleteit); \
+   Int status = send(TYPE, af.shape(), data, af.nelements()*sizeof(T)); \
+   af.freeStorage(data, deleteit); \
+   return(status); \
+}
+
+LOCALTRANSPORT_PUTARRAY(Float, FLOATARR)
+LOCALTRANSPORT_PUTARRAY(Double, DOUBLEARR)
+LOCALTRANSPORT_PUTARRAY(Complex, COMPLEXARR)
+LOCALTRANSPORT_PUTARRAY(DComplex, DCOMPLEXARR)
+LOCALTRANSPORT_PUTARRAY(Int, INTARR)
+
+#undef LOCALTRANSPORT_PUTARRAY
+
+Int LocalTransport::put(const Float &f){
+   return send(FLOAT, IPosition(), &f, sizeof(f));
+}
+Int LocalTransport::put(const Double &d){
+   return send(DOUBLE, IPosition(), &d, sizeof(d));
+}
+Int LocalTransport::put(const Complex &f){
+   return send(COMPLEX, IPosition(), &f, sizeof(f));
+}
+Int LocalTransport::put(const DComplex &f){
+   return send(DCOMPLEX, IPosition(), &f, sizeof(f));
+}
+Int LocalTransport::put(const Int &i){
+   return send(INT, IPosition(), &i, sizeof(i));
+}
+Int LocalTransport::put(const Bool &b){
+   return send(BOOL, IPosition(), &b, sizeof(b));
+}
+Int LocalTransport::put(const String &s){
+   return send(STRING, IPosition(), s.chars(), s.length());
+}
+Int LocalTransport::put(const Record &r){
+   MemoryIO buffer;
+   AipsIO rBuf(&buffer);
+   rBuf.putstart("LocalRecord",1);
+   rBuf << r;
+   rBuf.putend();
+   return send(RECORD, IPosition(), buffer.getBuffer(), buffer.length());
+}
+
+Int LocalTransport::get(Array<Float> &af){
+   return getArray(af, FLOATARR);
+}
+Int LocalTransport::get(Array<Double> &af){
+   return getArray(af, DOUBLEARR);
+}
+Int LocalTransport::get(Array<Complex> &af){
+   return getArray(af, COMPLEXARR);
+}
+Int LocalTransport::get(Array<DComplex> &af){
+   return getArray(af, DCOMPLEXARR);
+}
+Int LocalTransport::get(Array<Int> &af){
+   return getArray(af, INTARR);
+}
+Int LocalTransport::get(Float &f){
+   return getScalar(f, FLOAT);
+}
+Int LocalTransport::get(Double &d){
+   return getScalar(d, DOUBLE);
+}
+Int LocalTransport::get(Complex &f){
+   return getScalar(f, COMPLEX);
+}
+Int LocalTransport::get(DComplex &f){
+   return getScalar(f, DCOMPLEX);
+}
+Int LocalTransport::get(Int &i){
+   return getScalar(i, INT);
+}
+Int LocalTransport::get(Bool &b){
+   return getScalar(b, BOOL);
+}
+Int LocalTransport::get(String &s){
+   Message msg;
+   Int source = receive(STRING, msg);
+   readData(source, msg);
+   s = msg.data.empty() ? String() : String(&msg.data[0], msg.data.size());
+   return(source);
+}
+Int LocalTransport::get(Record &r){
+   Message msg;
+   Int source = receive(RECORD, msg);
+   readData(source, msg);
+   MemoryIO buffer(msg.data.empty() ? 0 : &msg.data[0], msg.data.size());
+   AipsIO rBuf(&buffer);
+   rBuf.getstart("LocalRecord");
+   rBuf >> r;
+   rBuf.getend();
+   return(source);
+}
+
+} //# NAMESPACE CASA - END
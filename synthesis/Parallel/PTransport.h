@@ -32,6 +32,10 @@
 //# Includes
 #include <casa/aips.h>
 #include <casa/Arrays/Array.h>
+#include <casa/BasicSL/String.h>
+#include <deque>
+#include <vector>
+#include <sys/types.h>
 
 namespace casa { //# NAMESPACE CASA - BEGIN
 
@@ -330,6 +334,154 @@ class SerialTransport : public PTransport {
   void *getFromQueue();
 };
 
+// <summary>
+// Local multi-process data transport model
+// </summary>
+
+// <use visibility=local>
+
+// <reviewed reviewer="" date="yyyy/mm/dd" tests="" demos="">
+// </reviewed>
+
+// <prerequisite>
+//   <li> PTransport
+//   <li> Applicator
+// </prerequisite>
+//
+// <etymology>
+// Transport between local processes.
+// </etymology>
+//
+// <synopsis>
+// LocalTransport makes it possible to run the parallel algorithms on a
+// single (multi-core) node without MPI. The constructor forks the worker
+// processes; the calling process becomes the controller (rank 0) and
+// each worker gets the next rank. Like with MPI, the worker processes
+// return from the constructor and should go into Applicator::loop.
+// <br>Each worker is connected to the controller by a UNIX socket pair.
+// A message consists of a header (tag, type, shape and size) followed by
+// the data, which are sent straight from and received straight into the
+// array storage. Messages that arrive with another tag than requested are
+// read into a buffer and queued until they are asked for; their data are
+// copied into the array when it is received.
+// <br>Note that only programs calling <src>Applicator::init</src> use
+// the Applicator (and hence this transport); the imager applications
+// in this package do not.
+// </synopsis>
+//
+// <example>
+// Put in the .aipsrc file
+// <srcblock>
+//   Applicator.nprocs: 8
+// </srcblock>
+// to let Applicator::init use a LocalTransport with 7 worker processes.
+// </example>
+//
+// <motivation>
+// The parallel algorithms could only be run on an MPI build.
+// </motivation>
+
+class LocalTransport : public PTransport {
+ public:
+  // Fork the worker processes, so there are <src>nProcs</src> processes
+  // in total.
+  explicit LocalTransport(Int nProcs);
+
+  // Close the connections; the controller waits for the workers to end.
+  virtual ~LocalTransport();
+
+  // Default source and message tag values
+  virtual Int anyTag() {return -1;};
+  virtual Int anySource() {return -1;};
+  
+  // Define the rank of the controller process
+  virtual Int controllerRank() {return 0;};
+
+  // Get and put functions on the data transport layer.
+  // The get functions return the rank of the sending process.
+  virtual Int put(const Array<Float> &);
+  virtual Int put(const Array<Double> &);
+  virtual Int put(const Array<Complex> &);
+  virtual Int put(const Array<DComplex> &);
+  virtual Int put(const Array<Int> &);
+  virtual Int put(const Float &);
+  virtual Int put(const Double &);
+  virtual Int put(const Complex &);
+  virtual Int put(const DComplex &);
+  virtual Int put(const Int &);
+  virtual Int put(const String &);
+  virtual Int put(const Bool &);
+  virtual Int put(const Record &);
+
+  virtual Int get(Array<Float> &);
+  virtual Int get(Array<Double> &);
+  virtual Int get(Array<Complex> &);
+  virtual Int get(Array<DComplex> &);
+  virtual Int get(Array<Int> &);
+  virtual Int get(Float &);
+  virtual Int get(Double &);
+  virtual Int get(Complex &);
+  virtual Int get(DComplex &);
+  virtual Int get(Int &);
+  virtual Int get(String &);
+  virtual Int get(Bool &);
+  virtual Int get(Record &);
+
+ private:
+  // Message types
+  enum MsgType {FLOATARR, DOUBLEARR, COMPLEXARR, DCOMPLEXARR, INTARR,
+                FLOAT, DOUBLE, COMPLEX, DCOMPLEX, INT, STRING, BOOL, RECORD};
+
+  // A received message. The data of a message are only read into
+  // <src>data</src> if the message has to be queued or is not an array
+  // or scalar; otherwise they are read from the socket straight into
+  // their target (<src>pending</src> is True until then).
+  struct Message {
+    Int tag;
+    Int type;
+    IPosition shape;
+    uInt64 nbytes;
+    Bool pending;
+    std::vector<char> data;
+  };
+
+  // Forbid copy and assignment
+  LocalTransport(const LocalTransport&);
+  LocalTransport& operator=(const LocalTransport&);
+
+  // Send a message to the current destination with the current tag.
+  Int send(Int type, const IPosition &shape, const void *data, uInt64 nbytes);
+
+  // Receive the next message from the current source with the current tag
+  // (which can be anySource and anyTag). The source and tag are set to
+  // the actual values. It returns the rank of the sender. The data of
+  // the message can still be pending in the socket.
+  Int receive(Int type, Message &msg);
+
+  // Read the header of the next message from the given process.
+  void readHeader(Int rank, Message &msg);
+
+  // Read the pending data of a message into <src>msg.data</src>.
+  void readData(Int rank, Message &msg);
+
+  // Read the pending data of a message into the given buffer, or copy
+  // them if the message was queued.
+  void copyData(Int rank, Message &msg, void *buf);
+
+  // Get an array out of a message.
+  template<class T> Int getArray(Array<T> &arr, Int type);
+
+  // Get a scalar out of a message.
+  template<class T> Int getScalar(T &val, Int type);
+
+  // Socket per process rank (-1 if not connected)
+  std::vector<int> fds_p;
+  // Queued messages per process rank
+  std::vector<std::deque<Message> > pending_p;
+  // Process ids of the workers (controller only)
+  std::vector<pid_t> children_p;
+};
+
 
 } //# NAMESPACE CASA - END
 
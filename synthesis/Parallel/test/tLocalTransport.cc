@@ -0,0 +1,142 @@
+//# tLocalTransport.cc: Test the local multi-process transport
+//# Copyright (C) 2011
+//# Associated Universities, Inc. Washington DC, USA.
+//#
+//# This program is free software; you can redistribute it and/or modify it
+//# under the terms of the GNU General Public License as published by the Free
+//# Software Foundation; either version 2 of the License, or (at your option)
+//# any later version.
+//#
+//# This program is distributed in the hope that it will be useful, but WITHOUT
+//# ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+//# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+//# more details.
+//#
+//# You should have received a copy of the GNU General Public License along
+//# with this program; if not, write to the Free Software Foundation, Inc.,
+//# 675 Massachusetts Ave, Cambridge, MA 02139, USA.
+//#
+//# Correspondence concerning AIPS++ should be addressed as follows:
+//#        Internet email: aips2-request@nrao.edu.
+//#        Postal address: AIPS++ Project Office
+//#                        National Radio Astronomy Observatory
+//#                        520 Edgemont Road
+//#                        Charlottesville, VA 22903-2475 USA
+//#
+//# $Id$
+
+#include <synthesis/Parallel/PTransport.h>
+#include <casa/Arrays/Vector.h>
+#include <casa/Arrays/Matrix.h>
+#include <casa/Arrays/ArrayMath.h>
+#include <casa/Arrays/ArrayLogical.h>
+#include <casa/Containers/Record.h>
+#include <casa/BasicSL/Complex.h>
+#include <casa/BasicSL/String.h>
+#include <casa/Exceptions/Error.h>
+#include <casa/Utilities/Assert.h>
+#include <casa/iostream.h>
+
+#include <casa/namespace.h>
+
+// Tags of the messages sent by a worker. They are sent in the order
+// 20, 10, 30 and received by the controller in the order 10, 20, 30,
+// so the message with tag 20 has to be queued.
+enum {INPUT=1, NUMBER=20, ARRAY=10, RECORD=30, WRONGTYPE=40};
+
+void doWorker (LocalTransport& comm)
+{
+  comm.connectToController();
+  comm.setAnyTag();
+  Matrix<Float> mat;
+  Int n;
+  Record rec;
+  comm.get (mat);
+  comm.get (n);
+  comm.get (rec);
+  AlwaysAssertExit (n == comm.cpu());
+
+  Array<Complex> carr(mat.shape());
+  convertArray (carr, mat);
+  carr *= Complex(2, 0);
+  rec.define ("worker", comm.cpu());
+
+  comm.connectToController();
+  comm.setTag (NUMBER);
+  comm.put (10*n);
+  comm.setTag (ARRAY);
+  comm.put (carr);
+  comm.setTag (RECORD);
+  comm.put (rec);
+  comm.setTag (WRONGTYPE);
+  comm.put (Float(1));
+}
+
+void doController (LocalTransport& comm)
+{
+  for (Int rank=1; rank<comm.numThreads(); ++rank) {
+    Matrix<Float> mat(3, 4);
+    indgen (mat, Float(rank));
+    Record rec;
+    rec.define ("name", "tLocalTransport");
+    comm.connect (rank);
+    comm.setTag (INPUT);
+    comm.put (mat);
+    comm.put (rank);
+    comm.put (rec);
+  }
+  for (Int rank=1; rank<comm.numThreads(); ++rank) {
+    Matrix<Float> mat(3, 4);
+    indgen (mat, Float(rank));
+    // The array is received straight from the socket.
+    Array<Complex> carr;
+    comm.connect (rank);
+    comm.setTag (ARRAY);
+    AlwaysAssertExit (comm.get(carr) == rank);
+    AlwaysAssertExit (carr.shape().isEqual (IPosition(2, 3, 4)));
+    Array<Complex> expected(mat.shape());
+    convertArray (expected, mat);
+    expected *= Complex(2, 0);
+    AlwaysAssertExit (allEQ (carr, expected));
+    // This message arrived before the array and was queued.
+    Int n;
+    comm.connect (rank);
+    comm.setTag (NUMBER);
+    AlwaysAssertExit (comm.get(n) == rank);
+    AlwaysAssertExit (n == 10*rank);
+    Record rec;
+    comm.connect (rank);
+    comm.setTag (RECORD);
+    AlwaysAssertExit (comm.get(rec) == rank);
+    AlwaysAssertExit (rec.asString("name") == "tLocalTransport");
+    AlwaysAssertExit (rec.asInt("worker") == rank);
+    // A message of another type than asked for is an error.
+    Bool caught = False;
+    comm.connect (rank);
+    comm.setTag (WRONGTYPE);
+    try {
+      comm.get (n);
+    } catch (AipsError&) {
+      caught = True;
+    }
+    AlwaysAssertExit (caught);
+  }
+}
+
+int main()
+{
+  try {
+    LocalTransport comm(3);
+    AlwaysAssertExit (comm.numThreads() == 3);
+    if (comm.isWorker()) {
+      doWorker (comm);
+      return 0;
+    }
+    doController (comm);
+  } catch (AipsError& x) {
+    cerr << "Exception caught: " << x.getMesg() << endl;
+    return 1;
+  }
+  cout << "OK" << endl;
+  return 0;
+}
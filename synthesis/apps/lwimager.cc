@@ -28,17 +28,26 @@
 //# Includes
 #include <casa/aips.h>
 #include <synthesis/MeasurementEquations/Imager.h>
+#include <synthesis/MeasurementEquations/ImagerMultiMS.h>
+#include <msvis/MSVis/VisibilityIteratorAsync.h>
 #include <images/Images/PagedImage.h>
 #include <images/Images/HDF5Image.h>
 #include <images/Images/ImageFITSConverter.h>
 #include <casa/Inputs.h>
 #include <casa/Arrays/ArrayUtil.h>
 #include <casa/Arrays/ArrayMath.h>
+#include <casa/Arrays/ArrayIO.h>
 #include <casa/Utilities/Regex.h>
 #include <casa/Utilities/Assert.h>
 #include <casa/Exceptions/Error.h>
+#include <casa/OS/HostInfo.h>
 #include <casa/iostream.h>
+#include <casa/fstream.h>
 #include <casa/sstream.h>
+#include <map>
+#include <vector>
+#include <unistd.h>
+#include <sys/wait.h>
 
 using namespace casa;
 
@@ -156,416 +165,535 @@ void makeEmpty (Imager& imager, const String& imgName, Int fieldid)
   imager.unlock();
 }
 
-int main (Int argc, char** argv)
+void defineInputs (Input& inputs)
 {
-  try {
-    Input inputs(1);
-    // define the input structure
-    inputs.version("1.3.3");
-    inputs.create ("ms", "",
-		   "Name of input MeasurementSet",
-		   "string");
-    inputs.create ("image", "",
-		   "Name of output image file (default is <msname-stokes-mode-nchan>.img)",
-		   "string");
-    inputs.create ("fits", "no",
-		   "Name of output image fits file ('no' means no fits file) empty is <imagename>.fits",
-		   "string");
-    inputs.create ("hdf5", "no",
-    		   "Name of output image HDF5 file ('no' means no HDF5 file) empty is <imagename>.hdf5",
-    		   "string");
-    inputs.create ("prior", "",
-		   "Name of prior image file (default is <imagename>.prior)",
-		   "string");
-    inputs.create ("model", "",
-		   "Name of model image file (default is <imagename>.model)",
-		   "string");
-    inputs.create ("restored", "",
-		   "Name of restored image file (default is <imagename>.restored)",
-		   "string");
-    inputs.create ("residual", "",
-		   "Name of residual image file (default is <imagename>.residual)",
-		   "string");
-    inputs.create ("data", "DATA",
-		   "Name of DATA column to use",
-		   "string");
-    inputs.create ("mode", "mfs",
-		   "Imaging mode (mfs, channel, or velocity)",
-		   "string");
-    inputs.create ("filter", "",
-                   "Apply gaussian tapering filter; specify as major,minor,pa",
-                   "string");
-    inputs.create ("clean_beam", "",
-                   "Specify clean restoring beam; specify as major axis,minor axis,position angle with units",
-                   "string");
-    inputs.create ("weight", "briggs",
-		   "Weighting scheme (uniform, superuniform, natural, briggs (robust), briggsabs, or radial)",
-		   "string");
-    inputs.create ("weight_fov", "",
-		   "Field of view size for uniform/briggs weighting, if different from image size",
-		   "quantity string");
-    inputs.create ("noise", "1.0",
-		   "Noise (in Jy) for briggsabs weighting"
-		   "float");
-    inputs.create ("robust", "0.0",
-		   "Robust parameter",
-		   "float");
-    inputs.create ("wprojplanes", "0",
-		   "if >0 specifies nr of convolution functions to use in W-projection",
-		   "int");
-    inputs.create ("padding", "1.0",
-		   "padding factor in image plane (>=1.0)",
-		   "float");
-    inputs.create ("cachesize", "512",
-		   "maximum size of gridding cache (in MBytes)",
-		   "int");
-    inputs.create ("stokes", "I",
-		   "Stokes parameters to image (e.g. IQUV)",
-		   "string");
-    inputs.create ("nfacets", "1",
-                   "number of facets in x or y",
-                   "int");
-    inputs.create ("npix", "256",
-		   "number of image pixels in x and y direction",
-		   "int");
-    inputs.create ("cellsize", "1arcsec",
-		   "pixel width in x and y direction",
-		   "quantity string");
-    inputs.create ("phasecenter", "",
-		   "phase center to be used (e.g. 'j2000, 05h30m, -30.2deg')",
-		   "direction string");
-    inputs.create ("field", "0",
-		   "field id to be used",
-		   "int");
-    inputs.create ("spwid", "0",
-		   "spectral window id(s) to be used",
-		   "int vector");
-    inputs.create ("chanmode", "channel",
-		   "frequency channel mode",
-		   "string");
-    inputs.create ("nchan", "1",
-		   "number of frequency channels to select from each spectral window (one number per spw)",
-		   "int vector");
-    inputs.create ("chanstart", "0",
-		   "first frequency channel per each spw (0-relative)",
-		   "int vector");
-    inputs.create ("chanstep", "1",
-		   "frequency channel step per each spw",
-		   "int vector");
-    inputs.create ("img_nchan", "1",
-		   "number of frequency channels in image",
-		   "int");
-    inputs.create ("img_chanstart", "0",
-		   "first frequency channel in image (0-relative)",
-		   "int");
-    inputs.create ("img_chanstep", "1",
-		   "frequency channel step in image",
-		   "int");
-    inputs.create ("uvrange", "",
-		   "UV range filter for input",
-		   "string");
-    inputs.create ("select", "",
-		   "TaQL selection string for MS",
-		   "string");
-    inputs.create ("operation", "image",
-		   "Operation (empty,image,psf,clark,hogbom,csclean,multiscale,entropy)",
-		   "string");
-    inputs.create ("niter", "1000",
-		   "Number of clean iterations",
-		   "int");
-    inputs.create ("gain", "0.1",
-		   "Loop gain for cleaning",
-		   "float");
-    inputs.create ("threshold", "0Jy",
-		   "Flux level at which to stop cleaning",
-		   "quantity string");
-    inputs.create ("targetflux", "1.0Jy",
-		   "Target flux for maximum entropy",
-		   "quantity string");
-    inputs.create ("sigma", "0.001Jy",
-		   "deviation for maximum entropy",
-		   "quantity string");
-    inputs.create ("fixed", "False",
-		   "Keep clean model fixed",
-		   "bool");
-    inputs.create ("fillmodel", "False",
-		   "fill MODEL_DATA column with clean model visibilities, else keeps model in memory",
-		   "bool");
-    inputs.create ("constrainflux", "False",
-		   "Constrain image to match target flux? For max entropy",
-		   "bool");
-    inputs.create ("prefervelocity", "True",
-                   "Should FITS image spectral axis be velocity or frequency",
-                   "bool");
-    inputs.create ("mask", "",
-		   "Name of the mask to use in cleaning",
-		   "string");
-    inputs.create ("maskblc", "0,0",
-		   "bottom-left corner of mask region",
-		   "int vector");
-    inputs.create ("masktrc", "image shape",
-		   "top-right corner of mask region",
-		   "int vector");
-    inputs.create ("nscales", "5",
-                   "Scales for MultiScale Clean",
-                   "int");
-    inputs.create ("uservector", "0",
-		   "user-defined scales for MultiScale clean",
-		   "float vector");
-    inputs.create ("maskvalue", "-1.0",
-		   "Value to store in mask region; if given, mask is created; if mask not exists, defaults to 1.0",
-		   "float");
-    inputs.create ("cyclefactor", "1.5",
-                   "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
-                   "float");
-    inputs.create ("cyclespeedup", "-1",
-                   "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
-                   "float");
-    inputs.create ("cyclemaxpsffraction", "0.8",
-                   "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
-                   "float");
-    inputs.create ("stoplargenegatives", "2",
-                   "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
-                   "int");
-    inputs.create ("stoppointmode", "-1",
-                   "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
-                   "setmfcontrol parameter; see casapy",
-                   "int");
+  // define the input structure
+  inputs.version("1.5.0");
+  inputs.create ("ms", "",
+                 "Name of input MeasurementSet (a comma separated list images multiple MSs into one image; they are read on a separate thread while gridding)",
+                 "string");
+  inputs.create ("image", "",
+                 "Name of output image file (default is <msname-stokes-mode-nchan>.img)",
+                 "string");
+  inputs.create ("fits", "no",
+                 "Name of output image fits file ('no' means no fits file) empty is <imagename>.fits",
+                 "string");
+  inputs.create ("hdf5", "no",
+  		   "Name of output image HDF5 file ('no' means no HDF5 file) empty is <imagename>.hdf5",
+  		   "string");
+  inputs.create ("prior", "",
+                 "Name of prior image file (default is <imagename>.prior)",
+                 "string");
+  inputs.create ("model", "",
+                 "Name of model image file (default is <imagename>.model)",
+                 "string");
+  inputs.create ("restored", "",
+                 "Name of restored image file (default is <imagename>.restored)",
+                 "string");
+  inputs.create ("residual", "",
+                 "Name of residual image file (default is <imagename>.residual)",
+                 "string");
+  inputs.create ("data", "DATA",
+                 "Name of DATA column to use",
+                 "string");
+  inputs.create ("mode", "mfs",
+                 "Imaging mode (mfs, channel, or velocity)",
+                 "string");
+  inputs.create ("filter", "",
+                 "Apply gaussian tapering filter; specify as major,minor,pa",
+                 "string");
+  inputs.create ("clean_beam", "",
+                 "Specify clean restoring beam; specify as major axis,minor axis,position angle with units",
+                 "string");
+  inputs.create ("weight", "briggs",
+                 "Weighting scheme (uniform, superuniform, natural, briggs (robust), briggsabs, or radial)",
+                 "string");
+  inputs.create ("weight_fov", "",
+                 "Field of view size for uniform/briggs weighting, if different from image size",
+                 "quantity string");
+  inputs.create ("noise", "1.0",
+                 "Noise (in Jy) for briggsabs weighting"
+                 "float");
+  inputs.create ("robust", "0.0",
+                 "Robust parameter",
+                 "float");
+  inputs.create ("wprojplanes", "0",
+                 "if >0 specifies nr of convolution functions to use in W-projection",
+                 "int");
+  inputs.create ("padding", "1.0",
+                 "padding factor in image plane (>=1.0)",
+                 "float");
+  inputs.create ("cachesize", "512",
+                 "maximum size of gridding cache (in MBytes)",
+                 "int");
+  inputs.create ("bdatolerance", "0",
+                 "max uv-shift (in uv-cells) of baseline-dependent averaging before gridding (0 means no averaging)",
+                 "float");
+  inputs.create ("bdamaxchan", "1",
+                 "max nr of channels to combine in baseline-dependent averaging (mfs only)",
+                 "int");
+  inputs.create ("stokes", "I",
+                 "Stokes parameters to image (e.g. IQUV)",
+                 "string");
+  inputs.create ("nfacets", "1",
+                 "number of facets in x or y",
+                 "int");
+  inputs.create ("npix", "256",
+                 "number of image pixels in x and y direction",
+                 "int");
+  inputs.create ("cellsize", "1arcsec",
+                 "pixel width in x and y direction",
+                 "quantity string");
+  inputs.create ("phasecenter", "",
+                 "phase center to be used (e.g. 'j2000, 05h30m, -30.2deg')",
+                 "direction string");
+  inputs.create ("field", "0",
+                 "field id to be used",
+                 "int");
+  inputs.create ("spwid", "0",
+                 "spectral window id(s) to be used",
+                 "int vector");
+  inputs.create ("chanmode", "channel",
+                 "frequency channel mode",
+                 "string");
+  inputs.create ("nchan", "1",
+                 "number of frequency channels to select from each spectral window (one number per spw)",
+                 "int vector");
+  inputs.create ("chanstart", "0",
+                 "first frequency channel per each spw (0-relative)",
+                 "int vector");
+  inputs.create ("chanstep", "1",
+                 "frequency channel step per each spw",
+                 "int vector");
+  inputs.create ("img_nchan", "1",
+                 "number of frequency channels in image",
+                 "int");
+  inputs.create ("img_chanstart", "0",
+                 "first frequency channel in image (0-relative)",
+                 "int");
+  inputs.create ("img_chanstep", "1",
+                 "frequency channel step in image",
+                 "int");
+  inputs.create ("uvrange", "",
+                 "UV range filter for input",
+                 "string");
+  inputs.create ("select", "",
+                 "TaQL selection string for MS",
+                 "string");
+  inputs.create ("operation", "image",
+                 "Operation (empty,image,psf,clark,hogbom,csclean,multiscale,entropy)",
+                 "string");
+  inputs.create ("niter", "1000",
+                 "Number of clean iterations",
+                 "int");
+  inputs.create ("gain", "0.1",
+                 "Loop gain for cleaning",
+                 "float");
+  inputs.create ("threshold", "0Jy",
+                 "Flux level at which to stop cleaning",
+                 "quantity string");
+  inputs.create ("targetflux", "1.0Jy",
+                 "Target flux for maximum entropy",
+                 "quantity string");
+  inputs.create ("sigma", "0.001Jy",
+                 "deviation for maximum entropy",
+                 "quantity string");
+  inputs.create ("fixed", "False",
+                 "Keep clean model fixed",
+                 "bool");
+  inputs.create ("fillmodel", "False",
+                 "fill MODEL_DATA column with clean model visibilities, else keeps model in memory",
+                 "bool");
+  inputs.create ("constrainflux", "False",
+                 "Constrain image to match target flux? For max entropy",
+                 "bool");
+  inputs.create ("prefervelocity", "True",
+                 "Should FITS image spectral axis be velocity or frequency",
+                 "bool");
+  inputs.create ("mask", "",
+                 "Name of the mask to use in cleaning",
+                 "string");
+  inputs.create ("maskblc", "0,0",
+                 "bottom-left corner of mask region",
+                 "int vector");
+  inputs.create ("masktrc", "image shape",
+                 "top-right corner of mask region",
+                 "int vector");
+  inputs.create ("nscales", "5",
+                 "Scales for MultiScale Clean",
+                 "int");
+  inputs.create ("uservector", "0",
+                 "user-defined scales for MultiScale clean",
+                 "float vector");
+  inputs.create ("maskvalue", "-1.0",
+                 "Value to store in mask region; if given, mask is created; if mask not exists, defaults to 1.0",
+                 "float");
+  inputs.create ("cyclefactor", "1.5",
+                 "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
+                 "float");
+  inputs.create ("cyclespeedup", "-1",
+                 "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
+                 "float");
+  inputs.create ("cyclemaxpsffraction", "0.8",
+                 "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
+                 "float");
+  inputs.create ("stoplargenegatives", "2",
+                 "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
+                 "int");
+  inputs.create ("stoppointmode", "-1",
+                 "multi-field deconvolution parameter; see casapy's imager.setmfcontrol",
+                 "setmfcontrol parameter; see casapy",
+                 "int");
+  inputs.create ("batch", "",
+                 "Name of file with imaging jobs (one per line as key=value pairs overriding the other arguments; - means stdin)",
+                 "string");
+  inputs.create ("nprocs", "1",
+                 "max nr of processes to run batch jobs on different MSs concurrently (0 means as many as memory allows)",
+                 "int");
+}
 
-    // Fill the input structure from the command line.
-    inputs.readArguments (argc, argv);
+// The MS and Imager are kept open between the jobs of a batch.
+// The keys tell which Imager settings are still valid, so they do not
+// need to be redone (which would throw away the imaging weights or the
+// FTMachine with its convolution functions).
+struct ImagerState
+{
+  ImagerState()
+    : ms(0), imager(0), useModel(False)
+  {}
+  ~ImagerState()
+    { clear(); }
+  void clear()
+  {
+    delete imager;
+    delete ms;
+    imager = 0;
+    ms     = 0;
+    msName = dataKey = weightKey = optionsKey = String();
+  }
+  MeasurementSet* ms;
+  Imager*         imager;
+  String          msName;
+  Bool            useModel;
+  String          dataKey;
+  String          weightKey;
+  String          optionsKey;
+};
 
-    // Get the input specification.
-    Bool fixed       = inputs.getBool("fixed");
-    Bool useModel    = inputs.getBool("fillmodel");
-    Bool constrainFlux  = inputs.getBool("constrainflux");
-    Bool preferVelocity = inputs.getBool("prefervelocity");
-    Long cachesize   = inputs.getInt("cachesize");
-    Int fieldid      = inputs.getInt("field");
-    Vector<Int> spwid(inputs.getIntArray("spwid"));
-    Int npix         = inputs.getInt("npix");
-    Int nfacet       = inputs.getInt("nfacets");
-    Vector<Int> nchan(inputs.getIntArray("nchan"));
-    Vector<Int> chanstart(inputs.getIntArray("chanstart"));
-    Vector<Int> chanstep(inputs.getIntArray("chanstep"));
-    Int img_nchan    = inputs.getInt("img_nchan");
-    Int img_start    = inputs.getInt("img_chanstart");
-    Int img_step     = inputs.getInt("img_chanstep");
-    Int wplanes      = inputs.getInt("wprojplanes");
-    Int niter        = inputs.getInt("niter");
-    Int nscales      = inputs.getInt("nscales");
-    Vector<Double> userScaleSizes(inputs.getDoubleArray("uservector"));
-    Double padding   = inputs.getDouble("padding");
-    Double gain      = inputs.getDouble("gain");
-    Double maskValue = inputs.getDouble("maskvalue");
-    String mode      = inputs.getString("mode");
-    String operation = inputs.getString("operation");
-    String weight    = inputs.getString("weight");
-    String fov       = inputs.getString("weight_fov");
-    Double noise     = inputs.getDouble("noise");
-    Double robust    = inputs.getDouble("robust");
-    String filter    = inputs.getString("filter");
-    String clean_beam = inputs.getString("clean_beam");
-    String stokes    = inputs.getString("stokes");
-    String chanmode  = inputs.getString("chanmode");
-    String cellsize  = inputs.getString("cellsize");
-    String phasectr  = inputs.getString("phasecenter");
-    String sigmaStr  = inputs.getString("sigma");
-    String targetStr = inputs.getString("targetflux");
-    String threshStr = inputs.getString("threshold");
-    String msName    = inputs.getString("ms");
-    String imgName   = inputs.getString("image");
-    String fitsName  = inputs.getString("fits");
-    String hdf5Name  = inputs.getString("hdf5");
-    String modelName = inputs.getString("model");
-    String priorName = inputs.getString("prior");
-    String restoName = inputs.getString("restored");
-    String residName = inputs.getString("residual");
-    String imageType = inputs.getString("data");
-    String uvrange   = inputs.getString("uvrange");
-    String select    = inputs.getString("select");
-    String maskName  = inputs.getString("mask");
-    String mstrBlc   = inputs.getString("maskblc");
-    String mstrTrc   = inputs.getString("masktrc");
-    Double cycleFactor   = inputs.getDouble ("cyclefactor");
-    Double cycleSpeedup  = inputs.getDouble ("cyclespeedup");
-    Double cycleMaxPsfFr = inputs.getDouble ("cyclemaxpsffraction");
-    Int    stopLargeNeg  = inputs.getInt    ("stoplargenegatives");
-    Int    stopPointMode = inputs.getInt    ("stoppointmode");
+void runJob (Input& inputs, ImagerState& state)
+{
+  // Get the input specification.
+  Bool fixed       = inputs.getBool("fixed");
+  Bool useModel    = inputs.getBool("fillmodel");
+  Bool constrainFlux  = inputs.getBool("constrainflux");
+  Bool preferVelocity = inputs.getBool("prefervelocity");
+  Long cachesize   = inputs.getInt("cachesize");
+  Int fieldid      = inputs.getInt("field");
+  Vector<Int> spwid(inputs.getIntArray("spwid"));
+  Int npix         = inputs.getInt("npix");
+  Int nfacet       = inputs.getInt("nfacets");
+  Vector<Int> nchan(inputs.getIntArray("nchan"));
+  Vector<Int> chanstart(inputs.getIntArray("chanstart"));
+  Vector<Int> chanstep(inputs.getIntArray("chanstep"));
+  Int img_nchan    = inputs.getInt("img_nchan");
+  Int img_start    = inputs.getInt("img_chanstart");
+  Int img_step     = inputs.getInt("img_chanstep");
+  Int wplanes      = inputs.getInt("wprojplanes");
+  Int niter        = inputs.getInt("niter");
+  Int nscales      = inputs.getInt("nscales");
+  Vector<Double> userScaleSizes(inputs.getDoubleArray("uservector"));
+  Double padding   = inputs.getDouble("padding");
+  Double bdaTol    = inputs.getDouble("bdatolerance");
+  Int bdaMaxChan   = inputs.getInt("bdamaxchan");
+  Double gain      = inputs.getDouble("gain");
+  Double maskValue = inputs.getDouble("maskvalue");
+  String mode      = inputs.getString("mode");
+  String operation = inputs.getString("operation");
+  String weight    = inputs.getString("weight");
+  String fov       = inputs.getString("weight_fov");
+  Double noise     = inputs.getDouble("noise");
+  Double robust    = inputs.getDouble("robust");
+  String filter    = inputs.getString("filter");
+  String clean_beam = inputs.getString("clean_beam");
+  String stokes    = inputs.getString("stokes");
+  String chanmode  = inputs.getString("chanmode");
+  String cellsize  = inputs.getString("cellsize");
+  String phasectr  = inputs.getString("phasecenter");
+  String sigmaStr  = inputs.getString("sigma");
+  String targetStr = inputs.getString("targetflux");
+  String threshStr = inputs.getString("threshold");
+  String msName    = inputs.getString("ms");
+  String imgName   = inputs.getString("image");
+  String fitsName  = inputs.getString("fits");
+  String hdf5Name  = inputs.getString("hdf5");
+  String modelName = inputs.getString("model");
+  String priorName = inputs.getString("prior");
+  String restoName = inputs.getString("restored");
+  String residName = inputs.getString("residual");
+  String imageType = inputs.getString("data");
+  String uvrange   = inputs.getString("uvrange");
+  String select    = inputs.getString("select");
+  String maskName  = inputs.getString("mask");
+  String mstrBlc   = inputs.getString("maskblc");
+  String mstrTrc   = inputs.getString("masktrc");
+  Double cycleFactor   = inputs.getDouble ("cyclefactor");
+  Double cycleSpeedup  = inputs.getDouble ("cyclespeedup");
+  Double cycleMaxPsfFr = inputs.getDouble ("cyclemaxpsffraction");
+  Int    stopLargeNeg  = inputs.getInt    ("stoplargenegatives");
+  Int    stopPointMode = inputs.getInt    ("stoppointmode");
 
-    // Check and interpret input values.
-    Quantity qcellsize = readQuantity (cellsize);
-    if (msName.empty()) {
-      throw AipsError("An MS name must be given like ms=test.ms");
-    }
-    imageType.downcase();
-    if (operation == "psf") {
-      imageType = "psf";
-    } else if (imageType == "data") {
-      imageType = "observed";
-    } else if (imageType == "corrected_data") {
-      imageType = "corrected";
-    } else if (imageType == "model_data") {
-      imageType = "model";
-    } else if (imageType == "residual_data") {
-      imageType = "residual";
-    }
-    if (select.empty()) {
-      select = "ANTENNA1 != ANTENNA2";
+  // Check and interpret input values.
+  Quantity qcellsize = readQuantity (cellsize);
+  if (msName.empty()) {
+    throw AipsError("An MS name must be given like ms=test.ms");
+  }
+  imageType.downcase();
+  if (operation == "psf") {
+    imageType = "psf";
+  } else if (imageType == "data") {
+    imageType = "observed";
+  } else if (imageType == "corrected_data") {
+    imageType = "corrected";
+  } else if (imageType == "model_data") {
+    imageType = "model";
+  } else if (imageType == "residual_data") {
+    imageType = "residual";
+  }
+  if (select.empty()) {
+    select = "ANTENNA1 != ANTENNA2";
+  } else {
+    select = '(' + select + ") && ANTENNA1 != ANTENNA2";
+  }
+  Vector<String> msNames = stringToVector (msName);
+  if (imgName.empty()) {
+    imgName = msNames[0];
+    imgName.gsub (Regex("\\..*"), "");
+    imgName.gsub (Regex(".*/"), "");
+    imgName += '-' + stokes + '-' + mode + String::toString(img_nchan)
+      + ".img";
+  }
+  if (fitsName == "no") {
+    fitsName = String();
+  } else if (fitsName.empty()) {
+    fitsName = imgName + ".fits";
+  }
+  if (hdf5Name == "no") {
+    hdf5Name = String();
+  }
+  if (priorName.empty()) {
+    priorName = imgName + ".prior";
+  }
+  if (modelName.empty()) {
+    modelName = imgName + ".model";
+  }
+  if (restoName.empty()) {
+    restoName = imgName + ".restored";
+  }
+  if (residName.empty()) {
+    residName = imgName + ".residual";
+  }
+  if (weight == "robust") {
+    weight = "briggs";
+  } else if (weight == "robustabs") {
+    weight = "briggsabs";
+  }
+  string rmode = "norm";
+  if (weight == "briggsabs") {
+    weight = "briggs";
+    rmode  = "abs";
+  } else if (weight == "uniform") {
+    rmode = "none";
+  }
+  bool doShift = False;
+  MDirection phaseCenter;
+  if (! phasectr.empty()) {
+    doShift = True;
+    phaseCenter = readDirection (phasectr);
+  }
+  operation.downcase();
+  AlwaysAssertExit (operation=="empty" || operation=="image" ||
+                    operation=="psf"   || operation=="hogbom" ||
+                    operation=="clark" || operation=="csclean" ||
+                    operation=="multiscale" || operation =="entropy");
+  IPosition maskBlc, maskTrc;
+  Quantity threshold;
+  Quantity sigma;
+  Quantity targetFlux;
+  Bool doClean = (operation != "empty" && operation != "image" && operation != "psf");
+  if (doClean) {
+    maskBlc = readIPosition (mstrBlc);
+    maskTrc = readIPosition (mstrTrc);
+    threshold = readQuantity (threshStr);
+    sigma = readQuantity (sigmaStr);
+    targetFlux = readQuantity (targetStr);
+  }
+  // Get axis specification from filter.
+  Quantity bmajor, bminor, bpa;
+  readFilter (filter, bmajor, bminor, bpa);
+
+  // Get restoring beam specification from clean_beam.
+  Quantity c_bmaj, c_bmin, c_bpa;
+  readCleanBeam (clean_beam, c_bmaj, c_bmin, c_bpa);
+
+  // Set the various imager variables.
+  // The non-parameterized values used are the defaults in imager.g.
+  // An MS and Imager left open by a previous job are reused.
+  if (state.imager == 0  ||  state.msName != msName  ||
+      state.useModel != useModel) {
+    state.clear();
+    if (msNames.size() == 1) {
+      state.ms     = new MeasurementSet(msName, Table::Update);
+      state.imager = new Imager(*state.ms, False, useModel);
     } else {
-      select = '(' + select + ") && ANTENNA1 != ANTENNA2";
-    }
-    if (imgName.empty()) {
-      imgName = msName;
-      imgName.gsub (Regex("\\..*"), "");
-      imgName.gsub (Regex(".*/"), "");
-      imgName += '-' + stokes + '-' + mode + String::toString(img_nchan)
-	+ ".img";
-    }
-    if (fitsName == "no") {
-      fitsName = String();
-    } else if (fitsName.empty()) {
-      fitsName = imgName + ".fits";
-    }
-    if (hdf5Name == "no") {
-      hdf5Name = String();
+      // The MSs are iterated one after the other, so let the lookahead
+      // thread of the asynchronous iterator read them while the data
+      // already read are gridded.
+      ROVisibilityIteratorAsync::setAsynchronousIoEnabled (True);
+      state.imager = new ImagerMultiMS();
     }
-    if (priorName.empty()) {
-      priorName = imgName + ".prior";
-    }
-    if (modelName.empty()) {
-      modelName = imgName + ".model";
-    }
-    if (restoName.empty()) {
-      restoName = imgName + ".restored";
-    }
-    if (residName.empty()) {
-      residName = imgName + ".residual";
-    }
-    if (weight == "robust") {
-      weight = "briggs";
-    } else if (weight == "robustabs") {
-      weight = "briggsabs";
-    }
-    string rmode = "norm";
-    if (weight == "briggsabs") {
-      weight = "briggs";
-      rmode  = "abs";
-    } else if (weight == "uniform") {
-      rmode = "none";
-    }
-    bool doShift = False;
-    MDirection phaseCenter;
-    if (! phasectr.empty()) {
-      doShift = True;
-      phaseCenter = readDirection (phasectr);
-    }
-    operation.downcase();
-    AlwaysAssertExit (operation=="empty" || operation=="image" ||
-                      operation=="psf"   || operation=="hogbom" ||
-                      operation=="clark" || operation=="csclean" ||
-                      operation=="multiscale" || operation =="entropy");
-    IPosition maskBlc, maskTrc;
-    Quantity threshold;
-    Quantity sigma;
-    Quantity targetFlux;
-    Bool doClean = (operation != "empty" && operation != "image" && operation != "psf");
-    if (doClean) {
-      maskBlc = readIPosition (mstrBlc);
-      maskTrc = readIPosition (mstrTrc);
-      threshold = readQuantity (threshStr);
-      sigma = readQuantity (sigmaStr);
-      targetFlux = readQuantity (targetStr);
+    state.msName   = msName;
+    state.useModel = useModel;
+  }
+  //    cout << "fillModel is "<<useModel;
+  // Use channel mode if only one data channel per image-channel.
+  if (nchan.size() == 1  &&  nchan[0] == img_nchan) {
+    mode = "channel";
+  }
+  // A new data selection invalidates the weights and the FTMachine.
+  ostringstream dataKey;
+  dataKey << chanmode << ' ' << nchan << ' ' << chanstart << ' '
+          << chanstep << ' ' << spwid << ' ' << fieldid << ' '
+          << select << ' ' << uvrange;
+  if (dataKey.str() != state.dataKey  &&  msNames.size() > 1) {
+    // ImagerMultiMS adds an MS for each setDataPerMS, so it has to be
+    // recreated for a new selection.
+    if (! state.dataKey.empty()) {
+      state.clear();
+      state.imager   = new ImagerMultiMS();
+      state.msName   = msName;
+      state.useModel = useModel;
     }
-    // Get axis specification from filter.
-    Quantity bmajor, bminor, bpa;
-    readFilter (filter, bmajor, bminor, bpa);
-
-    // Get restoring beam specification from clean_beam.
-    Quantity c_bmaj, c_bmin, c_bpa;
-    readCleanBeam (clean_beam, c_bmaj, c_bmin, c_bpa);
-
-    // Set the various imager variables.
-    // The non-parameterized values used are the defaults in imager.g.
-    MeasurementSet ms(msName, Table::Update);
-    Imager imager(ms,False,useModel);
-    //    cout << "fillModel is "<<useModel;
-    // Use channel mode if only one data channel per image-channel.
-    if (nchan.size() == 1  &&  nchan[0] == img_nchan) {
-      mode = "channel";
+    state.dataKey = dataKey.str();
+    state.weightKey = state.optionsKey = String();
+    ImagerMultiMS& mimager = dynamic_cast<ImagerMultiMS&>(*state.imager);
+    for (uInt i=0; i<msNames.size(); ++i) {
+      mimager.setDataPerMS (msNames[i],
+                            chanmode,
+                            nchan,
+                            chanstart,
+                            chanstep,
+                            spwid,
+                            Vector<Int>(1,fieldid),
+                            select,               // msSelect
+                            String(),             // timerng
+                            String(),             // fieldnames
+                            Vector<Int>(),        // antIndex
+                            String(),             // antnames
+                            String(),             // spwstring
+                            uvrange,              // uvdist
+                            String(),             // scan
+                            True);                // useModel
     }
-    imager.setdata (chanmode,                       // mode
-		    nchan,
-		    chanstart,
+  }
+  Imager& imager = *state.imager;
+  if (dataKey.str() != state.dataKey) {
+    state.dataKey = dataKey.str();
+    state.weightKey = state.optionsKey = String();
+    imager.setdata (chanmode,                     // mode
+                    nchan,
+                    chanstart,
                     chanstep,
-		    MRadialVelocity(),              // mStart
-		    MRadialVelocity(),              // mStep
-		    spwid,
-		    Vector<Int>(1,fieldid),
-		    select,                         // msSelect
-                    String(),                       // timerng
-                    String(),                       // fieldnames
-                    Vector<Int>(),                  // antIndex
-                    String(),                       // antnames
-                    String(),                       // spwstring
-                    uvrange,                        // uvdist
-                    String(),                       // scan
-                    True);                          // useModelCol
+                    MRadialVelocity(),            // mStart
+                    MRadialVelocity(),            // mStep
+                    spwid,
+                    Vector<Int>(1,fieldid),
+                    select,                       // msSelect
+                    String(),                     // timerng
+                    String(),                     // fieldnames
+                    Vector<Int>(),                // antIndex
+                    String(),                     // antnames
+                    String(),                     // spwstring
+                    uvrange,                      // uvdist
+                    String(),                     // scan
+                    True);                        // useModelCol
+  }
 
-    imager.defineImage (npix,                       // nx
-                        npix,                       // ny
-                        qcellsize,                  // cellx
-                        qcellsize,                  // celly
-                        stokes,                     // stokes
-                        phaseCenter,                // phaseCenter
-                        doShift  ?  -1 : fieldid,   // fieldid
-                        mode,                       // mode
-                        img_nchan,                  // nchan
-                        img_start,                  // start
-                        img_step,                   // step
-                        MFrequency(),               // mFreqstart
-                        MRadialVelocity(),          // mStart
-                        Quantity(1,"km/s"),         // qstep, Def=1 km/s
-                        spwid,                      // spectralwindowids
-                        nfacet);                    // facets
+  imager.defineImage (npix,                       // nx
+                      npix,                       // ny
+                      qcellsize,                  // cellx
+                      qcellsize,                  // celly
+                      stokes,                     // stokes
+                      phaseCenter,                // phaseCenter
+                      doShift  ?  -1 : fieldid,   // fieldid
+                      mode,                       // mode
+                      img_nchan,                  // nchan
+                      img_start,                  // start
+                      img_step,                   // step
+                      MFrequency(),               // mFreqstart
+                      MRadialVelocity(),          // mStart
+                      Quantity(1,"km/s"),         // qstep, Def=1 km/s
+                      spwid,                      // spectralwindowids
+                      nfacet);                    // facets
 
-    // Create empty image?
-    if (operation == "empty" ) {
-      makeEmpty (imager, imgName, fieldid);
-    } else {
+  // Create empty image?
+  if (operation == "empty" ) {
+    makeEmpty (imager, imgName, fieldid);
+  } else {
 
-      // Define weighting.
-      if (weight != "default") {
-        imager.weight (weight,                      // type
-                       rmode,                       // rmode
-                       Quantity(noise, "Jy"),       // briggsabs noise
-                       robust,                      // robust
-                       fov.length() ? readQuantity(fov) : Quantity(0, "rad"),          // fieldofview
-                       0);                          // npixels
-      }
+    // Define weighting.
+    // Uniform and briggs weights depend on the image grid if no field of
+    // view is given; the taper of the filter is part of the weights.
+    ostringstream weightKey;
+    weightKey << weight << ' ' << rmode << ' ' << noise << ' ' << robust
+              << ' ' << fov << ' ' << filter;
+    if (weight != "natural"  &&  fov.empty()) {
+      weightKey << ' ' << npix << ' ' << cellsize;
+    }
+    Bool newWeights = (weightKey.str() != state.weightKey);
+    if (weight != "default"  &&  newWeights) {
+      imager.weight (weight,                      // type
+                     rmode,                       // rmode
+                     Quantity(noise, "Jy"),       // briggsabs noise
+                     robust,                      // robust
+                     fov.length() ? readQuantity(fov) : Quantity(0, "rad"),          // fieldofview
+                     0);                          // npixels
+    }
+    state.weightKey = weightKey.str();
 
-      // If multiscale, set its parameters.
-      if (operation == "multiscale") {
-        String scaleMethod;
-        Vector<Float> userVector(userScaleSizes.shape());
-        convertArray (userVector, userScaleSizes);
-        if (userScaleSizes.size() > 1) {
-          scaleMethod = "uservector";
-        } else {
-          scaleMethod = "nscales";
-        }
-        imager.setscales(scaleMethod, nscales, userVector);
-      }
-      if (! filter.empty()) {
-        imager.filter ("gaussian", bmajor, bminor, bpa);
-      }
-      if (! clean_beam.empty()) {
-        imager.setbeam (c_bmaj, c_bmin, c_bpa);
-      }
-      String ftmachine("ft");
-      if (wplanes > 0) {
-        ftmachine = "wproject";
+    // If multiscale, set its parameters.
+    if (operation == "multiscale") {
+      String scaleMethod;
+      Vector<Float> userVector(userScaleSizes.shape());
+      convertArray (userVector, userScaleSizes);
+      if (userScaleSizes.size() > 1) {
+        scaleMethod = "uservector";
+      } else {
+        scaleMethod = "nscales";
       }
+      imager.setscales(scaleMethod, nscales, userVector);
+    }
+    if (! filter.empty()  &&  newWeights) {
+      imager.filter ("gaussian", bmajor, bminor, bpa);
+    }
+    if (! clean_beam.empty()) {
+      imager.setbeam (c_bmaj, c_bmin, c_bpa);
+    }
+    String ftmachine("ft");
+    if (wplanes > 0) {
+      ftmachine = "wproject";
+    }
+    // Keep the FTMachine (and its W-kernels) if the options are unchanged.
+    // Imager::createFTMachine also builds the image definition (facets,
+    // phase center, number of image channels and polarizations) into the
+    // FTMachine, and defineImage does not reset it. So all image
+    // parameters are part of the key.
+    ostringstream optionsKey;
+    optionsKey << ftmachine << ' ' << cachesize << ' ' << padding << ' '
+               << wplanes << ' ' << npix << ' ' << cellsize << ' '
+               << stokes << ' ' << phasectr << ' ' << fieldid << ' '
+               << mode << ' ' << img_nchan << ' ' << img_start << ' '
+               << img_step << ' ' << spwid << ' ' << nfacet;
+    if (optionsKey.str() != state.optionsKey) {
       imager.setoptions(ftmachine,                    // ftmachine
                         cachesize*1024*(1024/8),      // cache
                         16,                           // tile
@@ -573,98 +701,303 @@ int main (Int argc, char** argv)
                         MPosition(),                  // mLocation
                         padding,                      // padding
                         wplanes);                     // wprojplanes
-      // Do the imaging.
-      if (operation == "image" || operation == "psf") {
-        imager.makeimage (imageType, imgName);
+      state.optionsKey = optionsKey.str();
+    }
+    imager.setbdaveraging (bdaTol, bdaMaxChan);
+    // Do the imaging.
+    if (operation == "image" || operation == "psf") {
+      imager.makeimage (imageType, imgName);
 
-        // Convert result to fits if needed.
-        if (! fitsName.empty()) {
-          String error;
-          PagedImage<float> img(imgName);
-          if (! ImageFITSConverter::ImageToFITS (error,
-                                                 img,
-                                                 fitsName,
-                                                 64,         // memoryInMB
-                                                 preferVelocity)) {
-            throw AipsError(error);
-          }
+      // Convert result to fits if needed.
+      if (! fitsName.empty()) {
+        String error;
+        PagedImage<float> img(imgName);
+        if (! ImageFITSConverter::ImageToFITS (error,
+                                               img,
+                                               fitsName,
+                                               64,         // memoryInMB
+                                               preferVelocity)) {
+          throw AipsError(error);
         }
+      }
+
+      // Convert to HDF5 if needed.
+      if (! hdf5Name.empty()) {
+        PagedImage<float> pimg(imgName);
+        HDF5Image<float>  himg(pimg.shape(), pimg.coordinates(), hdf5Name);
+        himg.copyData (pimg);
+        himg.setUnits     (pimg.units());
+        himg.setImageInfo (pimg.imageInfo());
+        himg.setMiscInfo  (pimg.miscInfo());
+        // Delete PagedImage if HDF5 is used.
+        Table::deleteTable (imgName);
+      }
 
-        // Convert to HDF5 if needed.
-        if (! hdf5Name.empty()) {
+    } else {
+      // Do the cleaning.
+      if (! maskName.empty()) {
+        if (maskValue >= 0) {
           PagedImage<float> pimg(imgName);
-          HDF5Image<float>  himg(pimg.shape(), pimg.coordinates(), hdf5Name);
-          himg.copyData (pimg);
-          himg.setUnits     (pimg.units());
-          himg.setImageInfo (pimg.imageInfo());
-          himg.setMiscInfo  (pimg.miscInfo());
-          // Delete PagedImage if HDF5 is used.
-          Table::deleteTable (imgName);
+          maskBlc = handlePos (maskBlc, IPosition(pimg.ndim(), 0));
+          maskTrc = handlePos (maskTrc, pimg.shape() - 1);
+          imager.boxmask (maskName,
+                          maskBlc.asVector(),
+                          maskTrc.asVector(),
+                          maskValue);
         }
+      }
+      imager.setmfcontrol (cycleFactor,
+                           cycleSpeedup,
+                           cycleMaxPsfFr,
+                           stopLargeNeg, 
+                           stopPointMode,
+                           "SAULT",                 // scaleType
+                           0.1,                     // minPB
+                           0.4,                     // constPB
+                           Vector<String>(),        // fluxscale
+                           True);                   // flatnoise
+      if (operation == "entropy") {
+        imager.mem(operation,                       // algorithm
+                   niter,                           // niter
+                   sigma,                           // sigma
+                   targetFlux,                      // targetflux
+                   constrainFlux,                   // constrainflux
+                   False,                           // displayProgress
+                   Vector<String>(1, modelName),    // model
+                   Vector<Bool>(1, fixed),          // fixed
+                   "",                              // complist
+                   Vector<String>(1, priorName),    // prior
+                   Vector<String>(1, maskName),     // mask
+                   Vector<String>(1, restoName),    // restored
+                   Vector<String>(1, residName));   // residual
 
       } else {
-        // Do the cleaning.
-        if (! maskName.empty()) {
-          if (maskValue >= 0) {
-            PagedImage<float> pimg(imgName);
-            maskBlc = handlePos (maskBlc, IPosition(pimg.ndim(), 0));
-            maskTrc = handlePos (maskTrc, pimg.shape() - 1);
-            imager.boxmask (maskName,
-                            maskBlc.asVector(),
-                            maskTrc.asVector(),
-                            maskValue);
-          }
+        imager.clean(operation,                     // algorithm,
+                     niter,                         // niter
+                     gain,                          // gain
+                     threshold,                     // threshold
+                     False,                         // displayProgress
+                     Vector<String>(1, modelName),  // model
+                     Vector<Bool>(1, fixed),        // fixed
+                     "",                            // complist
+                     Vector<String>(1, maskName),   // mask
+                     Vector<String>(1, restoName),  // restored
+                     Vector<String>(1, residName)); // residual
+      }
+      // Convert result to fits if needed.
+      if (! fitsName.empty()) {
+        String error;
+        PagedImage<float> img(restoName);
+        if (! ImageFITSConverter::ImageToFITS (error,
+                                               img,
+                                               fitsName,
+                                               64,         // memoryInMB
+                                               preferVelocity)) {
+          throw AipsError(error);
         }
-        imager.setmfcontrol (cycleFactor,
-                             cycleSpeedup,
-                             cycleMaxPsfFr,
-                             stopLargeNeg, 
-                             stopPointMode,
-                             "SAULT",                 // scaleType
-                             0.1,                     // minPB
-                             0.4,                     // constPB
-                             Vector<String>(),        // fluxscale
-                             True);                   // flatnoise
-        if (operation == "entropy") {
-          imager.mem(operation,                       // algorithm
-                     niter,                           // niter
-                     sigma,                           // sigma
-                     targetFlux,                      // targetflux
-                     constrainFlux,                   // constrainflux
-                     False,                           // displayProgress
-                     Vector<String>(1, modelName),    // model
-                     Vector<Bool>(1, fixed),          // fixed
-                     "",                              // complist
-                     Vector<String>(1, priorName),    // prior
-                     Vector<String>(1, maskName),     // mask
-                     Vector<String>(1, restoName),    // restored
-                     Vector<String>(1, residName));   // residual
+      }
+    }
+  }
+}
 
-        } else {
-          imager.clean(operation,                     // algorithm,
-                       niter,                         // niter
-                       gain,                          // gain
-                       threshold,                     // threshold
-                       False,                         // displayProgress
-                       Vector<String>(1, modelName),  // model
-                       Vector<Bool>(1, fixed),        // fixed
-                       "",                            // complist
-                       Vector<String>(1, maskName),   // mask
-                       Vector<String>(1, restoName),  // restored
-                       Vector<String>(1, residName)); // residual
-        }
-        // Convert result to fits if needed.
-        if (! fitsName.empty()) {
-          String error;
-          PagedImage<float> img(restoName);
-          if (! ImageFITSConverter::ImageToFITS (error,
-                                                 img,
-                                                 fitsName,
-                                                 64,         // memoryInMB
-                                                 preferVelocity)) {
-            throw AipsError(error);
-          }
-        }
+// Split a batch job line into its key=value arguments.
+// Quotes can be used to keep blanks in a value.
+std::vector<std::string> splitJobLine (const std::string& line)
+{
+  std::vector<std::string> args;
+  std::string arg;
+  bool inArg = false;
+  char quote = 0;
+  for (std::string::size_type i=0; i<line.size(); ++i) {
+    char c = line[i];
+    if (quote != 0) {
+      if (c == quote) {
+        quote = 0;
+      } else {
+        arg += c;
+      }
+    } else if (c == '"'  ||  c == '\'') {
+      quote = c;
+      inArg = true;
+    } else if (c == ' '  ||  c == '\t') {
+      if (inArg) {
+        args.push_back (arg);
+        arg.clear();
+        inArg = false;
+      }
+    } else {
+      arg += c;
+      inArg = true;
+    }
+  }
+  if (quote != 0) {
+    throw AipsError ("Unbalanced quote in batch job: " + line);
+  }
+  if (inArg) {
+    args.push_back (arg);
+  }
+  return args;
+}
+
+// Fill the inputs of a batch job from the command line arguments followed
+// by the job's arguments, so the latter take precedence.
+void readJobInputs (Input& inputs, const std::vector<std::string>& args)
+{
+  std::vector<char*> argv(args.size());
+  for (uInt i=0; i<args.size(); ++i) {
+    argv[i] = const_cast<char*>(args[i].c_str());
+  }
+  defineInputs (inputs);
+  inputs.readArguments (argv.size(), &(argv[0]));
+}
+
+// Estimate the memory (in MB) used by a job from its gridding cache and
+// the image cubes (complex grid, model, residual, PSF).
+Double jobMemory (Input& inputs)
+{
+  Double npix   = inputs.getInt("npix") * max(1.0, inputs.getDouble("padding"));
+  Double nplane = inputs.getInt("img_nchan") *
+                  Double(inputs.getString("stokes").length());
+  return inputs.getInt("cachesize") + 4 * 8 * npix * npix * nplane / (1024.*1024.);
+}
+
+// Run the jobs of a batch one after the other, keeping the MS and Imager
+// open in between.  A failing job does not stop the batch.
+// It returns the number of failed jobs.
+Int runJobs (const std::vector<std::vector<std::string> >& jobs, const std::vector<uInt>& jobIds)
+{
+  ImagerState state;
+  Int nfail = 0;
+  for (uInt i=0; i<jobIds.size(); ++i) {
+    uInt jobId = jobIds[i];
+    try {
+      cout << "lwimager batch job " << jobId+1 << " started" << endl;
+      Input inputs(1);
+      readJobInputs (inputs, jobs[jobId]);
+      runJob (inputs, state);
+      cout << "lwimager batch job " << jobId+1 << " ended" << endl;
+    } catch (AipsError x) {
+      cout << "lwimager batch job " << jobId+1 << " failed: "
+           << x.getMesg() << endl;
+      // Do not trust the Imager state after an error.
+      state.clear();
+      nfail++;
+    }
+  }
+  return nfail;
+}
+
+// Run the jobs given in a batch file (or stdin), one per line.
+// Jobs on the same MS are done in order by a single process, so they share
+// the open MS and Imager and reuse its weights and FTMachine where possible.
+// Jobs on different MSs are independent; up to nprocs of such groups are run
+// concurrently in child processes, as far as the free memory allows.
+// It returns the number of failed jobs (or process groups).
+Int runBatch (Int argc, char** argv, const String& batchName, Int nprocs)
+{
+  std::ifstream ifs;
+  std::istream* is = &cin;
+  if (batchName != "-") {
+    ifs.open (batchName.c_str());
+    if (! ifs) {
+      throw AipsError ("Batch file " + batchName + " could not be opened");
+    }
+    is = &ifs;
+  }
+  // Read the jobs and group them by MS (in order of first use).
+  std::vector<std::vector<std::string> > jobs;
+  std::vector<String> msNames;
+  std::vector<std::vector<uInt> > groups;
+  std::vector<Double> groupMem;
+  std::string line;
+  while (std::getline (*is, line)) {
+    std::vector<std::string> jobArgs (splitJobLine (line));
+    if (jobArgs.empty()  ||  jobArgs[0][0] == '#') {
+      continue;
+    }
+    std::vector<std::string> args (argv, argv+argc);
+    args.insert (args.end(), jobArgs.begin(), jobArgs.end());
+    Input inputs(1);
+    readJobInputs (inputs, args);
+    String msName = inputs.getString("ms");
+    uInt group = 0;
+    while (group < msNames.size()  &&  msNames[group] != msName) {
+      ++group;
+    }
+    if (group == msNames.size()) {
+      msNames.push_back (msName);
+      groups.push_back (std::vector<uInt>());
+      groupMem.push_back (0);
+    }
+    groups[group].push_back (jobs.size());
+    groupMem[group] = max(groupMem[group], jobMemory(inputs));
+    jobs.push_back (args);
+  }
+  cout << "lwimager batch has " << jobs.size() << " jobs on "
+       << msNames.size() << " MeasurementSets" << endl;
+  if (nprocs == 1  ||  groups.size() <= 1) {
+    Int nfail = 0;
+    for (uInt i=0; i<groups.size(); ++i) {
+      nfail += runJobs (jobs, groups[i]);
+    }
+    return nfail;
+  }
+  // Start a child process per group as long as the processes fit in memory.
+  // At least one process is always running.
+  Double availMem = HostInfo::memoryFree() / 1024.;
+  Double usedMem  = 0;
+  std::map<pid_t,Double> running;
+  Int nfail = 0;
+  uInt next = 0;
+  while (next < groups.size()  ||  !running.empty()) {
+    if (next < groups.size()  &&
+        (nprocs <= 0  ||  Int(running.size()) < nprocs)  &&
+        (running.empty()  ||  usedMem + groupMem[next] <= availMem)) {
+      cout.flush();
+      pid_t pid = fork();
+      if (pid < 0) {
+        throw AipsError ("lwimager could not fork a batch process");
+      }
+      if (pid == 0) {
+        Int nf = runJobs (jobs, groups[next]);
+        cout.flush();
+        _exit (nf == 0  ?  0 : 1);
+      }
+      running[pid] = groupMem[next];
+      usedMem += groupMem[next];
+      ++next;
+    } else {
+      int status;
+      pid_t pid = wait (&status);
+      if (pid < 0) {
+        throw AipsError ("lwimager failed waiting for a batch process");
+      }
+      usedMem -= running[pid];
+      running.erase (pid);
+      if (! WIFEXITED(status)  ||  WEXITSTATUS(status) != 0) {
+        nfail++;
+      }
+    }
+  }
+  return nfail;
+}
+
+int main (Int argc, char** argv)
+{
+  try {
+    Input inputs(1);
+    defineInputs (inputs);
+    // Fill the input structure from the command line.
+    inputs.readArguments (argc, argv);
+    String batchName = inputs.getString("batch");
+    if (batchName.empty()) {
+      ImagerState state;
+      runJob (inputs, state);
+    } else {
+      Int nfail = runBatch (argc, argv, batchName, inputs.getInt("nprocs"));
+      if (nfail > 0) {
+        cout << "lwimager batch had " << nfail << " failures" << endl;
+        return 1;
       }
     }
   } catch (AipsError x) {